@@ -0,0 +1,367 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file checkBench.c
+ *
+ * Benchmark of the content checkers: each one is fed generated documents from 1KB to 10MB, in
+ * chunks of the size of the response buffer as the polling code does, with the verdict at the end
+ * of the document so that all of it is read. Prints a line per checker and size, in CSV by
+ * default or in JSON with --json, and fails if the time of a checker does not grow linearly with
+ * the size, as it did when Sensu metrics were scanned again for each key.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+#include "contentCheck.h"
+#include <math.h>
+
+// Chunks fed to the checkers, as the default /responseBufferBytes
+#define CHUNK_BYTES 4096
+
+// Largest ratio of the time per byte of the largest documents to the one of LINEAR_MIN_BYTES
+// documents, for the check to be considered linear. Smaller documents have a fixed cost.
+#define LINEAR_MAX_RATIO 2.0
+#define LINEAR_MIN_BYTES (100 * 1024)
+
+// Bytes checked for each size at least, so that the small sizes run enough times to be timed
+#define MIN_BYTES_PER_SIZE (64 * 1024 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Case of the benchmark: a checker, its settings, and how its documents are generated
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char * checkModePtr;                              ///< Checker
+    void (*setParams)(ContentCheckParams_t * paramsPtr);    ///< Sets its settings
+    void (*generate)(char * bufferPtr, size_t size);        ///< Fills a document of size bytes
+    MonitorState_t expectedState;                           ///< State of the documents
+}
+Case_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fills a buffer with a text, another text repeated, then ends it with a third text. The text is
+ * only repeated whole, the rest is padded with spaces, so that the end is not read in the middle
+ * of a token.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Fill
+(
+    char * bufferPtr,               ///< [OUT] Buffer
+    size_t size,                    ///< [IN] Size to fill
+    const char * startPtr,          ///< [IN] Text at the start
+    const char * fillerPtr,         ///< [IN] Text repeated
+    const char * endPtr             ///< [IN] Text at the end
+)
+{
+    size_t startLength = strlen(startPtr);
+    size_t fillerLength = strlen(fillerPtr);
+    size_t endLength = strlen(endPtr);
+    size_t offset = startLength;
+
+    LE_ASSERT(size >= startLength + endLength);
+
+    memcpy(bufferPtr, startPtr, startLength);
+
+    while (offset + fillerLength + endLength <= size)
+    {
+        memcpy(bufferPtr + offset, fillerPtr, fillerLength);
+        offset += fillerLength;
+    }
+
+    memset(bufferPtr + offset, ' ', size - endLength - offset);
+    memcpy(bufferPtr + size - endLength, endPtr, endLength);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Jenkins build: the build details, then its result
+//--------------------------------------------------------------------------------------------------
+static void SetJenkinsParams(ContentCheckParams_t * paramsPtr)
+{
+}
+
+static void GenerateJenkins(char * bufferPtr, size_t size)
+{
+    Fill(bufferPtr,
+         size,
+         "<freeStyleBuild>",
+         "<changeSet><item><msg>Fix the FAILURE of the build</msg>"
+         "<author>jenkins</author></item></changeSet>",
+         "<result>SUCCESS</result></freeStyleBuild>");
+}
+
+//--------------------------------------------------------------------------------------------------
+// Keywords: a log, then the keyword of the state
+//--------------------------------------------------------------------------------------------------
+static void SetKeywordParams(ContentCheckParams_t * paramsPtr)
+{
+    static const char * const Keywords[] = { "PANIC", "ERROR", "DEGRADED", "HEALTHY" };
+    static const MonitorState_t States[] = { STATE_FAIL, STATE_FAIL, STATE_WARNING, STATE_PASS };
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(Keywords); i++)
+    {
+        le_utf8_Copy(paramsPtr->keywords[i].keyword,
+                     Keywords[i],
+                     sizeof(paramsPtr->keywords[i].keyword),
+                     NULL);
+        paramsPtr->keywords[i].state = States[i];
+    }
+    paramsPtr->keywordCount = NUM_ARRAY_MEMBERS(Keywords);
+}
+
+static void GenerateKeywords(char * bufferPtr, size_t size)
+{
+    Fill(bufferPtr,
+         size,
+         "",
+         "2024-01-01T00:00:00Z service=api status=ok latency=12ms path=/v1/items\n",
+         "overall=HEALTHY\n");
+}
+
+//--------------------------------------------------------------------------------------------------
+// Sensu metrics: healthy datacenters, then one with a warning. A critical one would end the check.
+//--------------------------------------------------------------------------------------------------
+static void SetSensuParams(ContentCheckParams_t * paramsPtr)
+{
+}
+
+static void GenerateSensu(char * bufferPtr, size_t size)
+{
+    Fill(bufferPtr,
+         size,
+         "[",
+         "{\"dc\": \"main\", \"clients\": {\"critical\": 0, \"warning\": 0, \"total\": 12}, "
+         "\"checks\": {\"critical\": 0, \"warning\": 0, \"silenced\": 1, \"total\": 42}},\n",
+         "{\"dc\": \"edge\", \"clients\": {\"critical\": 0, \"warning\": 2, \"total\": 3}}]");
+}
+
+//--------------------------------------------------------------------------------------------------
+// Prometheus metrics: request counters, then the sample selected, below its thresholds
+//--------------------------------------------------------------------------------------------------
+static void SetPrometheusParams(ContentCheckParams_t * paramsPtr)
+{
+    le_utf8_Copy(paramsPtr->path, "queue_depth{queue=\"jobs\"}", sizeof(paramsPtr->path), NULL);
+    paramsPtr->warningThreshold = 100;
+    paramsPtr->criticalThreshold = 1000;
+}
+
+static void GeneratePrometheus(char * bufferPtr, size_t size)
+{
+    Fill(bufferPtr,
+         size,
+         "# HELP http_requests_total Requests served.\n# TYPE http_requests_total counter\n",
+         "http_requests_total{job=\"api\",method=\"get\",code=\"200\"} 1027 1700000000000\n",
+         "\nqueue_depth{queue=\"jobs\"} 12\n");
+}
+
+//--------------------------------------------------------------------------------------------------
+// JSON status page: the components, then the status indicator
+//--------------------------------------------------------------------------------------------------
+static void SetJsonParams(ContentCheckParams_t * paramsPtr)
+{
+    le_utf8_Copy(paramsPtr->path, "$.status.indicator", sizeof(paramsPtr->path), NULL);
+    le_utf8_Copy(paramsPtr->value, "none", sizeof(paramsPtr->value), NULL);
+}
+
+static void GenerateJson(char * bufferPtr, size_t size)
+{
+    Fill(bufferPtr,
+         size,
+         "{\"page\": {\"name\": \"status\"}, \"components\": [",
+         "{\"id\": \"k2t\", \"name\": \"API\", \"status\": \"operational\", "
+         "\"tags\": [1, 2.5, true, null]},\n",
+         "{\"id\": \"cdn\"}], \"status\": {\"indicator\": \"none\"}}");
+}
+
+//--------------------------------------------------------------------------------------------------
+// Cases, and sizes of the documents
+//--------------------------------------------------------------------------------------------------
+static const Case_t Cases[] =
+{
+    { "jenkins", SetJenkinsParams, GenerateJenkins, STATE_PASS },
+    { "keywords", SetKeywordParams, GenerateKeywords, STATE_PASS },
+    { "sensu", SetSensuParams, GenerateSensu, STATE_WARNING },
+    { "prometheus", SetPrometheusParams, GeneratePrometheus, STATE_PASS },
+    { "json", SetJsonParams, GenerateJson, STATE_PASS },
+};
+
+static const size_t Sizes[] =
+{
+    1024,
+    10 * 1024,
+    100 * 1024,
+    1024 * 1024,
+    10 * 1024 * 1024,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks a document as the polling code does: chunk by chunk, until the verdict is known
+ *
+ * @return
+ *      State of the document
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t CheckDocument
+(
+    ContentCheck_t * checkPtr,                  ///< [IN] Memory of the check
+    const ContentChecker_t * checkerPtr,        ///< [IN] Checker
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Its settings
+    const char * documentPtr,                   ///< [IN] Document
+    size_t size                                 ///< [IN] Size of the document
+)
+{
+    size_t offset = 0;
+
+    contentCheck_Init(checkPtr, checkerPtr, paramsPtr);
+
+    while ( (offset < size) && !checkPtr->isDone )
+    {
+        size_t length = (size - offset < CHUNK_BYTES) ? size - offset : CHUNK_BYTES;
+
+        contentCheck_Feed(checkPtr, documentPtr + offset, length);
+        offset += length;
+    }
+
+    return contentCheck_GetResult(checkPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Times the check of documents of a size
+ *
+ * @return
+ *      Nanoseconds per document
+ */
+//--------------------------------------------------------------------------------------------------
+static double TimeCheck
+(
+    const Case_t * casePtr,             ///< [IN] Case
+    size_t size,                        ///< [IN] Size of the documents
+    size_t * runCountPtr                ///< [OUT] Number of documents checked
+)
+{
+    static ContentCheckParams_t params;
+    const ContentChecker_t * checkerPtr = contentCheck_GetChecker(casePtr->checkModePtr);
+    ContentCheck_t * checkPtr;
+    char * documentPtr = malloc(size);
+    size_t runCount = MIN_BYTES_PER_SIZE / size;
+    uint64_t startUs;
+    size_t i;
+
+    LE_ASSERT(checkerPtr && documentPtr);
+
+    // The settings of the previous case are built again
+    contentCheck_Release(&params);
+    memset(&params, 0, sizeof(params));
+    params.warningThreshold = NAN;
+    params.criticalThreshold = NAN;
+    casePtr->setParams(&params);
+    LE_ASSERT(contentCheck_Prepare(checkerPtr, &params) == LE_OK);
+
+    checkPtr = malloc(contentCheck_GetSize(checkerPtr));
+    LE_ASSERT(checkPtr);
+    casePtr->generate(documentPtr, size);
+
+    if (runCount == 0)
+    {
+        runCount = 1;
+    }
+
+    // Once to check the verdict, and to warm the caches up
+    LE_FATAL_IF(CheckDocument(checkPtr, checkerPtr, &params, documentPtr, size) !=
+                casePtr->expectedState,
+                "Unexpected state of %s for %zu bytes",
+                casePtr->checkModePtr,
+                size);
+
+    startUs = stubClk_GetUs();
+    for (i = 0; i < runCount; i++)
+    {
+        CheckDocument(checkPtr, checkerPtr, &params, documentPtr, size);
+    }
+
+    *runCountPtr = runCount;
+    free(checkPtr);
+    free(documentPtr);
+    return (double) (stubClk_GetUs() - startUs) * 1000 / runCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs the benchmark. The time of each check must grow linearly with the size of the documents:
+ * the time per byte of the largest ones is compared to the one of LINEAR_MIN_BYTES ones.
+ *
+ * @return
+ *      EXIT_FAILURE if a check is not linear
+ */
+//--------------------------------------------------------------------------------------------------
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    bool isJson = (argc > 1) && (strcmp(argv[1], "--json") == 0);
+    bool isFirst = true;
+    bool isLinear = true;
+    size_t c;
+    size_t s;
+
+    printf(isJson ? "[\n" : "checker,bytes,chunkBytes,runs,nsPerDocument,mbPerSec\n");
+
+    for (c = 0; c < NUM_ARRAY_MEMBERS(Cases); c++)
+    {
+        double baseNsPerByte = 0;
+        double ratio;
+
+        for (s = 0; s < NUM_ARRAY_MEMBERS(Sizes); s++)
+        {
+            size_t runCount;
+            double ns = TimeCheck(&Cases[c], Sizes[s], &runCount);
+            double mbPerSec = Sizes[s] / ns * 1e9 / (1024 * 1024);
+
+            if (isJson)
+            {
+                printf("%s  {\"checker\": \"%s\", \"bytes\": %zu, \"chunkBytes\": %d, "
+                       "\"runs\": %zu, \"nsPerDocument\": %.0f, \"mbPerSec\": %.1f}",
+                       isFirst ? "" : ",\n",
+                       Cases[c].checkModePtr, Sizes[s], CHUNK_BYTES, runCount, ns, mbPerSec);
+            }
+            else
+            {
+                printf("%s,%zu,%d,%zu,%.0f,%.1f\n",
+                       Cases[c].checkModePtr, Sizes[s], CHUNK_BYTES, runCount, ns, mbPerSec);
+            }
+            isFirst = false;
+
+            if (Sizes[s] == LINEAR_MIN_BYTES)
+            {
+                baseNsPerByte = ns / Sizes[s];
+            }
+            ratio = ns / Sizes[s] / baseNsPerByte;
+        }
+
+        // Printed apart from the results, so that they stay CSV or JSON
+        fprintf(stderr,
+                "%s: time per byte of %zu bytes is %.2f times the one of %d bytes%s\n",
+                Cases[c].checkModePtr,
+                Sizes[NUM_ARRAY_MEMBERS(Sizes) - 1],
+                ratio,
+                LINEAR_MIN_BYTES,
+                (ratio <= LINEAR_MAX_RATIO) ? "" : ", NOT LINEAR");
+        if (ratio > LINEAR_MAX_RATIO)
+        {
+            isLinear = false;
+        }
+    }
+
+    if (isJson)
+    {
+        printf("\n]\n");
+    }
+    return isLinear ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,566 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file pollBench.c
+ *
+ * Benchmark of the polls, with the component run as a whole against the HTTP server of the stubs:
+ * the polling timer, the transfers, the content checks and the light. For each load, a number of
+ * monitors answered after a delay with Jenkins builds of a size, the result of the builds is
+ * flipped after each poll so that each poll changes the light, and the time from the first
+ * request of the poll to the first write of the pins is measured. Prints a line per load with the
+ * percentiles of that time and the throughput of the polls, in CSV by default or in JSON with
+ * --json, and fails if the transfers of a poll do not run concurrently.
+ *
+ * The light is then checked against the table of the README under the heaviest load, for each
+ * setting of the exit code and content checks and HTTP code.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+
+// Polling interval, and polls measured for each load after a first one opening the connections
+#define POLLING_INTERVAL_SEC 1
+#define POLL_COUNT 10
+
+// Time for the settings to be applied, more than the delay of the component after a change
+#define CONFIG_MS 500
+
+// Most monitors and largest build of the loads
+#define MAX_BENCH_MONITORS 32
+#define MAX_BODY_BYTES (256 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load of the benchmark: the monitors, and how their server answers
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t monitorCount;            ///< Monitors polled
+    uint32_t delayMs;               ///< Delay of the server before each response
+    size_t bodyBytes;               ///< Size of the builds, with the result at the end
+    size_t chunkBytes;              ///< Size of the chunks they are sent in, 0 with their length
+}
+Load_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Row of the light table of the README
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isExitCodeChecked;         ///< info/exitCode/checkFlag of the monitors
+    bool isContentChecked;          ///< info/content/checkFlag of the monitors
+    int status;                     ///< HTTP code of the responses
+    const char * resultPtr;         ///< Result of the builds
+    bool isOneFailing;              ///< Whether the build of the first monitor fails regardless
+    bool isRed;                     ///< Whether the light must be red, green otherwise
+}
+LightCase_t;
+
+//--------------------------------------------------------------------------------------------------
+// Loads, and rows of the light table, ordered so that the light changes from one to the next
+//--------------------------------------------------------------------------------------------------
+static const Load_t Loads[] =
+{
+    { 1, 0, 4 * 1024, 0 },
+    { 8, 20, 64 * 1024, 1024 },
+    { MAX_BENCH_MONITORS, 50, MAX_BODY_BYTES, 4096 },
+};
+
+static const LightCase_t LightCases[] =
+{
+    { true, true, 200, "SUCCESS", false, false },
+    { true, true, 200, "FAILURE", false, true },
+    { true, false, 200, "FAILURE", false, false },
+    { true, true, 500, "SUCCESS", false, true },
+    { false, true, 500, "SUCCESS", false, false },
+    { true, false, 500, "SUCCESS", false, true },
+    { false, false, 500, "FAILURE", false, false },
+    { false, true, 500, "FAILURE", false, true },
+    { true, true, 200, "SUCCESS", false, false },
+    { true, true, 200, "SUCCESS", true, true },
+};
+
+// Port of the server
+static uint16_t Port;
+
+// Load measured, the times from the start of its polls to the light, and the result served
+static const Load_t * CurrentLoadPtr = NULL;
+static bool IsMeasuring = false;
+static uint64_t LastPollUs = 0;
+static uint64_t LatenciesUs[1 + POLL_COUNT];
+static size_t LatencyCount = 0;
+static bool IsFailure = false;
+static bool IsShownFailure = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the path of the build of a monitor
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetPath
+(
+    size_t monitor,                 ///< [IN] Monitor
+    char * pathPtr,                 ///< [OUT] Path
+    size_t size                     ///< [IN] Size of the path buffer
+)
+{
+    snprintf(pathPtr, size, "/job/m%zu/lastBuild/api/xml", monitor);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fills a buffer with a build of a size: its change sets, then its result. The change sets are
+ * only repeated whole, the rest is padded with spaces.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Generate
+(
+    char * bufferPtr,               ///< [OUT] Buffer, of size + 1 bytes
+    size_t size,                    ///< [IN] Size of the build
+    const char * resultPtr          ///< [IN] Result of the build
+)
+{
+    static const char start[] = "<freeStyleBuild>";
+    static const char filler[] = "<changeSet><item><msg>Fix the FAILURE of the build</msg>"
+                                 "<author>jenkins</author></item></changeSet>";
+    char end[64];
+    size_t endLength = snprintf(end, sizeof(end), "<result>%s</result></freeStyleBuild>",
+                                resultPtr);
+    size_t offset = sizeof(start) - 1;
+
+    LE_ASSERT(size >= offset + endLength);
+
+    memcpy(bufferPtr, start, offset);
+    while (offset + sizeof(filler) - 1 + endLength <= size)
+    {
+        memcpy(bufferPtr + offset, filler, sizeof(filler) - 1);
+        offset += sizeof(filler) - 1;
+    }
+
+    memset(bufferPtr + offset, ' ', size - endLength - offset);
+    memcpy(bufferPtr + size - endLength, end, endLength + 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the responses of the server to the monitors of a load
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetResponses
+(
+    const Load_t * loadPtr,         ///< [IN] Load
+    int status,                     ///< [IN] HTTP code
+    const char * resultPtr,         ///< [IN] Result of the builds
+    const char * firstResultPtr     ///< [IN] Result of the build of the first monitor, NULL for
+                                    ///<      the same
+)
+{
+    static char body[MAX_BODY_BYTES + 1];
+    static char firstBody[MAX_BODY_BYTES + 1];
+    stubHttp_Response_t response = { .status = status,
+                                     .delayMs = loadPtr->delayMs,
+                                     .chunkBytes = loadPtr->chunkBytes };
+    char path[64];
+    size_t i;
+
+    LE_ASSERT(loadPtr->bodyBytes <= MAX_BODY_BYTES);
+
+    Generate(body, loadPtr->bodyBytes, resultPtr);
+    Generate(firstBody, loadPtr->bodyBytes, firstResultPtr ? firstResultPtr : resultPtr);
+
+    for (i = 0; i < loadPtr->monitorCount; i++)
+    {
+        GetPath(i, path, sizeof(path));
+        response.bodyPtr = (i == 0) ? firstBody : body;
+        stubHttp_SetResponse(path, &response);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the monitors of a load, and lets the component apply them
+ */
+//--------------------------------------------------------------------------------------------------
+static void Configure
+(
+    const Load_t * loadPtr,         ///< [IN] Load
+    bool isExitCodeChecked,         ///< [IN] info/exitCode/checkFlag of the monitors
+    bool isContentChecked           ///< [IN] info/content/checkFlag of the monitors
+)
+{
+    char path[64];
+    char key[128];
+    char url[128];
+    size_t i;
+
+    stubCfg_Delete("/monitors");
+
+    for (i = 0; i < loadPtr->monitorCount; i++)
+    {
+        GetPath(i, path, sizeof(path));
+        snprintf(url, sizeof(url), "http://127.0.0.1:%u%s", Port, path);
+
+        snprintf(key, sizeof(key), "/monitors/m%zu/url", i);
+        stubCfg_SetString(key, url);
+        snprintf(key, sizeof(key), "/monitors/m%zu/info/exitCode/checkFlag", i);
+        stubCfg_SetBool(key, isExitCodeChecked);
+        snprintf(key, sizeof(key), "/monitors/m%zu/info/content/checkFlag", i);
+        stubCfg_SetBool(key, isContentChecked);
+        snprintf(key, sizeof(key), "/monitors/m%zu/info/content/checkMode", i);
+        stubCfg_SetString(key, "jenkins");
+    }
+
+    stubLoop_Run(CONFIG_MS);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the time the last poll of the load measured started at: the first of its requests, since
+ * each monitor is requested once per poll
+ *
+ * @return
+ *      Time of the first request, see stubClk_GetUs, 0 if a monitor has not been polled yet
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetPollStartUs(void)
+{
+    uint64_t startUs = UINT64_MAX;
+    char path[64];
+    size_t i;
+
+    for (i = 0; i < CurrentLoadPtr->monitorCount; i++)
+    {
+        uint64_t requestUs;
+
+        GetPath(i, path, sizeof(path));
+        requestUs = stubHttp_GetLastRequestUs(path);
+        if (requestUs == 0)
+        {
+            return 0;
+        }
+        if (requestUs < startUs)
+        {
+            startUs = requestUs;
+        }
+    }
+
+    return startUs;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records the time from the start of a poll to its first write of the pins, and flips the result
+ * of the builds so that the next poll changes the light again
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteHandler
+(
+    stubGpio_Pin_t pin,             ///< [IN] Pin written
+    bool value,                     ///< [IN] Level written
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    uint64_t pollUs;
+
+    if (!IsMeasuring || (LatencyCount >= NUM_ARRAY_MEMBERS(LatenciesUs)))
+    {
+        return;
+    }
+
+    pollUs = GetPollStartUs();
+    if ( (pollUs == 0) || (pollUs == LastPollUs) )
+    {
+        return;
+    }
+
+    LastPollUs = pollUs;
+    LatenciesUs[LatencyCount++] = stubClk_GetUs() - pollUs;
+
+    IsShownFailure = IsFailure;
+    IsFailure = !IsFailure;
+    SetResponses(CurrentLoadPtr, 200, IsFailure ? "FAILURE" : "SUCCESS", NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the polls of the load have all been measured
+ *
+ * @return
+ *      true if they have
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsMeasured
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    return LatencyCount >= NUM_ARRAY_MEMBERS(LatenciesUs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the light is red, or green
+ *
+ * @return
+ *      true if it is
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsLight
+(
+    void * contextPtr               ///< [IN] Whether it must be red, as a bool
+)
+{
+    bool isRed = *(const bool *) contextPtr;
+
+    return (stubGpio_Get(STUB_GPIO_RED) == isRed) && (stubGpio_Get(STUB_GPIO_GREEN) != isRed);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the first monitor has been requested a number of times
+ *
+ * @return
+ *      true if it has
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsRequested
+(
+    void * contextPtr               ///< [IN] Number of requests, as a uint32_t
+)
+{
+    char path[64];
+
+    GetPath(0, path, sizeof(path));
+    return stubHttp_GetRequestCount(path) >= *(const uint32_t *) contextPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares two times, for qsort
+ *
+ * @return
+ *      Negative, zero or positive as the first time is less, equal or greater
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompareUs
+(
+    const void * aPtr,              ///< [IN] First time
+    const void * bPtr               ///< [IN] Second time
+)
+{
+    uint64_t a = *(const uint64_t *) aPtr;
+    uint64_t b = *(const uint64_t *) bPtr;
+
+    return (a > b) - (a < b);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Measures the polls of a load. The first poll, which opens the connections, is not counted.
+ *
+ * @return
+ *      Times from the start of the polls to the light, sorted, POLL_COUNT of them
+ */
+//--------------------------------------------------------------------------------------------------
+static const uint64_t * MeasureLoad
+(
+    const Load_t * loadPtr          ///< [IN] Load
+)
+{
+    bool isRed = !stubGpio_Get(STUB_GPIO_GREEN);
+
+    // The responses are the opposite of the light, so that the first poll changes it
+    CurrentLoadPtr = loadPtr;
+    IsFailure = !isRed;
+    LastPollUs = 0;
+    LatencyCount = 0;
+    SetResponses(loadPtr, 200, IsFailure ? "FAILURE" : "SUCCESS", NULL);
+
+    IsMeasuring = true;
+    Configure(loadPtr, true, true);
+    LE_FATAL_IF(!stubLoop_RunUntil(IsMeasured,
+                                   NULL,
+                                   (NUM_ARRAY_MEMBERS(LatenciesUs) + 2) *
+                                   POLLING_INTERVAL_SEC * 1000),
+                "Only %zu polls of %zu monitors changed the light",
+                LatencyCount,
+                loadPtr->monitorCount);
+    IsMeasuring = false;
+
+    // The light shows the result served to the last poll
+    LE_FATAL_IF(!IsLight(&IsShownFailure),
+                "Light of %zu monitors not %s",
+                loadPtr->monitorCount,
+                IsShownFailure ? "red" : "green");
+
+    qsort(LatenciesUs + 1, POLL_COUNT, sizeof(LatenciesUs[0]), CompareUs);
+    return LatenciesUs + 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks a row of the light table: the light must reach its state, and keep it over the next polls
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckLight
+(
+    const Load_t * loadPtr,             ///< [IN] Load
+    const LightCase_t * casePtr         ///< [IN] Row of the table
+)
+{
+    char path[64];
+    uint32_t requestCount;
+    uint32_t writeCount;
+
+    SetResponses(loadPtr,
+                 casePtr->status,
+                 casePtr->resultPtr,
+                 casePtr->isOneFailing ? "FAILURE" : NULL);
+    Configure(loadPtr, casePtr->isExitCodeChecked, casePtr->isContentChecked);
+
+    LE_FATAL_IF(!stubLoop_RunUntil(IsLight,
+                                   (void *) &casePtr->isRed,
+                                   3 * POLLING_INTERVAL_SEC * 1000),
+                "exitCode %d, content %d, HTTP %d, %s%s: light not %s",
+                casePtr->isExitCodeChecked,
+                casePtr->isContentChecked,
+                casePtr->status,
+                casePtr->resultPtr,
+                casePtr->isOneFailing ? " but one FAILURE" : "",
+                casePtr->isRed ? "red" : "green");
+
+    // Two more polls start, so that one more is done, without any change of the light
+    GetPath(0, path, sizeof(path));
+    requestCount = stubHttp_GetRequestCount(path) + 2;
+    writeCount = stubGpio_GetPinWriteCount(STUB_GPIO_RED) +
+                 stubGpio_GetPinWriteCount(STUB_GPIO_GREEN);
+    LE_ASSERT(stubLoop_RunUntil(IsRequested, &requestCount, 3 * POLLING_INTERVAL_SEC * 1000));
+    LE_FATAL_IF(stubGpio_GetPinWriteCount(STUB_GPIO_RED) +
+                stubGpio_GetPinWriteCount(STUB_GPIO_GREEN) != writeCount,
+                "exitCode %d, content %d, HTTP %d, %s: light changed on a later poll",
+                casePtr->isExitCodeChecked,
+                casePtr->isContentChecked,
+                casePtr->status,
+                casePtr->resultPtr);
+
+    fprintf(stderr,
+            "exitCode %s, content %s, HTTP %d, %s%s: %s\n",
+            casePtr->isExitCodeChecked ? "true" : "false",
+            casePtr->isContentChecked ? "true" : "false",
+            casePtr->status,
+            casePtr->resultPtr,
+            casePtr->isOneFailing ? " but one FAILURE" : "",
+            casePtr->isRed ? "LIGHT_RED" : "LIGHT_GREEN");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs the benchmark. The transfers of a poll must run concurrently: the slowest poll of a load
+ * must take less than the delays of its responses one after the other.
+ *
+ * @return
+ *      EXIT_FAILURE if they do not
+ */
+//--------------------------------------------------------------------------------------------------
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    bool isJson = (argc > 1) && (strcmp(argv[1], "--json") == 0);
+    bool isConcurrent = true;
+    size_t l;
+    size_t c;
+
+    Port = stubHttp_Start();
+    stubGpio_SetWriteHandler(WriteHandler, NULL);
+    stubCfg_SetInt("/pollingIntervalSec", POLLING_INTERVAL_SEC);
+    SetResponses(&Loads[0], 200, "SUCCESS", NULL);
+    Configure(&Loads[0], true, true);
+
+    _le_stub_ComponentInit();
+
+    printf(isJson ? "[\n" : "monitors,delayMs,bodyBytes,chunkBytes,polls,"
+                            "p50Ms,p90Ms,maxMs,transfersPerSec,mbPerSec\n");
+
+    for (l = 0; l < NUM_ARRAY_MEMBERS(Loads); l++)
+    {
+        const Load_t * loadPtr = &Loads[l];
+        const uint64_t * latenciesUs = MeasureLoad(loadPtr);
+        uint64_t totalUs = 0;
+        uint64_t serialUs = (uint64_t) loadPtr->monitorCount * loadPtr->delayMs * 1000;
+        double p50Ms = latenciesUs[(POLL_COUNT - 1) / 2] / 1000.0;
+        double p90Ms = latenciesUs[(POLL_COUNT - 1) * 9 / 10] / 1000.0;
+        double maxMs = latenciesUs[POLL_COUNT - 1] / 1000.0;
+        double transfersPerSec;
+        double mbPerSec;
+        size_t i;
+
+        for (i = 0; i < POLL_COUNT; i++)
+        {
+            totalUs += latenciesUs[i];
+        }
+        transfersPerSec = (double) POLL_COUNT * loadPtr->monitorCount / totalUs * 1e6;
+        mbPerSec = transfersPerSec * loadPtr->bodyBytes / (1024 * 1024);
+
+        if (isJson)
+        {
+            printf("%s  {\"monitors\": %zu, \"delayMs\": %u, \"bodyBytes\": %zu, "
+                   "\"chunkBytes\": %zu, \"polls\": %d, \"p50Ms\": %.1f, \"p90Ms\": %.1f, "
+                   "\"maxMs\": %.1f, \"transfersPerSec\": %.0f, \"mbPerSec\": %.1f}",
+                   (l == 0) ? "" : ",\n",
+                   loadPtr->monitorCount, loadPtr->delayMs, loadPtr->bodyBytes,
+                   loadPtr->chunkBytes, POLL_COUNT, p50Ms, p90Ms, maxMs, transfersPerSec,
+                   mbPerSec);
+        }
+        else
+        {
+            printf("%zu,%u,%zu,%zu,%d,%.1f,%.1f,%.1f,%.0f,%.1f\n",
+                   loadPtr->monitorCount, loadPtr->delayMs, loadPtr->bodyBytes,
+                   loadPtr->chunkBytes, POLL_COUNT, p50Ms, p90Ms, maxMs, transfersPerSec,
+                   mbPerSec);
+        }
+
+        // Printed apart from the results, so that they stay CSV or JSON
+        if ( (loadPtr->monitorCount > 1) && (serialUs > 0) )
+        {
+            bool isLoadConcurrent = (latenciesUs[POLL_COUNT - 1] < serialUs);
+
+            fprintf(stderr,
+                    "%zu monitors: slowest poll %.1f ms, %.1f ms with the transfers one after "
+                    "the other%s\n",
+                    loadPtr->monitorCount,
+                    maxMs,
+                    serialUs / 1000.0,
+                    isLoadConcurrent ? "" : ", NOT CONCURRENT");
+            if (!isLoadConcurrent)
+            {
+                isConcurrent = false;
+            }
+        }
+    }
+
+    if (isJson)
+    {
+        printf("\n]\n");
+    }
+
+    // The light table of the README, under the heaviest load
+    for (c = 0; c < NUM_ARRAY_MEMBERS(LightCases); c++)
+    {
+        CheckLight(&Loads[NUM_ARRAY_MEMBERS(Loads) - 1], &LightCases[c]);
+    }
+
+    if (!isConcurrent)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // The component exits once its resources are released
+    stubSig_Raise(SIGTERM);
+    return EXIT_FAILURE;
+}
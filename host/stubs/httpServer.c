@@ -0,0 +1,454 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file httpServer.c
+ *
+ * HTTP server on the loopback interface for the host build, standing in for the servers polled
+ * and for the event streams. Each connection is served by its own thread, so that a delayed
+ * response or an open stream does not hold the others; the event loop of the stubs is not used.
+ * Connections are kept alive between requests.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stubs.h"
+#include <pthread.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Most paths answered, streams open at once, and longest path and request head
+#define MAX_PATHS 64
+#define MAX_STREAMS 8
+#define MAX_PATH_BYTES 256
+#define MAX_REQUEST_BYTES 8192
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Path answered
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char path[MAX_PATH_BYTES];          ///< Path, "" if the entry is unused
+    stubHttp_Response_t response;       ///< Response, with a copy of the body
+    size_t bodyLength;                  ///< Length of the body
+    uint32_t requestCount;              ///< Requests received
+    uint64_t lastRequestUs;             ///< Time the last request was received at
+}
+Path_t;
+
+// Paths, streams open, connections accepted and listening socket, shared by the threads
+static pthread_mutex_t Mutex = PTHREAD_MUTEX_INITIALIZER;
+static Path_t Paths[MAX_PATHS];
+static int StreamFds[MAX_STREAMS];
+static size_t StreamCount = 0;
+static uint32_t ConnectionCount = 0;
+static int ListenFd = -1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sends all of a buffer
+ *
+ * @return
+ *      false if the connection is closed
+ */
+//--------------------------------------------------------------------------------------------------
+static bool SendAll
+(
+    int fd,                         ///< [IN] Socket
+    const char * dataPtr,           ///< [IN] Data
+    size_t length                   ///< [IN] Its length
+)
+{
+    while (length > 0)
+    {
+        ssize_t sent = send(fd, dataPtr, length, MSG_NOSIGNAL);
+
+        if (sent <= 0)
+        {
+            return false;
+        }
+        dataPtr += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Looks for a path, with the mutex locked
+ *
+ * @return
+ *      The path, NULL if it is not set
+ */
+//--------------------------------------------------------------------------------------------------
+static Path_t * FindPath
+(
+    const char * pathPtr            ///< [IN] Path
+)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_PATHS; i++)
+    {
+        if ( (Paths[i].path[0] != '\0') && (strcmp(Paths[i].path, pathPtr) == 0) )
+        {
+            return &Paths[i];
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps a connection open as an event stream until the client or stubHttp_DropStreams closes it
+ */
+//--------------------------------------------------------------------------------------------------
+static void ServeStream
+(
+    int fd                          ///< [IN] Socket of the connection
+)
+{
+    static const char head[] = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/event-stream\r\n"
+                               "Cache-Control: no-cache\r\n"
+                               "\r\n";
+    char buffer[256];
+    size_t i;
+
+    pthread_mutex_lock(&Mutex);
+    LE_ASSERT(StreamCount < MAX_STREAMS);
+    StreamFds[StreamCount++] = fd;
+    SendAll(fd, head, sizeof(head) - 1);
+    pthread_mutex_unlock(&Mutex);
+
+    while (recv(fd, buffer, sizeof(buffer), 0) > 0)
+    {
+    }
+
+    pthread_mutex_lock(&Mutex);
+    for (i = 0; i < StreamCount; i++)
+    {
+        if (StreamFds[i] == fd)
+        {
+            StreamFds[i] = StreamFds[--StreamCount];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Mutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sends a response, after its delay
+ *
+ * @return
+ *      false if the connection is closed
+ */
+//--------------------------------------------------------------------------------------------------
+static bool SendResponse
+(
+    int fd,                                 ///< [IN] Socket of the connection
+    const stubHttp_Response_t * responsePtr,///< [IN] Response
+    size_t bodyLength                       ///< [IN] Length of its body
+)
+{
+    char head[256];
+    size_t offset = 0;
+    int length;
+
+    if (responsePtr->delayMs > 0)
+    {
+        usleep(responsePtr->delayMs * 1000);
+    }
+
+    if (responsePtr->chunkBytes > 0)
+    {
+        length = snprintf(head, sizeof(head),
+                          "HTTP/1.1 %d Status\r\nTransfer-Encoding: chunked\r\n\r\n",
+                          responsePtr->status);
+    }
+    else
+    {
+        length = snprintf(head, sizeof(head),
+                          "HTTP/1.1 %d Status\r\nContent-Length: %zu\r\n\r\n",
+                          responsePtr->status,
+                          bodyLength);
+    }
+    if (!SendAll(fd, head, length))
+    {
+        return false;
+    }
+
+    if (responsePtr->chunkBytes == 0)
+    {
+        return SendAll(fd, responsePtr->bodyPtr, bodyLength);
+    }
+
+    while (offset < bodyLength)
+    {
+        size_t chunk = bodyLength - offset;
+
+        if (chunk > responsePtr->chunkBytes)
+        {
+            chunk = responsePtr->chunkBytes;
+        }
+
+        length = snprintf(head, sizeof(head), "%zx\r\n", chunk);
+        if ( !SendAll(fd, head, length) ||
+             !SendAll(fd, responsePtr->bodyPtr + offset, chunk) ||
+             !SendAll(fd, "\r\n", 2) )
+        {
+            return false;
+        }
+        offset += chunk;
+    }
+
+    return SendAll(fd, "0\r\n\r\n", 5);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serves the requests of a connection until it is closed
+ *
+ * @return
+ *      NULL
+ */
+//--------------------------------------------------------------------------------------------------
+static void * ServeConnection
+(
+    void * contextPtr               ///< [IN] Socket of the connection
+)
+{
+    int fd = (int) (intptr_t) contextPtr;
+    char request[MAX_REQUEST_BYTES];
+    size_t length = 0;
+
+    for (;;)
+    {
+        char path[MAX_PATH_BYTES] = "";
+        stubHttp_Response_t response = { .status = 404 };
+        char * bodyPtr = NULL;
+        size_t bodyLength = 0;
+        char * endPtr;
+        size_t headLength;
+        Path_t * pathPtr;
+        ssize_t received;
+        bool isSent;
+
+        // Head of the request, the requests of the component have no body
+        request[length] = '\0';
+        while ( (endPtr = strstr(request, "\r\n\r\n")) == NULL )
+        {
+            received = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+            if ( (received <= 0) || (length + received >= sizeof(request) - 1) )
+            {
+                close(fd);
+                return NULL;
+            }
+            length += received;
+            request[length] = '\0';
+        }
+        headLength = endPtr + 4 - request;
+
+        sscanf(request, "%*s %255[^? \r\n]", path);
+
+        pthread_mutex_lock(&Mutex);
+        pathPtr = FindPath(path);
+        if (pathPtr)
+        {
+            pathPtr->requestCount++;
+            pathPtr->lastRequestUs = stubClk_GetUs();
+            response = pathPtr->response;
+            bodyLength = pathPtr->bodyLength;
+            bodyPtr = malloc(bodyLength + 1);
+            LE_ASSERT(bodyPtr);
+            memcpy(bodyPtr, pathPtr->response.bodyPtr, bodyLength);
+        }
+        pthread_mutex_unlock(&Mutex);
+
+        memmove(request, request + headLength, length - headLength);
+        length -= headLength;
+
+        if (response.isStream)
+        {
+            free(bodyPtr);
+            ServeStream(fd);
+            break;
+        }
+
+        response.bodyPtr = bodyPtr;
+        isSent = SendResponse(fd, &response, bodyLength);
+        free(bodyPtr);
+        if (!isSent)
+        {
+            break;
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Accepts the connections, each served by its own thread
+ *
+ * @return
+ *      NULL
+ */
+//--------------------------------------------------------------------------------------------------
+static void * Listen
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    for (;;)
+    {
+        int fd = accept(ListenFd, NULL, NULL);
+        pthread_t thread;
+
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&Mutex);
+        ConnectionCount++;
+        pthread_mutex_unlock(&Mutex);
+
+        LE_ASSERT(pthread_create(&thread, NULL, ServeConnection, (void *) (intptr_t) fd) == 0);
+        pthread_detach(thread);
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Control of the stub, see stubs.h
+//--------------------------------------------------------------------------------------------------
+uint16_t stubHttp_Start(void)
+{
+    struct sockaddr_in address = { .sin_family = AF_INET };
+    socklen_t addressLength = sizeof(address);
+    pthread_t thread;
+
+    LE_ASSERT(ListenFd < 0);
+
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    LE_ASSERT(ListenFd >= 0);
+    LE_ASSERT(bind(ListenFd, (struct sockaddr *) &address, sizeof(address)) == 0);
+    LE_ASSERT(listen(ListenFd, 64) == 0);
+    LE_ASSERT(getsockname(ListenFd, (struct sockaddr *) &address, &addressLength) == 0);
+
+    LE_ASSERT(pthread_create(&thread, NULL, Listen, NULL) == 0);
+    pthread_detach(thread);
+
+    return ntohs(address.sin_port);
+}
+
+void stubHttp_SetResponse(const char * pathPtr, const stubHttp_Response_t * responsePtr)
+{
+    Path_t * entryPtr;
+    size_t i;
+
+    pthread_mutex_lock(&Mutex);
+
+    entryPtr = FindPath(pathPtr);
+    for (i = 0; (entryPtr == NULL) && (i < MAX_PATHS); i++)
+    {
+        if (Paths[i].path[0] == '\0')
+        {
+            entryPtr = &Paths[i];
+            le_utf8_Copy(entryPtr->path, pathPtr, sizeof(entryPtr->path), NULL);
+        }
+    }
+    LE_ASSERT(entryPtr);
+
+    free((char *) entryPtr->response.bodyPtr);
+    entryPtr->response = *responsePtr;
+    entryPtr->bodyLength = responsePtr->bodyPtr ? strlen(responsePtr->bodyPtr) : 0;
+    entryPtr->response.bodyPtr = strdup(responsePtr->bodyPtr ? responsePtr->bodyPtr : "");
+    LE_ASSERT(entryPtr->response.bodyPtr);
+
+    pthread_mutex_unlock(&Mutex);
+}
+
+uint32_t stubHttp_GetRequestCount(const char * pathPtr)
+{
+    Path_t * entryPtr;
+    uint32_t count;
+
+    pthread_mutex_lock(&Mutex);
+    entryPtr = FindPath(pathPtr);
+    count = entryPtr ? entryPtr->requestCount : 0;
+    pthread_mutex_unlock(&Mutex);
+
+    return count;
+}
+
+uint64_t stubHttp_GetLastRequestUs(const char * pathPtr)
+{
+    Path_t * entryPtr;
+    uint64_t timeUs;
+
+    pthread_mutex_lock(&Mutex);
+    entryPtr = FindPath(pathPtr);
+    timeUs = entryPtr ? entryPtr->lastRequestUs : 0;
+    pthread_mutex_unlock(&Mutex);
+
+    return timeUs;
+}
+
+uint32_t stubHttp_GetConnectionCount(void)
+{
+    uint32_t count;
+
+    pthread_mutex_lock(&Mutex);
+    count = ConnectionCount;
+    pthread_mutex_unlock(&Mutex);
+
+    return count;
+}
+
+size_t stubHttp_GetStreamCount(void)
+{
+    size_t count;
+
+    pthread_mutex_lock(&Mutex);
+    count = StreamCount;
+    pthread_mutex_unlock(&Mutex);
+
+    return count;
+}
+
+void stubHttp_SendEvent(const char * eventPtr, const char * dataPtr)
+{
+    char event[512];
+    int length = snprintf(event, sizeof(event), "event: %s\ndata: %s\n\n", eventPtr, dataPtr);
+    size_t i;
+
+    LE_ASSERT( (length > 0) && ((size_t) length < sizeof(event)) );
+
+    pthread_mutex_lock(&Mutex);
+    for (i = 0; i < StreamCount; i++)
+    {
+        SendAll(StreamFds[i], event, length);
+    }
+    pthread_mutex_unlock(&Mutex);
+}
+
+void stubHttp_DropStreams(void)
+{
+    size_t i;
+
+    // The threads of the streams see them closed, and close them
+    pthread_mutex_lock(&Mutex);
+    for (i = 0; i < StreamCount; i++)
+    {
+        shutdown(StreamFds[i], SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&Mutex);
+}
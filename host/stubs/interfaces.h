@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file interfaces.h
+ *
+ * Stand-in of the interfaces generated from Component.cdef for the host build. The services the
+ * component requires are stubbed by le_cfg.c, le_gpio.c, le_pm.c and le_dcs.c, and controlled by
+ * the tests and benchmarks through stubs.h.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef INTERFACES_H_INCLUDE_GUARD
+#define INTERFACES_H_INCLUDE_GUARD
+
+#include "legato.h"
+#include "le_cfg_interface.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Declares the le_gpio API as bound to one pin, e.g. le_gpioRed
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_GPIO_INTERFACE(pin, PIN)                                                          \
+    typedef enum                                                                               \
+    {                                                                                          \
+        LE_GPIO##PIN##_ACTIVE_HIGH,                                                            \
+        LE_GPIO##PIN##_ACTIVE_LOW,                                                             \
+    }                                                                                          \
+    le_gpio##pin##_Polarity_t;                                                                 \
+    le_result_t le_gpio##pin##_TryConnectService(void);                                        \
+    le_result_t le_gpio##pin##_SetPushPullOutput(le_gpio##pin##_Polarity_t polarity,           \
+                                                 bool value);                                  \
+    le_result_t le_gpio##pin##_Activate(void);                                                 \
+    le_result_t le_gpio##pin##_Deactivate(void);                                               \
+    le_result_t le_gpio##pin##_EnablePullUp(void);                                             \
+    bool le_gpio##pin##_Read(void);
+
+STUB_GPIO_INTERFACE(Red, RED)
+STUB_GPIO_INTERFACE(Yellow, YELLOW)
+STUB_GPIO_INTERFACE(Green, GREEN)
+STUB_GPIO_INTERFACE(Red2, RED2)
+STUB_GPIO_INTERFACE(Yellow2, YELLOW2)
+STUB_GPIO_INTERFACE(Green2, GREEN2)
+STUB_GPIO_INTERFACE(Red3, RED3)
+STUB_GPIO_INTERFACE(Yellow3, YELLOW3)
+STUB_GPIO_INTERFACE(Green3, GREEN3)
+
+//--------------------------------------------------------------------------------------------------
+// le_pm
+//--------------------------------------------------------------------------------------------------
+#define LE_PM_REF_COUNT 1
+
+typedef struct le_pm_WakeupSource * le_pm_WakeupSourceRef_t;
+
+le_pm_WakeupSourceRef_t le_pm_NewWakeupSource(uint32_t createOpts, const char * wsTag);
+le_result_t le_pm_StayAwake(le_pm_WakeupSourceRef_t wsRef);
+le_result_t le_pm_Relax(le_pm_WakeupSourceRef_t wsRef);
+
+//--------------------------------------------------------------------------------------------------
+// le_dcs
+//--------------------------------------------------------------------------------------------------
+#define LE_DCS_CHANNEL_NAME_MAX_LEN 32
+
+typedef struct le_dcs_Channel * le_dcs_ChannelRef_t;
+typedef struct le_dcs_ReqObj * le_dcs_ReqObjRef_t;
+typedef struct le_dcs_EventHandler * le_dcs_EventHandlerRef_t;
+
+typedef enum
+{
+    LE_DCS_TECH_UNKNOWN,
+    LE_DCS_TECH_WIFI,
+    LE_DCS_TECH_CELLULAR,
+    LE_DCS_TECH_ETHERNET,
+}
+le_dcs_Technology_t;
+
+typedef enum
+{
+    LE_DCS_STATE_DOWN,
+    LE_DCS_STATE_UP,
+}
+le_dcs_State_t;
+
+typedef enum
+{
+    LE_DCS_EVENT_UP,
+    LE_DCS_EVENT_DOWN,
+    LE_DCS_EVENT_TEMP_DOWN,
+}
+le_dcs_Event_t;
+
+typedef struct
+{
+    le_dcs_ChannelRef_t ref;
+    char name[LE_DCS_CHANNEL_NAME_MAX_LEN + 1];
+    le_dcs_Technology_t technology;
+    le_dcs_State_t state;
+}
+le_dcs_ChannelInfo_t;
+
+typedef void (*le_dcs_GetChannelsHandlerFunc_t)(le_result_t result,
+                                                const le_dcs_ChannelInfo_t * channelListPtr,
+                                                size_t channelListSize,
+                                                void * contextPtr);
+typedef void (*le_dcs_EventHandlerFunc_t)(le_dcs_ChannelRef_t channelRef,
+                                          le_dcs_Event_t event,
+                                          int32_t code,
+                                          void * contextPtr);
+
+void le_dcs_GetChannels(le_dcs_GetChannelsHandlerFunc_t handlerPtr, void * contextPtr);
+le_dcs_EventHandlerRef_t le_dcs_AddEventHandler(le_dcs_ChannelRef_t channelRef,
+                                                le_dcs_EventHandlerFunc_t handlerPtr,
+                                                void * contextPtr);
+void le_dcs_RemoveEventHandler(le_dcs_EventHandlerRef_t handlerRef);
+le_dcs_ReqObjRef_t le_dcs_Start(le_dcs_ChannelRef_t channelRef);
+le_result_t le_dcs_Stop(le_dcs_ReqObjRef_t reqRef);
+
+//--------------------------------------------------------------------------------------------------
+// trafficLight, as provided by the component, see interfaces/trafficLight.api
+//--------------------------------------------------------------------------------------------------
+#define TRAFFICLIGHT_MAX_MONITOR_NAME_LEN 63
+
+typedef enum
+{
+    TRAFFICLIGHT_STATE_FAIL,
+    TRAFFICLIGHT_STATE_WARNING,
+    TRAFFICLIGHT_STATE_PASS,
+    TRAFFICLIGHT_STATE_UNKNOWN,
+}
+trafficLight_State_t;
+
+typedef struct trafficLight_PollResultHandler * trafficLight_PollResultHandlerRef_t;
+typedef void (*trafficLight_PollResultHandlerFunc_t)(const char * monitor,
+                                                     int32_t httpCode,
+                                                     trafficLight_State_t state,
+                                                     uint32_t latencyMs,
+                                                     void * contextPtr);
+
+trafficLight_State_t trafficLight_GetState(void);
+uint32_t trafficLight_GetHistoryCount(void);
+le_result_t trafficLight_GetHistoryEntry(uint32_t index, uint64_t * timePtr, char * monitor,
+                                         size_t monitorSize, int32_t * httpCodePtr,
+                                         trafficLight_State_t * statePtr,
+                                         uint32_t * latencyMsPtr);
+trafficLight_PollResultHandlerRef_t trafficLight_AddPollResultHandler(
+    trafficLight_PollResultHandlerFunc_t handlerPtr, void * contextPtr);
+void trafficLight_RemovePollResultHandler(trafficLight_PollResultHandlerRef_t handlerRef);
+le_msg_ServiceRef_t trafficLight_GetServiceRef(void);
+le_msg_SessionRef_t trafficLight_GetClientSessionRef(void);
+
+#endif // INTERFACES_H_INCLUDE_GUARD
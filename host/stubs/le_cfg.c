@@ -0,0 +1,613 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file le_cfg.c
+ *
+ * Stub of the config tree for the host build: a single in-memory tree, the tree name before ':'
+ * in the paths is ignored. Values are kept as strings with their type. The writes of a write
+ * transaction apply right away, a commit then queues the change handlers of the paths it wrote,
+ * and the values set by stubCfg_Set* queue them too.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stubs.h"
+
+// Longest absolute path in the tree
+#define MAX_PATH_BYTES 512
+
+// Most change handlers
+#define MAX_CHANGE_HANDLERS 32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Node of the tree
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct Node
+{
+    char name[LE_CFG_NAME_LEN_BYTES];   ///< Name, "" for the root
+    le_cfg_nodeType_t type;             ///< Type, LE_CFG_TYPE_STEM if it has children
+    char value[LE_CFG_STR_LEN_BYTES];   ///< Value, as a string
+    struct Node * parentPtr;            ///< Parent, NULL for the root
+    struct Node * firstChildPtr;        ///< First child
+    struct Node * nextSiblingPtr;       ///< Next child of the parent
+}
+Node_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Transaction: the node it is at, as an absolute path since it may not exist
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_cfg_Iterator
+{
+    char path[MAX_PATH_BYTES];          ///< Absolute path of the current node, without '/' at end
+    bool isWrite;                       ///< Whether it is a write transaction
+    bool isChanged[MAX_CHANGE_HANDLERS];    ///< Change handlers to call on commit
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change handler
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_cfg_ChangeHandler
+{
+    bool isUsed;                        ///< Whether the entry is used
+    char path[MAX_PATH_BYTES];          ///< Path watched, with its subtree
+    le_cfg_ChangeHandlerFunc_t handler; ///< Called after a change
+    void * contextPtr;                  ///< Passed to the handler
+};
+
+static Node_t Root = { .type = LE_CFG_TYPE_STEM };
+static struct le_cfg_ChangeHandler ChangeHandlers[MAX_CHANGE_HANDLERS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Makes an absolute path, without tree name or '/' at end, from a base and a relative path that
+ * may contain ".."
+ */
+//--------------------------------------------------------------------------------------------------
+static void JoinPath
+(
+    char * outPtr,                  ///< [OUT] Absolute path, MAX_PATH_BYTES
+    const char * basePtr,           ///< [IN] Absolute base path
+    const char * pathPtr            ///< [IN] Relative path, or absolute path
+)
+{
+    char buffer[MAX_PATH_BYTES];
+    const char * colonPtr = strchr(pathPtr, ':');
+    char * savePtr;
+    char * namePtr;
+
+    if (colonPtr)
+    {
+        pathPtr = colonPtr + 1;
+    }
+
+    if (pathPtr[0] == '/')
+    {
+        outPtr[0] = '\0';
+    }
+    else
+    {
+        le_utf8_Copy(outPtr, basePtr, MAX_PATH_BYTES, NULL);
+    }
+
+    le_utf8_Copy(buffer, pathPtr, sizeof(buffer), NULL);
+    for (namePtr = strtok_r(buffer, "/", &savePtr);
+         namePtr;
+         namePtr = strtok_r(NULL, "/", &savePtr))
+    {
+        if (strcmp(namePtr, "..") == 0)
+        {
+            char * slashPtr = strrchr(outPtr, '/');
+
+            if (slashPtr)
+            {
+                *slashPtr = '\0';
+            }
+        }
+        else if (strcmp(namePtr, ".") != 0)
+        {
+            size_t length = strlen(outPtr);
+
+            snprintf(outPtr + length, MAX_PATH_BYTES - length, "/%s", namePtr);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finds the node of an absolute path, creating it and its parents if asked to
+ *
+ * @return
+ *      Node, NULL if it does not exist and is not created
+ */
+//--------------------------------------------------------------------------------------------------
+static Node_t * FindNode
+(
+    const char * pathPtr,           ///< [IN] Absolute path, from JoinPath
+    bool isCreated                  ///< [IN] Whether to create the missing nodes
+)
+{
+    char buffer[MAX_PATH_BYTES];
+    Node_t * nodePtr = &Root;
+    char * savePtr;
+    char * namePtr;
+
+    le_utf8_Copy(buffer, pathPtr, sizeof(buffer), NULL);
+    for (namePtr = strtok_r(buffer, "/", &savePtr);
+         namePtr;
+         namePtr = strtok_r(NULL, "/", &savePtr))
+    {
+        Node_t ** childPtrPtr = &nodePtr->firstChildPtr;
+
+        while (*childPtrPtr && (strcmp((*childPtrPtr)->name, namePtr) != 0))
+        {
+            childPtrPtr = &(*childPtrPtr)->nextSiblingPtr;
+        }
+
+        if (*childPtrPtr == NULL)
+        {
+            if (!isCreated)
+            {
+                return NULL;
+            }
+
+            *childPtrPtr = calloc(1, sizeof(Node_t));
+            LE_ASSERT(*childPtrPtr);
+            le_utf8_Copy((*childPtrPtr)->name, namePtr, sizeof((*childPtrPtr)->name), NULL);
+            (*childPtrPtr)->type = LE_CFG_TYPE_EMPTY;
+            (*childPtrPtr)->parentPtr = nodePtr;
+            nodePtr->type = LE_CFG_TYPE_STEM;
+        }
+
+        nodePtr = *childPtrPtr;
+    }
+
+    return nodePtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Frees a node and its subtree, once unlinked from its parent
+ */
+//--------------------------------------------------------------------------------------------------
+static void FreeNode
+(
+    Node_t * nodePtr
+)
+{
+    while (nodePtr->firstChildPtr)
+    {
+        Node_t * childPtr = nodePtr->firstChildPtr;
+
+        nodePtr->firstChildPtr = childPtr->nextSiblingPtr;
+        FreeNode(childPtr);
+    }
+    free(nodePtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Calls a change handler, queued on commit
+ */
+//--------------------------------------------------------------------------------------------------
+static void CallChangeHandler
+(
+    void * param1Ptr,               ///< [IN] Change handler
+    void * param2Ptr                ///< [IN] Unused
+)
+{
+    struct le_cfg_ChangeHandler * handlerPtr = param1Ptr;
+
+    if (handlerPtr->isUsed)
+    {
+        handlerPtr->handler(handlerPtr->contextPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Marks the change handlers watching a path, or a node below or above it, as to be called
+ */
+//--------------------------------------------------------------------------------------------------
+static void MarkChanged
+(
+    bool * isChangedPtr,            ///< [IN/OUT] Handlers to call, MAX_CHANGE_HANDLERS
+    const char * pathPtr            ///< [IN] Absolute path written
+)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_CHANGE_HANDLERS; i++)
+    {
+        const char * watchedPtr = ChangeHandlers[i].path;
+        size_t watchedLength = strlen(watchedPtr);
+        size_t length = strlen(pathPtr);
+        size_t common = (watchedLength < length) ? watchedLength : length;
+
+        if ( ChangeHandlers[i].isUsed &&
+             (strncmp(watchedPtr, pathPtr, common) == 0) &&
+             ( (watchedPtr[common] == '\0') || (watchedPtr[common] == '/') ) &&
+             ( (pathPtr[common] == '\0') || (pathPtr[common] == '/') ) )
+        {
+            isChangedPtr[i] = true;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues the change handlers marked
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueChangeHandlers
+(
+    bool * isChangedPtr             ///< [IN/OUT] Handlers to call, cleared
+)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_CHANGE_HANDLERS; i++)
+    {
+        if (isChangedPtr[i])
+        {
+            isChangedPtr[i] = false;
+            le_event_QueueFunction(CallChangeHandler, &ChangeHandlers[i], NULL);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the value of a node
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetValue
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Write transaction, NULL for stubCfg_Set*
+    const char * pathPtr,               ///< [IN] Path, absolute if no transaction
+    le_cfg_nodeType_t type,             ///< [IN] Type of the value
+    const char * valuePtr               ///< [IN] Value, as a string
+)
+{
+    char path[MAX_PATH_BYTES];
+    Node_t * nodePtr;
+
+    JoinPath(path, iteratorRef ? iteratorRef->path : "", pathPtr);
+    nodePtr = FindNode(path, true);
+
+    LE_FATAL_IF(iteratorRef && !iteratorRef->isWrite, "Write to %s in a read transaction", path);
+    LE_FATAL_IF(nodePtr->firstChildPtr, "Value written to stem %s", path);
+
+    nodePtr->type = type;
+    le_utf8_Copy(nodePtr->value, valuePtr, sizeof(nodePtr->value), NULL);
+
+    if (iteratorRef)
+    {
+        MarkChanged(iteratorRef->isChanged, path);
+    }
+    else
+    {
+        bool isChanged[MAX_CHANGE_HANDLERS] = { false };
+
+        MarkChanged(isChanged, path);
+        QueueChangeHandlers(isChanged);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the value of a node
+ *
+ * @return
+ *      Value, NULL if the node has no value of this type
+ */
+//--------------------------------------------------------------------------------------------------
+static const char * GetValue
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Transaction
+    const char * pathPtr,               ///< [IN] Path
+    le_cfg_nodeType_t type              ///< [IN] Type of the value
+)
+{
+    char path[MAX_PATH_BYTES];
+    Node_t * nodePtr;
+
+    JoinPath(path, iteratorRef->path, pathPtr);
+    nodePtr = FindNode(path, false);
+
+    if ( (nodePtr == NULL) || (nodePtr->type != type) )
+    {
+        return NULL;
+    }
+
+    return nodePtr->value;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Transactions
+//--------------------------------------------------------------------------------------------------
+static le_cfg_IteratorRef_t CreateTxn
+(
+    const char * basePath,
+    bool isWrite
+)
+{
+    le_cfg_IteratorRef_t iteratorRef = calloc(1, sizeof(*iteratorRef));
+
+    LE_ASSERT(iteratorRef);
+    JoinPath(iteratorRef->path, "", basePath);
+    iteratorRef->isWrite = isWrite;
+    return iteratorRef;
+}
+
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn(const char * basePath)
+{
+    return CreateTxn(basePath, false);
+}
+
+le_cfg_IteratorRef_t le_cfg_CreateWriteTxn(const char * basePath)
+{
+    return CreateTxn(basePath, true);
+}
+
+void le_cfg_CommitTxn(le_cfg_IteratorRef_t iteratorRef)
+{
+    QueueChangeHandlers(iteratorRef->isChanged);
+    free(iteratorRef);
+}
+
+void le_cfg_CancelTxn(le_cfg_IteratorRef_t iteratorRef)
+{
+    free(iteratorRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Navigation
+//--------------------------------------------------------------------------------------------------
+void le_cfg_GoToNode(le_cfg_IteratorRef_t iteratorRef, const char * newPath)
+{
+    char path[MAX_PATH_BYTES];
+
+    JoinPath(path, iteratorRef->path, newPath);
+    le_utf8_Copy(iteratorRef->path, path, sizeof(iteratorRef->path), NULL);
+}
+
+le_result_t le_cfg_GoToParent(le_cfg_IteratorRef_t iteratorRef)
+{
+    char * slashPtr = strrchr(iteratorRef->path, '/');
+
+    if (slashPtr == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    *slashPtr = '\0';
+    return LE_OK;
+}
+
+le_result_t le_cfg_GoToFirstChild(le_cfg_IteratorRef_t iteratorRef)
+{
+    Node_t * nodePtr = FindNode(iteratorRef->path, false);
+    size_t length = strlen(iteratorRef->path);
+
+    if ( (nodePtr == NULL) || (nodePtr->firstChildPtr == NULL) )
+    {
+        return LE_NOT_FOUND;
+    }
+
+    snprintf(iteratorRef->path + length,
+             sizeof(iteratorRef->path) - length,
+             "/%s",
+             nodePtr->firstChildPtr->name);
+    return LE_OK;
+}
+
+le_result_t le_cfg_GoToNextSibling(le_cfg_IteratorRef_t iteratorRef)
+{
+    Node_t * nodePtr = FindNode(iteratorRef->path, false);
+    char * slashPtr = strrchr(iteratorRef->path, '/');
+
+    if ( (nodePtr == NULL) || (nodePtr->nextSiblingPtr == NULL) || (slashPtr == NULL) )
+    {
+        return LE_NOT_FOUND;
+    }
+
+    snprintf(slashPtr + 1,
+             sizeof(iteratorRef->path) - (slashPtr + 1 - iteratorRef->path),
+             "%s",
+             nodePtr->nextSiblingPtr->name);
+    return LE_OK;
+}
+
+le_cfg_nodeType_t le_cfg_GetNodeType(le_cfg_IteratorRef_t iteratorRef, const char * path)
+{
+    char fullPath[MAX_PATH_BYTES];
+    Node_t * nodePtr;
+
+    JoinPath(fullPath, iteratorRef->path, path);
+    nodePtr = FindNode(fullPath, false);
+
+    return nodePtr ? nodePtr->type : LE_CFG_TYPE_DOESNT_EXIST;
+}
+
+le_result_t le_cfg_GetNodeName(le_cfg_IteratorRef_t iteratorRef, const char * path, char * name,
+                               size_t nameSize)
+{
+    char fullPath[MAX_PATH_BYTES];
+    const char * slashPtr;
+
+    JoinPath(fullPath, iteratorRef->path, path);
+    slashPtr = strrchr(fullPath, '/');
+
+    return le_utf8_Copy(name, slashPtr ? slashPtr + 1 : "", nameSize, NULL);
+}
+
+bool le_cfg_NodeExists(le_cfg_IteratorRef_t iteratorRef, const char * path)
+{
+    return le_cfg_GetNodeType(iteratorRef, path) != LE_CFG_TYPE_DOESNT_EXIST;
+}
+
+void le_cfg_DeleteNode(le_cfg_IteratorRef_t iteratorRef, const char * path)
+{
+    char fullPath[MAX_PATH_BYTES];
+    Node_t * nodePtr;
+    Node_t ** linkPtrPtr;
+
+    JoinPath(fullPath, iteratorRef->path, path);
+    nodePtr = FindNode(fullPath, false);
+    if ( (nodePtr == NULL) || (nodePtr == &Root) )
+    {
+        return;
+    }
+
+    linkPtrPtr = &nodePtr->parentPtr->firstChildPtr;
+    while (*linkPtrPtr != nodePtr)
+    {
+        linkPtrPtr = &(*linkPtrPtr)->nextSiblingPtr;
+    }
+    *linkPtrPtr = nodePtr->nextSiblingPtr;
+    FreeNode(nodePtr);
+
+    MarkChanged(iteratorRef->isChanged, fullPath);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Values
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GetString(le_cfg_IteratorRef_t iteratorRef, const char * path, char * value,
+                             size_t valueSize, const char * defaultValue)
+{
+    const char * valuePtr = GetValue(iteratorRef, path, LE_CFG_TYPE_STRING);
+
+    return le_utf8_Copy(value, valuePtr ? valuePtr : defaultValue, valueSize, NULL);
+}
+
+void le_cfg_SetString(le_cfg_IteratorRef_t iteratorRef, const char * path, const char * value)
+{
+    SetValue(iteratorRef, path, LE_CFG_TYPE_STRING, value);
+}
+
+int32_t le_cfg_GetInt(le_cfg_IteratorRef_t iteratorRef, const char * path, int32_t defaultValue)
+{
+    const char * valuePtr = GetValue(iteratorRef, path, LE_CFG_TYPE_INT);
+
+    return valuePtr ? (int32_t) strtol(valuePtr, NULL, 10) : defaultValue;
+}
+
+void le_cfg_SetInt(le_cfg_IteratorRef_t iteratorRef, const char * path, int32_t value)
+{
+    char buffer[16];
+
+    snprintf(buffer, sizeof(buffer), "%" PRId32, value);
+    SetValue(iteratorRef, path, LE_CFG_TYPE_INT, buffer);
+}
+
+double le_cfg_GetFloat(le_cfg_IteratorRef_t iteratorRef, const char * path, double defaultValue)
+{
+    const char * valuePtr = GetValue(iteratorRef, path, LE_CFG_TYPE_FLOAT);
+
+    return valuePtr ? strtod(valuePtr, NULL) : defaultValue;
+}
+
+void le_cfg_SetFloat(le_cfg_IteratorRef_t iteratorRef, const char * path, double value)
+{
+    char buffer[32];
+
+    // As the config tree, which keeps floats with 6 decimals
+    snprintf(buffer, sizeof(buffer), "%f", value);
+    SetValue(iteratorRef, path, LE_CFG_TYPE_FLOAT, buffer);
+}
+
+bool le_cfg_GetBool(le_cfg_IteratorRef_t iteratorRef, const char * path, bool defaultValue)
+{
+    const char * valuePtr = GetValue(iteratorRef, path, LE_CFG_TYPE_BOOL);
+
+    return valuePtr ? (strcmp(valuePtr, "true") == 0) : defaultValue;
+}
+
+void le_cfg_SetBool(le_cfg_IteratorRef_t iteratorRef, const char * path, bool value)
+{
+    SetValue(iteratorRef, path, LE_CFG_TYPE_BOOL, value ? "true" : "false");
+}
+
+//--------------------------------------------------------------------------------------------------
+// Change handlers
+//--------------------------------------------------------------------------------------------------
+le_cfg_ChangeHandlerRef_t le_cfg_AddChangeHandler(const char * newPath,
+                                                  le_cfg_ChangeHandlerFunc_t handlerPtr,
+                                                  void * contextPtr)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_CHANGE_HANDLERS; i++)
+    {
+        if (!ChangeHandlers[i].isUsed)
+        {
+            ChangeHandlers[i].isUsed = true;
+            JoinPath(ChangeHandlers[i].path, "", newPath);
+            ChangeHandlers[i].handler = handlerPtr;
+            ChangeHandlers[i].contextPtr = contextPtr;
+            return &ChangeHandlers[i];
+        }
+    }
+
+    LE_FATAL("Too many change handlers, %s not watched", newPath);
+}
+
+void le_cfg_RemoveChangeHandler(le_cfg_ChangeHandlerRef_t handlerRef)
+{
+    handlerRef->isUsed = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Control of the stub, see stubs.h
+//--------------------------------------------------------------------------------------------------
+void stubCfg_SetString(const char * pathPtr, const char * valuePtr)
+{
+    SetValue(NULL, pathPtr, LE_CFG_TYPE_STRING, valuePtr);
+}
+
+void stubCfg_SetInt(const char * pathPtr, int32_t value)
+{
+    char buffer[16];
+
+    snprintf(buffer, sizeof(buffer), "%" PRId32, value);
+    SetValue(NULL, pathPtr, LE_CFG_TYPE_INT, buffer);
+}
+
+void stubCfg_SetFloat(const char * pathPtr, double value)
+{
+    char buffer[32];
+
+    snprintf(buffer, sizeof(buffer), "%f", value);
+    SetValue(NULL, pathPtr, LE_CFG_TYPE_FLOAT, buffer);
+}
+
+void stubCfg_SetBool(const char * pathPtr, bool value)
+{
+    SetValue(NULL, pathPtr, LE_CFG_TYPE_BOOL, value ? "true" : "false");
+}
+
+void stubCfg_Delete(const char * pathPtr)
+{
+    le_cfg_IteratorRef_t iteratorRef = le_cfg_CreateWriteTxn("/");
+
+    le_cfg_DeleteNode(iteratorRef, pathPtr);
+    le_cfg_CommitTxn(iteratorRef);
+}
+
+const char * stubCfg_Get(const char * pathPtr)
+{
+    char path[MAX_PATH_BYTES];
+    Node_t * nodePtr;
+
+    JoinPath(path, "", pathPtr);
+    nodePtr = FindNode(path, false);
+
+    return (nodePtr && (nodePtr->type != LE_CFG_TYPE_STEM)) ? nodePtr->value : NULL;
+}
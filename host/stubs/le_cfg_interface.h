@@ -0,0 +1,64 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file le_cfg_interface.h
+ *
+ * Stand-in of the config tree API for the host build, implemented by le_cfg.c over an in-memory
+ * tree. Writes apply right away, a committed write transaction then calls the change handlers of
+ * the paths it wrote.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LE_CFG_INTERFACE_H_INCLUDE_GUARD
+#define LE_CFG_INTERFACE_H_INCLUDE_GUARD
+
+#include "legato.h"
+
+#define LE_CFG_STR_LEN 511
+#define LE_CFG_STR_LEN_BYTES 512
+#define LE_CFG_NAME_LEN 127
+#define LE_CFG_NAME_LEN_BYTES 128
+
+typedef struct le_cfg_Iterator * le_cfg_IteratorRef_t;
+typedef struct le_cfg_ChangeHandler * le_cfg_ChangeHandlerRef_t;
+typedef void (*le_cfg_ChangeHandlerFunc_t)(void * contextPtr);
+
+typedef enum
+{
+    LE_CFG_TYPE_EMPTY,
+    LE_CFG_TYPE_STRING,
+    LE_CFG_TYPE_BOOL,
+    LE_CFG_TYPE_INT,
+    LE_CFG_TYPE_FLOAT,
+    LE_CFG_TYPE_STEM,
+    LE_CFG_TYPE_DOESNT_EXIST,
+}
+le_cfg_nodeType_t;
+
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn(const char * basePath);
+le_cfg_IteratorRef_t le_cfg_CreateWriteTxn(const char * basePath);
+void le_cfg_CommitTxn(le_cfg_IteratorRef_t iteratorRef);
+void le_cfg_CancelTxn(le_cfg_IteratorRef_t iteratorRef);
+void le_cfg_GoToNode(le_cfg_IteratorRef_t iteratorRef, const char * newPath);
+le_result_t le_cfg_GoToParent(le_cfg_IteratorRef_t iteratorRef);
+le_result_t le_cfg_GoToFirstChild(le_cfg_IteratorRef_t iteratorRef);
+le_result_t le_cfg_GoToNextSibling(le_cfg_IteratorRef_t iteratorRef);
+le_cfg_nodeType_t le_cfg_GetNodeType(le_cfg_IteratorRef_t iteratorRef, const char * path);
+le_result_t le_cfg_GetNodeName(le_cfg_IteratorRef_t iteratorRef, const char * path, char * name,
+                               size_t nameSize);
+bool le_cfg_NodeExists(le_cfg_IteratorRef_t iteratorRef, const char * path);
+void le_cfg_DeleteNode(le_cfg_IteratorRef_t iteratorRef, const char * path);
+le_result_t le_cfg_GetString(le_cfg_IteratorRef_t iteratorRef, const char * path, char * value,
+                             size_t valueSize, const char * defaultValue);
+void le_cfg_SetString(le_cfg_IteratorRef_t iteratorRef, const char * path, const char * value);
+int32_t le_cfg_GetInt(le_cfg_IteratorRef_t iteratorRef, const char * path, int32_t defaultValue);
+void le_cfg_SetInt(le_cfg_IteratorRef_t iteratorRef, const char * path, int32_t value);
+double le_cfg_GetFloat(le_cfg_IteratorRef_t iteratorRef, const char * path, double defaultValue);
+void le_cfg_SetFloat(le_cfg_IteratorRef_t iteratorRef, const char * path, double value);
+bool le_cfg_GetBool(le_cfg_IteratorRef_t iteratorRef, const char * path, bool defaultValue);
+void le_cfg_SetBool(le_cfg_IteratorRef_t iteratorRef, const char * path, bool value);
+le_cfg_ChangeHandlerRef_t le_cfg_AddChangeHandler(const char * newPath,
+                                                  le_cfg_ChangeHandlerFunc_t handlerPtr,
+                                                  void * contextPtr);
+void le_cfg_RemoveChangeHandler(le_cfg_ChangeHandlerRef_t handlerRef);
+
+#endif // LE_CFG_INTERFACE_H_INCLUDE_GUARD
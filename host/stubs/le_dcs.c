@@ -0,0 +1,234 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file le_dcs.c
+ *
+ * Stub of the data connection service for the host build. The channels are added and brought up
+ * or down by the tests, the list and the events are delivered through the event loop as le_dcs
+ * does, and the requests of each channel are counted.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stubs.h"
+
+// Most channels and event handlers
+#define MAX_CHANNELS 8
+#define MAX_DCS_HANDLERS 16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Channel
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_dcs_Channel
+{
+    le_dcs_ChannelInfo_t info;          ///< As listed
+    uint32_t requestCount;              ///< Requests not stopped
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request of a channel
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_dcs_ReqObj
+{
+    bool isUsed;                        ///< Whether the request is not stopped
+    le_dcs_ChannelRef_t channelRef;     ///< Channel requested
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event handler of a channel
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_dcs_EventHandler
+{
+    bool isUsed;                        ///< Whether the entry is used
+    le_dcs_ChannelRef_t channelRef;     ///< Channel
+    le_dcs_EventHandlerFunc_t handler;  ///< Handler
+    void * contextPtr;                  ///< Passed to the handler
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event queued to the handlers
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_dcs_ChannelRef_t channelRef;     ///< Channel
+    le_dcs_Event_t event;               ///< Event
+}
+ChannelEvent_t;
+
+static struct le_dcs_Channel Channels[MAX_CHANNELS];
+static size_t ChannelCount = 0;
+static struct le_dcs_ReqObj Requests[MAX_CHANNELS * 4];
+static struct le_dcs_EventHandler Handlers[MAX_DCS_HANDLERS];
+static le_result_t QueryResult = LE_OK;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Calls the handler of a channel list, queued by le_dcs_GetChannels
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReplyChannels
+(
+    void * param1Ptr,               ///< [IN] Handler
+    void * param2Ptr                ///< [IN] Its context
+)
+{
+    le_dcs_GetChannelsHandlerFunc_t handlerPtr = (le_dcs_GetChannelsHandlerFunc_t) param1Ptr;
+    le_dcs_ChannelInfo_t list[MAX_CHANNELS];
+    size_t i;
+
+    for (i = 0; i < ChannelCount; i++)
+    {
+        list[i] = Channels[i].info;
+    }
+
+    handlerPtr(QueryResult, list, (QueryResult == LE_OK) ? ChannelCount : 0, param2Ptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Calls the handlers of a channel event, queued by stubDcs_SetUp
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReportEvent
+(
+    void * param1Ptr,               ///< [IN] ChannelEvent_t, freed here
+    void * param2Ptr                ///< [IN] Unused
+)
+{
+    ChannelEvent_t * eventPtr = param1Ptr;
+    size_t i;
+
+    for (i = 0; i < MAX_DCS_HANDLERS; i++)
+    {
+        if (Handlers[i].isUsed && (Handlers[i].channelRef == eventPtr->channelRef))
+        {
+            Handlers[i].handler(eventPtr->channelRef, eventPtr->event, 0, Handlers[i].contextPtr);
+        }
+    }
+
+    free(eventPtr);
+}
+
+void le_dcs_GetChannels(le_dcs_GetChannelsHandlerFunc_t handlerPtr, void * contextPtr)
+{
+    le_event_QueueFunction(ReplyChannels, (void *) handlerPtr, contextPtr);
+}
+
+le_dcs_EventHandlerRef_t le_dcs_AddEventHandler(le_dcs_ChannelRef_t channelRef,
+                                                le_dcs_EventHandlerFunc_t handlerPtr,
+                                                void * contextPtr)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_DCS_HANDLERS; i++)
+    {
+        if (!Handlers[i].isUsed)
+        {
+            Handlers[i].isUsed = true;
+            Handlers[i].channelRef = channelRef;
+            Handlers[i].handler = handlerPtr;
+            Handlers[i].contextPtr = contextPtr;
+            return &Handlers[i];
+        }
+    }
+
+    LE_FATAL("Too many channel event handlers");
+}
+
+void le_dcs_RemoveEventHandler(le_dcs_EventHandlerRef_t handlerRef)
+{
+    LE_FATAL_IF(!handlerRef->isUsed, "Channel event handler %p already removed", handlerRef);
+    handlerRef->isUsed = false;
+}
+
+le_dcs_ReqObjRef_t le_dcs_Start(le_dcs_ChannelRef_t channelRef)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(Requests); i++)
+    {
+        if (!Requests[i].isUsed)
+        {
+            Requests[i].isUsed = true;
+            Requests[i].channelRef = channelRef;
+            channelRef->requestCount++;
+            return &Requests[i];
+        }
+    }
+
+    return NULL;
+}
+
+le_result_t le_dcs_Stop(le_dcs_ReqObjRef_t reqRef)
+{
+    if (!reqRef->isUsed)
+    {
+        return LE_FAULT;
+    }
+
+    reqRef->isUsed = false;
+    reqRef->channelRef->requestCount--;
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Control of the stub, see stubs.h
+//--------------------------------------------------------------------------------------------------
+le_dcs_ChannelRef_t stubDcs_AddChannel(const char * namePtr, le_dcs_Technology_t technology,
+                                       bool isUp)
+{
+    le_dcs_ChannelRef_t channelRef;
+
+    LE_ASSERT(ChannelCount < MAX_CHANNELS);
+
+    channelRef = &Channels[ChannelCount++];
+    channelRef->info.ref = channelRef;
+    le_utf8_Copy(channelRef->info.name, namePtr, sizeof(channelRef->info.name), NULL);
+    channelRef->info.technology = technology;
+    channelRef->info.state = isUp ? LE_DCS_STATE_UP : LE_DCS_STATE_DOWN;
+    return channelRef;
+}
+
+void stubDcs_SetUp(le_dcs_ChannelRef_t channelRef, bool isUp)
+{
+    ChannelEvent_t * eventPtr = malloc(sizeof(*eventPtr));
+
+    LE_ASSERT(eventPtr);
+    channelRef->info.state = isUp ? LE_DCS_STATE_UP : LE_DCS_STATE_DOWN;
+    eventPtr->channelRef = channelRef;
+    eventPtr->event = isUp ? LE_DCS_EVENT_UP : LE_DCS_EVENT_DOWN;
+    le_event_QueueFunction(ReportEvent, eventPtr, NULL);
+}
+
+uint32_t stubDcs_GetRequestCount(le_dcs_ChannelRef_t channelRef)
+{
+    return channelRef->requestCount;
+}
+
+size_t stubDcs_GetHandlerCount(le_dcs_ChannelRef_t channelRef)
+{
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < MAX_DCS_HANDLERS; i++)
+    {
+        if (Handlers[i].isUsed && (Handlers[i].channelRef == channelRef))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+void stubDcs_SetQueryResult(le_result_t result)
+{
+    QueryResult = result;
+}
@@ -0,0 +1,156 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file le_gpio.c
+ *
+ * Stub of the GPIO pins of the towers for the host build. The level of each pin is kept, and each
+ * write is recorded with its time so that the tests can check what the lights showed and when.
+ * The pins of the additional towers are only bound once stubGpio_Bind is called.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stubs.h"
+
+// Most writes recorded, the later ones are counted but not recorded
+#define MAX_GPIO_WRITES 65536
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pin
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isActive;          ///< Whether it is activated
+    bool value;             ///< Level written last
+    uint32_t writeCount;    ///< Number of writes
+}
+Pin_t;
+
+static Pin_t Pins[STUB_GPIO_PIN_COUNT];
+static bool IsBound[STUB_GPIO_PIN_COUNT / 3] = { true };
+
+static stubGpio_Write_t Writes[MAX_GPIO_WRITES];
+static size_t WriteCount = 0;
+
+static stubGpio_WriteHandlerFunc_t WriteHandlerPtr = NULL;
+static void * WriteContextPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records the write of a pin
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Write
+(
+    stubGpio_Pin_t pin,
+    bool value
+)
+{
+    Pins[pin].value = value;
+    Pins[pin].writeCount++;
+
+    if (WriteCount < MAX_GPIO_WRITES)
+    {
+        Writes[WriteCount].timeUs = stubClk_GetUs();
+        Writes[WriteCount].pin = pin;
+        Writes[WriteCount].value = value;
+        WriteCount++;
+    }
+
+    if (WriteHandlerPtr)
+    {
+        WriteHandlerPtr(pin, value, WriteContextPtr);
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Defines the le_gpio API bound to one pin
+ */
+//--------------------------------------------------------------------------------------------------
+#define STUB_GPIO_PIN(pin, index)                                                              \
+    le_result_t le_gpio##pin##_TryConnectService(void)                                         \
+    {                                                                                          \
+        return IsBound[(index) / 3] ? LE_OK : LE_UNAVAILABLE;                                  \
+    }                                                                                          \
+    le_result_t le_gpio##pin##_SetPushPullOutput(le_gpio##pin##_Polarity_t polarity,           \
+                                                 bool value)                                   \
+    {                                                                                          \
+        return Write(index, value);                                                            \
+    }                                                                                          \
+    le_result_t le_gpio##pin##_Activate(void)                                                  \
+    {                                                                                          \
+        Pins[index].isActive = true;                                                           \
+        return LE_OK;                                                                          \
+    }                                                                                          \
+    le_result_t le_gpio##pin##_Deactivate(void)                                                \
+    {                                                                                          \
+        Pins[index].isActive = false;                                                          \
+        return LE_OK;                                                                          \
+    }                                                                                          \
+    le_result_t le_gpio##pin##_EnablePullUp(void)                                              \
+    {                                                                                          \
+        return LE_OK;                                                                          \
+    }                                                                                          \
+    bool le_gpio##pin##_Read(void)                                                             \
+    {                                                                                          \
+        return Pins[index].value;                                                              \
+    }
+
+STUB_GPIO_PIN(Red, STUB_GPIO_RED)
+STUB_GPIO_PIN(Yellow, STUB_GPIO_YELLOW)
+STUB_GPIO_PIN(Green, STUB_GPIO_GREEN)
+STUB_GPIO_PIN(Red2, STUB_GPIO_RED2)
+STUB_GPIO_PIN(Yellow2, STUB_GPIO_YELLOW2)
+STUB_GPIO_PIN(Green2, STUB_GPIO_GREEN2)
+STUB_GPIO_PIN(Red3, STUB_GPIO_RED3)
+STUB_GPIO_PIN(Yellow3, STUB_GPIO_YELLOW3)
+STUB_GPIO_PIN(Green3, STUB_GPIO_GREEN3)
+
+//--------------------------------------------------------------------------------------------------
+// Control of the stub, see stubs.h
+//--------------------------------------------------------------------------------------------------
+void stubGpio_Bind(size_t tower)
+{
+    LE_ASSERT(tower < NUM_ARRAY_MEMBERS(IsBound));
+    IsBound[tower] = true;
+}
+
+bool stubGpio_Get(stubGpio_Pin_t pin)
+{
+    return Pins[pin].value;
+}
+
+bool stubGpio_IsActive(stubGpio_Pin_t pin)
+{
+    return Pins[pin].isActive;
+}
+
+uint32_t stubGpio_GetPinWriteCount(stubGpio_Pin_t pin)
+{
+    return Pins[pin].writeCount;
+}
+
+size_t stubGpio_GetWriteCount(void)
+{
+    return WriteCount;
+}
+
+const stubGpio_Write_t * stubGpio_GetWrite(size_t index)
+{
+    return (index < WriteCount) ? &Writes[index] : NULL;
+}
+
+void stubGpio_ClearWrites(void)
+{
+    WriteCount = 0;
+}
+
+void stubGpio_SetWriteHandler(stubGpio_WriteHandlerFunc_t handlerPtr, void * contextPtr)
+{
+    WriteHandlerPtr = handlerPtr;
+    WriteContextPtr = contextPtr;
+}
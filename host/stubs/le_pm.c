@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file le_pm.c
+ *
+ * Stub of the power manager for the host build: counts how the wakeup source is held and
+ * released, and for how long it is held.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stubs.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wakeup source, reference counted as created with LE_PM_REF_COUNT
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_pm_WakeupSource
+{
+    char tag[32];           ///< Tag
+    bool isRefCounted;      ///< Whether each StayAwake needs its Relax
+    uint32_t holdCount;     ///< Holds not released
+};
+
+static struct le_pm_WakeupSource WakeupSource;
+static bool IsCreated = false;
+
+static uint32_t StayAwakeCount = 0;
+static uint32_t RelaxCount = 0;
+static uint64_t HeldSinceUs = 0;
+static uint64_t HeldUs = 0;
+
+le_pm_WakeupSourceRef_t le_pm_NewWakeupSource(uint32_t createOpts, const char * wsTag)
+{
+    LE_FATAL_IF(IsCreated, "Only one wakeup source is stubbed");
+
+    IsCreated = true;
+    le_utf8_Copy(WakeupSource.tag, wsTag, sizeof(WakeupSource.tag), NULL);
+    WakeupSource.isRefCounted = (createOpts & LE_PM_REF_COUNT) != 0;
+    return &WakeupSource;
+}
+
+le_result_t le_pm_StayAwake(le_pm_WakeupSourceRef_t wsRef)
+{
+    LE_ASSERT(wsRef == &WakeupSource);
+
+    StayAwakeCount++;
+    if (wsRef->holdCount == 0)
+    {
+        HeldSinceUs = stubClk_GetUs();
+    }
+    if ( (wsRef->holdCount == 0) || wsRef->isRefCounted )
+    {
+        wsRef->holdCount++;
+    }
+    return LE_OK;
+}
+
+le_result_t le_pm_Relax(le_pm_WakeupSourceRef_t wsRef)
+{
+    LE_ASSERT(wsRef == &WakeupSource);
+
+    RelaxCount++;
+    if (wsRef->holdCount == 0)
+    {
+        LE_ERROR("Wakeup source %s released while not held", wsRef->tag);
+        return LE_FAULT;
+    }
+
+    wsRef->holdCount--;
+    if (wsRef->holdCount == 0)
+    {
+        HeldUs += stubClk_GetUs() - HeldSinceUs;
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Control of the stub, see stubs.h
+//--------------------------------------------------------------------------------------------------
+bool stubPm_IsAwake(void)
+{
+    return WakeupSource.holdCount > 0;
+}
+
+uint32_t stubPm_GetStayAwakeCount(void)
+{
+    return StayAwakeCount;
+}
+
+uint32_t stubPm_GetRelaxCount(void)
+{
+    return RelaxCount;
+}
+
+uint64_t stubPm_GetHeldUs(void)
+{
+    return HeldUs + (stubPm_IsAwake() ? stubClk_GetUs() - HeldSinceUs : 0);
+}
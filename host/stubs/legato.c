@@ -0,0 +1,824 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file legato.c
+ *
+ * Framework part of the host build: clock, memory pools, and a single-threaded event loop
+ * expiring the timers, polling the file descriptor monitors and calling the queued functions and
+ * event handlers, as the Legato event loop of the component's thread does. The loop only runs
+ * within stubLoop_Run and stubLoop_RunUntil, see stubs.h.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stubs.h"
+#include <stdarg.h>
+
+// Sizes of the tables of the loop, large enough for the component
+#define MAX_TIMERS 64
+#define MAX_FD_MONITORS 256
+#define MAX_QUEUED_FUNCTIONS 4096
+#define MAX_EVENT_IDS 16
+#define MAX_EVENT_HANDLERS 64
+#define MAX_SIGNALS 65
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_timer
+{
+    bool isUsed;                        ///< Whether the entry is used
+    char name[32];                      ///< Name, for the logs
+    le_timer_ExpiryHandler_t handler;   ///< Called when it expires
+    uint64_t intervalUs;                ///< Interval
+    uint32_t repeatCount;               ///< Number of expiries, 0 to repeat forever
+    uint32_t expiryCount;               ///< Expiries since it was started
+    bool isRunning;                     ///< Whether it is started
+    uint64_t dueUs;                     ///< Time of the next expiry
+    void * contextPtr;                  ///< Context
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * File descriptor monitor
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_fdMonitor
+{
+    bool isUsed;                        ///< Whether the entry is used
+    int fd;                             ///< File descriptor
+    short events;                       ///< Events polled
+    le_fdMonitor_HandlerFunc_t handler; ///< Called with the events received
+    void * contextPtr;                  ///< Context
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event and its handlers
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_event_Id
+{
+    size_t payloadSize;                 ///< Size of the reports
+};
+
+struct le_event_Handler
+{
+    bool isUsed;                                ///< Whether the entry is used
+    le_event_Id_t eventId;                      ///< Event handled
+    le_event_LayeredHandlerFunc_t firstLayer;   ///< Called with the report
+    void * secondLayerPtr;                      ///< Passed to the first layer
+    void * contextPtr;                          ///< Context, see le_event_GetContextPtr
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function queued to the loop
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_event_DeferredFunc_t func;       ///< Function
+    void * param1Ptr;                   ///< First parameter
+    void * param2Ptr;                   ///< Second parameter
+}
+QueuedFunction_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Memory pool
+ */
+//--------------------------------------------------------------------------------------------------
+struct le_mem_Pool
+{
+    size_t objSize;                     ///< Size of the objects
+};
+
+static struct le_timer Timers[MAX_TIMERS];
+static struct le_fdMonitor FdMonitors[MAX_FD_MONITORS];
+static struct le_event_Id EventIds[MAX_EVENT_IDS];
+static size_t EventIdCount = 0;
+static struct le_event_Handler EventHandlers[MAX_EVENT_HANDLERS];
+
+// Queue of the functions to call, as a ring
+static QueuedFunction_t Queue[MAX_QUEUED_FUNCTIONS];
+static size_t QueueHead = 0;
+static size_t QueueCount = 0;
+
+// Contexts of the handler being called
+static void * FdMonitorContextPtr = NULL;
+static void * EventContextPtr = NULL;
+
+static le_sig_EventHandlerFunc_t SignalHandlers[MAX_SIGNALS];
+
+// Service of the component, and client session of the call in progress
+static le_msg_SessionEventHandler_t CloseHandler = NULL;
+static void * CloseContextPtr = NULL;
+static le_msg_SessionRef_t ClientSessionRef = NULL;
+
+static le_log_Level_t LogLevel = LE_LOG_WARN;
+static bool IsLogLevelSet = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prints a log message if its level is not filtered out. The level is LE_LOG_WARN unless set by
+ * stubLog_SetLevel or by the STUB_LOG_LEVEL environment variable (DEBUG, INFO, WARN or ERR).
+ */
+//--------------------------------------------------------------------------------------------------
+void stubLog_Print
+(
+    le_log_Level_t level,
+    const char * filePtr,
+    int line,
+    const char * formatPtr,
+    ...
+)
+{
+    static const char * const LevelNames[] = { "DBUG", "INFO", "WARN", "ERR", "EMER" };
+    const char * basePtr = strrchr(filePtr, '/');
+    va_list args;
+
+    if (!IsLogLevelSet)
+    {
+        const char * envPtr = getenv("STUB_LOG_LEVEL");
+
+        IsLogLevelSet = true;
+        if (envPtr)
+        {
+            size_t i;
+
+            for (i = 0; i < NUM_ARRAY_MEMBERS(LevelNames); i++)
+            {
+                if (strncmp(envPtr, LevelNames[i], 3) == 0)
+                {
+                    LogLevel = i;
+                }
+            }
+        }
+    }
+
+    if (level < LogLevel)
+    {
+        return;
+    }
+
+    fprintf(stderr, "%s | %s:%d | ", LevelNames[level], basePtr ? basePtr + 1 : filePtr, line);
+    va_start(args, formatPtr);
+    vfprintf(stderr, formatPtr, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the lowest level of the messages logged
+ */
+//--------------------------------------------------------------------------------------------------
+void stubLog_SetLevel
+(
+    le_log_Level_t level
+)
+{
+    LogLevel = level;
+    IsLogLevelSet = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Clock
+//--------------------------------------------------------------------------------------------------
+static le_clk_Time_t GetTime
+(
+    clockid_t clockId
+)
+{
+    struct timespec ts;
+    le_clk_Time_t t;
+
+    clock_gettime(clockId, &ts);
+    t.sec = ts.tv_sec;
+    t.usec = ts.tv_nsec / 1000;
+    return t;
+}
+
+le_clk_Time_t le_clk_GetRelativeTime(void)
+{
+    return GetTime(CLOCK_MONOTONIC);
+}
+
+le_clk_Time_t le_clk_GetAbsoluteTime(void)
+{
+    return GetTime(CLOCK_REALTIME);
+}
+
+le_clk_Time_t le_clk_Add(le_clk_Time_t timeA, le_clk_Time_t timeB)
+{
+    le_clk_Time_t t = { timeA.sec + timeB.sec, timeA.usec + timeB.usec };
+
+    if (t.usec >= 1000000)
+    {
+        t.usec -= 1000000;
+        t.sec++;
+    }
+    return t;
+}
+
+le_clk_Time_t le_clk_Sub(le_clk_Time_t timeA, le_clk_Time_t timeB)
+{
+    le_clk_Time_t t = { timeA.sec - timeB.sec, timeA.usec - timeB.usec };
+
+    if (t.usec < 0)
+    {
+        t.usec += 1000000;
+        t.sec--;
+    }
+    return t;
+}
+
+bool le_clk_GreaterThan(le_clk_Time_t timeA, le_clk_Time_t timeB)
+{
+    return (timeA.sec > timeB.sec) || ( (timeA.sec == timeB.sec) && (timeA.usec > timeB.usec) );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the time of the event loop
+ *
+ * @return
+ *      Microseconds of the monotonic clock
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t stubClk_GetUs
+(
+    void
+)
+{
+    le_clk_Time_t t = le_clk_GetRelativeTime();
+
+    return (uint64_t) t.sec * 1000000 + t.usec;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Memory pools
+//--------------------------------------------------------------------------------------------------
+le_mem_PoolRef_t le_mem_CreatePool(const char * namePtr, size_t objSize)
+{
+    le_mem_PoolRef_t pool = malloc(sizeof(*pool));
+
+    LE_ASSERT(pool);
+    pool->objSize = objSize;
+    return pool;
+}
+
+le_mem_PoolRef_t le_mem_ExpandPool(le_mem_PoolRef_t pool, size_t numObjects)
+{
+    return pool;
+}
+
+void * le_mem_TryAlloc(le_mem_PoolRef_t pool)
+{
+    return malloc(pool->objSize);
+}
+
+void * le_mem_ForceAlloc(le_mem_PoolRef_t pool)
+{
+    void * objPtr = le_mem_TryAlloc(pool);
+
+    LE_ASSERT(objPtr);
+    return objPtr;
+}
+
+void le_mem_Release(void * objPtr)
+{
+    free(objPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Timers
+//--------------------------------------------------------------------------------------------------
+le_timer_Ref_t le_timer_Create(const char * nameStr)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_TIMERS; i++)
+    {
+        if (!Timers[i].isUsed)
+        {
+            memset(&Timers[i], 0, sizeof(Timers[i]));
+            Timers[i].isUsed = true;
+            Timers[i].repeatCount = 1;
+            le_utf8_Copy(Timers[i].name, nameStr, sizeof(Timers[i].name), NULL);
+            return &Timers[i];
+        }
+    }
+
+    LE_FATAL("Too many timers, %s not created", nameStr);
+}
+
+void le_timer_Delete(le_timer_Ref_t timerRef)
+{
+    timerRef->isUsed = false;
+}
+
+le_result_t le_timer_SetHandler(le_timer_Ref_t timerRef, le_timer_ExpiryHandler_t handlerFunc)
+{
+    timerRef->handler = handlerFunc;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetInterval(le_timer_Ref_t timerRef, le_clk_Time_t interval)
+{
+    timerRef->intervalUs = (uint64_t) interval.sec * 1000000 + interval.usec;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetMsInterval(le_timer_Ref_t timerRef, uint32_t interval)
+{
+    timerRef->intervalUs = (uint64_t) interval * 1000;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetRepeat(le_timer_Ref_t timerRef, uint32_t repeatCount)
+{
+    timerRef->repeatCount = repeatCount;
+    return LE_OK;
+}
+
+le_result_t le_timer_SetContextPtr(le_timer_Ref_t timerRef, void * contextPtr)
+{
+    timerRef->contextPtr = contextPtr;
+    return LE_OK;
+}
+
+void * le_timer_GetContextPtr(le_timer_Ref_t timerRef)
+{
+    return timerRef->contextPtr;
+}
+
+le_result_t le_timer_SetWakeup(le_timer_Ref_t timerRef, bool wakeupEnabled)
+{
+    return LE_OK;
+}
+
+le_result_t le_timer_Start(le_timer_Ref_t timerRef)
+{
+    if (timerRef->isRunning)
+    {
+        LE_WARN("Timer %s already running", timerRef->name);
+        return LE_BUSY;
+    }
+
+    timerRef->isRunning = true;
+    timerRef->expiryCount = 0;
+    timerRef->dueUs = stubClk_GetUs() + timerRef->intervalUs;
+    return LE_OK;
+}
+
+le_result_t le_timer_Stop(le_timer_Ref_t timerRef)
+{
+    if (!timerRef->isRunning)
+    {
+        return LE_FAULT;
+    }
+
+    timerRef->isRunning = false;
+    return LE_OK;
+}
+
+le_result_t le_timer_Restart(le_timer_Ref_t timerRef)
+{
+    le_timer_Stop(timerRef);
+    return le_timer_Start(timerRef);
+}
+
+bool le_timer_IsRunning(le_timer_Ref_t timerRef)
+{
+    return timerRef->isRunning;
+}
+
+//--------------------------------------------------------------------------------------------------
+// File descriptor monitors
+//--------------------------------------------------------------------------------------------------
+le_fdMonitor_Ref_t le_fdMonitor_Create(const char * namePtr, int fd,
+                                       le_fdMonitor_HandlerFunc_t handlerFunc, short events)
+{
+    size_t i;
+    le_fdMonitor_Ref_t freePtr = NULL;
+
+    for (i = 0; i < MAX_FD_MONITORS; i++)
+    {
+        if (FdMonitors[i].isUsed)
+        {
+            LE_FATAL_IF(FdMonitors[i].fd == fd, "fd %d of %s already monitored", fd, namePtr);
+        }
+        else if (freePtr == NULL)
+        {
+            freePtr = &FdMonitors[i];
+        }
+    }
+
+    LE_FATAL_IF(freePtr == NULL, "Too many fd monitors, %s not created", namePtr);
+
+    freePtr->isUsed = true;
+    freePtr->fd = fd;
+    freePtr->events = events;
+    freePtr->handler = handlerFunc;
+    freePtr->contextPtr = NULL;
+    return freePtr;
+}
+
+void le_fdMonitor_Enable(le_fdMonitor_Ref_t monitorRef, short events)
+{
+    monitorRef->events |= events;
+}
+
+void le_fdMonitor_Disable(le_fdMonitor_Ref_t monitorRef, short events)
+{
+    monitorRef->events &= ~events;
+}
+
+void le_fdMonitor_SetContextPtr(le_fdMonitor_Ref_t monitorRef, void * contextPtr)
+{
+    monitorRef->contextPtr = contextPtr;
+}
+
+void * le_fdMonitor_GetContextPtr(void)
+{
+    return FdMonitorContextPtr;
+}
+
+void le_fdMonitor_Delete(le_fdMonitor_Ref_t monitorRef)
+{
+    monitorRef->isUsed = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Events
+//--------------------------------------------------------------------------------------------------
+void le_event_QueueFunction(le_event_DeferredFunc_t func, void * param1Ptr, void * param2Ptr)
+{
+    QueuedFunction_t * entryPtr;
+
+    LE_FATAL_IF(QueueCount == MAX_QUEUED_FUNCTIONS, "Event queue full");
+
+    entryPtr = &Queue[(QueueHead + QueueCount) % MAX_QUEUED_FUNCTIONS];
+    entryPtr->func = func;
+    entryPtr->param1Ptr = param1Ptr;
+    entryPtr->param2Ptr = param2Ptr;
+    QueueCount++;
+}
+
+le_event_Id_t le_event_CreateId(const char * name, size_t payloadSize)
+{
+    LE_FATAL_IF(EventIdCount == MAX_EVENT_IDS, "Too many events, %s not created", name);
+
+    EventIds[EventIdCount].payloadSize = payloadSize;
+    return &EventIds[EventIdCount++];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Calls the handlers of a report, queued by le_event_Report
+ */
+//--------------------------------------------------------------------------------------------------
+static void DispatchReport
+(
+    void * param1Ptr,       ///< [IN] Event
+    void * param2Ptr        ///< [IN] Copy of the report, freed here
+)
+{
+    le_event_Id_t eventId = param1Ptr;
+    size_t i;
+
+    for (i = 0; i < MAX_EVENT_HANDLERS; i++)
+    {
+        struct le_event_Handler * handlerPtr = &EventHandlers[i];
+
+        if (handlerPtr->isUsed && (handlerPtr->eventId == eventId))
+        {
+            EventContextPtr = handlerPtr->contextPtr;
+            handlerPtr->firstLayer(param2Ptr, handlerPtr->secondLayerPtr);
+            EventContextPtr = NULL;
+        }
+    }
+
+    free(param2Ptr);
+}
+
+void le_event_Report(le_event_Id_t eventId, void * payloadPtr, size_t payloadSize)
+{
+    void * copyPtr = malloc(eventId->payloadSize);
+
+    LE_ASSERT(copyPtr && (payloadSize <= eventId->payloadSize));
+    memcpy(copyPtr, payloadPtr, payloadSize);
+    le_event_QueueFunction(DispatchReport, eventId, copyPtr);
+}
+
+le_event_HandlerRef_t le_event_AddLayeredHandler(const char * name, le_event_Id_t eventId,
+                                                 le_event_LayeredHandlerFunc_t firstLayerFuncPtr,
+                                                 void * secondLayerFuncPtr)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_EVENT_HANDLERS; i++)
+    {
+        if (!EventHandlers[i].isUsed)
+        {
+            EventHandlers[i].isUsed = true;
+            EventHandlers[i].eventId = eventId;
+            EventHandlers[i].firstLayer = firstLayerFuncPtr;
+            EventHandlers[i].secondLayerPtr = secondLayerFuncPtr;
+            EventHandlers[i].contextPtr = NULL;
+            return &EventHandlers[i];
+        }
+    }
+
+    LE_FATAL("Too many event handlers, %s not added", name);
+}
+
+void le_event_SetContextPtr(le_event_HandlerRef_t handlerRef, void * contextPtr)
+{
+    handlerRef->contextPtr = contextPtr;
+}
+
+void * le_event_GetContextPtr(void)
+{
+    return EventContextPtr;
+}
+
+void le_event_RemoveHandler(le_event_HandlerRef_t handlerRef)
+{
+    LE_FATAL_IF(!handlerRef->isUsed, "Handler %p already removed", handlerRef);
+    handlerRef->isUsed = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Signals
+//--------------------------------------------------------------------------------------------------
+void le_sig_Block(int sigNum)
+{
+}
+
+void le_sig_SetEventHandler(int sigNum, le_sig_EventHandlerFunc_t sigEventHandler)
+{
+    LE_ASSERT( (sigNum > 0) && (sigNum < MAX_SIGNALS) );
+    SignalHandlers[sigNum] = sigEventHandler;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Calls the handler the component set for a signal, as the loop does when the signal is received
+ */
+//--------------------------------------------------------------------------------------------------
+void stubSig_Raise
+(
+    int sigNum
+)
+{
+    LE_ASSERT( (sigNum > 0) && (sigNum < MAX_SIGNALS) );
+    if (SignalHandlers[sigNum])
+    {
+        SignalHandlers[sigNum](sigNum);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Random numbers and UTF-8 strings
+//--------------------------------------------------------------------------------------------------
+uint32_t le_rand_GetNumBetween(uint32_t min, uint32_t max)
+{
+    return min + (uint32_t) (random() % ((uint64_t) max - min + 1));
+}
+
+le_result_t le_utf8_Copy(char * destStr, const char * srcStr, const size_t destSize,
+                         size_t * numBytesPtr)
+{
+    size_t length = strnlen(srcStr, destSize);
+    le_result_t result = LE_OK;
+
+    if (length == destSize)
+    {
+        // Only whole UTF-8 characters are kept
+        length = destSize - 1;
+        while ( (length > 0) && ((srcStr[length] & 0xC0) == 0x80) )
+        {
+            length--;
+        }
+        result = LE_OVERFLOW;
+    }
+
+    memcpy(destStr, srcStr, length);
+    destStr[length] = '\0';
+    if (numBytesPtr)
+    {
+        *numBytesPtr = length;
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Sessions of the trafficLight service
+//--------------------------------------------------------------------------------------------------
+le_msg_SessionEventHandlerRef_t le_msg_AddServiceCloseHandler(le_msg_ServiceRef_t serviceRef,
+                                                              le_msg_SessionEventHandler_t handler,
+                                                              void * contextPtr)
+{
+    CloseHandler = handler;
+    CloseContextPtr = contextPtr;
+    return (le_msg_SessionEventHandlerRef_t) &CloseHandler;
+}
+
+le_msg_ServiceRef_t trafficLight_GetServiceRef(void)
+{
+    return (le_msg_ServiceRef_t) &CloseHandler;
+}
+
+le_msg_SessionRef_t trafficLight_GetClientSessionRef(void)
+{
+    return ClientSessionRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the client session the next calls to the trafficLight API come from
+ */
+//--------------------------------------------------------------------------------------------------
+void stubMsg_SetClientSession
+(
+    le_msg_SessionRef_t sessionRef      ///< [IN] Any distinct non-NULL value
+)
+{
+    ClientSessionRef = sessionRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Closes a client session of the trafficLight service, e.g. as when the client app stops
+ */
+//--------------------------------------------------------------------------------------------------
+void stubMsg_CloseSession
+(
+    le_msg_SessionRef_t sessionRef      ///< [IN] Session set by stubMsg_SetClientSession
+)
+{
+    if (CloseHandler)
+    {
+        CloseHandler(sessionRef, CloseContextPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Event loop
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs one pass of the loop: polls the monitored file descriptors until the next timer is due,
+ * then calls the handlers of the file descriptors, of the timers and the queued functions.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunOnce
+(
+    uint64_t deadlineUs         ///< [IN] Time the pass must not wait beyond
+)
+{
+    struct pollfd pollFds[MAX_FD_MONITORS];
+    le_fdMonitor_Ref_t monitors[MAX_FD_MONITORS];
+    size_t monitorCount = 0;
+    uint64_t nowUs = stubClk_GetUs();
+    uint64_t waitUs = (deadlineUs > nowUs) ? deadlineUs - nowUs : 0;
+    size_t queued;
+    size_t i;
+
+    for (i = 0; i < MAX_TIMERS; i++)
+    {
+        if (Timers[i].isUsed && Timers[i].isRunning)
+        {
+            uint64_t dueInUs = (Timers[i].dueUs > nowUs) ? Timers[i].dueUs - nowUs : 0;
+
+            if (dueInUs < waitUs)
+            {
+                waitUs = dueInUs;
+            }
+        }
+    }
+
+    if (QueueCount > 0)
+    {
+        waitUs = 0;
+    }
+
+    for (i = 0; i < MAX_FD_MONITORS; i++)
+    {
+        if (FdMonitors[i].isUsed)
+        {
+            pollFds[monitorCount].fd = FdMonitors[i].fd;
+            pollFds[monitorCount].events = FdMonitors[i].events;
+            pollFds[monitorCount].revents = 0;
+            monitors[monitorCount] = &FdMonitors[i];
+            monitorCount++;
+        }
+    }
+
+    // Rounded up, so that the timers are due once poll returns
+    poll(pollFds, monitorCount, (int) ((waitUs + 999) / 1000));
+
+    for (i = 0; i < monitorCount; i++)
+    {
+        le_fdMonitor_Ref_t monitorRef = monitors[i];
+
+        // A handler may delete or replace the monitors of the other descriptors
+        if ( pollFds[i].revents &&
+             monitorRef->isUsed &&
+             (monitorRef->fd == pollFds[i].fd) )
+        {
+            FdMonitorContextPtr = monitorRef->contextPtr;
+            monitorRef->handler(pollFds[i].fd, pollFds[i].revents);
+            FdMonitorContextPtr = NULL;
+        }
+    }
+
+    nowUs = stubClk_GetUs();
+    for (i = 0; i < MAX_TIMERS; i++)
+    {
+        le_timer_Ref_t timerRef = &Timers[i];
+
+        if (timerRef->isUsed && timerRef->isRunning && (timerRef->dueUs <= nowUs))
+        {
+            timerRef->expiryCount++;
+            if ( (timerRef->repeatCount != 0) && (timerRef->expiryCount >= timerRef->repeatCount) )
+            {
+                timerRef->isRunning = false;
+            }
+            else
+            {
+                timerRef->dueUs += timerRef->intervalUs;
+            }
+
+            if (timerRef->handler)
+            {
+                timerRef->handler(timerRef);
+            }
+        }
+    }
+
+    // Only the functions queued so far, those they queue wait for the next pass
+    queued = QueueCount;
+    while (queued-- > 0)
+    {
+        QueuedFunction_t entry = Queue[QueueHead];
+
+        QueueHead = (QueueHead + 1) % MAX_QUEUED_FUNCTIONS;
+        QueueCount--;
+        entry.func(entry.param1Ptr, entry.param2Ptr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs the event loop for a while
+ */
+//--------------------------------------------------------------------------------------------------
+void stubLoop_Run
+(
+    uint32_t ms                 ///< [IN] Time to run the loop for
+)
+{
+    uint64_t deadlineUs = stubClk_GetUs() + (uint64_t) ms * 1000;
+
+    do
+    {
+        RunOnce(deadlineUs);
+    }
+    while (stubClk_GetUs() < deadlineUs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs the event loop until a condition is met
+ *
+ * @return
+ *      true if the condition is met, false if the time ran out
+ */
+//--------------------------------------------------------------------------------------------------
+bool stubLoop_RunUntil
+(
+    bool (*conditionPtr)(void * contextPtr),    ///< [IN] Condition, checked after each pass
+    void * contextPtr,                          ///< [IN] Passed to the condition
+    uint32_t timeoutMs                          ///< [IN] Longest time to run the loop for
+)
+{
+    uint64_t deadlineUs = stubClk_GetUs() + (uint64_t) timeoutMs * 1000;
+
+    while (!conditionPtr(contextPtr))
+    {
+        if (stubClk_GetUs() >= deadlineUs)
+        {
+            return false;
+        }
+        RunOnce(deadlineUs);
+    }
+
+    return true;
+}
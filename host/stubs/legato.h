@@ -0,0 +1,201 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file legato.h
+ *
+ * Stand-in of the Legato framework header for the host build, see host/README.md. Only the parts
+ * of the framework the trafficLight component uses are declared, with the same names and types.
+ * They are implemented by legato.c over a single-threaded event loop run by stubLoop_Run.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LEGATO_H_INCLUDE_GUARD
+#define LEGATO_H_INCLUDE_GUARD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result codes
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    LE_OK = 0,
+    LE_NOT_FOUND = -1,
+    LE_NOT_POSSIBLE = -2,
+    LE_OUT_OF_RANGE = -3,
+    LE_NO_MEMORY = -4,
+    LE_NOT_PERMITTED = -5,
+    LE_FAULT = -6,
+    LE_COMM_ERROR = -7,
+    LE_TIMEOUT = -8,
+    LE_OVERFLOW = -9,
+    LE_UNDERFLOW = -10,
+    LE_WOULD_BLOCK = -11,
+    LE_DEADLOCK = -12,
+    LE_FORMAT_ERROR = -13,
+    LE_DUPLICATE = -14,
+    LE_BAD_PARAMETER = -15,
+    LE_CLOSED = -16,
+    LE_BUSY = -17,
+    LE_UNSUPPORTED = -18,
+    LE_IO_ERROR = -19,
+    LE_NOT_IMPLEMENTED = -20,
+    LE_UNAVAILABLE = -21,
+    LE_TERMINATED = -22,
+}
+le_result_t;
+
+//--------------------------------------------------------------------------------------------------
+// Logging, filtered by stubLog_SetLevel
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    LE_LOG_DEBUG,
+    LE_LOG_INFO,
+    LE_LOG_WARN,
+    LE_LOG_ERR,
+    LE_LOG_EMERG,
+}
+le_log_Level_t;
+
+void stubLog_Print(le_log_Level_t level, const char * filePtr, int line, const char * formatPtr,
+                   ...) __attribute__((format(printf, 4, 5)));
+
+#define LE_DEBUG(...)   stubLog_Print(LE_LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_INFO(...)    stubLog_Print(LE_LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_WARN(...)    stubLog_Print(LE_LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_ERROR(...)   stubLog_Print(LE_LOG_ERR, __FILE__, __LINE__, __VA_ARGS__)
+#define LE_FATAL(...)   (stubLog_Print(LE_LOG_EMERG, __FILE__, __LINE__, __VA_ARGS__), abort())
+
+#define LE_WARN_IF(condition, ...)  do { if (condition) { LE_WARN(__VA_ARGS__); } } while (0)
+#define LE_ERROR_IF(condition, ...) do { if (condition) { LE_ERROR(__VA_ARGS__); } } while (0)
+#define LE_FATAL_IF(condition, ...) do { if (condition) { LE_FATAL(__VA_ARGS__); } } while (0)
+#define LE_ASSERT(condition)        LE_FATAL_IF(!(condition), "Assert Failed: '%s'", #condition)
+#define LE_ASSERT_OK(condition)     LE_ASSERT((condition) == LE_OK)
+
+#define NUM_ARRAY_MEMBERS(array)    (sizeof(array) / sizeof((array)[0]))
+#define CONTAINER_OF(ptr, type, member) ((type *) (((uint8_t *) (ptr)) - offsetof(type, member)))
+
+// The init function of the component, called by the test or benchmark once the stubs are set
+#define COMPONENT_INIT void _le_stub_ComponentInit(void)
+void _le_stub_ComponentInit(void);
+
+//--------------------------------------------------------------------------------------------------
+// Clock
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    time_t sec;         ///< Seconds
+    long usec;          ///< Microseconds
+}
+le_clk_Time_t;
+
+le_clk_Time_t le_clk_GetRelativeTime(void);
+le_clk_Time_t le_clk_GetAbsoluteTime(void);
+le_clk_Time_t le_clk_Add(le_clk_Time_t timeA, le_clk_Time_t timeB);
+le_clk_Time_t le_clk_Sub(le_clk_Time_t timeA, le_clk_Time_t timeB);
+bool le_clk_GreaterThan(le_clk_Time_t timeA, le_clk_Time_t timeB);
+
+//--------------------------------------------------------------------------------------------------
+// Memory pools, backed by malloc
+//--------------------------------------------------------------------------------------------------
+typedef struct le_mem_Pool * le_mem_PoolRef_t;
+
+le_mem_PoolRef_t le_mem_CreatePool(const char * namePtr, size_t objSize);
+le_mem_PoolRef_t le_mem_ExpandPool(le_mem_PoolRef_t pool, size_t numObjects);
+void * le_mem_ForceAlloc(le_mem_PoolRef_t pool);
+void * le_mem_TryAlloc(le_mem_PoolRef_t pool);
+void le_mem_Release(void * objPtr);
+
+//--------------------------------------------------------------------------------------------------
+// Timers, expired by the event loop
+//--------------------------------------------------------------------------------------------------
+typedef struct le_timer * le_timer_Ref_t;
+typedef void (*le_timer_ExpiryHandler_t)(le_timer_Ref_t timerRef);
+
+le_timer_Ref_t le_timer_Create(const char * nameStr);
+void le_timer_Delete(le_timer_Ref_t timerRef);
+le_result_t le_timer_SetHandler(le_timer_Ref_t timerRef, le_timer_ExpiryHandler_t handlerFunc);
+le_result_t le_timer_SetInterval(le_timer_Ref_t timerRef, le_clk_Time_t interval);
+le_result_t le_timer_SetMsInterval(le_timer_Ref_t timerRef, uint32_t interval);
+le_result_t le_timer_SetRepeat(le_timer_Ref_t timerRef, uint32_t repeatCount);
+le_result_t le_timer_SetContextPtr(le_timer_Ref_t timerRef, void * contextPtr);
+void * le_timer_GetContextPtr(le_timer_Ref_t timerRef);
+le_result_t le_timer_SetWakeup(le_timer_Ref_t timerRef, bool wakeupEnabled);
+le_result_t le_timer_Start(le_timer_Ref_t timerRef);
+le_result_t le_timer_Stop(le_timer_Ref_t timerRef);
+le_result_t le_timer_Restart(le_timer_Ref_t timerRef);
+bool le_timer_IsRunning(le_timer_Ref_t timerRef);
+
+//--------------------------------------------------------------------------------------------------
+// File descriptor monitors, polled by the event loop
+//--------------------------------------------------------------------------------------------------
+typedef struct le_fdMonitor * le_fdMonitor_Ref_t;
+typedef void (*le_fdMonitor_HandlerFunc_t)(int fd, short events);
+
+le_fdMonitor_Ref_t le_fdMonitor_Create(const char * namePtr, int fd,
+                                       le_fdMonitor_HandlerFunc_t handlerFunc, short events);
+void le_fdMonitor_Enable(le_fdMonitor_Ref_t monitorRef, short events);
+void le_fdMonitor_Disable(le_fdMonitor_Ref_t monitorRef, short events);
+void le_fdMonitor_SetContextPtr(le_fdMonitor_Ref_t monitorRef, void * contextPtr);
+void * le_fdMonitor_GetContextPtr(void);
+void le_fdMonitor_Delete(le_fdMonitor_Ref_t monitorRef);
+
+//--------------------------------------------------------------------------------------------------
+// Events, reported through the event loop
+//--------------------------------------------------------------------------------------------------
+typedef struct le_event_Id * le_event_Id_t;
+typedef struct le_event_Handler * le_event_HandlerRef_t;
+typedef void (*le_event_DeferredFunc_t)(void * param1Ptr, void * param2Ptr);
+typedef void (*le_event_LayeredHandlerFunc_t)(void * reportPtr, void * secondLayerFunc);
+
+void le_event_QueueFunction(le_event_DeferredFunc_t func, void * param1Ptr, void * param2Ptr);
+le_event_Id_t le_event_CreateId(const char * name, size_t payloadSize);
+void le_event_Report(le_event_Id_t eventId, void * payloadPtr, size_t payloadSize);
+le_event_HandlerRef_t le_event_AddLayeredHandler(const char * name, le_event_Id_t eventId,
+                                                 le_event_LayeredHandlerFunc_t firstLayerFuncPtr,
+                                                 void * secondLayerFuncPtr);
+void le_event_SetContextPtr(le_event_HandlerRef_t handlerRef, void * contextPtr);
+void * le_event_GetContextPtr(void);
+void le_event_RemoveHandler(le_event_HandlerRef_t handlerRef);
+
+//--------------------------------------------------------------------------------------------------
+// Signals, raised by stubSig_Raise
+//--------------------------------------------------------------------------------------------------
+typedef void (*le_sig_EventHandlerFunc_t)(int sigNum);
+
+void le_sig_Block(int sigNum);
+void le_sig_SetEventHandler(int sigNum, le_sig_EventHandlerFunc_t sigEventHandler);
+
+//--------------------------------------------------------------------------------------------------
+// Random numbers and UTF-8 strings
+//--------------------------------------------------------------------------------------------------
+uint32_t le_rand_GetNumBetween(uint32_t min, uint32_t max);
+le_result_t le_utf8_Copy(char * destStr, const char * srcStr, const size_t destSize,
+                         size_t * numBytesPtr);
+
+//--------------------------------------------------------------------------------------------------
+// IPC sessions of the services the component provides
+//--------------------------------------------------------------------------------------------------
+typedef struct le_msg_Service * le_msg_ServiceRef_t;
+typedef struct le_msg_Session * le_msg_SessionRef_t;
+typedef struct le_msg_SessionEventHandler * le_msg_SessionEventHandlerRef_t;
+typedef void (*le_msg_SessionEventHandler_t)(le_msg_SessionRef_t sessionRef, void * contextPtr);
+
+le_msg_SessionEventHandlerRef_t le_msg_AddServiceCloseHandler(le_msg_ServiceRef_t serviceRef,
+                                                              le_msg_SessionEventHandler_t handler,
+                                                              void * contextPtr);
+
+#endif // LEGATO_H_INCLUDE_GUARD
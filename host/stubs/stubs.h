@@ -0,0 +1,160 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file stubs.h
+ *
+ * Control of the stubbed framework and services of the host build, for the tests and benchmarks.
+ * The stubs are single-threaded: they must only be used from the thread running the event loop.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef STUBS_H_INCLUDE_GUARD
+#define STUBS_H_INCLUDE_GUARD
+
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+// Framework, see legato.c
+//--------------------------------------------------------------------------------------------------
+
+// Sets the lowest level logged, LE_LOG_WARN by default or as set by STUB_LOG_LEVEL
+void stubLog_SetLevel(le_log_Level_t level);
+
+// Gets the time of the monotonic clock of le_clk_GetRelativeTime and of the timers
+uint64_t stubClk_GetUs(void);
+
+// Runs the event loop for a while
+void stubLoop_Run(uint32_t ms);
+
+// Runs the event loop until a condition is met, returns false if the time ran out first
+bool stubLoop_RunUntil(bool (*conditionPtr)(void * contextPtr), void * contextPtr,
+                       uint32_t timeoutMs);
+
+// Calls the handler of a signal, as the loop does when the signal is received
+void stubSig_Raise(int sigNum);
+
+// Sets the client session the next calls to the trafficLight API come from
+void stubMsg_SetClientSession(le_msg_SessionRef_t sessionRef);
+
+// Closes a client session of the trafficLight service
+void stubMsg_CloseSession(le_msg_SessionRef_t sessionRef);
+
+//--------------------------------------------------------------------------------------------------
+// Config tree, see le_cfg.c. Paths are absolute, the change handlers are queued to the loop.
+//--------------------------------------------------------------------------------------------------
+void stubCfg_SetString(const char * pathPtr, const char * valuePtr);
+void stubCfg_SetInt(const char * pathPtr, int32_t value);
+void stubCfg_SetFloat(const char * pathPtr, double value);
+void stubCfg_SetBool(const char * pathPtr, bool value);
+void stubCfg_Delete(const char * pathPtr);
+
+// Gets the value of a node as a string, NULL if it does not exist or is a stem
+const char * stubCfg_Get(const char * pathPtr);
+
+//--------------------------------------------------------------------------------------------------
+// GPIO pins of the towers, see le_gpio.c
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    STUB_GPIO_RED,
+    STUB_GPIO_YELLOW,
+    STUB_GPIO_GREEN,
+    STUB_GPIO_RED2,
+    STUB_GPIO_YELLOW2,
+    STUB_GPIO_GREEN2,
+    STUB_GPIO_RED3,
+    STUB_GPIO_YELLOW3,
+    STUB_GPIO_GREEN3,
+    STUB_GPIO_PIN_COUNT,
+}
+stubGpio_Pin_t;
+
+// Write of a pin
+typedef struct
+{
+    uint64_t timeUs;            ///< Time of the write, see stubClk_GetUs
+    stubGpio_Pin_t pin;         ///< Pin
+    bool value;                 ///< Level written
+}
+stubGpio_Write_t;
+
+typedef void (*stubGpio_WriteHandlerFunc_t)(stubGpio_Pin_t pin, bool value, void * contextPtr);
+
+// Binds the pins of an additional tower, 1 or 2. Those of the main tower, 0, are always bound.
+void stubGpio_Bind(size_t tower);
+
+// Gets the level written last to a pin, and whether the pin is activated
+bool stubGpio_Get(stubGpio_Pin_t pin);
+bool stubGpio_IsActive(stubGpio_Pin_t pin);
+
+// Gets the number of writes of a pin
+uint32_t stubGpio_GetPinWriteCount(stubGpio_Pin_t pin);
+
+// Gets the writes of all the pins recorded since the start or stubGpio_ClearWrites
+size_t stubGpio_GetWriteCount(void);
+const stubGpio_Write_t * stubGpio_GetWrite(size_t index);
+void stubGpio_ClearWrites(void);
+
+// Sets a handler called on each write, NULL for none
+void stubGpio_SetWriteHandler(stubGpio_WriteHandlerFunc_t handlerPtr, void * contextPtr);
+
+//--------------------------------------------------------------------------------------------------
+// Power manager, see le_pm.c
+//--------------------------------------------------------------------------------------------------
+bool stubPm_IsAwake(void);
+uint32_t stubPm_GetStayAwakeCount(void);
+uint32_t stubPm_GetRelaxCount(void);
+
+// Gets the time the wakeup source was held for
+uint64_t stubPm_GetHeldUs(void);
+
+//--------------------------------------------------------------------------------------------------
+// Data connection service, see le_dcs.c. Channel events are queued to the loop.
+//--------------------------------------------------------------------------------------------------
+le_dcs_ChannelRef_t stubDcs_AddChannel(const char * namePtr, le_dcs_Technology_t technology,
+                                       bool isUp);
+void stubDcs_SetUp(le_dcs_ChannelRef_t channelRef, bool isUp);
+uint32_t stubDcs_GetRequestCount(le_dcs_ChannelRef_t channelRef);
+size_t stubDcs_GetHandlerCount(le_dcs_ChannelRef_t channelRef);
+
+// Sets the result of the next channel lists, LE_OK by default
+void stubDcs_SetQueryResult(le_result_t result);
+
+//--------------------------------------------------------------------------------------------------
+// HTTP server on the loopback interface, standing in for the servers polled, see httpServer.c. It
+// runs in its own threads: these functions may be called while the loop runs or not.
+//--------------------------------------------------------------------------------------------------
+
+// Response to the requests of a path
+typedef struct
+{
+    int status;                 ///< HTTP status
+    const char * bodyPtr;       ///< Body, copied, NULL for none
+    uint32_t delayMs;           ///< Delay before the response is sent
+    size_t chunkBytes;          ///< Size of the chunks of the body, 0 to send it with its length
+    bool isStream;              ///< Server-Sent Events instead of the body: the response stays
+                                ///< open, see stubHttp_SendEvent
+}
+stubHttp_Response_t;
+
+// Starts the server, returns its port. The paths not set are answered with a 404.
+uint16_t stubHttp_Start(void);
+
+// Sets the response to the requests of a path, e.g. "/job/build/api/xml". The query is ignored.
+void stubHttp_SetResponse(const char * pathPtr, const stubHttp_Response_t * responsePtr);
+
+// Gets the number of requests of a path received, answered or not yet
+uint32_t stubHttp_GetRequestCount(const char * pathPtr);
+
+// Gets the time the last request of a path was received at, see stubClk_GetUs, 0 if none was
+uint64_t stubHttp_GetLastRequestUs(const char * pathPtr);
+
+// Gets the number of connections accepted
+uint32_t stubHttp_GetConnectionCount(void);
+
+// Gets the number of event streams open, sends an event to all of them, or closes them
+size_t stubHttp_GetStreamCount(void);
+void stubHttp_SendEvent(const char * eventPtr, const char * dataPtr);
+void stubHttp_DropStreams(void);
+
+#endif // STUBS_H_INCLUDE_GUARD
@@ -0,0 +1,214 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file contentCheckTest.c
+ *
+ * Tests of the content checkers fed as the polling code does, through contentCheck.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+#include "contentCheck.h"
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prepares the settings of a check, with no threshold
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitParams
+(
+    ContentCheckParams_t * paramsPtr    ///< [OUT] Settings
+)
+{
+    memset(paramsPtr, 0, sizeof(*paramsPtr));
+    paramsPtr->warningThreshold = NAN;
+    paramsPtr->criticalThreshold = NAN;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks a content, fed in chunks of a few bytes so that the tokens span chunks
+ *
+ * @return
+ *      State of the content
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t Check
+(
+    const char * checkModePtr,                  ///< [IN] Checker
+    ContentCheckParams_t * paramsPtr,           ///< [IN] Settings, prepared here
+    const char * contentPtr                     ///< [IN] Content
+)
+{
+    const ContentChecker_t * checkerPtr = contentCheck_GetChecker(checkModePtr);
+    ContentCheck_t * checkPtr;
+    size_t length = strlen(contentPtr);
+    size_t offset = 0;
+    MonitorState_t state;
+
+    LE_ASSERT(checkerPtr);
+    LE_ASSERT_OK(contentCheck_Prepare(checkerPtr, paramsPtr));
+
+    checkPtr = malloc(contentCheck_GetSize(checkerPtr));
+    LE_ASSERT(checkPtr);
+
+    contentCheck_Init(checkPtr, checkerPtr, paramsPtr);
+    while ( (offset < length) && !checkPtr->isDone )
+    {
+        size_t chunk = (length - offset < 7) ? length - offset : 7;
+
+        contentCheck_Feed(checkPtr, contentPtr + offset, chunk);
+        offset += chunk;
+    }
+
+    state = contentCheck_GetResult(checkPtr);
+    free(checkPtr);
+    contentCheck_Release(paramsPtr);
+    return state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The most keywords, of the longest size and without any common prefix, fit in the automaton
+ * along with the longest anchors
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestLongestKeywords(void)
+{
+    static ContentCheckParams_t params;
+    char content[MAX_CONTENT_KEYWORD_BYTES * 3];
+    size_t i;
+
+    InitParams(&params);
+    for (i = 0; i < MAX_CONTENT_KEYWORDS; i++)
+    {
+        memset(params.keywords[i].keyword, 'a' + i, MAX_CONTENT_KEYWORD_BYTES - 1);
+        params.keywords[i].keyword[MAX_CONTENT_KEYWORD_BYTES - 1] = '\0';
+        params.keywords[i].state = (i == MAX_CONTENT_KEYWORDS - 1) ? STATE_WARNING : STATE_PASS;
+    }
+    params.keywordCount = MAX_CONTENT_KEYWORDS;
+    memset(params.anchor, '<', MAX_CONTENT_KEYWORD_BYTES - 1);
+    memset(params.anchorEnd, '>', MAX_CONTENT_KEYWORD_BYTES - 1);
+
+    // The last keyword, whose nodes are the last ones built
+    snprintf(content, sizeof(content), "%s%s%s",
+             params.anchor, params.keywords[MAX_CONTENT_KEYWORDS - 1].keyword, params.anchorEnd);
+
+    LE_ASSERT(Check("keywords", &params, content) == STATE_WARNING);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Only the result of a Jenkins build counts, not the same words elsewhere in the build
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestJenkinsResult(void)
+{
+    static ContentCheckParams_t params;
+
+    InitParams(&params);
+    LE_ASSERT(Check("jenkins", &params,
+                    "<freeStyleBuild><changeSet><msg>Fix the FAILURE</msg></changeSet>"
+                    "<result>SUCCESS</result></freeStyleBuild>") == STATE_PASS);
+
+    InitParams(&params);
+    LE_ASSERT(Check("jenkins", &params,
+                    "<freeStyleBuild><changeSet><msg>Back to SUCCESS</msg></changeSet>"
+                    "<result>FAILURE</result></freeStyleBuild>") == STATE_FAIL);
+
+    InitParams(&params);
+    LE_ASSERT(Check("jenkins", &params,
+                    "<freeStyleBuild><building>true</building><msg>SUCCESS</msg>"
+                    "</freeStyleBuild>") == STATE_FAIL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Settings are compared by what is configured, not by what the checkers build from them
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestSameSettings(void)
+{
+    static ContentCheckParams_t a;
+    static ContentCheckParams_t b;
+
+    InitParams(&a);
+    InitParams(&b);
+    LE_ASSERT(contentCheck_IsSameSettings(&a, &b));
+
+    LE_ASSERT_OK(contentCheck_Prepare(contentCheck_GetChecker("jenkins"), &a));
+    LE_ASSERT_OK(contentCheck_Prepare(contentCheck_GetChecker("jenkins"), &b));
+    LE_ASSERT(a.automatonPtr && b.automatonPtr && (a.automatonPtr != b.automatonPtr));
+    memset(b.automatonPtr, 0xFF, sizeof(*b.automatonPtr));
+    LE_ASSERT(contentCheck_IsSameSettings(&a, &b));
+
+    b.keywords[1].state = STATE_WARNING;
+    LE_ASSERT(!contentCheck_IsSameSettings(&a, &b));
+    b.keywords[1].state = a.keywords[1].state;
+
+    b.warningThreshold = 1;
+    LE_ASSERT(!contentCheck_IsSameSettings(&a, &b));
+
+    contentCheck_Release(&a);
+    contentCheck_Release(&b);
+    LE_ASSERT( (a.automatonPtr == NULL) && (b.automatonPtr == NULL) );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The URL of a Jenkins view is restricted to the fields the check reads, whether it has a query or
+ * not, unless it sets them itself
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestJenkinsViewUrl(void)
+{
+    static const char tree[] = "tree=jobs%5Bname%2Ccolor%2ClastCompletedBuild%5Bresult%5D%5D";
+    const ContentChecker_t * checkerPtr = contentCheck_GetChecker("jenkinsView");
+    static ContentCheckParams_t params;
+    char url[256];
+    char expected[256];
+
+    InitParams(&params);
+    LE_ASSERT_OK(contentCheck_Prepare(checkerPtr, &params));
+
+    // Only the checkers of keywords build an automaton
+    LE_ASSERT(params.automatonPtr == NULL);
+
+    snprintf(url, sizeof(url), "https://ci/view/Team");
+    LE_ASSERT_OK(contentCheck_CompleteUrl(checkerPtr, &params, url, sizeof(url)));
+    snprintf(expected, sizeof(expected), "https://ci/view/Team/api/json?%s", tree);
+    LE_ASSERT(strcmp(url, expected) == 0);
+
+    snprintf(url, sizeof(url), "https://ci/job/folder/api/json?depth=1");
+    LE_ASSERT_OK(contentCheck_CompleteUrl(checkerPtr, &params, url, sizeof(url)));
+    snprintf(expected, sizeof(expected), "https://ci/job/folder/api/json?depth=1&%s", tree);
+    LE_ASSERT(strcmp(url, expected) == 0);
+
+    snprintf(url, sizeof(url), "https://ci/view/Team/api/json?tree=jobs[name,color]");
+    LE_ASSERT_OK(contentCheck_CompleteUrl(checkerPtr, &params, url, sizeof(url)));
+    LE_ASSERT(strcmp(url, "https://ci/view/Team/api/json?tree=jobs[name,color]") == 0);
+
+    // Too long for the tree: kept as set
+    memset(url, 'a', sizeof(url) - 8);
+    memcpy(url, "https://", 8);
+    url[sizeof(url) - 8] = '\0';
+    snprintf(expected, sizeof(expected), "%s", url);
+    LE_ASSERT(contentCheck_CompleteUrl(checkerPtr, &params, url, sizeof(url)) == LE_OVERFLOW);
+    LE_ASSERT(strcmp(url, expected) == 0);
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    TestLongestKeywords();
+    TestJenkinsResult();
+    TestSameSettings();
+    TestJenkinsViewUrl();
+
+    printf("contentCheckTest: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file dataLinkTest.c
+ *
+ * Tests of the data link the servers are polled through, over the channels of the le_dcs stub
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+#include "dataLink.h"
+
+// Time for the channel lists and events queued by the stub to be delivered
+#define DELIVERY_MS 10
+
+// Channels listed by the stub
+static le_dcs_ChannelRef_t Cellular;
+static le_dcs_ChannelRef_t Wifi;
+static le_dcs_ChannelRef_t Ethernet;
+
+// Link changes told to the handler, and the last one
+static int ChangeCount = 0;
+static bool LastIsUp = true;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records the link changes
+ */
+//--------------------------------------------------------------------------------------------------
+static void LinkChangeHandler
+(
+    bool isUp                       ///< [IN] Whether the servers can be polled
+)
+{
+    ChangeCount++;
+    LastIsUp = isUp;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The link follows the main channel, and the fallback one while the main one is down. The
+ * fallback channel is only requested while the main one is down.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestFallback(void)
+{
+    dataLink_SetChannels("", "");
+    LE_ASSERT(dataLink_IsUp());
+    stubLoop_Run(DELIVERY_MS);
+
+    // Cellular is down, Wi-Fi is up: both are requested
+    LE_ASSERT(stubDcs_GetRequestCount(Cellular) == 1);
+    LE_ASSERT(stubDcs_GetRequestCount(Wifi) == 1);
+    LE_ASSERT(stubDcs_GetRequestCount(Ethernet) == 0);
+    LE_ASSERT(dataLink_IsUp());
+    LE_ASSERT(ChangeCount == 0);
+
+    // Cellular up: Wi-Fi released, the link stays up
+    stubDcs_SetUp(Cellular, true);
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(stubDcs_GetRequestCount(Wifi) == 0);
+    LE_ASSERT(dataLink_IsUp());
+    LE_ASSERT(ChangeCount == 0);
+
+    // Both down: the link goes down once
+    stubDcs_SetUp(Wifi, false);
+    stubDcs_SetUp(Cellular, false);
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(stubDcs_GetRequestCount(Wifi) == 1);
+    LE_ASSERT(!dataLink_IsUp());
+    LE_ASSERT( (ChangeCount == 1) && !LastIsUp );
+
+    // The fallback channel brings it back up
+    stubDcs_SetUp(Wifi, true);
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(dataLink_IsUp());
+    LE_ASSERT( (ChangeCount == 2) && LastIsUp );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Changing the channels while the link is down keeps it down until the new channels are found,
+ * and then tells the handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestChangeWhileDown(void)
+{
+    stubDcs_SetUp(Wifi, false);
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(!dataLink_IsUp());
+    ChangeCount = 0;
+
+    stubDcs_SetUp(Ethernet, true);
+    dataLink_SetChannels("eth0", "");
+    LE_ASSERT(!dataLink_IsUp());
+    LE_ASSERT(stubDcs_GetRequestCount(Cellular) == 0);
+    LE_ASSERT(stubDcs_GetHandlerCount(Cellular) == 0);
+    LE_ASSERT(ChangeCount == 0);
+
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(stubDcs_GetRequestCount(Ethernet) == 1);
+    LE_ASSERT(dataLink_IsUp());
+    LE_ASSERT( (ChangeCount == 1) && LastIsUp );
+
+    // Without a channel list the servers are polled regardless of the link
+    stubDcs_SetUp(Ethernet, false);
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(!dataLink_IsUp());
+    stubDcs_SetQueryResult(LE_FAULT);
+    dataLink_SetChannels("", "");
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(dataLink_IsUp());
+    LE_ASSERT( (ChangeCount == 3) && LastIsUp );
+    LE_ASSERT(stubDcs_GetRequestCount(Ethernet) == 0);
+    stubDcs_SetQueryResult(LE_OK);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releasing the channels stops their requests and their events, without calling the handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRelease(void)
+{
+    dataLink_SetChannels("rmnet0", "wlan0");
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(!dataLink_IsUp());
+    LE_ASSERT(stubDcs_GetRequestCount(Cellular) == 1);
+    LE_ASSERT(stubDcs_GetRequestCount(Wifi) == 1);
+    ChangeCount = 0;
+
+    dataLink_Release();
+    LE_ASSERT(dataLink_IsUp());
+    LE_ASSERT(stubDcs_GetRequestCount(Cellular) == 0);
+    LE_ASSERT(stubDcs_GetRequestCount(Wifi) == 0);
+    LE_ASSERT(stubDcs_GetHandlerCount(Cellular) == 0);
+    LE_ASSERT(stubDcs_GetHandlerCount(Wifi) == 0);
+
+    stubDcs_SetUp(Cellular, true);
+    stubLoop_Run(DELIVERY_MS);
+    LE_ASSERT(ChangeCount == 0);
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    Cellular = stubDcs_AddChannel("rmnet0", LE_DCS_TECH_CELLULAR, false);
+    Wifi = stubDcs_AddChannel("wlan0", LE_DCS_TECH_WIFI, true);
+    Ethernet = stubDcs_AddChannel("eth0", LE_DCS_TECH_ETHERNET, false);
+
+    dataLink_Init(LinkChangeHandler);
+
+    TestFallback();
+    TestChangeWhileDown();
+    TestRelease();
+
+    printf("dataLinkTest: ok\n");
+    return EXIT_SUCCESS;
+}
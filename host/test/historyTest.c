@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file historyTest.c
+ *
+ * Tests of the history of the transitions, as kept in the config tree and served by the
+ * trafficLight API
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+#include "history.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Times are restored from the config tree exactly, whether written as a string or as a float by
+ * an older version, and are written as strings
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestTimes(void)
+{
+    char monitor[MAX_MONITOR_NAME_BYTES];
+    char expected[32];
+    uint64_t time;
+    int32_t httpCode;
+    trafficLight_State_t state;
+    uint32_t latencyMs;
+
+    stubCfg_SetInt("/history/count", 2);
+    stubCfg_SetInt("/history/next", 2);
+    stubCfg_SetFloat("/history/entries/0/time", 1700000000);
+    stubCfg_SetString("/history/entries/0/monitor", "old");
+    stubCfg_SetInt("/history/entries/0/state", STATE_FAIL);
+    stubCfg_SetString("/history/entries/1/time", "253402300799");
+    stubCfg_SetString("/history/entries/1/monitor", "new");
+    stubCfg_SetInt("/history/entries/1/state", STATE_PASS);
+
+    history_Init();
+
+    LE_ASSERT(trafficLight_GetHistoryCount() == 2);
+    LE_ASSERT_OK(trafficLight_GetHistoryEntry(0, &time, monitor, sizeof(monitor),
+                                              &httpCode, &state, &latencyMs));
+    LE_ASSERT( (time == 253402300799ULL) && (strcmp(monitor, "new") == 0) );
+    LE_ASSERT_OK(trafficLight_GetHistoryEntry(1, &time, monitor, sizeof(monitor),
+                                              &httpCode, &state, &latencyMs));
+    LE_ASSERT( (time == 1700000000) && (strcmp(monitor, "old") == 0) );
+
+    history_Record("build", 200, STATE_WARNING, 12);
+    history_Flush();
+
+    LE_ASSERT_OK(trafficLight_GetHistoryEntry(0, &time, monitor, sizeof(monitor),
+                                              &httpCode, &state, &latencyMs));
+    snprintf(expected, sizeof(expected), "%" PRIu64, time);
+    LE_ASSERT(stubCfg_Get("/history/entries/2/time") != NULL);
+    LE_ASSERT(strcmp(stubCfg_Get("/history/entries/2/time"), expected) == 0);
+    LE_ASSERT(strcmp(stubCfg_Get("/history/entries/2/monitor"), "build") == 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counts the poll results received by a client
+ */
+//--------------------------------------------------------------------------------------------------
+static void CountPollResult
+(
+    const char * monitor,           ///< [IN] Unused
+    int32_t httpCode,               ///< [IN] Unused
+    trafficLight_State_t state,     ///< [IN] Unused
+    uint32_t latencyMs,             ///< [IN] Unused
+    void * contextPtr               ///< [IN] Count of the client
+)
+{
+    (*(int *) contextPtr)++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The PollResult handlers of a client are removed when its session closes, those of the other
+ * clients are kept
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestClientSessionClose(void)
+{
+    le_msg_SessionRef_t sessionA = (le_msg_SessionRef_t) 0xA;
+    le_msg_SessionRef_t sessionB = (le_msg_SessionRef_t) 0xB;
+    trafficLight_PollResultHandlerRef_t handlerRef;
+    int countA = 0;
+    int countB = 0;
+
+    stubMsg_SetClientSession(sessionA);
+    LE_ASSERT(trafficLight_AddPollResultHandler(CountPollResult, &countA));
+    LE_ASSERT(trafficLight_AddPollResultHandler(CountPollResult, &countA));
+    stubMsg_SetClientSession(sessionB);
+    handlerRef = trafficLight_AddPollResultHandler(CountPollResult, &countB);
+    LE_ASSERT(handlerRef);
+
+    history_ReportPoll("build", 200, STATE_PASS, 10);
+    stubLoop_Run(10);
+    LE_ASSERT( (countA == 2) && (countB == 1) );
+
+    stubMsg_CloseSession(sessionA);
+    history_ReportPoll("build", 200, STATE_PASS, 10);
+    stubLoop_Run(10);
+    LE_ASSERT( (countA == 2) && (countB == 2) );
+
+    trafficLight_RemovePollResultHandler(handlerRef);
+    stubMsg_CloseSession(sessionB);
+    history_ReportPoll("build", 200, STATE_PASS, 10);
+    stubLoop_Run(10);
+    LE_ASSERT(countB == 2);
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    TestTimes();
+    TestClientSessionClose();
+
+    printf("historyTest: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file lightTest.c
+ *
+ * Tests of the patterns of the towers, stepped by the event loop of the stubs
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+#include "light.h"
+
+// Tolerance on the time of a step: the timers are set in milliseconds and the loop wakes up within
+// a millisecond, far more on a loaded host. Steps are hundreds of milliseconds apart.
+#define STEP_TOLERANCE_US 20000
+
+// Most time between the writes of the towers done on the same wakeup
+#define SAME_WAKEUP_US 500
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the times of the writes of a pin since the writes were cleared
+ *
+ * @return
+ *      Number of writes
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetWriteTimes
+(
+    stubGpio_Pin_t pin,             ///< [IN] Pin
+    uint64_t * timesPtr,            ///< [OUT] Times of its writes
+    size_t maxCount                 ///< [IN] Size of the times buffer
+)
+{
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; (i < stubGpio_GetWriteCount()) && (count < maxCount); i++)
+    {
+        const stubGpio_Write_t * writePtr = stubGpio_GetWrite(i);
+
+        if (writePtr->pin == pin)
+        {
+            timesPtr[count++] = writePtr->timeUs;
+        }
+    }
+
+    return count;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The patterns of two towers shown together step together, on time, and a steady pattern is
+ * written once
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestPatternsStepTogether(void)
+{
+    LightPattern_t blink;
+    LightPattern_t pulse;
+    LightPattern_t steady;
+    uint64_t redTimes[16];
+    uint64_t red2Times[16];
+    uint64_t startUs;
+    size_t redCount;
+    size_t red2Count;
+    size_t i;
+
+    LE_ASSERT_OK(light_ParsePattern("blink red", &blink));
+    LE_ASSERT_OK(light_ParsePattern("pulse green", &pulse));
+    LE_ASSERT_OK(light_ParsePattern("steady yellow", &steady));
+
+    stubGpio_ClearWrites();
+    startUs = stubClk_GetUs();
+    light_Show(0, &blink);
+    light_Show(1, &blink);
+    light_Show(2, &steady);
+    stubLoop_Run(2200);
+
+    // On, then off and on every 500ms
+    redCount = GetWriteTimes(STUB_GPIO_RED, redTimes, NUM_ARRAY_MEMBERS(redTimes));
+    red2Count = GetWriteTimes(STUB_GPIO_RED2, red2Times, NUM_ARRAY_MEMBERS(red2Times));
+    LE_ASSERT(redCount == 5);
+    LE_ASSERT(red2Count == 5);
+    for (i = 1; i < redCount; i++)
+    {
+        uint64_t expectedUs = startUs + i * 500 * 1000;
+
+        LE_ASSERT(redTimes[i] >= expectedUs);
+        LE_ASSERT(redTimes[i] < expectedUs + STEP_TOLERANCE_US);
+        LE_ASSERT(red2Times[i] - redTimes[i] < SAME_WAKEUP_US);
+    }
+    LE_ASSERT(stubGpio_GetPinWriteCount(STUB_GPIO_YELLOW3) == 1);
+    LE_ASSERT(stubGpio_Get(STUB_GPIO_YELLOW3));
+
+    // Showing the same pattern again does not restart it, another one does
+    stubGpio_ClearWrites();
+    light_Show(0, &blink);
+    LE_ASSERT(stubGpio_GetWriteCount() == 0);
+    light_Show(1, &pulse);
+    stubGpio_ClearWrites();
+    stubLoop_Run(2100);
+    LE_ASSERT(GetWriteTimes(STUB_GPIO_GREEN2, red2Times, NUM_ARRAY_MEMBERS(red2Times)) == 2);
+
+    // Steady patterns stop the timer: nothing is written anymore
+    light_Show(0, &steady);
+    light_Show(1, &steady);
+    stubGpio_ClearWrites();
+    stubLoop_Run(3000);
+    LE_ASSERT(stubGpio_GetWriteCount() == 0);
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    stubGpio_Bind(1);
+    stubGpio_Bind(2);
+    light_Init();
+
+    TestPatternsStepTogether();
+
+    light_Deinit();
+    printf("lightTest: ok\n");
+    return EXIT_SUCCESS;
+}
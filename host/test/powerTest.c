@@ -0,0 +1,121 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file powerTest.c
+ *
+ * Tests of the wakeup source held for the polls, over the le_pm stub
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+#include "power.h"
+
+// Time a poll holds the wakeup source for, and the time between polls
+#define POLL_MS 200
+#define IDLE_MS 800
+
+// Tolerance on the times held, the loop wakes up within a few milliseconds on a loaded host
+#define HELD_TOLERANCE_US 20000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the counters of the wakeup source, and gets one of them
+ *
+ * @return
+ *      Value of the counter
+ */
+//--------------------------------------------------------------------------------------------------
+static int GetCounter
+(
+    const char * namePtr            ///< [IN] Counter, relative to /stats/power
+)
+{
+    le_cfg_IteratorRef_t iteratorRef = le_cfg_CreateWriteTxn("/stats");
+    char path[64];
+    const char * valuePtr;
+
+    power_Write(iteratorRef);
+    le_cfg_CommitTxn(iteratorRef);
+
+    snprintf(path, sizeof(path), "/stats/power/%s", namePtr);
+    valuePtr = stubCfg_Get(path);
+    LE_ASSERT(valuePtr);
+    return atoi(valuePtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Out of low-power mode the wakeup source is held all the time, polls or not
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestAlwaysAwake(void)
+{
+    LE_ASSERT(stubPm_IsAwake());
+
+    power_SetLowPower(false);
+    power_StayAwake();
+    power_Relax();
+    LE_ASSERT(stubPm_IsAwake());
+    LE_ASSERT(stubPm_GetStayAwakeCount() == 1);
+    LE_ASSERT(stubPm_GetRelaxCount() == 0);
+    LE_ASSERT(GetCounter("wakeups") == 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * In low-power mode the wakeup source is only held during the polls, and the counters tell for how
+ * long
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestLowPower(void)
+{
+    uint64_t heldUs;
+    int i;
+
+    power_SetLowPower(true);
+    LE_ASSERT(!stubPm_IsAwake());
+    heldUs = stubPm_GetHeldUs();
+
+    for (i = 0; i < 3; i++)
+    {
+        stubLoop_Run(IDLE_MS);
+
+        power_StayAwake();
+        power_StayAwake();
+        LE_ASSERT(stubPm_IsAwake());
+        stubLoop_Run(POLL_MS);
+        power_Relax();
+        LE_ASSERT(!stubPm_IsAwake());
+    }
+
+    // Held once per poll, and released as many times
+    LE_ASSERT(stubPm_GetStayAwakeCount() == 1 + 3);
+    LE_ASSERT(stubPm_GetRelaxCount() == 1 + 3);
+    LE_ASSERT(GetCounter("wakeups") == 1 + 3);
+
+    heldUs = stubPm_GetHeldUs() - heldUs;
+    LE_ASSERT(heldUs >= 3 * POLL_MS * 1000);
+    LE_ASSERT(heldUs < 3 * (POLL_MS * 1000 + HELD_TOLERANCE_US));
+
+    // Held for about a fifth of the time since the polls started
+    LE_ASSERT(GetCounter("awakePermille") < 1000 * (POLL_MS + 50) / (POLL_MS + IDLE_MS));
+
+    // Back out of low-power mode, held again
+    power_SetLowPower(false);
+    LE_ASSERT(stubPm_IsAwake());
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    power_Init();
+
+    TestAlwaysAwake();
+    TestLowPower();
+
+    printf("powerTest: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file responseTest.c
+ *
+ * Tests of the rest of a response received once its state is known, with the component run as a
+ * whole against the HTTP server of the stubs: a short rest is drained and the connection kept for
+ * the next polls, a long one is aborted
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+
+// Path of the build polled
+#define BUILD_PATH "/job/build/lastBuild/api/xml"
+
+// Buffer of the responses, and size of the chunks they are sent in
+#define RESPONSE_BUFFER_BYTES 4096
+#define CHUNK_BYTES 256
+
+// Polling interval, and number of polls each test waits for
+#define POLLING_INTERVAL_SEC 1
+#define POLL_COUNT 3
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the build polled, its result followed by a description of unknown length
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetBuild
+(
+    const char * resultPtr,         ///< [IN] Result, e.g. SUCCESS
+    size_t descriptionBytes         ///< [IN] Length of the description after the result
+)
+{
+    static char body[128 * 1024];
+    stubHttp_Response_t response = { .status = 200, .bodyPtr = body, .chunkBytes = CHUNK_BYTES };
+    int length = snprintf(body, sizeof(body),
+                          "<freeStyleBuild><result>%s</result><description>", resultPtr);
+
+    LE_ASSERT(length + descriptionBytes + 64 < sizeof(body));
+    memset(body + length, 'x', descriptionBytes);
+    strcpy(body + length + descriptionBytes, "</description></freeStyleBuild>");
+    stubHttp_SetResponse(BUILD_PATH, &response);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the light is green, or red
+ *
+ * @return
+ *      true if it is
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsGreen
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    return stubGpio_Get(STUB_GPIO_GREEN) && !stubGpio_Get(STUB_GPIO_RED);
+}
+
+static bool IsRed
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    return stubGpio_Get(STUB_GPIO_RED) && !stubGpio_Get(STUB_GPIO_GREEN);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A chunked response whose rest fits in the buffer is drained: the polls reuse the connection
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestDrained(void)
+{
+    uint32_t requestCount;
+    uint32_t connectionCount;
+
+    SetBuild("SUCCESS", RESPONSE_BUFFER_BYTES / 2);
+    LE_ASSERT(stubLoop_RunUntil(IsGreen, NULL, 5000));
+
+    requestCount = stubHttp_GetRequestCount(BUILD_PATH);
+    connectionCount = stubHttp_GetConnectionCount();
+    stubLoop_Run(POLL_COUNT * POLLING_INTERVAL_SEC * 1000 + 500);
+
+    LE_ASSERT(stubHttp_GetRequestCount(BUILD_PATH) >= requestCount + POLL_COUNT);
+    LE_ASSERT(stubHttp_GetConnectionCount() == connectionCount);
+    LE_ASSERT(IsGreen(NULL));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A chunked response whose rest is more than the buffer is aborted once its state is known: each
+ * poll opens a new connection, and the state is still the one of the response
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestAborted(void)
+{
+    uint32_t requestCount;
+    uint32_t connectionCount;
+
+    SetBuild("FAILURE", 16 * RESPONSE_BUFFER_BYTES);
+    LE_ASSERT(stubLoop_RunUntil(IsRed, NULL, 5000));
+
+    requestCount = stubHttp_GetRequestCount(BUILD_PATH);
+    connectionCount = stubHttp_GetConnectionCount();
+    stubLoop_Run(POLL_COUNT * POLLING_INTERVAL_SEC * 1000 + 500);
+
+    requestCount = stubHttp_GetRequestCount(BUILD_PATH) - requestCount;
+    LE_ASSERT(requestCount >= POLL_COUNT);
+    LE_ASSERT(stubHttp_GetConnectionCount() - connectionCount >= requestCount);
+    LE_ASSERT(IsRed(NULL));
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    uint16_t port = stubHttp_Start();
+    char url[128];
+
+    SetBuild("SUCCESS", 0);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u" BUILD_PATH, port);
+    stubCfg_SetString("/url", url);
+    stubCfg_SetBool("/info/exitCode/checkFlag", true);
+    stubCfg_SetBool("/info/content/checkFlag", true);
+    stubCfg_SetString("/info/content/checkMode", "jenkins");
+    stubCfg_SetInt("/pollingIntervalSec", POLLING_INTERVAL_SEC);
+    stubCfg_SetInt("/responseBufferBytes", RESPONSE_BUFFER_BYTES);
+
+    _le_stub_ComponentInit();
+
+    TestDrained();
+    TestAborted();
+
+    // The component exits once its resources are released
+    printf("responseTest: ok\n");
+    stubSig_Raise(SIGTERM);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,164 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file streamTest.c
+ *
+ * Tests of the stream of events of the component, run as a whole against the HTTP server of the
+ * stubs: the light follows the events of the stream, and the polling timer takes over once the
+ * stream drops
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+
+// Paths of the build polled and of the stream
+#define BUILD_PATH "/job/build/lastBuild/api/xml"
+#define STREAM_PATH "/events"
+
+// Most time from the end of a build to its light, when the stream tells it
+#define STREAM_LATENCY_MS 1000
+
+// Polling interval once the stream dropped
+#define POLLING_INTERVAL_SEC 1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the result of the build polled
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetBuildResult
+(
+    const char * resultPtr          ///< [IN] Result, e.g. SUCCESS
+)
+{
+    char body[128];
+    stubHttp_Response_t response = { .status = 200, .bodyPtr = body };
+
+    snprintf(body, sizeof(body), "<freeStyleBuild><result>%s</result></freeStyleBuild>", resultPtr);
+    stubHttp_SetResponse(BUILD_PATH, &response);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the light is green, or red
+ *
+ * @return
+ *      true if it is
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsGreen
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    return stubGpio_Get(STUB_GPIO_GREEN) && !stubGpio_Get(STUB_GPIO_RED);
+}
+
+static bool IsRed
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    return stubGpio_Get(STUB_GPIO_RED) && !stubGpio_Get(STUB_GPIO_GREEN);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the stream is open on the server
+ *
+ * @return
+ *      true if it is
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsStreamOpen
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    return stubHttp_GetStreamCount() > 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * While the stream is connected the build is only polled on its events, and its light changes
+ * within a second of the event
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestEvents(void)
+{
+    uint32_t requestCount;
+    uint64_t startUs;
+
+    LE_ASSERT(stubLoop_RunUntil(IsStreamOpen, NULL, 5000));
+    LE_ASSERT(stubLoop_RunUntil(IsGreen, NULL, 5000));
+
+    // No poll without an event
+    stubLoop_Run(100);
+    requestCount = stubHttp_GetRequestCount(BUILD_PATH);
+    stubLoop_Run(3 * POLLING_INTERVAL_SEC * 1000);
+    LE_ASSERT(stubHttp_GetRequestCount(BUILD_PATH) == requestCount);
+
+    // The build fails: the light is red within a second of the event
+    SetBuildResult("FAILURE");
+    startUs = stubClk_GetUs();
+    stubHttp_SendEvent("build", "{\"job\":\"build\",\"result\":\"FAILURE\"}");
+    LE_ASSERT(stubLoop_RunUntil(IsRed, NULL, STREAM_LATENCY_MS));
+    LE_INFO("Light changed %" PRIu64 " us after the event", stubClk_GetUs() - startUs);
+    LE_ASSERT(stubHttp_GetRequestCount(BUILD_PATH) == requestCount + 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Once the stream drops, the build is polled right away and then on the polling timer
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestDrop(void)
+{
+    stubHttp_Response_t refused = { .status = 503 };
+    uint32_t requestCount = stubHttp_GetRequestCount(BUILD_PATH);
+
+    stubHttp_SetResponse(STREAM_PATH, &refused);
+    SetBuildResult("SUCCESS");
+    stubHttp_DropStreams();
+
+    LE_ASSERT(stubLoop_RunUntil(IsGreen, NULL, STREAM_LATENCY_MS));
+    LE_ASSERT(stubHttp_GetRequestCount(BUILD_PATH) == requestCount + 1);
+
+    stubLoop_Run(3 * POLLING_INTERVAL_SEC * 1000 + 500);
+    LE_ASSERT(stubHttp_GetRequestCount(BUILD_PATH) >= requestCount + 1 + 3);
+    LE_ASSERT(!IsStreamOpen(NULL));
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    stubHttp_Response_t stream = { .status = 200, .isStream = true };
+    uint16_t port = stubHttp_Start();
+    char url[128];
+
+    SetBuildResult("SUCCESS");
+    stubHttp_SetResponse(STREAM_PATH, &stream);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u" BUILD_PATH, port);
+    stubCfg_SetString("/url", url);
+    stubCfg_SetBool("/info/exitCode/checkFlag", true);
+    stubCfg_SetBool("/info/content/checkFlag", true);
+    stubCfg_SetString("/info/content/checkMode", "jenkins");
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u" STREAM_PATH, port);
+    stubCfg_SetString("/streamUrl", url);
+    stubCfg_SetInt("/pollingIntervalSec", POLLING_INTERVAL_SEC);
+    stubCfg_SetInt("/streamRetrySec", 60);
+
+    _le_stub_ComponentInit();
+
+    TestEvents();
+    TestDrop();
+
+    // The component exits once its resources are released
+    printf("streamTest: ok\n");
+    stubSig_Raise(SIGTERM);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,205 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file towerTest.c
+ *
+ * Tests of the rules of the towers, with the component run as a whole against the HTTP server of
+ * the stubs: the weighted and anyCritical rules, and an invalid rule shown as the worst state of
+ * all the monitors. The monitors change one after the other, so that the towers are evaluated
+ * again from the weights of their monitors in each state.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+
+// Monitors, each polled for its own build
+#define MONITOR_COUNT 3
+
+// Polling interval, and most time for a change of a build to be shown
+#define POLLING_INTERVAL_SEC 1
+#define UPDATE_MS (3 * POLLING_INTERVAL_SEC * 1000)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Color of a tower
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    COLOR_RED,
+    COLOR_YELLOW,
+    COLOR_GREEN,
+}
+Color_t;
+
+// Names of the monitors
+static const char * const MonitorNames[MONITOR_COUNT] = { "a", "b", "c" };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the results of the builds of the monitors
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetResults
+(
+    const char * const resultPtrs[MONITOR_COUNT]    ///< [IN] Results, e.g. SUCCESS, by monitor
+)
+{
+    char path[64];
+    char body[128];
+    stubHttp_Response_t response = { .status = 200, .bodyPtr = body };
+    size_t i;
+
+    for (i = 0; i < MONITOR_COUNT; i++)
+    {
+        snprintf(path, sizeof(path), "/job/%s/lastBuild/api/xml", MonitorNames[i]);
+        snprintf(body, sizeof(body),
+                 "<freeStyleBuild><result>%s</result></freeStyleBuild>", resultPtrs[i]);
+        stubHttp_SetResponse(path, &response);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the towers show their colors
+ *
+ * @return
+ *      true if they all do
+ */
+//--------------------------------------------------------------------------------------------------
+static bool AreColors
+(
+    void * contextPtr               ///< [IN] Colors expected, by tower
+)
+{
+    const Color_t * colorsPtr = contextPtr;
+    size_t tower;
+
+    for (tower = 0; tower < 3; tower++)
+    {
+        stubGpio_Pin_t redPin = STUB_GPIO_RED + tower * (STUB_GPIO_RED2 - STUB_GPIO_RED);
+
+        if ( (stubGpio_Get(redPin) != (colorsPtr[tower] == COLOR_RED)) ||
+             (stubGpio_Get(redPin + STUB_GPIO_YELLOW - STUB_GPIO_RED) !=
+              (colorsPtr[tower] == COLOR_YELLOW)) ||
+             (stubGpio_Get(redPin + STUB_GPIO_GREEN - STUB_GPIO_RED) !=
+              (colorsPtr[tower] == COLOR_GREEN)) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the results of the builds, and waits until the towers show their colors
+ */
+//--------------------------------------------------------------------------------------------------
+static void Check
+(
+    const char * aPtr,              ///< [IN] Result of the build of a
+    const char * bPtr,              ///< [IN] Result of the build of b
+    const char * cPtr,              ///< [IN] Result of the build of c
+    Color_t weighted,               ///< [IN] Color of the tower of "weighted(a:3, b, c)"
+    Color_t anyCritical,            ///< [IN] Color of the tower of "anyCritical(b, c)"
+    Color_t invalid                 ///< [IN] Color of the tower of the invalid rule
+)
+{
+    const char * const results[MONITOR_COUNT] = { aPtr, bPtr, cPtr };
+    Color_t colors[] = { weighted, anyCritical, invalid };
+
+    SetResults(results);
+    LE_ASSERT(stubLoop_RunUntil(AreColors, colors, UPDATE_MS));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The heavier monitor decides a weighted rule, against the number of monitors in each state
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestWeighted(void)
+{
+    // Two monitors of weight 1 fail, the one of weight 3 passes
+    Check("SUCCESS", "FAILURE", "FAILURE", COLOR_GREEN, COLOR_RED, COLOR_RED);
+
+    // The other way round
+    Check("FAILURE", "SUCCESS", "SUCCESS", COLOR_RED, COLOR_GREEN, COLOR_RED);
+
+    // The heavier monitor passes again, a lighter one warns: still less than half of the weight
+    Check("SUCCESS", "UNSTABLE", "SUCCESS", COLOR_GREEN, COLOR_GREEN, COLOR_YELLOW);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * anyCritical only fails when one of its monitors fails, warnings do not count
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestAnyCritical(void)
+{
+    // One monitor warns, the other fails
+    Check("SUCCESS", "UNSTABLE", "FAILURE", COLOR_GREEN, COLOR_RED, COLOR_RED);
+
+    // Only the warning is left
+    Check("SUCCESS", "UNSTABLE", "SUCCESS", COLOR_GREEN, COLOR_GREEN, COLOR_YELLOW);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * An invalid rule shows the worst state of all the monitors, not only of those it names
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestInvalid(void)
+{
+    // "a" is the only monitor named, and passes
+    Check("SUCCESS", "SUCCESS", "FAILURE", COLOR_GREEN, COLOR_RED, COLOR_RED);
+    Check("SUCCESS", "SUCCESS", "SUCCESS", COLOR_GREEN, COLOR_GREEN, COLOR_GREEN);
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    uint16_t port = stubHttp_Start();
+    char key[64];
+    char url[128];
+    size_t i;
+
+    stubGpio_Bind(1);
+    stubGpio_Bind(2);
+
+    for (i = 0; i < MONITOR_COUNT; i++)
+    {
+        snprintf(url, sizeof(url), "http://127.0.0.1:%u/job/%s/lastBuild/api/xml",
+                 port, MonitorNames[i]);
+        snprintf(key, sizeof(key), "/monitors/%s/url", MonitorNames[i]);
+        stubCfg_SetString(key, url);
+        snprintf(key, sizeof(key), "/monitors/%s/info/exitCode/checkFlag", MonitorNames[i]);
+        stubCfg_SetBool(key, true);
+        snprintf(key, sizeof(key), "/monitors/%s/info/content/checkFlag", MonitorNames[i]);
+        stubCfg_SetBool(key, true);
+        snprintf(key, sizeof(key), "/monitors/%s/info/content/checkMode", MonitorNames[i]);
+        stubCfg_SetString(key, "jenkins");
+    }
+    stubCfg_SetInt("/pollingIntervalSec", POLLING_INTERVAL_SEC);
+
+    stubCfg_SetInt("/towers/weighted/output", 1);
+    stubCfg_SetString("/towers/weighted/rule", "weighted(a:3, b, c)");
+    stubCfg_SetInt("/towers/critical/output", 2);
+    stubCfg_SetString("/towers/critical/rule", "anyCritical(b, c)");
+    stubCfg_SetInt("/towers/invalid/output", 3);
+    stubCfg_SetString("/towers/invalid/rule", "weighted(a:0)");
+
+    _le_stub_ComponentInit();
+
+    TestWeighted();
+    TestAnyCritical();
+    TestInvalid();
+
+    // The component exits once its resources are released
+    printf("towerTest: ok\n");
+    stubSig_Raise(SIGTERM);
+    return EXIT_FAILURE;
+}
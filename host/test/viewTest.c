@@ -0,0 +1,249 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file viewTest.c
+ *
+ * Tests of the jobs of a Jenkins view shown as monitors of their own, with the component run as a
+ * whole against the HTTP server of the stubs
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "stubs.h"
+
+// Path of the API of the view polled, added to its URL
+#define VIEW_API_PATH "/view/Team/api/json"
+
+// JSON object of a job, as answered with the tree filter
+#define JOB(name, color, result) \
+    "{\"name\":\"" name "\",\"color\":\"" color "\",\"lastCompletedBuild\":{\"result\":\"" \
+    result "\"}}"
+
+// Views added to the one polled, more than the checks of views the poll arena once held
+#define EXTRA_VIEW_COUNT 8
+
+// Polling interval, and most time for a change of the view to be shown
+#define POLLING_INTERVAL_SEC 1
+#define UPDATE_MS (3 * POLLING_INTERVAL_SEC * 1000)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Light of a tower, as in the README
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    stubGpio_Pin_t redPin;          ///< Red pin of the tower
+    bool isRed;                     ///< Whether it must be red, green otherwise
+}
+Light_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the jobs of the view, as answered with the tree filter
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetJobs
+(
+    const char * jobsPtr            ///< [IN] JSON objects of the jobs, separated by commas
+)
+{
+    char body[1024];
+    stubHttp_Response_t response = { .status = 200, .bodyPtr = body };
+
+    snprintf(body, sizeof(body),
+             "{\"_class\":\"hudson.model.ListView\",\"jobs\":[%s]}", jobsPtr);
+    stubHttp_SetResponse(VIEW_API_PATH, &response);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether a tower is red, or green
+ *
+ * @return
+ *      true if it is as expected
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsLight
+(
+    void * contextPtr               ///< [IN] Light_t expected
+)
+{
+    const Light_t * lightPtr = contextPtr;
+    stubGpio_Pin_t greenPin = lightPtr->redPin + (STUB_GPIO_GREEN - STUB_GPIO_RED);
+
+    return (stubGpio_Get(lightPtr->redPin) == lightPtr->isRed) &&
+           (stubGpio_Get(greenPin) != lightPtr->isRed);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Waits until a tower shows a state
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitLight
+(
+    stubGpio_Pin_t redPin,          ///< [IN] Red pin of the tower
+    bool isRed                      ///< [IN] Whether it must be red, green otherwise
+)
+{
+    Light_t light = { .redPin = redPin, .isRed = isRed };
+
+    LE_ASSERT(stubLoop_RunUntil(IsLight, &light, UPDATE_MS));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The towers select the jobs of the view by name, while the rules without a job term only see
+ * the view
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestJobTowers(void)
+{
+    SetJobs(JOB("api", "blue", "SUCCESS") ","
+            JOB("deploy", "red", "FAILURE") ","
+            JOB("docs", "blue_anime", "SUCCESS"));
+
+    _le_stub_ComponentInit();
+
+    WaitLight(STUB_GPIO_RED, false);
+    WaitLight(STUB_GPIO_RED2, true);
+    WaitLight(STUB_GPIO_RED3, false);
+    LE_ASSERT(stubHttp_GetRequestCount(VIEW_API_PATH) > 0);
+
+    // A job changes: only its tower follows
+    SetJobs(JOB("api", "red", "FAILURE") ","
+            JOB("deploy", "red", "FAILURE") ","
+            JOB("docs", "blue", "SUCCESS"));
+    WaitLight(STUB_GPIO_RED, true);
+    WaitLight(STUB_GPIO_RED2, true);
+
+    // Most of the jobs fail
+    WaitLight(STUB_GPIO_RED3, true);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A job added to the view is selected by the towers naming it, a job removed is no longer
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestJobsChange(void)
+{
+    // The only failing job is half of the jobs: the majority of them fail
+    SetJobs(JOB("api", "blue", "SUCCESS") ","
+            JOB("deploy", "red", "FAILURE"));
+    WaitLight(STUB_GPIO_RED, false);
+    WaitLight(STUB_GPIO_RED3, true);
+
+    // It is removed, and the job added fails: a third of the jobs fail, the majority passes, and
+    // the tower naming the job added shows it
+    SetJobs(JOB("api", "blue", "SUCCESS") ","
+            JOB("docs", "blue", "SUCCESS") ","
+            JOB("lint", "red", "FAILURE"));
+    WaitLight(STUB_GPIO_RED3, false);
+    WaitLight(STUB_GPIO_RED, true);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the added views have all been polled at least twice, so that a poll of all of
+ * them is done
+ *
+ * @return
+ *      true if they have
+ */
+//--------------------------------------------------------------------------------------------------
+static bool AreViewsPolled
+(
+    void * contextPtr               ///< [IN] Unused
+)
+{
+    char path[64];
+    size_t i;
+
+    for (i = 0; i < EXTRA_VIEW_COUNT; i++)
+    {
+        snprintf(path, sizeof(path), "/view/V%zu/api/json", i);
+        if (stubHttp_GetRequestCount(path) < 2)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * All the views of a config are polled in the same poll: the tower of all the monitors stays green
+ * with more views than a few
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestManyViews
+(
+    uint16_t port                   ///< [IN] Port of the server
+)
+{
+    static const char body[] = "{\"_class\":\"hudson.model.ListView\",\"jobs\":["
+                               JOB("api", "blue", "SUCCESS") "]}";
+    stubHttp_Response_t response = { .status = 200, .bodyPtr = body };
+    Light_t light = { .redPin = STUB_GPIO_RED2, .isRed = false };
+    char path[64];
+    char key[64];
+    char url[128];
+    size_t i;
+
+    // The jobs of the first view all pass again
+    SetJobs(JOB("api", "blue", "SUCCESS"));
+
+    for (i = 0; i < EXTRA_VIEW_COUNT; i++)
+    {
+        snprintf(path, sizeof(path), "/view/V%zu/api/json", i);
+        stubHttp_SetResponse(path, &response);
+
+        snprintf(url, sizeof(url), "http://127.0.0.1:%u/view/V%zu/", port, i);
+        snprintf(key, sizeof(key), "/monitors/v%zu/url", i);
+        stubCfg_SetString(key, url);
+        snprintf(key, sizeof(key), "/monitors/v%zu/info/content/checkFlag", i);
+        stubCfg_SetBool(key, true);
+        snprintf(key, sizeof(key), "/monitors/v%zu/info/content/checkMode", i);
+        stubCfg_SetString(key, "jenkinsView");
+    }
+
+    // A view that did not fit in the poll arena would be a warning
+    LE_ASSERT(stubLoop_RunUntil(AreViewsPolled, NULL, UPDATE_MS));
+    LE_ASSERT(IsLight(&light));
+}
+
+int main
+(
+    int argc,
+    char * argv[]
+)
+{
+    uint16_t port = stubHttp_Start();
+    char url[128];
+
+    stubGpio_Bind(1);
+    stubGpio_Bind(2);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/view/Team/", port);
+    stubCfg_SetString("/monitors/ci/url", url);
+    stubCfg_SetBool("/monitors/ci/info/content/checkFlag", true);
+    stubCfg_SetString("/monitors/ci/info/content/checkMode", "jenkinsView");
+    stubCfg_SetInt("/pollingIntervalSec", POLLING_INTERVAL_SEC);
+
+    stubCfg_SetInt("/towers/named/output", 1);
+    stubCfg_SetString("/towers/named/rule", "worst(ci/api, ci/lint)");
+    stubCfg_SetInt("/towers/view/output", 2);
+    stubCfg_SetString("/towers/view/rule", "worst");
+    stubCfg_SetInt("/towers/jobs/output", 3);
+    stubCfg_SetString("/towers/jobs/rule", "majority(ci/*)");
+
+    TestJobTowers();
+    TestJobsChange();
+    TestManyViews(port);
+
+    // The component exits once its resources are released
+    printf("viewTest: ok\n");
+    stubSig_Raise(SIGTERM);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,1090 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file contentCheck.c
+ *
+ * Registry of the content checkers, and checks of keywords (e.g. Jenkins jobs) and Sensu metrics,
+ * see contentCheck.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "contentCheck.h"
+#include <ctype.h>
+#include <math.h>
+
+// Element of the result of a Jenkins build, where its keywords count unless info/content/anchor
+// is set
+#define JENKINS_RESULT_ANCHOR "<result>"
+
+// Most checkers that can be registered
+#define CONTENT_CHECK_MAX_CHECKERS 16
+
+// Bits of the keyword automaton: one per keyword, by priority order, then the bits below
+#define KEYWORD_BIT_ANCHOR      (1u << MAX_CONTENT_KEYWORDS)
+#define KEYWORD_BIT_ANCHOR_END  (1u << (MAX_CONTENT_KEYWORDS + 1))
+#define KEYWORD_BIT_BUILDING    (1u << (MAX_CONTENT_KEYWORDS + 2))
+#define KEYWORD_PATTERN_COUNT   (MAX_CONTENT_KEYWORDS + 3)
+
+// Longest key of the Sensu metrics that needs to be recognized, with its NULL char
+#define SENSU_MAX_KEY_BYTES 16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the check of keywords, e.g. the result of a Jenkins job, see CheckKeywordResult
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const ContentCheckParams_t * paramsPtr;     ///< Keywords and their automaton
+    uint16_t node;                              ///< Node of the automaton reached so far
+    uint32_t found;                             ///< Keywords found so far
+    bool isInAnchor;                            ///< Whether the content is in the anchor element
+    bool isBuilding;                            ///< Whether a Jenkins build is in progress
+}
+KeywordCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tokens of the JSON content of Sensu metrics, as tracked by FeedSensuContent
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SENSU_TOKEN_NONE,           ///< Between tokens
+    SENSU_TOKEN_STRING,         ///< In a string
+    SENSU_TOKEN_ESCAPE,         ///< After a backslash in a string
+    SENSU_TOKEN_KEY,            ///< After a string, which is a key if a colon follows
+    SENSU_TOKEN_NUMBER,         ///< In the integer part of a number
+    SENSU_TOKEN_FRACTION,       ///< In the fraction or exponent of a number
+}
+SensuToken_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keys of the Sensu metrics whose values are counted
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SENSU_KEY_NONE,
+    SENSU_KEY_CRITICAL,
+    SENSU_KEY_WARNING,
+}
+SensuKey_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the check of Sensu metrics, see CheckSensuResult
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    SensuToken_t token;                 ///< Token the content is in
+    char string[SENSU_MAX_KEY_BYTES];   ///< Start of the string being read
+    size_t stringLength;                ///< Length of the string being read, may exceed the buffer
+    SensuKey_t key;                     ///< Key the next value belongs to
+    uint64_t number;                    ///< Number being read
+    uint64_t criticalCount;             ///< Sum of the values of the "critical" keys
+    uint64_t warningCount;              ///< Sum of the values of the "warning" keys
+}
+SensuCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keywords of a Jenkins job result, by priority order, used when info/content/keywords is not set
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentKeyword_t JenkinsKeywords[] =
+{
+    { "SUCCESS",  STATE_PASS },
+    { "FAILURE",  STATE_FAIL },
+    { "ABORTED",  STATE_PASS },
+    { "UNSTABLE", STATE_WARNING },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checkers registered, by checkMode
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentChecker_t * Checkers[CONTENT_CHECK_MAX_CHECKERS];
+static size_t CheckerCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Automata of the keyword checks, only allocated for the monitors whose checker looks for keywords
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t AutomatonPool = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the automaton looking for the keywords, the anchor element and, for Jenkins, a build in
+ * progress, all in a single pass over the content.
+ *
+ * @return
+ *      - LE_OK if the automaton is built
+ *      - LE_OVERFLOW if the keywords are too long, nothing is found then
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t BuildKeywordAutomaton
+(
+    ContentCheckParams_t * paramsPtr,   ///< [IN/OUT] Settings of the check
+    const char * buildingPtr            ///< [IN] Marker of a job in progress, "" if none
+)
+{
+    const char * patterns[KEYWORD_PATTERN_COUNT];
+    size_t i;
+
+    for (i = 0; i < MAX_CONTENT_KEYWORDS; i++)
+    {
+        patterns[i] = (i < paramsPtr->keywordCount) ? paramsPtr->keywords[i].keyword : "";
+    }
+
+    // An element <x> ends with </x> unless told otherwise
+    if ( (paramsPtr->anchorEnd[0] == '\0') && (paramsPtr->anchor[0] == '<') )
+    {
+        snprintf(paramsPtr->anchorEnd, sizeof(paramsPtr->anchorEnd), "</%s", paramsPtr->anchor + 1);
+    }
+
+    patterns[MAX_CONTENT_KEYWORDS] = paramsPtr->anchor;
+    patterns[MAX_CONTENT_KEYWORDS + 1] = paramsPtr->anchorEnd;
+    patterns[MAX_CONTENT_KEYWORDS + 2] = buildingPtr;
+
+    if (AutomatonPool == NULL)
+    {
+        AutomatonPool = le_mem_CreatePool("KeywordAutomata", sizeof(KeywordAutomaton_t));
+    }
+    if (paramsPtr->automatonPtr == NULL)
+    {
+        paramsPtr->automatonPtr = le_mem_ForceAlloc(AutomatonPool);
+    }
+
+    if (keywordMatch_Compile(paramsPtr->automatonPtr, patterns, KEYWORD_PATTERN_COUNT) != LE_OK)
+    {
+        LE_ERROR("Keywords are too long, none can be found");
+        keywordMatch_Compile(paramsPtr->automatonPtr, NULL, 0);
+        return LE_OVERFLOW;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the automaton of the keywords of info/content/keywords
+ *
+ * @return
+ *      - LE_OK if the automaton is built
+ *      - LE_OVERFLOW if the keywords are too long
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PrepareKeywordCheck
+(
+    ContentCheckParams_t * paramsPtr    ///< [IN/OUT] Settings of the check
+)
+{
+    return BuildKeywordAutomaton(paramsPtr, "");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the automaton of the keywords of a Jenkins job, the default ones if info/content/keywords
+ * is not set, counted in its <result> element if info/content/anchor is not set.
+ *
+ * @return
+ *      - LE_OK if the automaton is built
+ *      - LE_OVERFLOW if the keywords are too long
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PrepareJenkinsCheck
+(
+    ContentCheckParams_t * paramsPtr    ///< [IN/OUT] Settings of the check
+)
+{
+    contentCheck_SetJenkinsKeywords(paramsPtr);
+
+    // Only the result of the build counts, not the same words in its changelog or its causes
+    if (paramsPtr->anchor[0] == '\0')
+    {
+        le_utf8_Copy(paramsPtr->anchor, JENKINS_RESULT_ANCHOR, sizeof(paramsPtr->anchor), NULL);
+    }
+
+    return BuildKeywordAutomaton(paramsPtr, "<building>true</building>");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the check of keywords
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitKeywordCheck
+(
+    void * statePtr,                        ///< [OUT] Check to initialize
+    const ContentCheckParams_t * paramsPtr  ///< [IN] Keywords and their automaton
+)
+{
+    KeywordCheck_t * checkPtr = statePtr;
+
+    checkPtr->paramsPtr = paramsPtr;
+    checkPtr->node = 0;
+    checkPtr->found = 0;
+    checkPtr->isInAnchor = false;
+    checkPtr->isBuilding = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the content, e.g. of a Jenkins job REST API <job>/<build>/api/xml. All the
+ * keywords are looked for at once, each character is read once.
+ *
+ * @return
+ *      true once the verdict is known: the keyword with the highest priority is found, or the
+ *      anchor element ends after a keyword
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FeedKeywordContent
+(
+    void * statePtr,                ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    KeywordCheck_t * checkPtr = statePtr;
+    const ContentCheckParams_t * paramsPtr = checkPtr->paramsPtr;
+    bool isAnchored = (paramsPtr->anchor[0] != '\0');
+    size_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        uint32_t matches = keywordMatch_Feed(paramsPtr->automatonPtr,
+                                             &checkPtr->node,
+                                             dataPtr[index]);
+
+        if (matches == 0)
+        {
+            continue;
+        }
+
+        if (!isAnchored || checkPtr->isInAnchor)
+        {
+            checkPtr->found |= matches & ((1u << MAX_CONTENT_KEYWORDS) - 1);
+        }
+
+        // The building element comes before the result, it is known when the transfer stops
+        if (matches & KEYWORD_BIT_BUILDING)
+        {
+            checkPtr->isBuilding = true;
+        }
+
+        if (matches & KEYWORD_BIT_ANCHOR)
+        {
+            checkPtr->isInAnchor = true;
+        }
+
+        if (matches & KEYWORD_BIT_ANCHOR_END)
+        {
+            checkPtr->isInAnchor = false;
+            if (checkPtr->found)
+            {
+                return true;
+            }
+        }
+
+        if (checkPtr->found & 1)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the state of the content, e.g. of a Jenkins job as returned by the REST API
+ * <job>/<build>/api/xml
+ *
+ * @return
+ *      State of the keyword found with the highest priority, STATE_FAIL if none is found
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t CheckKeywordResult
+(
+    void * statePtr                 ///< [IN] Check fed with the content received
+)
+{
+    const KeywordCheck_t * checkPtr = statePtr;
+    const ContentCheckParams_t * paramsPtr = checkPtr->paramsPtr;
+    size_t i;
+
+    for (i = 0; i < paramsPtr->keywordCount; i++)
+    {
+        if (checkPtr->found & (1u << i))
+        {
+            LE_INFO("contentResult = %s", paramsPtr->keywords[i].keyword);
+            return paramsPtr->keywords[i].state;
+        }
+    }
+
+    LE_ERROR("Cannot find keyword for statuses");
+    LE_INFO("contentResult = NULL");
+
+    return STATE_FAIL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether a Jenkins build is in progress
+ *
+ * @return
+ *      true if <building>true</building> was found
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsJenkinsBuilding
+(
+    const void * statePtr           ///< [IN] Check fed with the content received
+)
+{
+    return ((const KeywordCheck_t *) statePtr)->isBuilding;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the check of Sensu metrics
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitSensuCheck
+(
+    void * statePtr,                        ///< [OUT] Check to initialize
+    const ContentCheckParams_t * paramsPtr  ///< [IN] Unused
+)
+{
+    SensuCheck_t * checkPtr = statePtr;
+
+    memset(checkPtr, 0, sizeof(SensuCheck_t));
+    checkPtr->token = SENSU_TOKEN_NONE;
+    checkPtr->key = SENSU_KEY_NONE;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Identifies the string that was just read as a key of the Sensu metrics
+ *
+ * @return
+ *      Key whose value is counted, SENSU_KEY_NONE for the others
+ */
+//--------------------------------------------------------------------------------------------------
+static SensuKey_t GetSensuKey
+(
+    const SensuCheck_t * checkPtr   ///< [IN] Check that just read a key
+)
+{
+    if (checkPtr->stringLength >= SENSU_MAX_KEY_BYTES)
+    {
+        return SENSU_KEY_NONE;
+    }
+
+    if ( (checkPtr->stringLength == 8) && !memcmp(checkPtr->string, "critical", 8) )
+    {
+        return SENSU_KEY_CRITICAL;
+    }
+
+    if ( (checkPtr->stringLength == 7) && !memcmp(checkPtr->string, "warning", 7) )
+    {
+        return SENSU_KEY_WARNING;
+    }
+
+    return SENSU_KEY_NONE;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds the number that was just read to the count of its key
+ *
+ * @return
+ *      true once the verdict is known: there are machines in critical state
+ */
+//--------------------------------------------------------------------------------------------------
+static bool AddSensuCount
+(
+    SensuCheck_t * checkPtr         ///< [IN] Check that just read a number
+)
+{
+    checkPtr->token = SENSU_TOKEN_NONE;
+
+    switch (checkPtr->key)
+    {
+        case SENSU_KEY_CRITICAL:
+            checkPtr->criticalCount += checkPtr->number;
+            break;
+
+        case SENSU_KEY_WARNING:
+            checkPtr->warningCount += checkPtr->number;
+            break;
+
+        case SENSU_KEY_NONE:
+        default:
+            break;
+    }
+
+    checkPtr->key = SENSU_KEY_NONE;
+
+    return (checkPtr->criticalCount > 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the content returned by the Sensu '/metrics' REST API.
+ *
+ * The JSON content is tokenized in a single pass, the token in progress is kept between chunks.
+ * The numeric values of the "critical" and "warning" keys are summed, at any nesting level.
+ *
+ * @return
+ *      true once the verdict is known: there are machines in critical state
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FeedSensuContent
+(
+    void * statePtr,                ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    SensuCheck_t * checkPtr = statePtr;
+    size_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        char c = dataPtr[index];
+
+        switch (checkPtr->token)
+        {
+            case SENSU_TOKEN_STRING:
+                if (c == '\\')
+                {
+                    checkPtr->token = SENSU_TOKEN_ESCAPE;
+                }
+                else if (c == '"')
+                {
+                    checkPtr->token = SENSU_TOKEN_KEY;
+                }
+                else
+                {
+                    if (checkPtr->stringLength < SENSU_MAX_KEY_BYTES)
+                    {
+                        checkPtr->string[checkPtr->stringLength] = c;
+                    }
+                    checkPtr->stringLength++;
+                }
+                continue;
+
+            case SENSU_TOKEN_ESCAPE:
+                // Escaped characters never appear in the keys that are counted
+                checkPtr->stringLength = SENSU_MAX_KEY_BYTES;
+                checkPtr->token = SENSU_TOKEN_STRING;
+                continue;
+
+            case SENSU_TOKEN_KEY:
+                if (isspace((unsigned char) c))
+                {
+                    continue;
+                }
+
+                checkPtr->token = SENSU_TOKEN_NONE;
+                if (c == ':')
+                {
+                    checkPtr->key = GetSensuKey(checkPtr);
+                    continue;
+                }
+                checkPtr->key = SENSU_KEY_NONE;
+                break;
+
+            case SENSU_TOKEN_NUMBER:
+                if (isdigit((unsigned char) c))
+                {
+                    uint64_t digit = c - '0';
+
+                    // Saturate instead of wrapping around on absurdly long numbers
+                    checkPtr->number = (checkPtr->number > (UINT64_MAX - digit) / 10) ?
+                                       UINT64_MAX : checkPtr->number * 10 + digit;
+                    continue;
+                }
+                if ( (c == '.') || (c == 'e') || (c == 'E') )
+                {
+                    checkPtr->token = SENSU_TOKEN_FRACTION;
+                    continue;
+                }
+                if (AddSensuCount(checkPtr))
+                {
+                    return true;
+                }
+                break;
+
+            case SENSU_TOKEN_FRACTION:
+                if ( isdigit((unsigned char) c) ||
+                     (c == '.') || (c == 'e') || (c == 'E') || (c == '+') || (c == '-') )
+                {
+                    continue;
+                }
+                if (AddSensuCount(checkPtr))
+                {
+                    return true;
+                }
+                break;
+
+            case SENSU_TOKEN_NONE:
+            default:
+                break;
+        }
+
+        // Between tokens
+        if (c == '"')
+        {
+            checkPtr->token = SENSU_TOKEN_STRING;
+            checkPtr->stringLength = 0;
+        }
+        else if ( isdigit((unsigned char) c) && (checkPtr->key != SENSU_KEY_NONE) )
+        {
+            checkPtr->token = SENSU_TOKEN_NUMBER;
+            checkPtr->number = c - '0';
+        }
+        else if (!isspace((unsigned char) c))
+        {
+            // Any other value or punctuation ends what followed the key
+            checkPtr->key = SENSU_KEY_NONE;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the Sensu state based on content as returned by the '/metrics' REST API.
+ *
+ * @return
+ *      light states
+ *      contentResult in config tree
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t CheckSensuResult
+(
+    void * statePtr                 ///< [IN] Check fed with the content received
+)
+{
+    SensuCheck_t * checkPtr = statePtr;
+    MonitorState_t state = STATE_PASS;
+
+    // The content may end on a number
+    if ( (checkPtr->token == SENSU_TOKEN_NUMBER) || (checkPtr->token == SENSU_TOKEN_FRACTION) )
+    {
+        AddSensuCount(checkPtr);
+    }
+
+    LE_INFO("There are %" PRIu64 " machines in critical state, %" PRIu64 " in warning state",
+            checkPtr->criticalCount,
+            checkPtr->warningCount);
+
+    if (checkPtr->criticalCount > 0)
+    {
+        state = STATE_FAIL;
+    }
+    else if (checkPtr->warningCount > 0)
+    {
+        state = STATE_WARNING;
+    }
+
+    LE_INFO("Sensu state: %d", state);
+    return state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checkers of keywords, of Jenkins builds and of Sensu metrics
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentChecker_t JenkinsChecker =
+{
+    .namePtr = "jenkins",
+    .stateSize = sizeof(KeywordCheck_t),
+    .prepare = PrepareJenkinsCheck,
+    .init = InitKeywordCheck,
+    .feed = FeedKeywordContent,
+    .finish = CheckKeywordResult,
+    .isInProgress = IsJenkinsBuilding,
+};
+CONTENT_CHECK_REGISTER(JenkinsChecker)
+
+static const ContentChecker_t KeywordChecker =
+{
+    .namePtr = "keywords",
+    .stateSize = sizeof(KeywordCheck_t),
+    .prepare = PrepareKeywordCheck,
+    .init = InitKeywordCheck,
+    .feed = FeedKeywordContent,
+    .finish = CheckKeywordResult,
+};
+CONTENT_CHECK_REGISTER(KeywordChecker)
+
+static const ContentChecker_t SensuChecker =
+{
+    .namePtr = "sensu",
+    .stateSize = sizeof(SensuCheck_t),
+    .init = InitSensuCheck,
+    .feed = FeedSensuContent,
+    .finish = CheckSensuResult,
+};
+CONTENT_CHECK_REGISTER(SensuChecker)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registers a checker
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Register
+(
+    const ContentChecker_t * checkerPtr     ///< [IN] Checker, kept
+)
+{
+    LE_FATAL_IF(CheckerCount >= CONTENT_CHECK_MAX_CHECKERS,
+                "Too many content checkers, cannot register %s",
+                checkerPtr->namePtr);
+    LE_FATAL_IF(contentCheck_GetChecker(checkerPtr->namePtr) != NULL,
+                "Content checker %s registered twice",
+                checkerPtr->namePtr);
+
+    Checkers[CheckerCount++] = checkerPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finds the checker of a checkMode
+ *
+ * @return
+ *      Checker, NULL if unknown
+ */
+//--------------------------------------------------------------------------------------------------
+const ContentChecker_t * contentCheck_GetChecker
+(
+    const char * checkMode          ///< [IN] info/content/checkMode of the monitor
+)
+{
+    size_t i;
+
+    for (i = 0; i < CheckerCount; i++)
+    {
+        if (strncmp(checkMode, Checkers[i]->namePtr, MAX_CHECK_MODE_BYTES) == 0)
+        {
+            return Checkers[i];
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the URL of a monitor with the API its checker reads
+ *
+ * @return
+ *      - LE_OK if the URL is complete
+ *      - LE_OVERFLOW if it does not fit
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t contentCheck_CompleteUrl
+(
+    const ContentChecker_t * checkerPtr,        ///< [IN] How the content is checked, or NULL
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Settings of the check
+    char * urlPtr,                              ///< [IN/OUT] URL of the monitor
+    size_t urlSize                              ///< [IN] Size of the URL buffer
+)
+{
+    if (checkerPtr && checkerPtr->completeUrl)
+    {
+        return checkerPtr->completeUrl(paramsPtr, urlPtr, urlSize);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a parameter to the query of a URL. Only the unreserved characters of RFC 3986 are kept as
+ * they are in the value.
+ *
+ * @return
+ *      - LE_OK if the parameter is added
+ *      - LE_OVERFLOW if it does not fit
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t contentCheck_AddQueryParam
+(
+    char * urlPtr,                  ///< [IN/OUT] URL
+    size_t urlSize,                 ///< [IN] Size of the URL buffer
+    const char * namePtr,           ///< [IN] Name of the parameter
+    const char * valuePtr           ///< [IN] Value of the parameter, not encoded
+)
+{
+    static const char HexDigits[] = "0123456789ABCDEF";
+    size_t length = strlen(urlPtr);
+    size_t index;
+    int written;
+
+    written = snprintf(urlPtr + length,
+                       urlSize - length,
+                       "%c%s=",
+                       (strchr(urlPtr, '?') != NULL) ? '&' : '?',
+                       namePtr);
+    if ( (written < 0) || ((size_t) written >= urlSize - length) )
+    {
+        urlPtr[length] = '\0';
+        return LE_OVERFLOW;
+    }
+    index = length + written;
+
+    for (; *valuePtr != '\0'; valuePtr++)
+    {
+        unsigned char c = *valuePtr;
+
+        if (isalnum(c) || (c == '-') || (c == '.') || (c == '_') || (c == '~'))
+        {
+            if (index + 1 >= urlSize)
+            {
+                break;
+            }
+            urlPtr[index++] = c;
+        }
+        else
+        {
+            if (index + 3 >= urlSize)
+            {
+                break;
+            }
+            urlPtr[index++] = '%';
+            urlPtr[index++] = HexDigits[c >> 4];
+            urlPtr[index++] = HexDigits[c & 0x0F];
+        }
+    }
+
+    if (*valuePtr != '\0')
+    {
+        urlPtr[length] = '\0';
+        return LE_OVERFLOW;
+    }
+
+    urlPtr[index] = '\0';
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the memory needed by a check
+ *
+ * @return
+ *      Bytes needed by the check
+ */
+//--------------------------------------------------------------------------------------------------
+size_t contentCheck_GetSize
+(
+    const ContentChecker_t * checkerPtr         ///< [IN] How the content is checked, or NULL
+)
+{
+    return offsetof(ContentCheck_t, state) + (checkerPtr ? checkerPtr->stateSize : 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the memory needed by a check of the largest checker registered
+ *
+ * @return
+ *      Bytes needed by the check
+ */
+//--------------------------------------------------------------------------------------------------
+size_t contentCheck_GetMaxSize
+(
+    void
+)
+{
+    size_t maxSize = contentCheck_GetSize(NULL);
+    size_t i;
+
+    for (i = 0; i < CheckerCount; i++)
+    {
+        size_t size = contentCheck_GetSize(Checkers[i]);
+
+        if (size > maxSize)
+        {
+            maxSize = size;
+        }
+    }
+
+    return maxSize;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the settings of a check with what the checker builds from them
+ *
+ * @return
+ *      - LE_OK if the settings are usable
+ *      - LE_OVERFLOW if they are too large, the check then fails
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t contentCheck_Prepare
+(
+    const ContentChecker_t * checkerPtr,        ///< [IN] How the content is checked, or NULL
+    ContentCheckParams_t * paramsPtr            ///< [IN/OUT] Settings of the check
+)
+{
+    if (checkerPtr && checkerPtr->prepare)
+    {
+        return checkerPtr->prepare(paramsPtr);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether two thresholds are the same, both not set included
+ *
+ * @return
+ *      true if the thresholds are the same
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSameThreshold
+(
+    double a,                       ///< [IN] Threshold, NAN if not set
+    double b                        ///< [IN] Other threshold, NAN if not set
+)
+{
+    return (isnan(a) && isnan(b)) || (a == b);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases what the checker built from the settings of a check
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Release
+(
+    ContentCheckParams_t * paramsPtr            ///< [IN/OUT] Settings of the check
+)
+{
+    if (paramsPtr->automatonPtr)
+    {
+        le_mem_Release(paramsPtr->automatonPtr);
+        paramsPtr->automatonPtr = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares the settings of two checks, without what the checkers build from them
+ *
+ * @return
+ *      true if the settings are the same
+ */
+//--------------------------------------------------------------------------------------------------
+bool contentCheck_IsSameSettings
+(
+    const ContentCheckParams_t * aPtr,      ///< [IN] Settings of a check
+    const ContentCheckParams_t * bPtr       ///< [IN] Settings of another check
+)
+{
+    size_t i;
+
+    if ( strcmp(aPtr->path, bPtr->path) ||
+         strcmp(aPtr->value, bPtr->value) ||
+         !IsSameThreshold(aPtr->warningThreshold, bPtr->warningThreshold) ||
+         !IsSameThreshold(aPtr->criticalThreshold, bPtr->criticalThreshold) ||
+         (aPtr->keywordCount != bPtr->keywordCount) ||
+         strcmp(aPtr->anchor, bPtr->anchor) ||
+         strcmp(aPtr->anchorEnd, bPtr->anchorEnd) ||
+         strcmp(aPtr->labelSelector, bPtr->labelSelector) ||
+         strcmp(aPtr->fieldSelector, bPtr->fieldSelector) ||
+         (aPtr->pageSize != bPtr->pageSize) )
+    {
+        return false;
+    }
+
+    for (i = 0; i < aPtr->keywordCount; i++)
+    {
+        if ( strcmp(aPtr->keywords[i].keyword, bPtr->keywords[i].keyword) ||
+             (aPtr->keywords[i].state != bPtr->keywords[i].state) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the check of the content of a response
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Init
+(
+    ContentCheck_t * checkPtr,                  ///< [OUT] Check to initialize
+    const ContentChecker_t * checkerPtr,        ///< [IN] How the content is checked, or NULL
+    const ContentCheckParams_t * paramsPtr      ///< [IN] Settings of the check, kept until the end
+)
+{
+    checkPtr->isDone = false;
+    checkPtr->length = 0;
+    checkPtr->checkerPtr = checkerPtr;
+
+    if (checkerPtr)
+    {
+        checkerPtr->init(checkPtr->state, paramsPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the content of a response to its check
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Feed
+(
+    ContentCheck_t * checkPtr,      ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    checkPtr->length += length;
+
+    if (checkPtr->checkerPtr)
+    {
+        checkPtr->isDone = checkPtr->checkerPtr->feed(checkPtr->state, dataPtr, length);
+    }
+    else
+    {
+        // Nothing to look for, the content is not needed
+        checkPtr->isDone = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the check of the content of a response, once it is entirely received or once the
+ * verdict is known.
+ *
+ * @return
+ *      State of the content
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t contentCheck_GetResult
+(
+    ContentCheck_t * checkPtr           ///< [IN] Check fed with the content received
+)
+{
+    if (!checkPtr->checkerPtr)
+    {
+        LE_ERROR("No content check mode set");
+        return STATE_PASS;
+    }
+
+    return checkPtr->checkerPtr->finish(checkPtr->state);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the content shows that the monitored job is still running, e.g. a Jenkins build
+ * in progress.
+ *
+ * @return
+ *      true if the job is running
+ */
+//--------------------------------------------------------------------------------------------------
+bool contentCheck_IsInProgress
+(
+    const ContentCheck_t * checkPtr     ///< [IN] Check fed with the content received
+)
+{
+    return checkPtr->checkerPtr &&
+           checkPtr->checkerPtr->isInProgress &&
+           checkPtr->checkerPtr->isInProgress(checkPtr->state);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the items of the content that have a state of their own, e.g. the jobs of a Jenkins view
+ *
+ * @return
+ *      Items, NULL if there are none
+ */
+//--------------------------------------------------------------------------------------------------
+const ContentItem_t * contentCheck_GetItems
+(
+    const ContentCheck_t * checkPtr,    ///< [IN] Check fed with the content received
+    size_t * countPtr                   ///< [OUT] Number of items
+)
+{
+    *countPtr = 0;
+
+    if ( !checkPtr->checkerPtr || !checkPtr->checkerPtr->getItems )
+    {
+        return NULL;
+    }
+
+    return checkPtr->checkerPtr->getItems(checkPtr->state, countPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the keywords of a check to the results of a Jenkins build, if info/content/keywords is not
+ * set
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_SetJenkinsKeywords
+(
+    ContentCheckParams_t * paramsPtr    ///< [IN/OUT] Settings of the check
+)
+{
+    if (paramsPtr->keywordCount == 0)
+    {
+        memcpy(paramsPtr->keywords, JenkinsKeywords, sizeof(JenkinsKeywords));
+        paramsPtr->keywordCount = NUM_ARRAY_MEMBERS(JenkinsKeywords);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares a value to the thresholds of a check. The thresholds are maximums if the critical one
+ * is above the warning one, minimums otherwise. A threshold that is not set is ignored.
+ *
+ * @return
+ *      State of the value
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t contentCheck_CompareThresholds
+(
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Settings of the check
+    double value                                ///< [IN] Value found in the content
+)
+{
+    double warning = paramsPtr->warningThreshold;
+    double critical = paramsPtr->criticalThreshold;
+    bool isMaximum = isnan(warning) || isnan(critical) || (critical >= warning);
+
+    if (isnan(value))
+    {
+        return STATE_FAIL;
+    }
+
+    if (!isnan(critical) && (isMaximum ? (value >= critical) : (value <= critical)))
+    {
+        return STATE_FAIL;
+    }
+
+    if (!isnan(warning) && (isMaximum ? (value >= warning) : (value <= warning)))
+    {
+        return STATE_WARNING;
+    }
+
+    return STATE_PASS;
+}
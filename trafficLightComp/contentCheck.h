@@ -0,0 +1,324 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file contentCheck.h
+ *
+ * Checks of the content of a response, fed chunk by chunk as it is received.
+ *
+ * Each kind of content has a checker, which registers itself with CONTENT_CHECK_REGISTER and is
+ * found by its name. Adding a checker only needs its source file, listed in Component.cdef: the
+ * polling code and this module do not depend on the checkers, and the memory of a check is sized
+ * from the state of its checker.
+ *
+ * This module only depends on the C library and the Legato logging macros: it does not use any
+ * service, cURL or the config tree, so that it can be built and profiled on its own.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef CONTENT_CHECK_H_INCLUDE_GUARD
+#define CONTENT_CHECK_H_INCLUDE_GUARD
+
+#include "trafficLight.h"
+
+#define MAX_CHECK_MODE_BYTES 32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * How the pages of a paged API are followed: each page has a header with the token of the next
+ * one, which is sent back as a query parameter of the request of the next page
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char * headerPtr;         ///< Header of the token with its colon, e.g. "Sensu-Continue:"
+    const char * paramPtr;          ///< Query parameter of the token
+}
+ContentPaging_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Item of a content that has a state of its own, e.g. a job of a Jenkins view. The items of a
+ * monitor are shown as monitors of their own, named "<monitor>/<item>".
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char name[MAX_MONITOR_NAME_BYTES];      ///< Name of the item, e.g. of the job
+    MonitorState_t state;                   ///< State of the item
+    bool isInProgress;                      ///< Whether it is running, e.g. a build of the job
+}
+ContentItem_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checker of a kind of content, as named in info/content/checkMode. The hooks get the state of
+ * the checker, ContentCheck_t.state.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char * namePtr;                                           ///< checkMode
+    size_t stateSize;                                   ///< Size of its state in ContentCheck_t
+    le_result_t (*prepare)(ContentCheckParams_t * paramsPtr);       ///< NULL if nothing to build
+    void (*init)(void * statePtr, const ContentCheckParams_t * paramsPtr);  ///< Starts a check
+    bool (*feed)(void * statePtr, const char * dataPtr, size_t length);     ///< true when done
+    MonitorState_t (*finish)(void * statePtr);                      ///< Returns the state
+    bool (*isInProgress)(const void * statePtr);                    ///< NULL if never in progress
+    const ContentItem_t * (*getItems)(const void * statePtr,
+                                      size_t * countPtr);   ///< NULL if the content has no items
+    le_result_t (*completeUrl)(const ContentCheckParams_t * paramsPtr,
+                               char * urlPtr,
+                               size_t urlSize);             ///< NULL if the URL is used as set
+    const ContentPaging_t * pagingPtr;                      ///< NULL if the content is not paged
+}
+ContentChecker_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check of the content of a response, fed chunk by chunk as it is received
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const ContentChecker_t * checkerPtr;    ///< How the content is checked, NULL to not check it
+    bool isDone;                ///< Whether the verdict is known, the rest of the content is unused
+    size_t length;              ///< Bytes of content received
+    uint64_t state[];           ///< State of the checker, checkerPtr->stateSize bytes
+}
+ContentCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registers a checker, at startup, before any checker is looked for. See CONTENT_CHECK_REGISTER.
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Register
+(
+    const ContentChecker_t * checkerPtr     ///< [IN] Checker, kept
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registers a checker when the component is loaded, e.g.
+ *
+ *     static const ContentChecker_t MyChecker = { .namePtr = "my", ... };
+ *     CONTENT_CHECK_REGISTER(MyChecker)
+ */
+//--------------------------------------------------------------------------------------------------
+#define CONTENT_CHECK_REGISTER(checker) \
+    static void __attribute__((constructor)) RegisterContentChecker_##checker(void) \
+    { \
+        contentCheck_Register(&(checker)); \
+    }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finds the checker of a checkMode. This is done once, when the settings of a monitor are read.
+ *
+ * @return
+ *      Checker, NULL if unknown
+ */
+//--------------------------------------------------------------------------------------------------
+const ContentChecker_t * contentCheck_GetChecker
+(
+    const char * checkMode          ///< [IN] info/content/checkMode of the monitor
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the URL of a monitor with the API its checker reads, e.g. the API of a Jenkins view
+ * with only the fields it needs, or the size of the pages and the filters of the server.
+ *
+ * @return
+ *      - LE_OK if the URL is complete
+ *      - LE_OVERFLOW if it does not fit, it is then kept as it is
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t contentCheck_CompleteUrl
+(
+    const ContentChecker_t * checkerPtr,        ///< [IN] How the content is checked, or NULL
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Settings of the check
+    char * urlPtr,                              ///< [IN/OUT] URL of the monitor
+    size_t urlSize                              ///< [IN] Size of the URL buffer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a parameter to the query of a URL, percent-encoding its value
+ *
+ * @return
+ *      - LE_OK if the parameter is added
+ *      - LE_OVERFLOW if it does not fit, the URL is then kept as it is
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t contentCheck_AddQueryParam
+(
+    char * urlPtr,                  ///< [IN/OUT] URL
+    size_t urlSize,                 ///< [IN] Size of the URL buffer
+    const char * namePtr,           ///< [IN] Name of the parameter
+    const char * valuePtr           ///< [IN] Value of the parameter, not encoded
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the memory needed by a check: ContentCheck_t is followed by the state of its checker, a
+ * check must be allocated with this size.
+ *
+ * @return
+ *      Bytes needed by the check
+ */
+//--------------------------------------------------------------------------------------------------
+size_t contentCheck_GetSize
+(
+    const ContentChecker_t * checkerPtr         ///< [IN] How the content is checked, or NULL
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the memory needed by a check of the largest checker registered, e.g. to size the memory of
+ * the checks of all the monitors
+ *
+ * @return
+ *      Bytes needed by the check
+ */
+//--------------------------------------------------------------------------------------------------
+size_t contentCheck_GetMaxSize
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the settings of a check with what the checker builds from them, e.g. its keyword
+ * automaton. This is done once, when the settings of a monitor are read.
+ *
+ * @return
+ *      - LE_OK if the settings are usable
+ *      - LE_OVERFLOW if they are too large, the check then fails
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t contentCheck_Prepare
+(
+    const ContentChecker_t * checkerPtr,        ///< [IN] How the content is checked, or NULL
+    ContentCheckParams_t * paramsPtr            ///< [IN/OUT] Settings of the check
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases what the checker built from the settings of a check with contentCheck_Prepare, once
+ * they are replaced or no longer used. Settings never prepared, zeroed, have nothing to release.
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Release
+(
+    ContentCheckParams_t * paramsPtr            ///< [IN/OUT] Settings of the check
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares the settings of two checks, as read from info/content. What the checkers build from
+ * them, e.g. the keyword automaton, is not compared.
+ *
+ * @return
+ *      true if the settings are the same
+ */
+//--------------------------------------------------------------------------------------------------
+bool contentCheck_IsSameSettings
+(
+    const ContentCheckParams_t * aPtr,      ///< [IN] Settings of a check
+    const ContentCheckParams_t * bPtr       ///< [IN] Settings of another check
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the check of the content of a response
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Init
+(
+    ContentCheck_t * checkPtr,                  ///< [OUT] Check to initialize
+    const ContentChecker_t * checkerPtr,        ///< [IN] How the content is checked, or NULL
+    const ContentCheckParams_t * paramsPtr      ///< [IN] Settings of the check, kept until the end
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the content of a response to its check. Once checkPtr->isDone is set, the rest
+ * of the content is not needed.
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_Feed
+(
+    ContentCheck_t * checkPtr,      ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the check of the content of a response, once it is entirely received or once the
+ * verdict is known.
+ *
+ * @return
+ *      State of the content
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t contentCheck_GetResult
+(
+    ContentCheck_t * checkPtr       ///< [IN] Check fed with the content received
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the content shows that the monitored job is still running, e.g. a Jenkins build
+ * in progress.
+ *
+ * @return
+ *      true if the job is running
+ */
+//--------------------------------------------------------------------------------------------------
+bool contentCheck_IsInProgress
+(
+    const ContentCheck_t * checkPtr     ///< [IN] Check fed with the content received
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the items of the content that have a state of their own, e.g. the jobs of a Jenkins view
+ *
+ * @return
+ *      Items, NULL if there are none
+ */
+//--------------------------------------------------------------------------------------------------
+const ContentItem_t * contentCheck_GetItems
+(
+    const ContentCheck_t * checkPtr,    ///< [IN] Check fed with the content received
+    size_t * countPtr                   ///< [OUT] Number of items
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the keywords of a check to the results of a Jenkins build, if info/content/keywords is not
+ * set
+ */
+//--------------------------------------------------------------------------------------------------
+void contentCheck_SetJenkinsKeywords
+(
+    ContentCheckParams_t * paramsPtr    ///< [IN/OUT] Settings of the check
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares a value to the thresholds of a check. The thresholds are maximums if the critical one
+ * is above the warning one, minimums otherwise. A threshold that is not set is ignored.
+ *
+ * @return
+ *      State of the value
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t contentCheck_CompareThresholds
+(
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Settings of the check
+    double value                                ///< [IN] Value found in the content
+);
+
+#endif // CONTENT_CHECK_H_INCLUDE_GUARD
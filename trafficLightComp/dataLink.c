@@ -0,0 +1,401 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file dataLink.c
+ *
+ * Data link the servers are polled through, see dataLink.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "dataLink.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Data channel tracked
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char setting[LE_DCS_CHANNEL_NAME_MAX_LEN + 1];  ///< Name set, "" to pick one by technology
+    char name[LE_DCS_CHANNEL_NAME_MAX_LEN + 1];     ///< Name of the channel found
+    le_dcs_ChannelRef_t channelRef;                 ///< Channel, NULL if none was found
+    le_dcs_EventHandlerRef_t handlerRef;            ///< Handler of its events
+    le_dcs_ReqObjRef_t requestRef;                  ///< Request, NULL if it is not requested
+    bool isUp;                                      ///< Whether it is up
+}
+Channel_t;
+
+// Main channel, and channel requested while the main one is down
+static Channel_t MainChannel;
+static Channel_t FallbackChannel;
+
+// Whether the channels are looked up, and whether the servers can be polled
+static bool IsQueryDone = false;
+static bool IsUp = true;
+
+// Handler of the link changes
+static dataLink_ChangeHandlerFunc_t ChangeHandlerPtr = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells the handler when the servers can no longer, or can again, be polled
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateLink
+(
+    void
+)
+{
+    bool isUp = (MainChannel.channelRef == NULL) ||
+                MainChannel.isUp ||
+                ( (FallbackChannel.requestRef != NULL) && FallbackChannel.isUp );
+
+    if (isUp == IsUp)
+    {
+        return;
+    }
+
+    IsUp = isUp;
+    LE_INFO("Data link %s", IsUp ? "up" : "down");
+
+    if (ChangeHandlerPtr)
+    {
+        ChangeHandlerPtr(IsUp);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Requests a channel
+ */
+//--------------------------------------------------------------------------------------------------
+static void Request
+(
+    Channel_t * channelPtr          ///< [IN] Channel to request
+)
+{
+    if ( (channelPtr->channelRef == NULL) || (channelPtr->requestRef != NULL) )
+    {
+        return;
+    }
+
+    channelPtr->requestRef = le_dcs_Start(channelPtr->channelRef);
+    if (channelPtr->requestRef == NULL)
+    {
+        LE_WARN("Unable to request data channel %s", channelPtr->name);
+        return;
+    }
+
+    LE_INFO("Data channel %s requested", channelPtr->name);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases the request of a channel
+ */
+//--------------------------------------------------------------------------------------------------
+static void Unrequest
+(
+    Channel_t * channelPtr          ///< [IN] Channel requested
+)
+{
+    if (channelPtr->requestRef == NULL)
+    {
+        return;
+    }
+
+    if (le_dcs_Stop(channelPtr->requestRef) != LE_OK)
+    {
+        LE_WARN("Unable to release data channel %s", channelPtr->name);
+    }
+    channelPtr->requestRef = NULL;
+
+    LE_INFO("Data channel %s released", channelPtr->name);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stops tracking a channel
+ */
+//--------------------------------------------------------------------------------------------------
+static void Untrack
+(
+    Channel_t * channelPtr          ///< [IN] Channel tracked
+)
+{
+    Unrequest(channelPtr);
+
+    if (channelPtr->handlerRef)
+    {
+        le_dcs_RemoveEventHandler(channelPtr->handlerRef);
+        channelPtr->handlerRef = NULL;
+    }
+
+    channelPtr->channelRef = NULL;
+    channelPtr->name[0] = '\0';
+    channelPtr->isUp = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when a channel goes up or down. The fallback channel is requested while the main one is
+ * down.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ChannelEventHandler
+(
+    le_dcs_ChannelRef_t channelRef, ///< [IN] Channel
+    le_dcs_Event_t event,           ///< [IN] Event
+    int32_t code,                   ///< [IN] Additional code
+    void * contextPtr               ///< [IN] Channel_t tracking the channel
+)
+{
+    Channel_t * channelPtr = contextPtr;
+
+    channelPtr->isUp = (event == LE_DCS_EVENT_UP);
+    LE_INFO("Data channel %s %s (event %d, code %d)",
+            channelPtr->name,
+            channelPtr->isUp ? "up" : "down",
+            event,
+            code);
+
+    if (channelPtr == &MainChannel)
+    {
+        if (MainChannel.isUp)
+        {
+            Unrequest(&FallbackChannel);
+        }
+        else
+        {
+            Request(&FallbackChannel);
+        }
+    }
+
+    UpdateLink();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts tracking a channel found in the channel list
+ */
+//--------------------------------------------------------------------------------------------------
+static void Track
+(
+    Channel_t * channelPtr,                 ///< [IN] Channel to track
+    const le_dcs_ChannelInfo_t * infoPtr    ///< [IN] Channel found
+)
+{
+    le_utf8_Copy(channelPtr->name, infoPtr->name, sizeof(channelPtr->name), NULL);
+    channelPtr->channelRef = infoPtr->ref;
+    channelPtr->isUp = (infoPtr->state == LE_DCS_STATE_UP);
+    channelPtr->handlerRef = le_dcs_AddEventHandler(infoPtr->ref, ChannelEventHandler, channelPtr);
+
+    LE_INFO("Data channel %s (technology %d) is %s",
+            channelPtr->name,
+            infoPtr->technology,
+            channelPtr->isUp ? "up" : "down");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Looks for a channel in the channel list, by name if it is set, otherwise by technology
+ *
+ * @return
+ *      The channel, NULL if there is none
+ */
+//--------------------------------------------------------------------------------------------------
+static const le_dcs_ChannelInfo_t * FindChannel
+(
+    const le_dcs_ChannelInfo_t * channelList,   ///< [IN] Channel list
+    size_t channelListSize,                     ///< [IN] Size of the list
+    const char * namePtr,                       ///< [IN] Name, "" to look by technology
+    bool isFallback,                            ///< [IN] Wi-Fi or Ethernet, otherwise cellular
+    le_dcs_ChannelRef_t excludedRef             ///< [IN] Channel already used, NULL if none
+)
+{
+    size_t i;
+
+    for (i = 0; i < channelListSize; i++)
+    {
+        const le_dcs_ChannelInfo_t * infoPtr = &channelList[i];
+
+        if (infoPtr->ref == excludedRef)
+        {
+            continue;
+        }
+
+        if (namePtr[0] != '\0')
+        {
+            if (strcmp(infoPtr->name, namePtr) == 0)
+            {
+                return infoPtr;
+            }
+        }
+        else if (isFallback ? ( (infoPtr->technology == LE_DCS_TECH_WIFI) ||
+                                (infoPtr->technology == LE_DCS_TECH_ETHERNET) ) :
+                              (infoPtr->technology == LE_DCS_TECH_CELLULAR) )
+        {
+            return infoPtr;
+        }
+    }
+
+    if (namePtr[0] != '\0')
+    {
+        LE_WARN("Data channel %s not found", namePtr);
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called with the channel list: requests the main channel, and tracks the fallback one
+ */
+//--------------------------------------------------------------------------------------------------
+static void ChannelQueryHandler
+(
+    le_result_t result,                         ///< [IN] Result of the query
+    const le_dcs_ChannelInfo_t * channelList,   ///< [IN] Channel list returned
+    size_t channelListSize,                     ///< [IN] Channel list's size
+    void * contextPtr                           ///< [IN] Associated user context pointer
+)
+{
+    const le_dcs_ChannelInfo_t * mainPtr;
+    const le_dcs_ChannelInfo_t * fallbackPtr;
+    size_t i;
+
+    LE_INFO("Received channel query result %d, channel list size %zu", result, channelListSize);
+
+    // The channels of an earlier query, if the settings changed again before it was answered
+    Untrack(&MainChannel);
+    Untrack(&FallbackChannel);
+    IsQueryDone = true;
+
+    if (result != LE_OK)
+    {
+        LE_WARN("Unable to list the data channels, polling regardless of the link");
+        UpdateLink();
+        return;
+    }
+
+    for (i = 0; i < channelListSize; i++)
+    {
+        LE_INFO("Available channel #%zu: name %s from technology %d, state %s, reference %p",
+                i + 1,
+                channelList[i].name,
+                channelList[i].technology,
+                ( channelList[i].state == LE_DCS_STATE_UP ) ? "up" : "down" ,
+                channelList[i].ref);
+    }
+
+    mainPtr = FindChannel(channelList, channelListSize, MainChannel.setting, false, NULL);
+    if (mainPtr == NULL)
+    {
+        LE_WARN("No data channel to request, polling regardless of the link");
+        UpdateLink();
+        return;
+    }
+    Track(&MainChannel, mainPtr);
+
+    fallbackPtr = FindChannel(channelList,
+                              channelListSize,
+                              FallbackChannel.setting,
+                              true,
+                              mainPtr->ref);
+    if (fallbackPtr)
+    {
+        Track(&FallbackChannel, fallbackPtr);
+    }
+
+    Request(&MainChannel);
+    if (!MainChannel.isUp)
+    {
+        Request(&FallbackChannel);
+    }
+
+    UpdateLink();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the handler of the link changes. The link is up until the channels are set.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataLink_Init
+(
+    dataLink_ChangeHandlerFunc_t handlerPtr     ///< [IN] Handler of the link changes
+)
+{
+    ChangeHandlerPtr = handlerPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the channels to request. The channels previously requested are released if they change,
+ * and the new ones are looked up among the channels le_dcs lists. The link keeps its state until
+ * they are found, the handler is then called if it changes.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataLink_SetChannels
+(
+    const char * mainNamePtr,       ///< [IN] Main channel, "" for the first cellular one
+    const char * fallbackNamePtr    ///< [IN] Fallback channel, "" for the first Wi-Fi or Ethernet
+)
+{
+    if ( IsQueryDone &&
+         (strcmp(mainNamePtr, MainChannel.setting) == 0) &&
+         (strcmp(fallbackNamePtr, FallbackChannel.setting) == 0) )
+    {
+        return;
+    }
+
+    // The link stays as it is until the new channels are found, see ChannelQueryHandler
+    Untrack(&MainChannel);
+    Untrack(&FallbackChannel);
+    IsQueryDone = false;
+
+    le_utf8_Copy(MainChannel.setting, mainNamePtr, sizeof(MainChannel.setting), NULL);
+    le_utf8_Copy(FallbackChannel.setting,
+                 fallbackNamePtr,
+                 sizeof(FallbackChannel.setting),
+                 NULL);
+
+    le_dcs_GetChannels(ChannelQueryHandler, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the servers can be polled
+ *
+ * @return
+ *      true if a channel is up, or if no channel is requested
+ */
+//--------------------------------------------------------------------------------------------------
+bool dataLink_IsUp
+(
+    void
+)
+{
+    return IsUp;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases the channels, e.g. before the app stops. The handler is no longer called: the link is
+ * then up, as no channel is requested.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataLink_Release
+(
+    void
+)
+{
+    ChangeHandlerPtr = NULL;
+
+    Untrack(&MainChannel);
+    Untrack(&FallbackChannel);
+    IsQueryDone = false;
+
+    UpdateLink();
+}
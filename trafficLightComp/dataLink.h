@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file dataLink.h
+ *
+ * Data link the servers are polled through. A data channel is requested from le_dcs, cellular by
+ * default, and its up and down events are tracked so that polling pauses while it is down. A
+ * fallback channel, Wi-Fi or Ethernet by default, is requested while the main one is down.
+ *
+ * When le_dcs lists no channel to request, the link is considered up.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef DATA_LINK_H_INCLUDE_GUARD
+#define DATA_LINK_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when the link goes up or down
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*dataLink_ChangeHandlerFunc_t)
+(
+    bool isUp                       ///< [IN] Whether the servers can be polled
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the handler of the link changes. The link is up until the channels are set.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataLink_Init
+(
+    dataLink_ChangeHandlerFunc_t handlerPtr     ///< [IN] Handler of the link changes
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the channels to request. The channels previously requested are released if they change,
+ * and the new ones are looked up among the channels le_dcs lists. The link keeps its state until
+ * they are found, the handler is then called if it changes.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataLink_SetChannels
+(
+    const char * mainNamePtr,       ///< [IN] Main channel, "" for the first cellular one
+    const char * fallbackNamePtr    ///< [IN] Fallback channel, "" for the first Wi-Fi or Ethernet
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the servers can be polled
+ *
+ * @return
+ *      true if a channel is up, or if no channel is requested
+ */
+//--------------------------------------------------------------------------------------------------
+bool dataLink_IsUp
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases the channels, e.g. before the app stops. The handler is no longer called: the link is
+ * then up, as no channel is requested.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataLink_Release
+(
+    void
+);
+
+#endif // DATA_LINK_H_INCLUDE_GUARD
@@ -0,0 +1,672 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file history.c
+ *
+ * History of the state transitions of the monitors, and the trafficLight API serving it and
+ * reporting the poll results, see history.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "history.h"
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+#define MAX(a,b) (((a)>(b))?(a):(b))
+
+// Node of the config tree the history is written to
+#define HISTORY_CONFIG_PATH "/history"
+
+// Size of the path of an entry relative to HISTORY_CONFIG_PATH, e.g. "entries/12/monitor"
+#define MAX_HISTORY_PATH_BYTES 32
+
+// Most PollResult handlers of the clients of the trafficLight API
+#define MAX_POLL_RESULT_HANDLERS 16
+
+// Size of a time written to the config tree, in decimal digits with the NULL char
+#define MAX_TIME_BYTES 24
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Transition of a monitor
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t time;                          ///< Seconds since the Epoch
+    char monitor[MAX_MONITOR_NAME_BYTES];   ///< Name of the monitor
+    int32_t httpCode;                       ///< HTTP code of the response, 0 if none
+    MonitorState_t state;                   ///< State the monitor changed to
+    uint32_t latencyMs;                     ///< Time from the start of the poll to the state
+}
+Entry_t;
+
+// Ring of the last transitions, and the number of transitions ever recorded: the next one goes to
+// Entries[RecordCount % HISTORY_SIZE]
+static Entry_t Entries[HISTORY_SIZE];
+static size_t RecordCount = 0;
+
+// Number of the last transitions not written to flash yet, at most HISTORY_SIZE
+static size_t PendingCount = 0;
+
+// State shown by the light, and whether it changed since it was written to flash
+static MonitorState_t State = STATE_UNKNOWN;
+static bool IsStatePending = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Result of a poll, as reported to the PollResult handlers
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char monitor[MAX_MONITOR_NAME_BYTES];   ///< Name of the monitor
+    int32_t httpCode;                       ///< HTTP code of the response, 0 if none
+    MonitorState_t state;                   ///< State of the monitor
+    uint32_t latencyMs;                     ///< Time from the start of the poll to the state
+}
+PollResult_t;
+
+// Event the poll results are reported with
+static le_event_Id_t PollResultEventId = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * PollResult handler of a client, removed when its session closes
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_msg_SessionRef_t sessionRef;         ///< Session of the client, NULL if the entry is free
+    le_event_HandlerRef_t handlerRef;       ///< Handler
+}
+ClientHandler_t;
+
+static ClientHandler_t ClientHandlers[MAX_POLL_RESULT_HANDLERS];
+
+// When the transitions are written to flash, see history_SetFlushPolicy
+static uint32_t FlushCount = 1;
+static uint32_t FlushIntervalSec = 0;
+static le_timer_Ref_t FlushTimer = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Converts a state to its value in the trafficLight API
+ *
+ * @return
+ *      State in the API
+ */
+//--------------------------------------------------------------------------------------------------
+static trafficLight_State_t ToApiState
+(
+    MonitorState_t state            ///< [IN] State of a monitor
+)
+{
+    switch (state)
+    {
+        case STATE_FAIL:
+            return TRAFFICLIGHT_STATE_FAIL;
+
+        case STATE_WARNING:
+            return TRAFFICLIGHT_STATE_WARNING;
+
+        case STATE_PASS:
+            return TRAFFICLIGHT_STATE_PASS;
+
+        case STATE_UNKNOWN:
+        default:
+            return TRAFFICLIGHT_STATE_UNKNOWN;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets a transition of the history
+ *
+ * @return
+ *      Transition, NULL if there is no such transition
+ */
+//--------------------------------------------------------------------------------------------------
+static const Entry_t * GetEntry
+(
+    size_t index                    ///< [IN] 0 for the most recent transition
+)
+{
+    if (index >= MIN(RecordCount, HISTORY_SIZE))
+    {
+        return NULL;
+    }
+
+    return &Entries[(RecordCount - 1 - index) % HISTORY_SIZE];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Calls a PollResult handler of a client with the result reported
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerPollResultHandler
+(
+    void * reportPtr,               ///< [IN] Result of the poll
+    void * secondLayerHandlerFunc   ///< [IN] Handler of the client
+)
+{
+    const PollResult_t * resultPtr = reportPtr;
+    trafficLight_PollResultHandlerFunc_t handlerFunc = secondLayerHandlerFunc;
+
+    handlerFunc(resultPtr->monitor,
+                resultPtr->httpCode,
+                ToApiState(resultPtr->state),
+                resultPtr->latencyMs,
+                le_event_GetContextPtr());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes the PollResult handlers of a client whose session closes, e.g. when it stops or crashes
+ * without removing them
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseSessionHandler
+(
+    le_msg_SessionRef_t sessionRef,     ///< [IN] Session closing
+    void * contextPtr                   ///< [IN] Unused
+)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_POLL_RESULT_HANDLERS; i++)
+    {
+        if (ClientHandlers[i].sessionRef == sessionRef)
+        {
+            le_event_RemoveHandler(ClientHandlers[i].handlerRef);
+            ClientHandlers[i].sessionRef = NULL;
+            ClientHandlers[i].handlerRef = NULL;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the time of an entry. The config tree has no 64-bit integers and its floats are not exact
+ * for every 64-bit value, the time is written as a decimal string. Entries written as floats by
+ * older versions are read as well.
+ *
+ * @return
+ *      Seconds since the Epoch, 0 if not set or invalid
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ReadTime
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator on HISTORY_CONFIG_PATH
+    const char * pathPtr                ///< [IN] Path of the time
+)
+{
+    char value[MAX_TIME_BYTES] = "";
+    char * endPtr;
+    uint64_t time;
+
+    if (le_cfg_GetNodeType(iteratorRef, pathPtr) == LE_CFG_TYPE_FLOAT)
+    {
+        double seconds = le_cfg_GetFloat(iteratorRef, pathPtr, 0);
+
+        return (seconds > 0) ? (uint64_t) seconds : 0;
+    }
+
+    le_cfg_GetString(iteratorRef, pathPtr, value, sizeof(value), "");
+    if (value[0] == '\0')
+    {
+        return 0;
+    }
+
+    errno = 0;
+    time = strtoull(value, &endPtr, 10);
+    if ( (value[0] < '0') || (value[0] > '9') || (*endPtr != '\0') || (errno != 0) )
+    {
+        LE_WARN("Invalid time '%s' at %s, ignoring it", value, pathPtr);
+        return 0;
+    }
+
+    return time;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the time of an entry as a decimal string, see ReadTime
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteTime
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Write iterator on HISTORY_CONFIG_PATH
+    const char * pathPtr,               ///< [IN] Path of the time
+    uint64_t time                       ///< [IN] Seconds since the Epoch
+)
+{
+    char value[MAX_TIME_BYTES];
+
+    snprintf(value, sizeof(value), "%" PRIu64, time);
+    le_cfg_SetString(iteratorRef, pathPtr, value);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when the oldest transition not written to flash waited long enough
+ */
+//--------------------------------------------------------------------------------------------------
+static void FlushTimerHandler
+(
+    le_timer_Ref_t timerRef         ///< [IN] Flush timer
+)
+{
+    history_Flush();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the transitions soon enough, depending on the flush policy
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleFlush
+(
+    void
+)
+{
+    if (PendingCount >= FlushCount)
+    {
+        history_Flush();
+        return;
+    }
+
+    if ( (FlushIntervalSec > 0) && !le_timer_IsRunning(FlushTimer) )
+    {
+        le_timer_SetMsInterval(FlushTimer, FlushIntervalSec * 1000);
+        le_timer_Start(FlushTimer);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restores the history and the state shown by the light from the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+void history_Init
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iteratorRef = le_cfg_CreateReadTxn(HISTORY_CONFIG_PATH);
+    int32_t count = le_cfg_GetInt(iteratorRef, "count", 0);
+    int32_t next = le_cfg_GetInt(iteratorRef, "next", 0);
+    int32_t state = le_cfg_GetInt(iteratorRef, "state", STATE_UNKNOWN);
+    size_t slot;
+
+    FlushTimer = le_timer_Create("HistoryFlushTimer");
+    le_timer_SetHandler(FlushTimer, FlushTimerHandler);
+    // The transitions can wait in RAM while the device suspends
+    le_timer_SetWakeup(FlushTimer, false);
+
+    PollResultEventId = le_event_CreateId("PollResult", sizeof(PollResult_t));
+    le_msg_AddServiceCloseHandler(trafficLight_GetServiceRef(), CloseSessionHandler, NULL);
+
+    if ( (count < 0) || (count > HISTORY_SIZE) || (next < 0) || (next >= HISTORY_SIZE) )
+    {
+        LE_WARN("Invalid history (%d entries, next %d), starting a new one", count, next);
+        count = 0;
+        next = 0;
+    }
+
+    // Keep the position of the next transition, the slots are written in place
+    RecordCount = (count < HISTORY_SIZE) ? count : HISTORY_SIZE + next;
+
+    for (slot = 0; slot < (size_t) count; slot++)
+    {
+        Entry_t * entryPtr = &Entries[slot];
+        char path[MAX_HISTORY_PATH_BYTES];
+
+        snprintf(path, sizeof(path), "entries/%zu/time", slot);
+        entryPtr->time = ReadTime(iteratorRef, path);
+        snprintf(path, sizeof(path), "entries/%zu/monitor", slot);
+        le_cfg_GetString(iteratorRef, path, entryPtr->monitor, sizeof(entryPtr->monitor), "");
+        snprintf(path, sizeof(path), "entries/%zu/httpCode", slot);
+        entryPtr->httpCode = le_cfg_GetInt(iteratorRef, path, 0);
+        snprintf(path, sizeof(path), "entries/%zu/state", slot);
+        entryPtr->state = le_cfg_GetInt(iteratorRef, path, STATE_UNKNOWN);
+        snprintf(path, sizeof(path), "entries/%zu/latencyMs", slot);
+        entryPtr->latencyMs = le_cfg_GetInt(iteratorRef, path, 0);
+    }
+
+    le_cfg_CancelTxn(iteratorRef);
+
+    State = ( (state >= STATE_FAIL) && (state <= STATE_UNKNOWN) ) ? state : STATE_UNKNOWN;
+
+    LE_INFO("History restored: %d transition(s), state %d", count, State);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets when the transitions are written to flash
+ */
+//--------------------------------------------------------------------------------------------------
+void history_SetFlushPolicy
+(
+    uint32_t flushCount,            ///< [IN] Transitions written together, at least 1
+    uint32_t flushIntervalSec       ///< [IN] Longest time a transition waits, 0 for no limit
+)
+{
+    FlushCount = MIN(MAX(flushCount, 1), HISTORY_SIZE);
+    FlushIntervalSec = flushIntervalSec;
+
+    le_timer_Stop(FlushTimer);
+    if ( (PendingCount > 0) || IsStatePending )
+    {
+        ScheduleFlush();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a transition of a monitor to the history
+ */
+//--------------------------------------------------------------------------------------------------
+void history_Record
+(
+    const char * monitorPtr,        ///< [IN] Name of the monitor
+    int32_t httpCode,               ///< [IN] HTTP code of the response, 0 if none
+    MonitorState_t state,           ///< [IN] State the monitor changed to
+    uint32_t latencyMs              ///< [IN] Time from the start of the poll to the state
+)
+{
+    Entry_t * entryPtr = &Entries[RecordCount % HISTORY_SIZE];
+
+    entryPtr->time = le_clk_GetAbsoluteTime().sec;
+    le_utf8_Copy(entryPtr->monitor, monitorPtr, sizeof(entryPtr->monitor), NULL);
+    entryPtr->httpCode = httpCode;
+    entryPtr->state = state;
+    entryPtr->latencyMs = latencyMs;
+
+    RecordCount++;
+    PendingCount = MIN(PendingCount + 1, HISTORY_SIZE);
+
+    LE_INFO("[%s] changed to state %d (HTTP %d, %u ms)", monitorPtr, state, httpCode, latencyMs);
+
+    ScheduleFlush();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reports the result of the poll of a monitor to the PollResult handlers of the trafficLight API
+ */
+//--------------------------------------------------------------------------------------------------
+void history_ReportPoll
+(
+    const char * monitorPtr,        ///< [IN] Name of the monitor
+    int32_t httpCode,               ///< [IN] HTTP code of the response, 0 if none
+    MonitorState_t state,           ///< [IN] State of the monitor
+    uint32_t latencyMs              ///< [IN] Time from the start of the poll to the state
+)
+{
+    PollResult_t result;
+
+    le_utf8_Copy(result.monitor, monitorPtr, sizeof(result.monitor), NULL);
+    result.httpCode = httpCode;
+    result.state = state;
+    result.latencyMs = latencyMs;
+
+    le_event_Report(PollResultEventId, &result, sizeof(result));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the state shown by the light. It is written to flash with the next transitions.
+ */
+//--------------------------------------------------------------------------------------------------
+void history_SetState
+(
+    MonitorState_t state            ///< [IN] Worst state of the monitors
+)
+{
+    if (state == State)
+    {
+        return;
+    }
+
+    State = state;
+    IsStatePending = true;
+
+    ScheduleFlush();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the state shown by the light
+ *
+ * @return
+ *      State, restored from flash until the first poll
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t history_GetState
+(
+    void
+)
+{
+    return State;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the state a monitor changed to last
+ *
+ * @return
+ *      State of the monitor, STATE_UNKNOWN if it is not in the history
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t history_GetLastState
+(
+    const char * monitorPtr         ///< [IN] Name of the monitor
+)
+{
+    const Entry_t * entryPtr;
+    size_t index;
+
+    for (index = 0; (entryPtr = GetEntry(index)) != NULL; index++)
+    {
+        if (strcmp(entryPtr->monitor, monitorPtr) == 0)
+        {
+            return entryPtr->state;
+        }
+    }
+
+    return STATE_UNKNOWN;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the transitions not written yet to flash, all in a single transaction
+ */
+//--------------------------------------------------------------------------------------------------
+void history_Flush
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iteratorRef;
+    size_t index;
+
+    le_timer_Stop(FlushTimer);
+
+    if ( (PendingCount == 0) && !IsStatePending )
+    {
+        return;
+    }
+
+    iteratorRef = le_cfg_CreateWriteTxn(HISTORY_CONFIG_PATH);
+
+    for (index = 0; index < PendingCount; index++)
+    {
+        size_t slot = (RecordCount - 1 - index) % HISTORY_SIZE;
+        const Entry_t * entryPtr = &Entries[slot];
+        char path[MAX_HISTORY_PATH_BYTES];
+
+        snprintf(path, sizeof(path), "entries/%zu/time", slot);
+        WriteTime(iteratorRef, path, entryPtr->time);
+        snprintf(path, sizeof(path), "entries/%zu/monitor", slot);
+        le_cfg_SetString(iteratorRef, path, entryPtr->monitor);
+        snprintf(path, sizeof(path), "entries/%zu/httpCode", slot);
+        le_cfg_SetInt(iteratorRef, path, entryPtr->httpCode);
+        snprintf(path, sizeof(path), "entries/%zu/state", slot);
+        le_cfg_SetInt(iteratorRef, path, entryPtr->state);
+        snprintf(path, sizeof(path), "entries/%zu/latencyMs", slot);
+        le_cfg_SetInt(iteratorRef, path, entryPtr->latencyMs);
+    }
+
+    le_cfg_SetInt(iteratorRef, "count", MIN(RecordCount, HISTORY_SIZE));
+    le_cfg_SetInt(iteratorRef, "next", RecordCount % HISTORY_SIZE);
+    le_cfg_SetInt(iteratorRef, "state", State);
+
+    le_cfg_CommitTxn(iteratorRef);
+
+    LE_DEBUG("History: %zu transition(s) written", PendingCount);
+
+    PendingCount = 0;
+    IsStatePending = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the state shown by the light, restored from flash until the first poll
+ *
+ * @return
+ *      Worst state of the monitors
+ */
+//--------------------------------------------------------------------------------------------------
+trafficLight_State_t trafficLight_GetState
+(
+    void
+)
+{
+    return ToApiState(State);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of transitions in the history
+ *
+ * @return
+ *      Number of transitions that can be read with trafficLight_GetHistoryEntry
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t trafficLight_GetHistoryCount
+(
+    void
+)
+{
+    return MIN(RecordCount, HISTORY_SIZE);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads a transition of the history
+ *
+ * @return
+ *      - LE_OK if the transition is read
+ *      - LE_OUT_OF_RANGE if there is no such transition
+ *      - LE_OVERFLOW if the name of the monitor was truncated
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t trafficLight_GetHistoryEntry
+(
+    uint32_t index,                     ///< [IN] 0 for the most recent transition
+    uint64_t * timePtr,                 ///< [OUT] Seconds since the Epoch
+    char * monitor,                     ///< [OUT] Name of the monitor
+    size_t monitorSize,                 ///< [IN] Size of the name buffer
+    int32_t * httpCodePtr,              ///< [OUT] HTTP code of the response, 0 if none
+    trafficLight_State_t * statePtr,    ///< [OUT] State the monitor changed to
+    uint32_t * latencyMsPtr             ///< [OUT] Time from the start of the poll to the state
+)
+{
+    const Entry_t * entryPtr = GetEntry(index);
+
+    if (!entryPtr)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    *timePtr = entryPtr->time;
+    *httpCodePtr = entryPtr->httpCode;
+    *statePtr = ToApiState(entryPtr->state);
+    *latencyMsPtr = entryPtr->latencyMs;
+
+    return le_utf8_Copy(monitor, entryPtr->monitor, monitorSize, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a handler called with the result of each monitor once it is polled. The handlers of a
+ * client are removed when its session closes.
+ *
+ * @return
+ *      Reference to remove the handler, NULL if there are too many handlers
+ */
+//--------------------------------------------------------------------------------------------------
+trafficLight_PollResultHandlerRef_t trafficLight_AddPollResultHandler
+(
+    trafficLight_PollResultHandlerFunc_t handlerPtr,    ///< [IN] Handler
+    void * contextPtr                                   ///< [IN] Context of the handler
+)
+{
+    le_msg_SessionRef_t sessionRef = trafficLight_GetClientSessionRef();
+    le_event_HandlerRef_t handlerRef;
+    size_t i;
+
+    for (i = 0; i < MAX_POLL_RESULT_HANDLERS; i++)
+    {
+        if (ClientHandlers[i].sessionRef == NULL)
+        {
+            break;
+        }
+    }
+
+    if (i == MAX_POLL_RESULT_HANDLERS)
+    {
+        LE_ERROR("Too many PollResult handlers, at most %d", MAX_POLL_RESULT_HANDLERS);
+        return NULL;
+    }
+
+    handlerRef = le_event_AddLayeredHandler("PollResultHandler",
+                                            PollResultEventId,
+                                            FirstLayerPollResultHandler,
+                                            (void *) handlerPtr);
+    le_event_SetContextPtr(handlerRef, contextPtr);
+
+    ClientHandlers[i].sessionRef = sessionRef;
+    ClientHandlers[i].handlerRef = handlerRef;
+
+    return (trafficLight_PollResultHandlerRef_t) handlerRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes a handler of the poll results
+ */
+//--------------------------------------------------------------------------------------------------
+void trafficLight_RemovePollResultHandler
+(
+    trafficLight_PollResultHandlerRef_t handlerRef      ///< [IN] Handler to remove
+)
+{
+    size_t i;
+
+    for (i = 0; i < MAX_POLL_RESULT_HANDLERS; i++)
+    {
+        if ( (ClientHandlers[i].sessionRef != NULL) &&
+             (ClientHandlers[i].handlerRef == (le_event_HandlerRef_t) handlerRef) )
+        {
+            le_event_RemoveHandler(ClientHandlers[i].handlerRef);
+            ClientHandlers[i].sessionRef = NULL;
+            ClientHandlers[i].handlerRef = NULL;
+            return;
+        }
+    }
+
+    LE_WARN("Unknown PollResult handler %p", handlerRef);
+}
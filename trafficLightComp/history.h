@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file history.h
+ *
+ * History of the state transitions of the monitors. The last transitions are kept in a ring in
+ * RAM, and written to /history in the config tree, which lives in flash, in batches: every
+ * /historyFlushCount transitions, or /historyFlushIntervalSec after the first one not written.
+ * The history and the state shown by the light are restored from there at startup.
+ *
+ * The history is served to other apps by the trafficLight API, which also reports them the result
+ * of every poll.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef HISTORY_H_INCLUDE_GUARD
+#define HISTORY_H_INCLUDE_GUARD
+
+#include "trafficLight.h"
+
+// Number of transitions kept, in RAM and in flash
+#define HISTORY_SIZE 64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restores the history and the state shown by the light from the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+void history_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets when the transitions are written to flash
+ */
+//--------------------------------------------------------------------------------------------------
+void history_SetFlushPolicy
+(
+    uint32_t flushCount,            ///< [IN] Transitions written together, at least 1
+    uint32_t flushIntervalSec       ///< [IN] Longest time a transition waits, 0 for no limit
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a transition of a monitor to the history
+ */
+//--------------------------------------------------------------------------------------------------
+void history_Record
+(
+    const char * monitorPtr,        ///< [IN] Name of the monitor
+    int32_t httpCode,               ///< [IN] HTTP code of the response, 0 if none
+    MonitorState_t state,           ///< [IN] State the monitor changed to
+    uint32_t latencyMs              ///< [IN] Time from the start of the poll to the state
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reports the result of the poll of a monitor to the PollResult handlers of the trafficLight API
+ */
+//--------------------------------------------------------------------------------------------------
+void history_ReportPoll
+(
+    const char * monitorPtr,        ///< [IN] Name of the monitor
+    int32_t httpCode,               ///< [IN] HTTP code of the response, 0 if none
+    MonitorState_t state,           ///< [IN] State of the monitor
+    uint32_t latencyMs              ///< [IN] Time from the start of the poll to the state
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the state shown by the light. It is written to flash with the next transitions.
+ */
+//--------------------------------------------------------------------------------------------------
+void history_SetState
+(
+    MonitorState_t state            ///< [IN] Worst state of the monitors
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the state shown by the light
+ *
+ * @return
+ *      State, restored from flash until the first poll
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t history_GetState
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the state a monitor changed to last
+ *
+ * @return
+ *      State of the monitor, STATE_UNKNOWN if it is not in the history
+ */
+//--------------------------------------------------------------------------------------------------
+MonitorState_t history_GetLastState
+(
+    const char * monitorPtr         ///< [IN] Name of the monitor
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the transitions not written yet to flash, e.g. before the app stops
+ */
+//--------------------------------------------------------------------------------------------------
+void history_Flush
+(
+    void
+);
+
+#endif // HISTORY_H_INCLUDE_GUARD
@@ -0,0 +1,553 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file jenkinsViewCheck.c
+ *
+ * Check of all the jobs of a Jenkins view or folder at once, from the JSON answered by
+ * <view>/api/json?tree=jobs[name,color,lastCompletedBuild[result]], fed chunk by chunk.
+ *
+ * The result of the last completed build of each job gives its state, as set by the keywords of
+ * the check (the Jenkins results by default). The state of the view is the worst of its jobs.
+ * Only the jobs whose name starts with info/content/path count; disabled jobs and jobs never built
+ * are ignored. The jobs that count are also kept as the items of the check, so that each of them
+ * is shown as a monitor of its own.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "contentCheck.h"
+#include <ctype.h>
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Color of a job whose build is in progress ends with it, e.g. "red_anime"
+#define BUILDING_COLOR_SUFFIX "_anime"
+
+// API of a view or folder, appended to its URL, and the fields of its jobs the check reads: only
+// these are sent
+#define JENKINS_VIEW_API "api/json"
+#define JENKINS_VIEW_TREE "jobs[name,color,lastCompletedBuild[result]]"
+
+// Longest key, name, color or result that is compared, with its NULL char
+#define JENKINS_VIEW_MAX_STRING_BYTES MAX_MONITOR_NAME_BYTES
+
+// Size of the list of failing jobs logged with the result
+#define JENKINS_VIEW_MAX_FAILING_BYTES 128
+
+// Most jobs kept as items, the others only count in the state of the view
+#define JENKINS_VIEW_MAX_JOBS MAX_JOB_MONITORS
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tokens of the JSON content, as tracked by FeedContent
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    JENKINS_VIEW_TOKEN_NONE,            ///< Between tokens
+    JENKINS_VIEW_TOKEN_STRING,          ///< In a string
+    JENKINS_VIEW_TOKEN_ESCAPE,          ///< After a backslash in a string
+    JENKINS_VIEW_TOKEN_AFTER_STRING,    ///< After a string, which is a key if a colon follows
+}
+JenkinsViewToken_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Job being read
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char name[JENKINS_VIEW_MAX_STRING_BYTES];       ///< name
+    char color[JENKINS_VIEW_MAX_STRING_BYTES];      ///< color, e.g. "blue" or "red_anime"
+    char result[JENKINS_VIEW_MAX_STRING_BYTES];     ///< lastCompletedBuild.result, "" if none
+}
+JenkinsViewJob_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the check of a Jenkins view
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const ContentCheckParams_t * paramsPtr;         ///< Settings of the check
+    JenkinsViewToken_t token;                       ///< Token the content is in
+    size_t depth;                                   ///< Number of containers the content is in
+    bool isInJobs;                                  ///< Whether the content is in the jobs array
+    bool isInBuild;                                 ///< Whether it is in lastCompletedBuild
+    char string[JENKINS_VIEW_MAX_STRING_BYTES];     ///< String being read
+    size_t stringLength;                            ///< Length of the string, may exceed the buffer
+    char key[JENKINS_VIEW_MAX_STRING_BYTES];        ///< Key the next value belongs to
+    JenkinsViewJob_t job;                           ///< Job being read
+    size_t jobCounts[STATE_UNKNOWN + 1];            ///< Number of jobs in each state
+    bool isBuilding;                                ///< Whether a build of a job is in progress
+    char failing[JENKINS_VIEW_MAX_FAILING_BYTES];   ///< Names of the first failing jobs
+    ContentItem_t jobs[JENKINS_VIEW_MAX_JOBS];      ///< Jobs that count, with their state
+    size_t jobCount;                                ///< Number of jobs kept
+}
+JenkinsViewCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copies the string that was just read, truncated if needed
+ */
+//--------------------------------------------------------------------------------------------------
+static void CopyString
+(
+    const JenkinsViewCheck_t * checkPtr,    ///< [IN] Check that just read a string
+    char * bufferPtr                        ///< [OUT] Buffer of JENKINS_VIEW_MAX_STRING_BYTES
+)
+{
+    size_t length = MIN(checkPtr->stringLength, JENKINS_VIEW_MAX_STRING_BYTES - 1);
+
+    memcpy(bufferPtr, checkPtr->string, length);
+    bufferPtr[length] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps the value that was just read if it is a field of the job being read
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleValue
+(
+    JenkinsViewCheck_t * checkPtr           ///< [IN] Check that just read a string value
+)
+{
+    if (!checkPtr->isInJobs)
+    {
+        return;
+    }
+
+    if (checkPtr->depth == 3)
+    {
+        if (strcmp(checkPtr->key, "name") == 0)
+        {
+            CopyString(checkPtr, checkPtr->job.name);
+        }
+        else if (strcmp(checkPtr->key, "color") == 0)
+        {
+            CopyString(checkPtr, checkPtr->job.color);
+        }
+    }
+    else if ( (checkPtr->depth == 4) &&
+              checkPtr->isInBuild &&
+              (strcmp(checkPtr->key, "result") == 0) )
+    {
+        CopyString(checkPtr, checkPtr->job.result);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counts the state of a job once it is entirely read
+ */
+//--------------------------------------------------------------------------------------------------
+static void CountJob
+(
+    JenkinsViewCheck_t * checkPtr           ///< [IN] Check that just read a job
+)
+{
+    const ContentCheckParams_t * paramsPtr = checkPtr->paramsPtr;
+    const JenkinsViewJob_t * jobPtr = &checkPtr->job;
+    size_t colorLength = strlen(jobPtr->color);
+    size_t suffixLength = strlen(BUILDING_COLOR_SUFFIX);
+    MonitorState_t state = STATE_UNKNOWN;
+    bool isBuilding;
+    size_t i;
+
+    if ( strncmp(jobPtr->name, paramsPtr->path, strlen(paramsPtr->path)) ||
+         (strcmp(jobPtr->color, "disabled") == 0) )
+    {
+        return;
+    }
+
+    isBuilding = (colorLength > suffixLength) &&
+                 (strcmp(jobPtr->color + colorLength - suffixLength, BUILDING_COLOR_SUFFIX) == 0);
+    checkPtr->isBuilding = checkPtr->isBuilding || isBuilding;
+
+    for (i = 0; i < paramsPtr->keywordCount; i++)
+    {
+        if (strcmp(jobPtr->result, paramsPtr->keywords[i].keyword) == 0)
+        {
+            state = paramsPtr->keywords[i].state;
+            break;
+        }
+    }
+
+    LE_DEBUG("Job '%s': %s, %s", jobPtr->name, jobPtr->color, jobPtr->result);
+    checkPtr->jobCounts[state]++;
+
+    if (checkPtr->jobCount < JENKINS_VIEW_MAX_JOBS)
+    {
+        ContentItem_t * itemPtr = &checkPtr->jobs[checkPtr->jobCount++];
+
+        memcpy(itemPtr->name, jobPtr->name, sizeof(itemPtr->name));
+        itemPtr->state = state;
+        itemPtr->isInProgress = isBuilding;
+    }
+
+    if (state == STATE_FAIL)
+    {
+        size_t length = strlen(checkPtr->failing);
+
+        snprintf(checkPtr->failing + length,
+                 sizeof(checkPtr->failing) - length,
+                 "%s%s",
+                 (length > 0) ? ", " : "",
+                 jobPtr->name);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles a character between tokens: punctuation, or the start of a string. Literals, e.g. null
+ * for a job never built, are skipped.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandlePunctuation
+(
+    JenkinsViewCheck_t * checkPtr,          ///< [IN] Check in progress
+    char c                                  ///< [IN] Character of the content
+)
+{
+    switch (c)
+    {
+        case '{':
+        case '[':
+            if ( (checkPtr->depth == 1) && (c == '[') && (strcmp(checkPtr->key, "jobs") == 0) )
+            {
+                checkPtr->isInJobs = true;
+            }
+            else if ( checkPtr->isInJobs && (checkPtr->depth == 2) && (c == '{') )
+            {
+                memset(&checkPtr->job, 0, sizeof(checkPtr->job));
+            }
+            else if ( checkPtr->isInJobs && (checkPtr->depth == 3) && (c == '{') &&
+                      (strcmp(checkPtr->key, "lastCompletedBuild") == 0) )
+            {
+                checkPtr->isInBuild = true;
+            }
+            checkPtr->depth++;
+            checkPtr->key[0] = '\0';
+            break;
+
+        case '}':
+        case ']':
+            if (checkPtr->depth == 0)
+            {
+                break;
+            }
+            checkPtr->depth--;
+
+            if (checkPtr->isInJobs)
+            {
+                if (checkPtr->depth == 3)
+                {
+                    checkPtr->isInBuild = false;
+                }
+                else if ( (checkPtr->depth == 2) && (c == '}') )
+                {
+                    CountJob(checkPtr);
+                }
+                else if (checkPtr->depth == 1)
+                {
+                    checkPtr->isInJobs = false;
+                }
+            }
+            break;
+
+        case ',':
+            checkPtr->key[0] = '\0';
+            break;
+
+        case '"':
+            checkPtr->token = JENKINS_VIEW_TOKEN_STRING;
+            checkPtr->stringLength = 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the check of the content of a response
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitCheck
+(
+    void * statePtr,                        ///< [OUT] Check to initialize
+    const ContentCheckParams_t * paramsPtr  ///< [IN] Settings of the check, kept until the end
+)
+{
+    JenkinsViewCheck_t * checkPtr = statePtr;
+
+    memset(checkPtr, 0, sizeof(JenkinsViewCheck_t));
+    checkPtr->paramsPtr = paramsPtr;
+    checkPtr->token = JENKINS_VIEW_TOKEN_NONE;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the JSON content. The content is tokenized in a single pass, each job is
+ * counted once its object ends, so that only the job being read is kept.
+ *
+ * @return
+ *      false: every job counts, the content is read to its end
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FeedContent
+(
+    void * statePtr,                ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    JenkinsViewCheck_t * checkPtr = statePtr;
+    size_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        char c = dataPtr[index];
+
+        switch (checkPtr->token)
+        {
+            case JENKINS_VIEW_TOKEN_STRING:
+                if (c == '\\')
+                {
+                    checkPtr->token = JENKINS_VIEW_TOKEN_ESCAPE;
+                }
+                else if (c == '"')
+                {
+                    checkPtr->token = JENKINS_VIEW_TOKEN_AFTER_STRING;
+                }
+                else
+                {
+                    if (checkPtr->stringLength < JENKINS_VIEW_MAX_STRING_BYTES)
+                    {
+                        checkPtr->string[checkPtr->stringLength] = c;
+                    }
+                    checkPtr->stringLength++;
+                }
+                continue;
+
+            case JENKINS_VIEW_TOKEN_ESCAPE:
+                // Names are compared as written, escapes included
+                if (checkPtr->stringLength + 1 < JENKINS_VIEW_MAX_STRING_BYTES)
+                {
+                    checkPtr->string[checkPtr->stringLength] = '\\';
+                    checkPtr->string[checkPtr->stringLength + 1] = c;
+                }
+                checkPtr->stringLength += 2;
+                checkPtr->token = JENKINS_VIEW_TOKEN_STRING;
+                continue;
+
+            case JENKINS_VIEW_TOKEN_AFTER_STRING:
+                if (isspace((unsigned char) c))
+                {
+                    continue;
+                }
+
+                checkPtr->token = JENKINS_VIEW_TOKEN_NONE;
+                if (c == ':')
+                {
+                    CopyString(checkPtr, checkPtr->key);
+                    continue;
+                }
+                HandleValue(checkPtr);
+                break;
+
+            case JENKINS_VIEW_TOKEN_NONE:
+            default:
+                break;
+        }
+
+        HandlePunctuation(checkPtr, c);
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the check once the content is entirely received
+ *
+ * @return
+ *      Worst state of the jobs, STATE_FAIL if there are none
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t FinishCheck
+(
+    void * statePtr                 ///< [IN] Check fed with the content received
+)
+{
+    JenkinsViewCheck_t * checkPtr = statePtr;
+    const size_t * countPtrs = checkPtr->jobCounts;
+    size_t jobCount = countPtrs[STATE_FAIL] + countPtrs[STATE_WARNING] + countPtrs[STATE_PASS] +
+                      countPtrs[STATE_UNKNOWN];
+    int state;
+
+    if (jobCount == 0)
+    {
+        LE_ERROR("Cannot find any job matching '%s'", checkPtr->paramsPtr->path);
+        return STATE_FAIL;
+    }
+
+    if (jobCount > checkPtr->jobCount)
+    {
+        LE_WARN("Only the first %zu of the %zu jobs are shown as monitors",
+                checkPtr->jobCount,
+                jobCount);
+    }
+
+    LE_INFO("%zu job(s): %zu failing, %zu unstable, %zu passing, %zu not built%s%s%s",
+            jobCount,
+            countPtrs[STATE_FAIL],
+            countPtrs[STATE_WARNING],
+            countPtrs[STATE_PASS],
+            countPtrs[STATE_UNKNOWN],
+            checkPtr->isBuilding ? ", building" : "",
+            (countPtrs[STATE_FAIL] > 0) ? "; failing: " : "",
+            checkPtr->failing);
+
+    for (state = STATE_FAIL; state < STATE_UNKNOWN; state++)
+    {
+        if (countPtrs[state] > 0)
+        {
+            return state;
+        }
+    }
+
+    // Only jobs never built
+    return STATE_UNKNOWN;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether a build of one of the jobs is in progress
+ *
+ * @return
+ *      true if the color of a job is animated, e.g. "blue_anime"
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsInProgress
+(
+    const void * statePtr           ///< [IN] Check fed with the content received
+)
+{
+    return ((const JenkinsViewCheck_t *) statePtr)->isBuilding;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the jobs that count, with their state
+ *
+ * @return
+ *      Jobs, in the order of the view
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentItem_t * GetItems
+(
+    const void * statePtr,          ///< [IN] Check fed with the content received
+    size_t * countPtr               ///< [OUT] Number of jobs
+)
+{
+    const JenkinsViewCheck_t * checkPtr = statePtr;
+
+    *countPtr = checkPtr->jobCount;
+    return checkPtr->jobs;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the results of the jobs of a Jenkins view to the default Jenkins keywords if
+ * info/content/keywords is not set. The results are compared as a whole, no automaton is needed.
+ *
+ * @return
+ *      LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PrepareCheck
+(
+    ContentCheckParams_t * paramsPtr    ///< [IN/OUT] Settings of the check
+)
+{
+    contentCheck_SetJenkinsKeywords(paramsPtr);
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds the API of a Jenkins view to its URL, unless the URL already has a query, e.g.
+ * ".../api/json?depth=1", and restricts the query to the fields the check reads, unless it already
+ * sets them
+ *
+ * @return
+ *      - LE_OK if the URL is complete
+ *      - LE_OVERFLOW if it does not fit
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CompleteUrl
+(
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Settings of the check
+    char * urlPtr,                              ///< [IN/OUT] URL of the view
+    size_t urlSize                              ///< [IN] Size of the URL buffer
+)
+{
+    size_t length = strlen(urlPtr);
+    const char * queryPtr;
+
+    if (length == 0)
+    {
+        return LE_OK;
+    }
+
+    queryPtr = strchr(urlPtr, '?');
+    if (queryPtr == NULL)
+    {
+        int written = snprintf(urlPtr + length,
+                               urlSize - length,
+                               "%s%s",
+                               (urlPtr[length - 1] == '/') ? "" : "/",
+                               JENKINS_VIEW_API);
+
+        if ( (written < 0) || ((size_t) written >= urlSize - length) )
+        {
+            urlPtr[length] = '\0';
+            return LE_OVERFLOW;
+        }
+    }
+    else if ( (strstr(queryPtr, "?tree=") != NULL) || (strstr(queryPtr, "&tree=") != NULL) )
+    {
+        return LE_OK;
+    }
+
+    if (contentCheck_AddQueryParam(urlPtr, urlSize, "tree", JENKINS_VIEW_TREE) != LE_OK)
+    {
+        urlPtr[length] = '\0';
+        return LE_OVERFLOW;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checker of the jobs of a Jenkins view, as info/content/checkMode "jenkinsView"
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentChecker_t JenkinsViewChecker =
+{
+    .namePtr = "jenkinsView",
+    .stateSize = sizeof(JenkinsViewCheck_t),
+    .prepare = PrepareCheck,
+    .init = InitCheck,
+    .feed = FeedContent,
+    .finish = FinishCheck,
+    .isInProgress = IsInProgress,
+    .getItems = GetItems,
+    .completeUrl = CompleteUrl,
+};
+CONTENT_CHECK_REGISTER(JenkinsViewChecker)
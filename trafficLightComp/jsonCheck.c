@@ -0,0 +1,529 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file jsonCheck.c
+ *
+ * Check of a value in a JSON document, fed chunk by chunk.
+ *
+ * info/content/path locates the value, e.g. `$.status.indicator` or `components[0].status`. If
+ * info/content/value is set, the value must be equal to it. Otherwise the value is a number
+ * compared to info/content/warningThreshold and info/content/criticalThreshold.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "contentCheck.h"
+#include <ctype.h>
+#include <math.h>
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Deepest nesting that is tracked, deeper values are skipped
+#define JSON_MAX_DEPTH 16
+
+// Longest key or value that can be compared
+#define JSON_MAX_STRING_BYTES MAX_CONTENT_VALUE_BYTES
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Step of a JSON path: a key of an object or an index in an array
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isIndex;               ///< Whether the step is an index
+    size_t index;               ///< Index in the array
+    const char * keyPtr;        ///< Key in the object, pointing in JsonCheck_t.path
+}
+JsonPathStep_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tokens of the JSON content, as tracked by FeedContent
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    JSON_TOKEN_NONE,            ///< Between tokens
+    JSON_TOKEN_STRING,          ///< In a string
+    JSON_TOKEN_ESCAPE,          ///< After a backslash in a string
+    JSON_TOKEN_AFTER_STRING,    ///< After a string, which is a key if a colon follows
+    JSON_TOKEN_LITERAL,         ///< In a number, true, false or null
+}
+JsonToken_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Object or array the content is in
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isArray;               ///< Whether the container is an array
+    size_t index;               ///< Index of the current element of an array
+    bool isOnPath;              ///< Whether the current member or element is on the path
+}
+JsonLevel_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the check of a JSON value
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const ContentCheckParams_t * paramsPtr;     ///< Settings of the check
+    char path[MAX_CONTENT_PATH_BYTES];          ///< Copy of the path, cut into its steps
+    JsonPathStep_t steps[JSON_MAX_DEPTH];       ///< Steps of the path
+    size_t stepCount;                           ///< Number of steps of the path
+    bool isPathValid;                           ///< Whether the path could be parsed
+    JsonToken_t token;                          ///< Token the content is in
+    JsonLevel_t levels[JSON_MAX_DEPTH];         ///< Containers the content is in
+    size_t depth;                               ///< Number of containers the content is in
+    size_t skippedDepth;                        ///< Containers nested deeper than JSON_MAX_DEPTH
+    size_t pathDepth;                           ///< Number of outer containers on the path
+    char string[JSON_MAX_STRING_BYTES];         ///< String or literal being read
+    size_t stringLength;                        ///< Length of the string, may exceed the buffer
+    bool isFound;                               ///< Whether the value was found
+    char value[JSON_MAX_STRING_BYTES];          ///< Value found, without quotes
+}
+JsonCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Cuts the path, e.g. `$.components[0].status`, into its steps
+ *
+ * @return
+ *      true if the path is valid
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ParsePath
+(
+    JsonCheck_t * checkPtr          ///< [IN] Check whose path is parsed
+)
+{
+    char * charPtr = checkPtr->path;
+
+    if (*charPtr == '$')
+    {
+        charPtr++;
+    }
+
+    while (*charPtr != '\0')
+    {
+        JsonPathStep_t * stepPtr = &checkPtr->steps[checkPtr->stepCount];
+
+        if (checkPtr->stepCount == JSON_MAX_DEPTH)
+        {
+            return false;
+        }
+
+        if (*charPtr == '[')
+        {
+            char * endPtr;
+
+            *charPtr++ = '\0';
+            if (!isdigit((unsigned char) *charPtr))
+            {
+                return false;
+            }
+
+            stepPtr->isIndex = true;
+            stepPtr->index = strtoul(charPtr, &endPtr, 10);
+            if (*endPtr != ']')
+            {
+                return false;
+            }
+            charPtr = endPtr + 1;
+        }
+        else
+        {
+            // The first key may not start with a dot
+            if (*charPtr == '.')
+            {
+                *charPtr++ = '\0';
+            }
+            else if (checkPtr->stepCount > 0)
+            {
+                return false;
+            }
+
+            stepPtr->isIndex = false;
+            stepPtr->keyPtr = charPtr;
+            while ( (*charPtr != '\0') && (*charPtr != '.') && (*charPtr != '[') )
+            {
+                charPtr++;
+            }
+            if (charPtr == stepPtr->keyPtr)
+            {
+                return false;
+            }
+        }
+
+        checkPtr->stepCount++;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the current member or element of the innermost container is on the path, and
+ * updates the number of containers on the path accordingly.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdatePathDepth
+(
+    JsonCheck_t * checkPtr,         ///< [IN] Check in progress
+    const char * keyPtr,            ///< [IN] Key of the member, NULL for an element of an array
+    size_t keyLength                ///< [IN] Length of the key
+)
+{
+    size_t level = checkPtr->depth - 1;
+    JsonLevel_t * levelPtr = &checkPtr->levels[level];
+    const JsonPathStep_t * stepPtr = &checkPtr->steps[level];
+
+    levelPtr->isOnPath = false;
+
+    if ( (checkPtr->pathDepth >= level) && (level < checkPtr->stepCount) )
+    {
+        if (keyPtr == NULL)
+        {
+            levelPtr->isOnPath = stepPtr->isIndex && (stepPtr->index == levelPtr->index);
+        }
+        else
+        {
+            levelPtr->isOnPath = !stepPtr->isIndex &&
+                                 (strlen(stepPtr->keyPtr) == keyLength) &&
+                                 (memcmp(stepPtr->keyPtr, keyPtr, keyLength) == 0);
+        }
+    }
+
+    checkPtr->pathDepth = levelPtr->isOnPath ? checkPtr->depth : MIN(checkPtr->pathDepth, level);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps a scalar value if it is the one the path locates
+ *
+ * @return
+ *      true if it is the value looked for
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CheckValue
+(
+    JsonCheck_t * checkPtr          ///< [IN] Check that just read a value
+)
+{
+    if ( (checkPtr->skippedDepth > 0) ||
+         (checkPtr->depth != checkPtr->stepCount) ||
+         (checkPtr->pathDepth != checkPtr->depth) )
+    {
+        return false;
+    }
+
+    if (checkPtr->stringLength >= JSON_MAX_STRING_BYTES)
+    {
+        LE_WARN("Value at '%s' is too long", checkPtr->paramsPtr->path);
+        checkPtr->stringLength = JSON_MAX_STRING_BYTES - 1;
+    }
+
+    memcpy(checkPtr->value, checkPtr->string, checkPtr->stringLength);
+    checkPtr->value[checkPtr->stringLength] = '\0';
+    checkPtr->isFound = true;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles a character between tokens: punctuation, or the start of a string or a literal
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandlePunctuation
+(
+    JsonCheck_t * checkPtr,         ///< [IN] Check in progress
+    char c                          ///< [IN] Character of the content
+)
+{
+    switch (c)
+    {
+        case '{':
+        case '[':
+            if ( (checkPtr->skippedDepth > 0) || (checkPtr->depth == JSON_MAX_DEPTH) )
+            {
+                checkPtr->skippedDepth++;
+                break;
+            }
+
+            checkPtr->levels[checkPtr->depth].isArray = (c == '[');
+            checkPtr->levels[checkPtr->depth].index = 0;
+            checkPtr->levels[checkPtr->depth].isOnPath = false;
+            checkPtr->depth++;
+
+            // The first element of an array has no separator before it
+            if (c == '[')
+            {
+                UpdatePathDepth(checkPtr, NULL, 0);
+            }
+            break;
+
+        case '}':
+        case ']':
+            if (checkPtr->skippedDepth > 0)
+            {
+                checkPtr->skippedDepth--;
+            }
+            else if (checkPtr->depth > 0)
+            {
+                checkPtr->depth--;
+                checkPtr->pathDepth = MIN(checkPtr->pathDepth, checkPtr->depth);
+            }
+            break;
+
+        case ',':
+            if ( (checkPtr->skippedDepth == 0) && (checkPtr->depth > 0) )
+            {
+                JsonLevel_t * levelPtr = &checkPtr->levels[checkPtr->depth - 1];
+
+                if (levelPtr->isArray)
+                {
+                    levelPtr->index++;
+                    UpdatePathDepth(checkPtr, NULL, 0);
+                }
+                else
+                {
+                    // On the path again once the key of the next member is read
+                    levelPtr->isOnPath = false;
+                    checkPtr->pathDepth = MIN(checkPtr->pathDepth, checkPtr->depth - 1);
+                }
+            }
+            break;
+
+        case '"':
+            checkPtr->token = JSON_TOKEN_STRING;
+            checkPtr->stringLength = 0;
+            break;
+
+        default:
+            if (isalnum((unsigned char) c) || (c == '-'))
+            {
+                checkPtr->token = JSON_TOKEN_LITERAL;
+                checkPtr->string[0] = c;
+                checkPtr->stringLength = 1;
+            }
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the check of the content of a response
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitCheck
+(
+    void * statePtr,                        ///< [OUT] Check to initialize
+    const ContentCheckParams_t * paramsPtr  ///< [IN] Settings of the check, kept until the end
+)
+{
+    JsonCheck_t * checkPtr = statePtr;
+
+    memset(checkPtr, 0, sizeof(JsonCheck_t));
+    checkPtr->paramsPtr = paramsPtr;
+    checkPtr->token = JSON_TOKEN_NONE;
+
+    snprintf(checkPtr->path, sizeof(checkPtr->path), "%s", paramsPtr->path);
+    checkPtr->isPathValid = ParsePath(checkPtr);
+    if (!checkPtr->isPathValid)
+    {
+        LE_ERROR("Invalid JSON path '%s'", paramsPtr->path);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the JSON content.
+ *
+ * The content is tokenized in a single pass, the token in progress and the containers it is in are
+ * kept between chunks.
+ *
+ * @return
+ *      true once the verdict is known: the value is found
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FeedContent
+(
+    void * statePtr,                ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    JsonCheck_t * checkPtr = statePtr;
+    size_t index;
+
+    if (!checkPtr->isPathValid)
+    {
+        return true;
+    }
+
+    for (index = 0; index < length; index++)
+    {
+        char c = dataPtr[index];
+
+        switch (checkPtr->token)
+        {
+            case JSON_TOKEN_STRING:
+                if (c == '\\')
+                {
+                    checkPtr->token = JSON_TOKEN_ESCAPE;
+                }
+                else if (c == '"')
+                {
+                    checkPtr->token = JSON_TOKEN_AFTER_STRING;
+                }
+                else
+                {
+                    if (checkPtr->stringLength < JSON_MAX_STRING_BYTES)
+                    {
+                        checkPtr->string[checkPtr->stringLength] = c;
+                    }
+                    checkPtr->stringLength++;
+                }
+                continue;
+
+            case JSON_TOKEN_ESCAPE:
+                // Escapes are kept as is, the value is compared as written
+                if (checkPtr->stringLength + 1 < JSON_MAX_STRING_BYTES)
+                {
+                    checkPtr->string[checkPtr->stringLength] = '\\';
+                    checkPtr->string[checkPtr->stringLength + 1] = c;
+                }
+                checkPtr->stringLength += 2;
+                checkPtr->token = JSON_TOKEN_STRING;
+                continue;
+
+            case JSON_TOKEN_AFTER_STRING:
+                if (isspace((unsigned char) c))
+                {
+                    continue;
+                }
+
+                checkPtr->token = JSON_TOKEN_NONE;
+                if (c == ':')
+                {
+                    if ( (checkPtr->skippedDepth == 0) && (checkPtr->depth > 0) )
+                    {
+                        UpdatePathDepth(checkPtr,
+                                        checkPtr->string,
+                                        MIN(checkPtr->stringLength, JSON_MAX_STRING_BYTES));
+                    }
+                    continue;
+                }
+                if (CheckValue(checkPtr))
+                {
+                    return true;
+                }
+                break;
+
+            case JSON_TOKEN_LITERAL:
+                if (isalnum((unsigned char) c) || (c == '.') || (c == '+') || (c == '-'))
+                {
+                    if (checkPtr->stringLength < JSON_MAX_STRING_BYTES)
+                    {
+                        checkPtr->string[checkPtr->stringLength] = c;
+                    }
+                    checkPtr->stringLength++;
+                    continue;
+                }
+
+                checkPtr->token = JSON_TOKEN_NONE;
+                if (CheckValue(checkPtr))
+                {
+                    return true;
+                }
+                break;
+
+            case JSON_TOKEN_NONE:
+            default:
+                break;
+        }
+
+        HandlePunctuation(checkPtr, c);
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the check once the content is entirely received or once the verdict is known
+ *
+ * @return
+ *      State of the value, STATE_FAIL if it is not found
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t FinishCheck
+(
+    void * statePtr                 ///< [IN] Check fed with the content received
+)
+{
+    JsonCheck_t * checkPtr = statePtr;
+    const ContentCheckParams_t * paramsPtr = checkPtr->paramsPtr;
+    MonitorState_t state;
+
+    if (!checkPtr->isPathValid)
+    {
+        return STATE_FAIL;
+    }
+
+    // The content may be a single string or literal
+    if ( ( (checkPtr->token == JSON_TOKEN_LITERAL) ||
+           (checkPtr->token == JSON_TOKEN_AFTER_STRING) ) &&
+         !checkPtr->isFound )
+    {
+        CheckValue(checkPtr);
+    }
+
+    if (!checkPtr->isFound)
+    {
+        LE_ERROR("Cannot find '%s'", paramsPtr->path);
+        return STATE_FAIL;
+    }
+
+    if (paramsPtr->value[0] != '\0')
+    {
+        state = (strcmp(checkPtr->value, paramsPtr->value) == 0) ? STATE_PASS : STATE_FAIL;
+    }
+    else
+    {
+        char * endPtr;
+        double number = strtod(checkPtr->value, &endPtr);
+
+        if ( (endPtr == checkPtr->value) || (*endPtr != '\0') )
+        {
+            LE_ERROR("'%s' is not a number: '%s'", paramsPtr->path, checkPtr->value);
+            return STATE_FAIL;
+        }
+
+        state = contentCheck_CompareThresholds(paramsPtr, number);
+    }
+
+    LE_INFO("'%s' = '%s': state %d", paramsPtr->path, checkPtr->value, state);
+
+    return state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checker of a JSON value, as info/content/checkMode "json"
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentChecker_t JsonChecker =
+{
+    .namePtr = "json",
+    .stateSize = sizeof(JsonCheck_t),
+    .init = InitCheck,
+    .feed = FeedContent,
+    .finish = FinishCheck,
+};
+CONTENT_CHECK_REGISTER(JsonChecker)
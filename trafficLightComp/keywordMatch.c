@@ -0,0 +1,164 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file keywordMatch.c
+ *
+ * Aho-Corasick automaton finding several keywords at once, see keywordMatch.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "keywordMatch.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finds the node continuing a prefix with a character
+ *
+ * @return
+ *      Node, 0 if the prefix cannot be continued with this character
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t GetChild
+(
+    const KeywordAutomaton_t * automatonPtr,    ///< [IN] Automaton
+    uint16_t node,                              ///< [IN] Node of the prefix
+    char c                                      ///< [IN] Next character
+)
+{
+    uint16_t child = automatonPtr->nodes[node].firstChild;
+
+    while ( (child != 0) && (automatonPtr->nodes[child].c != c) )
+    {
+        child = automatonPtr->nodes[child].nextSibling;
+    }
+
+    return child;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the automaton looking for keywords. Keyword i is reported as bit i of the matches.
+ *
+ * @return
+ *      - LE_OK if the automaton is built
+ *      - LE_OVERFLOW if there are more than KEYWORD_MAX_PATTERNS keywords, or one is longer than
+ *        KEYWORD_MAX_PATTERN_BYTES
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t keywordMatch_Compile
+(
+    KeywordAutomaton_t * automatonPtr,      ///< [OUT] Automaton
+    const char * const keywords[],          ///< [IN] Keywords, empty ones are never reported
+    size_t keywordCount                     ///< [IN] Number of keywords
+)
+{
+    uint16_t queue[KEYWORD_MAX_NODES];
+    size_t head = 0;
+    size_t tail = 0;
+    size_t i;
+
+    memset(automatonPtr, 0, sizeof(KeywordAutomaton_t));
+    automatonPtr->nodeCount = 1;
+
+    if (keywordCount > KEYWORD_MAX_PATTERNS)
+    {
+        return LE_OVERFLOW;
+    }
+
+    // Trie of the keywords
+    for (i = 0; i < keywordCount; i++)
+    {
+        const char * charPtr;
+        uint16_t node = 0;
+
+        if (keywords[i][0] == '\0')
+        {
+            continue;
+        }
+
+        if (strnlen(keywords[i], KEYWORD_MAX_PATTERN_BYTES) >= KEYWORD_MAX_PATTERN_BYTES)
+        {
+            return LE_OVERFLOW;
+        }
+
+        for (charPtr = keywords[i]; *charPtr != '\0'; charPtr++)
+        {
+            uint16_t child = GetChild(automatonPtr, node, *charPtr);
+
+            if (child == 0)
+            {
+                KeywordNode_t * childPtr;
+
+                LE_ASSERT(automatonPtr->nodeCount < KEYWORD_MAX_NODES);
+                child = automatonPtr->nodeCount++;
+                childPtr = &automatonPtr->nodes[child];
+                childPtr->c = *charPtr;
+                childPtr->nextSibling = automatonPtr->nodes[node].firstChild;
+                automatonPtr->nodes[node].firstChild = child;
+            }
+            node = child;
+        }
+
+        automatonPtr->nodes[node].matches |= (1u << i);
+    }
+
+    // Failure links, breadth first so that the links of the shorter prefixes are known
+    for (i = automatonPtr->nodes[0].firstChild; i != 0; i = automatonPtr->nodes[i].nextSibling)
+    {
+        queue[tail++] = i;
+    }
+
+    while (head < tail)
+    {
+        uint16_t node = queue[head++];
+        uint16_t child;
+
+        for (child = automatonPtr->nodes[node].firstChild;
+             child != 0;
+             child = automatonPtr->nodes[child].nextSibling)
+        {
+            KeywordNode_t * childPtr = &automatonPtr->nodes[child];
+            uint16_t fail = automatonPtr->nodes[node].fail;
+
+            while ( (fail != 0) && (GetChild(automatonPtr, fail, childPtr->c) == 0) )
+            {
+                fail = automatonPtr->nodes[fail].fail;
+            }
+            childPtr->fail = GetChild(automatonPtr, fail, childPtr->c);
+
+            // Keywords that are suffixes of this prefix end here too
+            childPtr->matches |= automatonPtr->nodes[childPtr->fail].matches;
+
+            queue[tail++] = child;
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds one character of the content to the automaton
+ *
+ * @return
+ *      Bit mask of the keywords that the character completes
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t keywordMatch_Feed
+(
+    const KeywordAutomaton_t * automatonPtr,    ///< [IN] Automaton
+    uint16_t * nodePtr,                         ///< [IN/OUT] Node reached so far, 0 to start
+    char c                                      ///< [IN] Next character of the content
+)
+{
+    uint16_t node = *nodePtr;
+    uint16_t child;
+
+    while ( ((child = GetChild(automatonPtr, node, c)) == 0) && (node != 0) )
+    {
+        node = automatonPtr->nodes[node].fail;
+    }
+
+    *nodePtr = child;
+
+    return automatonPtr->nodes[child].matches;
+}
@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file keywordMatch.h
+ *
+ * Finds several keywords at once in a content received chunk by chunk (Aho-Corasick automaton).
+ * The automaton is built once from the keywords, each character of the content then costs a
+ * constant time on average whatever the number of keywords.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef KEYWORD_MATCH_H_INCLUDE_GUARD
+#define KEYWORD_MATCH_H_INCLUDE_GUARD
+
+// Most keywords in an automaton, each one is a bit of KeywordNode_t.matches, and their size with
+// the NULL char
+#define KEYWORD_MAX_PATTERNS 19
+#define KEYWORD_MAX_PATTERN_BYTES 32
+
+// Most nodes in an automaton: the root plus one per distinct prefix of the keywords, which is at
+// most one per character when no keyword shares a prefix
+#define KEYWORD_MAX_NODES (1 + KEYWORD_MAX_PATTERNS * (KEYWORD_MAX_PATTERN_BYTES - 1))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Node of the automaton: the prefix of one or more keywords that was just read
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char c;                     ///< Character leading to the node from its parent
+    uint16_t firstChild;        ///< First node that continues the prefix, 0 if none
+    uint16_t nextSibling;       ///< Next node with the same parent, 0 if none
+    uint16_t fail;              ///< Node of the longest suffix of the prefix that is a prefix too
+    uint32_t matches;           ///< Bit mask of the keywords that end here
+}
+KeywordNode_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Automaton looking for a set of keywords. Node 0 is the root, the empty prefix.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    KeywordNode_t nodes[KEYWORD_MAX_NODES];     ///< Nodes
+    size_t nodeCount;                           ///< Number of nodes
+}
+KeywordAutomaton_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the automaton looking for keywords. Keyword i is reported as bit i of the matches.
+ *
+ * @return
+ *      - LE_OK if the automaton is built
+ *      - LE_OVERFLOW if there are more than KEYWORD_MAX_PATTERNS keywords, or one is longer than
+ *        KEYWORD_MAX_PATTERN_BYTES
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t keywordMatch_Compile
+(
+    KeywordAutomaton_t * automatonPtr,      ///< [OUT] Automaton
+    const char * const keywords[],          ///< [IN] Keywords, empty ones are never reported
+    size_t keywordCount                     ///< [IN] Number of keywords
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds one character of the content to the automaton
+ *
+ * @return
+ *      Bit mask of the keywords that the character completes
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t keywordMatch_Feed
+(
+    const KeywordAutomaton_t * automatonPtr,    ///< [IN] Automaton
+    uint16_t * nodePtr,                         ///< [IN/OUT] Node reached so far, 0 to start
+    char c                                      ///< [IN] Next character of the content
+);
+
+#endif // KEYWORD_MATCH_H_INCLUDE_GUARD
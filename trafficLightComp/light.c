@@ -0,0 +1,650 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file light.c
+ *
+ * Drives the lights of the towers, see light.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "light.h"
+
+// Durations of the steps of the patterns
+#define BLINK_STEP_MS 500
+#define PULSE_ON_MS 150
+#define PULSE_OFF_MS 1850
+#define ALTERNATE_STEP_MS 500
+
+// Steps due within this time of the one the step timer was set to are done along with it, so that
+// the towers shown together step together on a single wakeup
+#define STEP_SLACK_MS 10
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the pins of a tower whose level changes
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*WritePinsFunc_t)
+(
+    uint8_t changed,        ///< [IN] Bit mask of the lights whose level changes
+    uint8_t lights          ///< [IN] Bit mask of the lights that are on
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tower of lights
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isAvailable;               ///< Whether its pins are bound and activated
+    WritePinsFunc_t writePinsFunc;  ///< Writes its pins
+    LightPattern_t pattern;         ///< Pattern being shown
+    size_t stepIndex;               ///< Current step of the pattern
+    le_clk_Time_t nextStepTime;     ///< When the pattern moves to its next step, only for the
+                                    ///< patterns with several steps
+    uint8_t drivenLights;           ///< Lights currently on
+    bool hasDrivenLights;           ///< Whether the pins were ever written
+}
+Output_t;
+
+static Output_t Outputs[LIGHT_MAX_OUTPUTS];
+
+// Moves the patterns of all the towers to their next step, set to the earliest one. Only running
+// while a pattern has several steps.
+static le_timer_Ref_t StepTimer;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the GPIO pins of the main tower to active_high with respect to the lights
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteMainPins
+(
+    uint8_t changed,        ///< [IN] Bit mask of the lights whose level changes
+    uint8_t lights          ///< [IN] Bit mask of the lights that are on
+)
+{
+    if (changed & LIGHT_GREEN)
+    {
+        le_gpioGreen_SetPushPullOutput(LE_GPIOGREEN_ACTIVE_HIGH, (lights & LIGHT_GREEN) != 0);
+    }
+    if (changed & LIGHT_YELLOW)
+    {
+        le_gpioYellow_SetPushPullOutput(LE_GPIOYELLOW_ACTIVE_HIGH, (lights & LIGHT_YELLOW) != 0);
+    }
+    if (changed & LIGHT_RED)
+    {
+        le_gpioRed_SetPushPullOutput(LE_GPIORED_ACTIVE_HIGH, (lights & LIGHT_RED) != 0);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the GPIO pins of the second tower to active_high with respect to the lights
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteSecondPins
+(
+    uint8_t changed,        ///< [IN] Bit mask of the lights whose level changes
+    uint8_t lights          ///< [IN] Bit mask of the lights that are on
+)
+{
+    if (changed & LIGHT_GREEN)
+    {
+        le_gpioGreen2_SetPushPullOutput(LE_GPIOGREEN2_ACTIVE_HIGH, (lights & LIGHT_GREEN) != 0);
+    }
+    if (changed & LIGHT_YELLOW)
+    {
+        le_gpioYellow2_SetPushPullOutput(LE_GPIOYELLOW2_ACTIVE_HIGH,
+                                         (lights & LIGHT_YELLOW) != 0);
+    }
+    if (changed & LIGHT_RED)
+    {
+        le_gpioRed2_SetPushPullOutput(LE_GPIORED2_ACTIVE_HIGH, (lights & LIGHT_RED) != 0);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the GPIO pins of the third tower to active_high with respect to the lights
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteThirdPins
+(
+    uint8_t changed,        ///< [IN] Bit mask of the lights whose level changes
+    uint8_t lights          ///< [IN] Bit mask of the lights that are on
+)
+{
+    if (changed & LIGHT_GREEN)
+    {
+        le_gpioGreen3_SetPushPullOutput(LE_GPIOGREEN3_ACTIVE_HIGH, (lights & LIGHT_GREEN) != 0);
+    }
+    if (changed & LIGHT_YELLOW)
+    {
+        le_gpioYellow3_SetPushPullOutput(LE_GPIOYELLOW3_ACTIVE_HIGH,
+                                         (lights & LIGHT_YELLOW) != 0);
+    }
+    if (changed & LIGHT_RED)
+    {
+        le_gpioRed3_SetPushPullOutput(LE_GPIORED3_ACTIVE_HIGH, (lights & LIGHT_RED) != 0);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connects to the pins of the second tower and activates them
+ *
+ * @return
+ *      true if its pins are bound
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ActivateSecondPins
+(
+    void
+)
+{
+    if ( (le_gpioRed2_TryConnectService() != LE_OK) ||
+         (le_gpioYellow2_TryConnectService() != LE_OK) ||
+         (le_gpioGreen2_TryConnectService() != LE_OK) )
+    {
+        return false;
+    }
+
+    le_gpioRed2_Activate();
+    le_gpioRed2_EnablePullUp();
+    le_gpioYellow2_Activate();
+    le_gpioYellow2_EnablePullUp();
+    le_gpioGreen2_Activate();
+    le_gpioGreen2_EnablePullUp();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connects to the pins of the third tower and activates them
+ *
+ * @return
+ *      true if its pins are bound
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ActivateThirdPins
+(
+    void
+)
+{
+    if ( (le_gpioRed3_TryConnectService() != LE_OK) ||
+         (le_gpioYellow3_TryConnectService() != LE_OK) ||
+         (le_gpioGreen3_TryConnectService() != LE_OK) )
+    {
+        return false;
+    }
+
+    le_gpioRed3_Activate();
+    le_gpioRed3_EnablePullUp();
+    le_gpioYellow3_Activate();
+    le_gpioYellow3_EnablePullUp();
+    le_gpioGreen3_Activate();
+    le_gpioGreen3_EnablePullUp();
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the lights of a tower, only writing the pins whose level changes
+ */
+//--------------------------------------------------------------------------------------------------
+static void DriveLights
+(
+    Output_t * outputPtr,   ///< [IN] Tower
+    uint8_t lights          ///< [IN] Bit mask of the lights that are on
+)
+{
+    uint8_t changed = outputPtr->hasDrivenLights ? (lights ^ outputPtr->drivenLights) : LIGHT_ON;
+
+    outputPtr->writePinsFunc(changed, lights);
+
+    outputPtr->drivenLights = lights;
+    outputPtr->hasDrivenLights = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares two patterns step by step. The steps are compared field by field, their padding is not.
+ *
+ * @return
+ *      true if the patterns have the same steps
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSamePattern
+(
+    const LightPattern_t * aPtr,    ///< [IN] Pattern
+    const LightPattern_t * bPtr     ///< [IN] Other pattern
+)
+{
+    size_t i;
+
+    if (aPtr->stepCount != bPtr->stepCount)
+    {
+        return false;
+    }
+
+    for (i = 0; i < aPtr->stepCount; i++)
+    {
+        if ( (aPtr->steps[i].lights != bPtr->steps[i].lights) ||
+             (aPtr->steps[i].durationMs != bPtr->steps[i].durationMs) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Converts a duration of a step
+ *
+ * @return
+ *      Duration
+ */
+//--------------------------------------------------------------------------------------------------
+static le_clk_Time_t MsToTime
+(
+    uint32_t ms                     ///< [IN] Duration in milliseconds
+)
+{
+    le_clk_Time_t time = { ms / 1000, (ms % 1000) * 1000 };
+
+    return time;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the pattern of a tower moves from step to step
+ *
+ * @return
+ *      true if the tower shows a pattern with several steps
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsStepping
+(
+    const Output_t * outputPtr      ///< [IN] Tower
+)
+{
+    return outputPtr->isAvailable && (outputPtr->pattern.stepCount > 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the step timer to the earliest next step of the towers, or stops it if no pattern has
+ * several steps. A single timer wakes the app up once for the steps of all the towers that fall
+ * together.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleStepTimer
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    const Output_t * nextPtr = NULL;
+    le_clk_Time_t delay = { 0, 0 };
+    uint32_t delayMs;
+    size_t i;
+
+    le_timer_Stop(StepTimer);
+
+    for (i = 0; i < LIGHT_MAX_OUTPUTS; i++)
+    {
+        if ( IsStepping(&Outputs[i]) &&
+             ( (nextPtr == NULL) ||
+               le_clk_GreaterThan(nextPtr->nextStepTime, Outputs[i].nextStepTime) ) )
+        {
+            nextPtr = &Outputs[i];
+        }
+    }
+
+    if (nextPtr == NULL)
+    {
+        return;
+    }
+
+    if (le_clk_GreaterThan(nextPtr->nextStepTime, now))
+    {
+        delay = le_clk_Sub(nextPtr->nextStepTime, now);
+    }
+    delayMs = delay.sec * 1000 + (delay.usec + 999) / 1000;
+
+    le_timer_SetMsInterval(StepTimer, (delayMs > 0) ? delayMs : 1);
+    le_timer_Start(StepTimer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Moves the patterns of the towers whose step is due to their next step
+ */
+//--------------------------------------------------------------------------------------------------
+static void StepTimerHandler
+(
+    le_timer_Ref_t timerRef     ///< [IN] Step timer
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    le_clk_Time_t dueTime = le_clk_Add(now, MsToTime(STEP_SLACK_MS));
+    size_t i;
+
+    for (i = 0; i < LIGHT_MAX_OUTPUTS; i++)
+    {
+        Output_t * outputPtr = &Outputs[i];
+        const LightPattern_t * patternPtr = &outputPtr->pattern;
+        le_clk_Time_t duration;
+
+        if (!IsStepping(outputPtr) || le_clk_GreaterThan(outputPtr->nextStepTime, dueTime))
+        {
+            continue;
+        }
+
+        outputPtr->stepIndex = (outputPtr->stepIndex + 1) % patternPtr->stepCount;
+
+        DriveLights(outputPtr, patternPtr->steps[outputPtr->stepIndex].lights);
+
+        // From the time the step was due, so that the towers stay in step with each other. After
+        // a long delay, e.g. a suspend, the pattern goes on from now instead of catching up.
+        duration = MsToTime(patternPtr->steps[outputPtr->stepIndex].durationMs);
+        outputPtr->nextStepTime = le_clk_Add(outputPtr->nextStepTime, duration);
+        if (!le_clk_GreaterThan(outputPtr->nextStepTime, now))
+        {
+            outputPtr->nextStepTime = le_clk_Add(now, duration);
+        }
+    }
+
+    ScheduleStepTimer();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parses lights such as "red", "all" or "red+yellow"
+ *
+ * @return
+ *      - LE_OK if the lights are valid
+ *      - LE_FORMAT_ERROR otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ParseLights
+(
+    const char * lightsPtr,     ///< [IN] Lights, not modified
+    uint8_t * maskPtr           ///< [OUT] Bit mask of the lights
+)
+{
+    char buffer[MAX_LIGHT_PATTERN_BYTES];
+    char * savePtr = NULL;
+    char * namePtr;
+
+    if (le_utf8_Copy(buffer, lightsPtr, sizeof(buffer), NULL) != LE_OK)
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    *maskPtr = LIGHT_OFF;
+
+    for (namePtr = strtok_r(buffer, "+", &savePtr);
+         namePtr != NULL;
+         namePtr = strtok_r(NULL, "+", &savePtr))
+    {
+        if (strcmp(namePtr, "red") == 0)
+        {
+            *maskPtr |= LIGHT_RED;
+        }
+        else if (strcmp(namePtr, "yellow") == 0)
+        {
+            *maskPtr |= LIGHT_YELLOW;
+        }
+        else if (strcmp(namePtr, "green") == 0)
+        {
+            *maskPtr |= LIGHT_GREEN;
+        }
+        else if (strcmp(namePtr, "all") == 0)
+        {
+            *maskPtr |= LIGHT_ON;
+        }
+        else
+        {
+            return LE_FORMAT_ERROR;
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the timer of the patterns and activates the pins of the additional towers that are
+ * bound. The pins of the main tower must be activated beforehand.
+ */
+//--------------------------------------------------------------------------------------------------
+void light_Init
+(
+    void
+)
+{
+    size_t i;
+
+    Outputs[0].writePinsFunc = WriteMainPins;
+    Outputs[0].isAvailable = true;
+
+    Outputs[1].writePinsFunc = WriteSecondPins;
+    Outputs[1].isAvailable = ActivateSecondPins();
+
+    Outputs[2].writePinsFunc = WriteThirdPins;
+    Outputs[2].isAvailable = ActivateThirdPins();
+
+    StepTimer = le_timer_Create("LightStepTimer");
+    le_timer_SetRepeat(StepTimer, 1);
+    le_timer_SetHandler(StepTimer, StepTimerHandler);
+
+    for (i = 0; i < LIGHT_MAX_OUTPUTS; i++)
+    {
+        LE_INFO("Tower %zu: %s", i, Outputs[i].isAvailable ? "available" : "not bound");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stops the patterns being shown and releases the pins of the additional towers. The pins of the
+ * main tower keep their level.
+ */
+//--------------------------------------------------------------------------------------------------
+void light_Deinit
+(
+    void
+)
+{
+    size_t i;
+
+    le_timer_Stop(StepTimer);
+
+    for (i = 0; i < LIGHT_MAX_OUTPUTS; i++)
+    {
+        Outputs[i].pattern.stepCount = 0;
+    }
+
+    if (Outputs[1].isAvailable)
+    {
+        le_gpioGreen2_Deactivate();
+        le_gpioYellow2_Deactivate();
+        le_gpioRed2_Deactivate();
+    }
+
+    if (Outputs[2].isAvailable)
+    {
+        le_gpioGreen3_Deactivate();
+        le_gpioYellow3_Deactivate();
+        le_gpioRed3_Deactivate();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether a tower can be driven
+ *
+ * @return
+ *      true for the main tower, and for the additional towers whose pins are bound
+ */
+//--------------------------------------------------------------------------------------------------
+bool light_IsAvailable
+(
+    size_t output                   ///< [IN] Tower, from 0 to LIGHT_MAX_OUTPUTS - 1
+)
+{
+    return (output < LIGHT_MAX_OUTPUTS) && Outputs[output].isAvailable;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fills a steady pattern
+ */
+//--------------------------------------------------------------------------------------------------
+void light_SetSteady
+(
+    LightPattern_t * patternPtr,    ///< [OUT] Pattern
+    LightState_t lights             ///< [IN] Lights that are on
+)
+{
+    memset(patternPtr, 0, sizeof(*patternPtr));
+    patternPtr->steps[0].lights = lights;
+    patternPtr->stepCount = 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parses a pattern from the config tree, see light.h for the syntax
+ *
+ * @return
+ *      - LE_OK if the pattern is valid
+ *      - LE_FORMAT_ERROR otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t light_ParsePattern
+(
+    const char * descriptionPtr,    ///< [IN] Description of the pattern
+    LightPattern_t * patternPtr     ///< [OUT] Pattern
+)
+{
+    char buffer[MAX_LIGHT_PATTERN_BYTES];
+    char * savePtr = NULL;
+    const char * kindPtr;
+    const char * lightsPtr;
+    uint8_t lights = LIGHT_OFF;
+
+    memset(patternPtr, 0, sizeof(*patternPtr));
+
+    if (le_utf8_Copy(buffer, descriptionPtr, sizeof(buffer), NULL) != LE_OK)
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    kindPtr = strtok_r(buffer, " ", &savePtr);
+    if (kindPtr == NULL)
+    {
+        return LE_OK;
+    }
+
+    if (strcmp(kindPtr, "off") == 0)
+    {
+        light_SetSteady(patternPtr, LIGHT_OFF);
+        return LE_OK;
+    }
+
+    if (strcmp(kindPtr, "alternate") == 0)
+    {
+        while ( (lightsPtr = strtok_r(NULL, " ", &savePtr)) != NULL )
+        {
+            if ( (patternPtr->stepCount == LIGHT_MAX_STEPS) ||
+                 (ParseLights(lightsPtr, &lights) != LE_OK) )
+            {
+                return LE_FORMAT_ERROR;
+            }
+
+            patternPtr->steps[patternPtr->stepCount].lights = lights;
+            patternPtr->steps[patternPtr->stepCount].durationMs = ALTERNATE_STEP_MS;
+            patternPtr->stepCount++;
+        }
+
+        return (patternPtr->stepCount >= 2) ? LE_OK : LE_FORMAT_ERROR;
+    }
+
+    lightsPtr = strtok_r(NULL, " ", &savePtr);
+    if ( (lightsPtr == NULL) ||
+         (ParseLights(lightsPtr, &lights) != LE_OK) ||
+         (strtok_r(NULL, " ", &savePtr) != NULL) )
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    if (strcmp(kindPtr, "steady") == 0)
+    {
+        light_SetSteady(patternPtr, lights);
+    }
+    else if (strcmp(kindPtr, "blink") == 0)
+    {
+        patternPtr->steps[0] = (LightStep_t) { lights, BLINK_STEP_MS };
+        patternPtr->steps[1] = (LightStep_t) { LIGHT_OFF, BLINK_STEP_MS };
+        patternPtr->stepCount = 2;
+    }
+    else if (strcmp(kindPtr, "pulse") == 0)
+    {
+        patternPtr->steps[0] = (LightStep_t) { lights, PULSE_ON_MS };
+        patternPtr->steps[1] = (LightStep_t) { LIGHT_OFF, PULSE_OFF_MS };
+        patternPtr->stepCount = 2;
+    }
+    else
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shows a pattern on a tower. Showing the pattern already shown does nothing, so that it is not
+ * restarted on every poll. Towers that are not available are ignored.
+ */
+//--------------------------------------------------------------------------------------------------
+void light_Show
+(
+    size_t output,                      ///< [IN] Tower, from 0 to LIGHT_MAX_OUTPUTS - 1
+    const LightPattern_t * patternPtr   ///< [IN] Pattern, with at least one step
+)
+{
+    Output_t * outputPtr;
+
+    if (!light_IsAvailable(output))
+    {
+        return;
+    }
+    outputPtr = &Outputs[output];
+
+    if (IsSamePattern(patternPtr, &outputPtr->pattern))
+    {
+        return;
+    }
+
+    outputPtr->pattern = *patternPtr;
+    outputPtr->stepIndex = 0;
+
+    DriveLights(outputPtr, patternPtr->steps[0].lights);
+
+    // A steady pattern does not need the timer, nor any further write to the pins
+    if (patternPtr->stepCount > 1)
+    {
+        outputPtr->nextStepTime = le_clk_Add(le_clk_GetRelativeTime(),
+                                             MsToTime(patternPtr->steps[0].durationMs));
+    }
+
+    ScheduleStepTimer();
+}
@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file light.h
+ *
+ * Drives the lights of the towers: steady colors, or patterns (blink, pulse, alternate) stepped by
+ * a single timer set to the next step of any tower. Only the pins whose level changes are written
+ * to gpioService.
+ *
+ * The main tower is output 0. The additional towers are only driven if their pins are bound, see
+ * trafficLight.adef.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LIGHT_H_INCLUDE_GUARD
+#define LIGHT_H_INCLUDE_GUARD
+
+// Longest pattern description in the config tree, e.g. "alternate red green"
+#define MAX_LIGHT_PATTERN_BYTES 64
+
+// Most steps in a pattern
+#define LIGHT_MAX_STEPS 4
+
+// Number of towers: the main one and the additional ones
+#define LIGHT_MAX_OUTPUTS 3
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lights, combined as a bit mask of the lights that are on
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    LIGHT_OFF = 0,
+    LIGHT_RED = 0x1,
+    LIGHT_YELLOW = 0x2,
+    LIGHT_GREEN = 0x4,
+    LIGHT_ON = LIGHT_RED | LIGHT_YELLOW | LIGHT_GREEN,
+}
+LightState_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Step of a pattern: lights that are on, and for how long
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t lights;                 ///< Bit mask of LightState_t
+    uint32_t durationMs;            ///< Time before the next step
+}
+LightStep_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pattern repeated on the lights. A pattern with a single step is steady, one without steps is
+ * not set.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    LightStep_t steps[LIGHT_MAX_STEPS];     ///< Steps, repeated in order
+    size_t stepCount;                       ///< Number of steps
+}
+LightPattern_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the timer of the patterns and activates the pins of the additional towers that are
+ * bound. The pins of the main tower must be activated beforehand.
+ */
+//--------------------------------------------------------------------------------------------------
+void light_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stops the patterns being shown and releases the pins of the additional towers. The pins of the
+ * main tower keep their level.
+ */
+//--------------------------------------------------------------------------------------------------
+void light_Deinit
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether a tower can be driven
+ *
+ * @return
+ *      true for the main tower, and for the additional towers whose pins are bound
+ */
+//--------------------------------------------------------------------------------------------------
+bool light_IsAvailable
+(
+    size_t output                   ///< [IN] Tower, from 0 to LIGHT_MAX_OUTPUTS - 1
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fills a steady pattern
+ */
+//--------------------------------------------------------------------------------------------------
+void light_SetSteady
+(
+    LightPattern_t * patternPtr,    ///< [OUT] Pattern
+    LightState_t lights             ///< [IN] Lights that are on
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parses a pattern from the config tree:
+ *  - "" for no pattern
+ *  - "off"
+ *  - "steady <lights>", "blink <lights>", "pulse <lights>"
+ *  - "alternate <lights> <lights> ..." with up to LIGHT_MAX_STEPS steps
+ *
+ * where <lights> is "red", "yellow", "green" or "all", or several of them joined by '+' (e.g.
+ * "red+yellow").
+ *
+ * @return
+ *      - LE_OK if the pattern is valid
+ *      - LE_FORMAT_ERROR otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t light_ParsePattern
+(
+    const char * descriptionPtr,    ///< [IN] Description of the pattern
+    LightPattern_t * patternPtr     ///< [OUT] Pattern
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shows a pattern on a tower. Showing the pattern already shown does nothing, so that it is not
+ * restarted on every poll. Towers that are not available are ignored.
+ */
+//--------------------------------------------------------------------------------------------------
+void light_Show
+(
+    size_t output,                      ///< [IN] Tower, from 0 to LIGHT_MAX_OUTPUTS - 1
+    const LightPattern_t * patternPtr   ///< [IN] Pattern, with at least one step
+);
+
+#endif // LIGHT_H_INCLUDE_GUARD
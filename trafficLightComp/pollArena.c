@@ -0,0 +1,142 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file pollArena.c
+ *
+ * Memory of a poll, see pollArena.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "pollArena.h"
+
+// Alignment of the allocations, enough for any type used by the checks
+#define POLL_ARENA_ALIGNMENT sizeof(uint64_t)
+
+// Block reserved at startup and its size
+static uint8_t * ArenaPtr = NULL;
+static size_t ArenaSize = 0;
+
+// Bytes allocated since the last reset, and the most since startup
+static size_t UsedBytes = 0;
+static size_t HighWaterBytes = 0;
+
+// Allocations refused because the arena was full
+static uint32_t FailureCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reserves the memory of the polls. Only the first call reserves it, the size cannot change
+ * afterwards.
+ */
+//--------------------------------------------------------------------------------------------------
+void pollArena_Init
+(
+    size_t size                     ///< [IN] Bytes to reserve
+)
+{
+    le_mem_PoolRef_t poolRef;
+
+    if (ArenaPtr)
+    {
+        return;
+    }
+
+    // A pool of a single block, allocated once and never released
+    poolRef = le_mem_CreatePool("pollArena", size);
+    le_mem_ExpandPool(poolRef, 1);
+    ArenaPtr = le_mem_ForceAlloc(poolRef);
+    ArenaSize = size;
+
+    LE_INFO("Poll arena: %zu bytes", ArenaSize);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocates memory for the running poll, aligned for any type. It is valid until pollArena_Reset.
+ *
+ * @return
+ *      Allocated memory, NULL if the arena is full
+ */
+//--------------------------------------------------------------------------------------------------
+void * pollArena_Alloc
+(
+    size_t size                     ///< [IN] Bytes to allocate
+)
+{
+    size_t offset = (UsedBytes + POLL_ARENA_ALIGNMENT - 1) & ~(POLL_ARENA_ALIGNMENT - 1);
+
+    if ( (offset > ArenaSize) || (size > ArenaSize - offset) )
+    {
+        FailureCount++;
+        return NULL;
+    }
+
+    UsedBytes = offset + size;
+    if (UsedBytes > HighWaterBytes)
+    {
+        HighWaterBytes = UsedBytes;
+    }
+
+    return ArenaPtr + offset;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases everything allocated since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+void pollArena_Reset
+(
+    void
+)
+{
+    UsedBytes = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the size of the arena
+ *
+ * @return
+ *      Bytes reserved, 0 before pollArena_Init
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pollArena_GetSize
+(
+    void
+)
+{
+    return ArenaSize;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the most bytes a poll used
+ *
+ * @return
+ *      High-water mark of the arena since startup
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pollArena_GetHighWater
+(
+    void
+)
+{
+    return HighWaterBytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of allocations refused because the arena was full
+ *
+ * @return
+ *      Number of refused allocations since startup
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t pollArena_GetFailureCount
+(
+    void
+)
+{
+    return FailureCount;
+}
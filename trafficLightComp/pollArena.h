@@ -0,0 +1,87 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file pollArena.h
+ *
+ * Memory of a poll: the content checks and the request headers of its transfers are allocated
+ * from a block reserved once at startup, and all released at once when the next poll starts.
+ * Polling never allocates from the heap, and its memory cannot grow past /pollArenaBytes.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef POLL_ARENA_H_INCLUDE_GUARD
+#define POLL_ARENA_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reserves the memory of the polls. Only the first call reserves it, the size cannot change
+ * afterwards.
+ */
+//--------------------------------------------------------------------------------------------------
+void pollArena_Init
+(
+    size_t size                     ///< [IN] Bytes to reserve
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocates memory for the running poll, aligned for any type. It is valid until pollArena_Reset.
+ *
+ * @return
+ *      Allocated memory, NULL if the arena is full
+ */
+//--------------------------------------------------------------------------------------------------
+void * pollArena_Alloc
+(
+    size_t size                     ///< [IN] Bytes to allocate
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases everything allocated since the last reset
+ */
+//--------------------------------------------------------------------------------------------------
+void pollArena_Reset
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the size of the arena
+ *
+ * @return
+ *      Bytes reserved, 0 before pollArena_Init
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pollArena_GetSize
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the most bytes a poll used
+ *
+ * @return
+ *      High-water mark of the arena since startup
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pollArena_GetHighWater
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of allocations refused because the arena was full
+ *
+ * @return
+ *      Number of refused allocations since startup
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t pollArena_GetFailureCount
+(
+    void
+);
+
+#endif // POLL_ARENA_H_INCLUDE_GUARD
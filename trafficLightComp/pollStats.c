@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file pollStats.c
+ *
+ * Rolling statistics of the phases of the polls, see pollStats.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "pollStats.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Last samples of a measure
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t samples[POLL_STATS_WINDOW_SIZE];   ///< Ring of the last samples
+    size_t count;                               ///< Number of samples ever recorded
+}
+Window_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Names of the measures in the config tree, in the order of pollStats_Measure_t
+ */
+//--------------------------------------------------------------------------------------------------
+static const char * MeasureNames[POLL_STATS_MEASURE_COUNT] =
+{
+    "dns",
+    "connect",
+    "tls",
+    "firstByte",
+    "transfer",
+    "total",
+    "parse",
+    "bytes",
+    "contentBytes",
+};
+
+// Samples of each measure
+static Window_t Windows[POLL_STATS_MEASURE_COUNT];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a sample of a measure, replacing the oldest one once the window is full
+ */
+//--------------------------------------------------------------------------------------------------
+void pollStats_Record
+(
+    pollStats_Measure_t measure,    ///< [IN] Measure the sample is of
+    uint32_t value                  ///< [IN] Sample
+)
+{
+    Window_t * windowPtr = &Windows[measure];
+
+    windowPtr->samples[windowPtr->count % POLL_STATS_WINDOW_SIZE] = value;
+    windowPtr->count++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the min, avg and max of each measure as <measure>/min, <measure>/avg and <measure>/max,
+ * relative to the node the iterator is on.
+ */
+//--------------------------------------------------------------------------------------------------
+void pollStats_Write
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Write iterator, e.g. on /stats
+)
+{
+    char path[LE_CFG_NAME_LEN_BYTES];
+    int measure;
+
+    for (measure = 0; measure < POLL_STATS_MEASURE_COUNT; measure++)
+    {
+        const Window_t * windowPtr = &Windows[measure];
+        size_t count = (windowPtr->count < POLL_STATS_WINDOW_SIZE) ?
+                       windowPtr->count : POLL_STATS_WINDOW_SIZE;
+        uint32_t min = UINT32_MAX;
+        uint32_t max = 0;
+        uint64_t sum = 0;
+        size_t i;
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            uint32_t value = windowPtr->samples[i];
+
+            min = (value < min) ? value : min;
+            max = (value > max) ? value : max;
+            sum += value;
+        }
+
+        snprintf(path, sizeof(path), "%s/min", MeasureNames[measure]);
+        le_cfg_SetInt(iteratorRef, path, min);
+        snprintf(path, sizeof(path), "%s/avg", MeasureNames[measure]);
+        le_cfg_SetInt(iteratorRef, path, sum / count);
+        snprintf(path, sizeof(path), "%s/max", MeasureNames[measure]);
+        le_cfg_SetInt(iteratorRef, path, max);
+    }
+}
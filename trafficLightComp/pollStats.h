@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file pollStats.h
+ *
+ * Rolling statistics of the phases of the polls (DNS, connect, TLS, first byte, transfer, parse)
+ * and of the size of the responses, published under /stats in the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef POLL_STATS_H_INCLUDE_GUARD
+#define POLL_STATS_H_INCLUDE_GUARD
+
+#include "le_cfg_interface.h"
+
+// Number of samples the statistics are computed over
+#define POLL_STATS_WINDOW_SIZE 64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Measures of a transfer. Durations are in microseconds, the size is in bytes.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    POLL_STATS_DNS,             ///< Name resolution
+    POLL_STATS_CONNECT,         ///< TCP connection, after the name resolution
+    POLL_STATS_TLS,             ///< TLS handshake, after the TCP connection
+    POLL_STATS_FIRST_BYTE,      ///< From the request being ready to the first byte of the response
+    POLL_STATS_TRANSFER,        ///< From the first byte to the end of the response
+    POLL_STATS_TOTAL,           ///< Whole transfer
+    POLL_STATS_PARSE,           ///< Time spent checking the content
+    POLL_STATS_BYTES,           ///< Bytes downloaded, compressed if the server compressed them
+    POLL_STATS_CONTENT_BYTES,   ///< Bytes of content checked, once decompressed
+    POLL_STATS_MEASURE_COUNT
+}
+pollStats_Measure_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a sample of a measure, replacing the oldest one once the window is full
+ */
+//--------------------------------------------------------------------------------------------------
+void pollStats_Record
+(
+    pollStats_Measure_t measure,    ///< [IN] Measure the sample is of
+    uint32_t value                  ///< [IN] Sample
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the min, avg and max of each measure as <measure>/min, <measure>/avg and <measure>/max,
+ * relative to the node the iterator is on.
+ */
+//--------------------------------------------------------------------------------------------------
+void pollStats_Write
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Write iterator, e.g. on /stats
+);
+
+#endif // POLL_STATS_H_INCLUDE_GUARD
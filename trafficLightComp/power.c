@@ -0,0 +1,181 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file power.c
+ *
+ * Wakeup source of the app, see power.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "power.h"
+
+// Tag of the wakeup source
+#define POWER_WAKEUP_TAG "trafficLightWakeUpTag"
+
+// Wakeup source, whether it is held, and whether it is released between polls
+static le_pm_WakeupSourceRef_t WakeupRef = NULL;
+static bool IsAwake = false;
+static bool IsLowPower = false;
+
+// Time the app started at, the wakeup source was last held at, and for how long it was before
+static le_clk_Time_t StartTime;
+static le_clk_Time_t AwakeSince;
+static uint64_t AwakeMs = 0;
+
+// Number of times the wakeup source was held
+static uint32_t WakeupCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Converts a duration to milliseconds
+ *
+ * @return
+ *      Duration in milliseconds
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ToMs
+(
+    le_clk_Time_t time              ///< [IN] Duration
+)
+{
+    return (uint64_t) time.sec * 1000 + time.usec / 1000;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Holds the wakeup source
+ */
+//--------------------------------------------------------------------------------------------------
+static void Hold
+(
+    void
+)
+{
+    if (IsAwake)
+    {
+        return;
+    }
+
+    le_pm_StayAwake(WakeupRef);
+    IsAwake = true;
+    AwakeSince = le_clk_GetRelativeTime();
+    WakeupCount++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases the wakeup source
+ */
+//--------------------------------------------------------------------------------------------------
+static void Release
+(
+    void
+)
+{
+    if (!IsAwake)
+    {
+        return;
+    }
+
+    le_pm_Relax(WakeupRef);
+    IsAwake = false;
+    AwakeMs += ToMs(le_clk_Sub(le_clk_GetRelativeTime(), AwakeSince));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the wakeup source, held until the mode is set
+ */
+//--------------------------------------------------------------------------------------------------
+void power_Init
+(
+    void
+)
+{
+    StartTime = le_clk_GetRelativeTime();
+
+    WakeupRef = le_pm_NewWakeupSource(LE_PM_REF_COUNT, POWER_WAKEUP_TAG);
+    Hold();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets whether the wakeup source is released between polls
+ */
+//--------------------------------------------------------------------------------------------------
+void power_SetLowPower
+(
+    bool isLowPower                 ///< [IN] true to release it between polls
+)
+{
+    if (isLowPower != IsLowPower)
+    {
+        LE_INFO("Low-power mode %s", isLowPower ? "on" : "off");
+    }
+
+    IsLowPower = isLowPower;
+
+    // Outside of a poll, the wakeup source is held only when low-power mode is off. The caller
+    // holds it again for the poll it may be running.
+    if (IsLowPower)
+    {
+        Release();
+    }
+    else
+    {
+        Hold();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps the device awake for a poll. Does nothing if it already is.
+ */
+//--------------------------------------------------------------------------------------------------
+void power_StayAwake
+(
+    void
+)
+{
+    Hold();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lets the device suspend once a poll is done, in low-power mode. Does nothing otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+void power_Relax
+(
+    void
+)
+{
+    if (IsLowPower)
+    {
+        Release();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the time the device was kept awake as power/awakeSec, the number of times it was as
+ * power/wakeups and the share of the time it was as power/awakePermille, relative to the node the
+ * iterator is on.
+ */
+//--------------------------------------------------------------------------------------------------
+void power_Write
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Write iterator, e.g. on /stats
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    uint64_t awakeMs = AwakeMs + (IsAwake ? ToMs(le_clk_Sub(now, AwakeSince)) : 0);
+    uint64_t elapsedMs = ToMs(le_clk_Sub(now, StartTime));
+
+    le_cfg_SetInt(iteratorRef, "power/awakeSec", awakeMs / 1000);
+    le_cfg_SetInt(iteratorRef, "power/wakeups", WakeupCount);
+    le_cfg_SetInt(iteratorRef,
+                  "power/awakePermille",
+                  (elapsedMs > 0) ? (awakeMs * 1000) / elapsedMs : 1000);
+}
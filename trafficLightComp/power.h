@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file power.h
+ *
+ * Wakeup source of the app. In low-power mode it is only held while a poll runs, from the start of
+ * its transfers to the update of the light, so that the device can suspend between polls. The
+ * polling timer wakes the device up for the next one. Otherwise it is held all the time.
+ *
+ * The time the app kept the device awake is counted as a proxy of the energy it costs.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef POWER_H_INCLUDE_GUARD
+#define POWER_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the wakeup source, held until the mode is set
+ */
+//--------------------------------------------------------------------------------------------------
+void power_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets whether the wakeup source is released between polls
+ */
+//--------------------------------------------------------------------------------------------------
+void power_SetLowPower
+(
+    bool isLowPower                 ///< [IN] true to release it between polls
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps the device awake for a poll. Does nothing if it already is.
+ */
+//--------------------------------------------------------------------------------------------------
+void power_StayAwake
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lets the device suspend once a poll is done, in low-power mode. Does nothing otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+void power_Relax
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the time the device was kept awake as power/awakeSec, the number of times it was as
+ * power/wakeups and the share of the time it was as power/awakePermille, relative to the node the
+ * iterator is on.
+ */
+//--------------------------------------------------------------------------------------------------
+void power_Write
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Write iterator, e.g. on /stats
+);
+
+#endif // POWER_H_INCLUDE_GUARD
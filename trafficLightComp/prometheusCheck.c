@@ -0,0 +1,426 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file prometheusCheck.c
+ *
+ * Check of a metric in the Prometheus text exposition format, fed chunk by chunk.
+ *
+ * info/content/path selects the samples, e.g. `up` or `http_errors{job="api",code="500"}`: the
+ * name must be equal and the listed labels must have the given values. The worst state of the
+ * selected samples against info/content/warningThreshold and info/content/criticalThreshold is
+ * the state of the content.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "contentCheck.h"
+#include <ctype.h>
+#include <math.h>
+
+// Longest line of the exposition that can be checked, longer ones are skipped
+#define PROMETHEUS_MAX_LINE_BYTES 512
+
+// Most labels in a selector
+#define PROMETHEUS_MAX_SELECTOR_LABELS 4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Label of a selector, pointing in PrometheusCheck_t.selector
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char * namePtr;       ///< Name of the label
+    const char * valuePtr;      ///< Value of the label, unescaped
+}
+PrometheusLabel_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the check of a Prometheus metric
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const ContentCheckParams_t * paramsPtr;     ///< Settings of the check
+    char selector[MAX_CONTENT_PATH_BYTES];      ///< Copy of the selector, cut into its parts
+    const char * metricPtr;                     ///< Name of the metric
+    PrometheusLabel_t labels[PROMETHEUS_MAX_SELECTOR_LABELS];   ///< Labels of the selector
+    size_t labelCount;                          ///< Number of labels of the selector
+    bool isSelectorValid;                       ///< Whether the selector could be parsed
+    char line[PROMETHEUS_MAX_LINE_BYTES];       ///< Line being received
+    size_t lineLength;                          ///< Length of the line, may exceed the buffer
+    size_t sampleCount;                         ///< Number of samples selected
+    MonitorState_t state;                       ///< Worst state of the samples selected
+}
+PrometheusCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether a character can be part of a metric or label name
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsNameChar
+(
+    char c                          ///< [IN] Character
+)
+{
+    return isalnum((unsigned char) c) || (c == '_') || (c == ':');
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads a label value between double quotes and unescapes it in place.
+ *
+ * @return
+ *      Character after the closing quote, NULL if the value is not terminated
+ */
+//--------------------------------------------------------------------------------------------------
+static char * ReadLabelValue
+(
+    char * quotePtr                 ///< [IN] Opening quote, the value is unescaped after it
+)
+{
+    char * readPtr = quotePtr + 1;
+    char * writePtr = quotePtr + 1;
+
+    while (*readPtr != '"')
+    {
+        if (*readPtr == '\0')
+        {
+            return NULL;
+        }
+
+        if ( (*readPtr == '\\') && (readPtr[1] != '\0') )
+        {
+            readPtr++;
+            *writePtr++ = (*readPtr == 'n') ? '\n' : *readPtr;
+        }
+        else
+        {
+            *writePtr++ = *readPtr;
+        }
+        readPtr++;
+    }
+
+    *writePtr = '\0';
+    return readPtr + 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Cuts the selector, e.g. `http_errors{job="api",code="500"}`, into its name and labels
+ *
+ * @return
+ *      true if the selector is valid
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ParseSelector
+(
+    PrometheusCheck_t * checkPtr    ///< [IN] Check whose selector is parsed
+)
+{
+    char * charPtr = checkPtr->selector;
+
+    checkPtr->metricPtr = charPtr;
+    while (IsNameChar(*charPtr))
+    {
+        charPtr++;
+    }
+
+    if (charPtr == checkPtr->metricPtr)
+    {
+        return false;
+    }
+
+    if (*charPtr == '\0')
+    {
+        return true;
+    }
+
+    if (*charPtr != '{')
+    {
+        return false;
+    }
+    *charPtr++ = '\0';
+
+    while (*charPtr != '}')
+    {
+        PrometheusLabel_t * labelPtr = &checkPtr->labels[checkPtr->labelCount];
+
+        if (checkPtr->labelCount == PROMETHEUS_MAX_SELECTOR_LABELS)
+        {
+            return false;
+        }
+
+        labelPtr->namePtr = charPtr;
+        while (IsNameChar(*charPtr))
+        {
+            charPtr++;
+        }
+        if ( (charPtr == labelPtr->namePtr) || (charPtr[0] != '=') || (charPtr[1] != '"') )
+        {
+            return false;
+        }
+        *charPtr = '\0';
+
+        labelPtr->valuePtr = charPtr + 2;
+        charPtr = ReadLabelValue(charPtr + 1);
+        if (charPtr == NULL)
+        {
+            return false;
+        }
+        checkPtr->labelCount++;
+
+        if (*charPtr == ',')
+        {
+            charPtr++;
+        }
+        else if (*charPtr != '}')
+        {
+            return false;
+        }
+    }
+
+    return (charPtr[1] == '\0');
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks a complete line of the exposition. Comments and samples of other metrics are skipped.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckLine
+(
+    PrometheusCheck_t * checkPtr    ///< [IN] Check whose line is complete
+)
+{
+    char * charPtr = checkPtr->line;
+    char * namePtr;
+    char * endPtr;
+    size_t matchedLabels = 0;
+    double value;
+    MonitorState_t state;
+
+    if (checkPtr->lineLength >= PROMETHEUS_MAX_LINE_BYTES)
+    {
+        return;
+    }
+    checkPtr->line[checkPtr->lineLength] = '\0';
+
+    while (isspace((unsigned char) *charPtr))
+    {
+        charPtr++;
+    }
+
+    namePtr = charPtr;
+    while (IsNameChar(*charPtr))
+    {
+        charPtr++;
+    }
+
+    // Comments and empty lines have no name
+    if ( (charPtr == namePtr) ||
+         ((size_t) (charPtr - namePtr) != strlen(checkPtr->metricPtr)) ||
+         strncmp(namePtr, checkPtr->metricPtr, charPtr - namePtr) )
+    {
+        return;
+    }
+
+    if (*charPtr == '{')
+    {
+        charPtr++;
+        while (*charPtr != '}')
+        {
+            char * labelPtr;
+            char * valuePtr;
+            size_t i;
+
+            while (isspace((unsigned char) *charPtr) || (*charPtr == ','))
+            {
+                charPtr++;
+            }
+            if (*charPtr == '}')
+            {
+                break;
+            }
+
+            labelPtr = charPtr;
+            while (IsNameChar(*charPtr))
+            {
+                charPtr++;
+            }
+            if ( (charPtr == labelPtr) || (charPtr[0] != '=') || (charPtr[1] != '"') )
+            {
+                return;
+            }
+            *charPtr = '\0';
+
+            valuePtr = charPtr + 2;
+            charPtr = ReadLabelValue(charPtr + 1);
+            if (charPtr == NULL)
+            {
+                return;
+            }
+
+            for (i = 0; i < checkPtr->labelCount; i++)
+            {
+                if ( (strcmp(labelPtr, checkPtr->labels[i].namePtr) == 0) &&
+                     (strcmp(valuePtr, checkPtr->labels[i].valuePtr) == 0) )
+                {
+                    matchedLabels++;
+                }
+            }
+        }
+        charPtr++;
+    }
+
+    if (matchedLabels != checkPtr->labelCount)
+    {
+        return;
+    }
+
+    value = strtod(charPtr, &endPtr);
+    if (endPtr == charPtr)
+    {
+        LE_WARN("Cannot read the value of '%s'", checkPtr->metricPtr);
+        return;
+    }
+
+    state = contentCheck_CompareThresholds(checkPtr->paramsPtr, value);
+    LE_DEBUG("%s = %g: state %d", checkPtr->metricPtr, value, state);
+
+    checkPtr->sampleCount++;
+    checkPtr->state = (state < checkPtr->state) ? state : checkPtr->state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the check of the content of a response
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitCheck
+(
+    void * statePtr,                        ///< [OUT] Check to initialize
+    const ContentCheckParams_t * paramsPtr  ///< [IN] Settings of the check, kept until the end
+)
+{
+    PrometheusCheck_t * checkPtr = statePtr;
+
+    checkPtr->paramsPtr = paramsPtr;
+    checkPtr->labelCount = 0;
+    checkPtr->lineLength = 0;
+    checkPtr->sampleCount = 0;
+    checkPtr->state = STATE_PASS;
+
+    snprintf(checkPtr->selector, sizeof(checkPtr->selector), "%s", paramsPtr->path);
+    checkPtr->isSelectorValid = ParseSelector(checkPtr);
+    if (!checkPtr->isSelectorValid)
+    {
+        LE_ERROR("Invalid metric selector '%s'", paramsPtr->path);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the exposition. Lines are checked as soon as they are complete.
+ *
+ * @return
+ *      true once the verdict is known: a selected sample is critical
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FeedContent
+(
+    void * statePtr,                ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    PrometheusCheck_t * checkPtr = statePtr;
+    size_t index;
+
+    if (!checkPtr->isSelectorValid)
+    {
+        return true;
+    }
+
+    for (index = 0; index < length; index++)
+    {
+        char c = dataPtr[index];
+
+        if (c != '\n')
+        {
+            if (checkPtr->lineLength < PROMETHEUS_MAX_LINE_BYTES)
+            {
+                checkPtr->line[checkPtr->lineLength] = c;
+            }
+            checkPtr->lineLength++;
+            continue;
+        }
+
+        CheckLine(checkPtr);
+        checkPtr->lineLength = 0;
+
+        if (checkPtr->state == STATE_FAIL)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the check once the content is entirely received or once the verdict is known
+ *
+ * @return
+ *      Worst state of the selected samples, STATE_FAIL if there are none
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t FinishCheck
+(
+    void * statePtr                 ///< [IN] Check fed with the content received
+)
+{
+    PrometheusCheck_t * checkPtr = statePtr;
+
+    if (!checkPtr->isSelectorValid)
+    {
+        return STATE_FAIL;
+    }
+
+    // The content may not end with a new line
+    if ( (checkPtr->lineLength > 0) && (checkPtr->state != STATE_FAIL) )
+    {
+        CheckLine(checkPtr);
+        checkPtr->lineLength = 0;
+    }
+
+    if (checkPtr->sampleCount == 0)
+    {
+        LE_ERROR("Cannot find metric '%s'", checkPtr->paramsPtr->path);
+        return STATE_FAIL;
+    }
+
+    LE_INFO("Metric '%s': %zu sample(s), state %d",
+            checkPtr->paramsPtr->path,
+            checkPtr->sampleCount,
+            checkPtr->state);
+
+    return checkPtr->state;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checker of Prometheus metrics, as info/content/checkMode "prometheus"
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentChecker_t PrometheusChecker =
+{
+    .namePtr = "prometheus",
+    .stateSize = sizeof(PrometheusCheck_t),
+    .init = InitCheck,
+    .feed = FeedContent,
+    .finish = FinishCheck,
+};
+CONTENT_CHECK_REGISTER(PrometheusChecker)
@@ -0,0 +1,522 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file sensuGoCheck.c
+ *
+ * Check of the events of a Sensu Go backend, from the JSON list answered by
+ * /api/core/v2/namespaces/<namespace>/events, fed chunk by chunk. The list may span several
+ * pages, they are fed to the same check one after the other.
+ *
+ * The status of the check of each event gives its state: 0 is passing, 1 is a warning, 2 is
+ * critical and any other status is a warning too. Silenced events and events without a check,
+ * e.g. metrics, are ignored. The state of the backend is the worst of its events, passing if there
+ * are none so that the server can be asked for the failing events only.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "contentCheck.h"
+#include <ctype.h>
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Statuses of the checks, any other one is reported as a warning
+#define STATUS_PASSING 0
+#define STATUS_WARNING 1
+#define STATUS_CRITICAL 2
+
+// Header of a page giving the token of the next one, and the query parameter it is sent back with
+#define SENSU_GO_CONTINUE_HEADER "Sensu-Continue:"
+#define SENSU_GO_CONTINUE_PARAM "continue"
+
+// Longest key, literal or name that is compared, with its NULL char
+#define SENSU_GO_MAX_STRING_BYTES MAX_MONITOR_NAME_BYTES
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tokens of the JSON content, as tracked by FeedContent
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SENSU_GO_TOKEN_NONE,                ///< Between tokens
+    SENSU_GO_TOKEN_STRING,              ///< In a string
+    SENSU_GO_TOKEN_ESCAPE,              ///< After a backslash in a string
+    SENSU_GO_TOKEN_AFTER_STRING,        ///< After a string, which is a key if a colon follows
+    SENSU_GO_TOKEN_LITERAL,             ///< In a number, true, false or null
+}
+SensuGoToken_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Member of an event the content is in
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SENSU_GO_SECTION_NONE,
+    SENSU_GO_SECTION_CHECK,             ///< check
+    SENSU_GO_SECTION_ENTITY,            ///< entity
+}
+SensuGoSection_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event being read
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char check[SENSU_GO_MAX_STRING_BYTES];      ///< check.metadata.name
+    char entity[SENSU_GO_MAX_STRING_BYTES];     ///< entity.metadata.name
+    long status;                                ///< check.status, -1 for an event without check
+    bool isSilenced;                            ///< check.is_silenced
+}
+SensuGoEvent_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the check of the events of a Sensu Go backend
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    SensuGoToken_t token;                       ///< Token the content is in
+    size_t depth;                               ///< Number of containers the content is in
+    bool isList;                                ///< Whether the content is a list of events
+    SensuGoSection_t section;                   ///< Member of the event the content is in
+    bool isInMetadata;                          ///< Whether it is in the metadata of the member
+    char string[SENSU_GO_MAX_STRING_BYTES];     ///< String or literal being read
+    size_t stringLength;                        ///< Length of the string, may exceed the buffer
+    char key[SENSU_GO_MAX_STRING_BYTES];        ///< Key the next value belongs to
+    SensuGoEvent_t event;                       ///< Event being read
+    size_t passingCount;                        ///< Number of events of each kind
+    size_t warningCount;
+    size_t criticalCount;
+    size_t silencedCount;
+}
+SensuGoCheck_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copies the string or literal that was just read, truncated if needed
+ */
+//--------------------------------------------------------------------------------------------------
+static void CopyString
+(
+    const SensuGoCheck_t * checkPtr,        ///< [IN] Check that just read a string
+    char * bufferPtr                        ///< [OUT] Buffer of SENSU_GO_MAX_STRING_BYTES
+)
+{
+    size_t length = MIN(checkPtr->stringLength, SENSU_GO_MAX_STRING_BYTES - 1);
+
+    memcpy(bufferPtr, checkPtr->string, length);
+    bufferPtr[length] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps the value that was just read if it is a field of the event being read
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleValue
+(
+    SensuGoCheck_t * checkPtr               ///< [IN] Check that just read a value
+)
+{
+    SensuGoEvent_t * eventPtr = &checkPtr->event;
+    char value[SENSU_GO_MAX_STRING_BYTES];
+
+    if ( !checkPtr->isList || (checkPtr->section == SENSU_GO_SECTION_NONE) )
+    {
+        return;
+    }
+
+    CopyString(checkPtr, value);
+
+    if ( (checkPtr->depth == 3) && (checkPtr->section == SENSU_GO_SECTION_CHECK) )
+    {
+        if (strcmp(checkPtr->key, "status") == 0)
+        {
+            char * endPtr;
+            long status = strtol(value, &endPtr, 10);
+
+            eventPtr->status = ( (endPtr != value) && (status >= 0) ) ? status : -1;
+        }
+        else if (strcmp(checkPtr->key, "is_silenced") == 0)
+        {
+            eventPtr->isSilenced = (strcmp(value, "true") == 0);
+        }
+    }
+    else if ( (checkPtr->depth == 4) &&
+              checkPtr->isInMetadata &&
+              (strcmp(checkPtr->key, "name") == 0) )
+    {
+        memcpy( (checkPtr->section == SENSU_GO_SECTION_CHECK) ? eventPtr->check : eventPtr->entity,
+                value,
+                sizeof(value) );
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counts the state of an event once it is entirely read
+ *
+ * @return
+ *      true if the event is critical
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CountEvent
+(
+    SensuGoCheck_t * checkPtr               ///< [IN] Check that just read an event
+)
+{
+    const SensuGoEvent_t * eventPtr = &checkPtr->event;
+
+    // e.g. an event only carrying metrics
+    if (eventPtr->status < 0)
+    {
+        return false;
+    }
+
+    if (eventPtr->isSilenced)
+    {
+        checkPtr->silencedCount++;
+        return false;
+    }
+
+    LE_DEBUG("Event '%s/%s': %ld", eventPtr->entity, eventPtr->check, eventPtr->status);
+
+    switch (eventPtr->status)
+    {
+        case STATUS_PASSING:
+            checkPtr->passingCount++;
+            return false;
+
+        case STATUS_CRITICAL:
+            checkPtr->criticalCount++;
+            return true;
+
+        case STATUS_WARNING:
+        default:
+            checkPtr->warningCount++;
+            return false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles a character between tokens: punctuation, or the start of a string or a literal
+ *
+ * @return
+ *      true if an event just read is critical
+ */
+//--------------------------------------------------------------------------------------------------
+static bool HandlePunctuation
+(
+    SensuGoCheck_t * checkPtr,              ///< [IN] Check in progress
+    char c                                  ///< [IN] Character of the content
+)
+{
+    switch (c)
+    {
+        case '{':
+        case '[':
+            if ( (checkPtr->depth == 0) && (c == '[') )
+            {
+                checkPtr->isList = true;
+            }
+            else if ( checkPtr->isList && (checkPtr->depth == 1) && (c == '{') )
+            {
+                memset(&checkPtr->event, 0, sizeof(checkPtr->event));
+                checkPtr->event.status = -1;
+            }
+            else if ( checkPtr->isList && (checkPtr->depth == 2) && (c == '{') )
+            {
+                if (strcmp(checkPtr->key, "check") == 0)
+                {
+                    checkPtr->section = SENSU_GO_SECTION_CHECK;
+                }
+                else if (strcmp(checkPtr->key, "entity") == 0)
+                {
+                    checkPtr->section = SENSU_GO_SECTION_ENTITY;
+                }
+            }
+            else if ( (checkPtr->depth == 3) && (c == '{') &&
+                      (checkPtr->section != SENSU_GO_SECTION_NONE) &&
+                      (strcmp(checkPtr->key, "metadata") == 0) )
+            {
+                checkPtr->isInMetadata = true;
+            }
+            checkPtr->depth++;
+            checkPtr->key[0] = '\0';
+            break;
+
+        case '}':
+        case ']':
+            if (checkPtr->depth == 0)
+            {
+                break;
+            }
+            checkPtr->depth--;
+
+            if (checkPtr->depth == 3)
+            {
+                checkPtr->isInMetadata = false;
+            }
+            else if (checkPtr->depth == 2)
+            {
+                checkPtr->section = SENSU_GO_SECTION_NONE;
+            }
+            else if ( checkPtr->isList && (checkPtr->depth == 1) && (c == '}') )
+            {
+                return CountEvent(checkPtr);
+            }
+            break;
+
+        case ',':
+            checkPtr->key[0] = '\0';
+            break;
+
+        case '"':
+            checkPtr->token = SENSU_GO_TOKEN_STRING;
+            checkPtr->stringLength = 0;
+            break;
+
+        default:
+            if (isalnum((unsigned char) c) || (c == '-'))
+            {
+                checkPtr->token = SENSU_GO_TOKEN_LITERAL;
+                checkPtr->string[0] = c;
+                checkPtr->stringLength = 1;
+            }
+            break;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts the check of the content of a response
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitCheck
+(
+    void * statePtr,                        ///< [OUT] Check to initialize
+    const ContentCheckParams_t * paramsPtr  ///< [IN] Settings of the check, kept until the end
+)
+{
+    SensuGoCheck_t * checkPtr = statePtr;
+
+    memset(checkPtr, 0, sizeof(SensuGoCheck_t));
+    checkPtr->token = SENSU_GO_TOKEN_NONE;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds a chunk of the JSON content. The content is tokenized in a single pass, each event is
+ * counted once its object ends, so that only the event being read is kept whatever the number of
+ * events.
+ *
+ * Each page is a whole list: the check is back between containers at the end of a page, and the
+ * next one starts a new list.
+ *
+ * @return
+ *      true once the verdict is known: an event is critical
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FeedContent
+(
+    void * statePtr,                ///< [IN] Check in progress
+    const char * dataPtr,           ///< [IN] Chunk of content
+    size_t length                   ///< [IN] Length of the chunk
+)
+{
+    SensuGoCheck_t * checkPtr = statePtr;
+    size_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        char c = dataPtr[index];
+
+        switch (checkPtr->token)
+        {
+            case SENSU_GO_TOKEN_STRING:
+                if (c == '\\')
+                {
+                    checkPtr->token = SENSU_GO_TOKEN_ESCAPE;
+                }
+                else if (c == '"')
+                {
+                    checkPtr->token = SENSU_GO_TOKEN_AFTER_STRING;
+                }
+                else
+                {
+                    if (checkPtr->stringLength < SENSU_GO_MAX_STRING_BYTES)
+                    {
+                        checkPtr->string[checkPtr->stringLength] = c;
+                    }
+                    checkPtr->stringLength++;
+                }
+                continue;
+
+            case SENSU_GO_TOKEN_ESCAPE:
+                // Names are logged as written, escapes included
+                if (checkPtr->stringLength + 1 < SENSU_GO_MAX_STRING_BYTES)
+                {
+                    checkPtr->string[checkPtr->stringLength] = '\\';
+                    checkPtr->string[checkPtr->stringLength + 1] = c;
+                }
+                checkPtr->stringLength += 2;
+                checkPtr->token = SENSU_GO_TOKEN_STRING;
+                continue;
+
+            case SENSU_GO_TOKEN_AFTER_STRING:
+                if (isspace((unsigned char) c))
+                {
+                    continue;
+                }
+
+                checkPtr->token = SENSU_GO_TOKEN_NONE;
+                if (c == ':')
+                {
+                    CopyString(checkPtr, checkPtr->key);
+                    continue;
+                }
+                HandleValue(checkPtr);
+                break;
+
+            case SENSU_GO_TOKEN_LITERAL:
+                if (isalnum((unsigned char) c) || (c == '.') || (c == '+') || (c == '-'))
+                {
+                    if (checkPtr->stringLength < SENSU_GO_MAX_STRING_BYTES)
+                    {
+                        checkPtr->string[checkPtr->stringLength] = c;
+                    }
+                    checkPtr->stringLength++;
+                    continue;
+                }
+
+                checkPtr->token = SENSU_GO_TOKEN_NONE;
+                HandleValue(checkPtr);
+                break;
+
+            case SENSU_GO_TOKEN_NONE:
+            default:
+                break;
+        }
+
+        if (HandlePunctuation(checkPtr, c))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Completes the check once the content of all the pages is received or once the verdict is known
+ *
+ * @return
+ *      Worst state of the events, STATE_FAIL if the content is not a list of events
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t FinishCheck
+(
+    void * statePtr                 ///< [IN] Check fed with the content received
+)
+{
+    SensuGoCheck_t * checkPtr = statePtr;
+
+    // e.g. an error message instead of the events
+    if (!checkPtr->isList)
+    {
+        LE_ERROR("Not a list of Sensu events");
+        return STATE_FAIL;
+    }
+
+    if (checkPtr->criticalCount > 0)
+    {
+        LE_INFO("Critical event '%s/%s', after %zu passing and %zu warning event(s)",
+                checkPtr->event.entity,
+                checkPtr->event.check,
+                checkPtr->passingCount,
+                checkPtr->warningCount);
+        return STATE_FAIL;
+    }
+
+    LE_INFO("Sensu events: %zu passing, %zu warning, %zu silenced",
+            checkPtr->passingCount,
+            checkPtr->warningCount,
+            checkPtr->silencedCount);
+
+    return (checkPtr->warningCount > 0) ? STATE_WARNING : STATE_PASS;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds the size of the pages and the selectors of the events to the URL of a Sensu Go backend, so
+ * that the events are filtered by the server
+ *
+ * @return
+ *      - LE_OK if the URL is complete
+ *      - LE_OVERFLOW if it does not fit
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CompleteUrl
+(
+    const ContentCheckParams_t * paramsPtr,     ///< [IN] Settings of the check
+    char * urlPtr,                              ///< [IN/OUT] URL of the events
+    size_t urlSize                              ///< [IN] Size of the URL buffer
+)
+{
+    size_t length = strlen(urlPtr);
+    char pageSize[16];
+
+    if (length == 0)
+    {
+        return LE_OK;
+    }
+
+    snprintf(pageSize, sizeof(pageSize), "%" PRId32, paramsPtr->pageSize);
+
+    if ( (contentCheck_AddQueryParam(urlPtr, urlSize, "limit", pageSize) != LE_OK) ||
+         ( (paramsPtr->labelSelector[0] != '\0') &&
+           (contentCheck_AddQueryParam(urlPtr, urlSize, "labelSelector",
+                                       paramsPtr->labelSelector) != LE_OK) ) ||
+         ( (paramsPtr->fieldSelector[0] != '\0') &&
+           (contentCheck_AddQueryParam(urlPtr, urlSize, "fieldSelector",
+                                       paramsPtr->fieldSelector) != LE_OK) ) )
+    {
+        urlPtr[length] = '\0';
+        return LE_OVERFLOW;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pages of the Sensu Go API
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentPaging_t Paging = { SENSU_GO_CONTINUE_HEADER, SENSU_GO_CONTINUE_PARAM };
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checker of Sensu Go events, as info/content/checkMode "sensuGo"
+ */
+//--------------------------------------------------------------------------------------------------
+static const ContentChecker_t SensuGoChecker =
+{
+    .namePtr = "sensuGo",
+    .stateSize = sizeof(SensuGoCheck_t),
+    .init = InitCheck,
+    .feed = FeedContent,
+    .finish = FinishCheck,
+    .completeUrl = CompleteUrl,
+    .pagingPtr = &Paging,
+};
+CONTENT_CHECK_REGISTER(SensuGoChecker)
@@ -0,0 +1,541 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file stream.c
+ *
+ * Stream of Server-Sent Events, see stream.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "stream.h"
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Longest URL of the stream
+#define STREAM_MAX_URL_BYTES 512
+
+// Longest line of the stream, type of an event and data of an event kept. Longer ones are
+// truncated.
+#define STREAM_MAX_LINE_BYTES 512
+#define STREAM_MAX_EVENT_BYTES 64
+#define STREAM_MAX_DATA_BYTES 512
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event being received
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char line[STREAM_MAX_LINE_BYTES];       ///< Line being received
+    size_t lineLength;                      ///< Its length, may be more than it holds
+    bool isAfterCr;                         ///< Whether the last line ended with a CR
+    char event[STREAM_MAX_EVENT_BYTES];     ///< Type of the event, "" for "message"
+    char data[STREAM_MAX_DATA_BYTES];       ///< Data of the event, lines joined by LF
+    size_t dataLength;                      ///< Length of the data kept
+    bool hasData;                           ///< Whether the event has data, even empty
+}
+EventParser_t;
+
+// Handles the stream runs with, and its request
+static CURLM * MultiPtr = NULL;
+static CURLSH * SharePtr = NULL;
+static CURL * CurlPtr = NULL;
+static struct curl_slist * RequestHeadersPtr = NULL;
+
+// Handlers of the connection changes and of the events
+static stream_StateHandlerFunc_t StateHandlerPtr = NULL;
+static stream_EventHandlerFunc_t EventHandlerPtr = NULL;
+
+// Settings, see stream_SetSettings
+static char Url[STREAM_MAX_URL_BYTES] = "";
+static char EventFilter[STREAM_MAX_EVENT_BYTES] = "";
+static long ConnectTimeoutSec = 0;
+static long IdleTimeoutSec = 0;
+static uint32_t RetrySec = 0;
+
+// Whether the request runs, and whether the server answered it
+static bool IsRunning = false;
+static bool IsConnected = false;
+
+// Event being received
+static EventParser_t Parser;
+
+// Timer connecting the stream again once it dropped
+static le_timer_Ref_t RetryTimer = NULL;
+
+// Events that asked for a poll, and number of times the stream dropped
+static uint32_t EventCount = 0;
+static uint32_t DropCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles an event once it is complete: asks for a poll if it is of the type set, or if its data
+ * contains it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DispatchEvent
+(
+    void
+)
+{
+    const char * typePtr = (Parser.event[0] != '\0') ? Parser.event : "message";
+
+    Parser.data[Parser.dataLength] = '\0';
+
+    if ( (EventFilter[0] != '\0') &&
+         (strcmp(typePtr, EventFilter) != 0) &&
+         (strstr(Parser.data, EventFilter) == NULL) )
+    {
+        LE_DEBUG("Stream event '%s' ignored", typePtr);
+        return;
+    }
+
+    LE_INFO("Stream event '%s': %.64s", typePtr, Parser.data);
+    EventCount++;
+
+    if (EventHandlerPtr)
+    {
+        EventHandlerPtr();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles a complete line of the stream: a field of the event, a comment, or the empty line ending
+ * the event.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleLine
+(
+    void
+)
+{
+    char * valuePtr;
+
+    if (Parser.lineLength == 0)
+    {
+        // An event without data is not dispatched
+        if (Parser.hasData)
+        {
+            DispatchEvent();
+        }
+
+        Parser.event[0] = '\0';
+        Parser.dataLength = 0;
+        Parser.hasData = false;
+        return;
+    }
+
+    Parser.line[MIN(Parser.lineLength, STREAM_MAX_LINE_BYTES - 1)] = '\0';
+
+    // Comments keep the connection alive
+    if (Parser.line[0] == ':')
+    {
+        return;
+    }
+
+    valuePtr = strchr(Parser.line, ':');
+    if (valuePtr)
+    {
+        *valuePtr++ = '\0';
+        if (*valuePtr == ' ')
+        {
+            valuePtr++;
+        }
+    }
+    else
+    {
+        valuePtr = "";
+    }
+
+    if (strcmp(Parser.line, "event") == 0)
+    {
+        le_utf8_Copy(Parser.event, valuePtr, sizeof(Parser.event), NULL);
+    }
+    else if (strcmp(Parser.line, "data") == 0)
+    {
+        size_t length;
+
+        if ( Parser.hasData && (Parser.dataLength < STREAM_MAX_DATA_BYTES - 1) )
+        {
+            Parser.data[Parser.dataLength++] = '\n';
+        }
+
+        length = MIN(strlen(valuePtr), STREAM_MAX_DATA_BYTES - 1 - Parser.dataLength);
+        memcpy(&Parser.data[Parser.dataLength], valuePtr, length);
+        Parser.dataLength += length;
+        Parser.hasData = true;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called by cURL with each chunk of the stream. Lines end with CR, LF or CRLF.
+ *
+ * @return
+ *      size of the data handled, anything else drops the stream
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t WriteCallback
+(
+    void * bufferPtr,           ///< [IN] Chunk of the stream
+    size_t size,                ///< [IN] Size of an element
+    size_t nmemb,               ///< [IN] Number of elements
+    void * userPtr              ///< [IN] Unused
+)
+{
+    const char * dataPtr = bufferPtr;
+    size_t length = size * nmemb;
+    size_t index;
+
+    // The body of an error is not a stream
+    if (!IsConnected)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < length; index++)
+    {
+        char c = dataPtr[index];
+
+        if ( (c == '\n') && Parser.isAfterCr )
+        {
+            Parser.isAfterCr = false;
+            continue;
+        }
+
+        if ( (c == '\r') || (c == '\n') )
+        {
+            Parser.isAfterCr = (c == '\r');
+            HandleLine();
+            Parser.lineLength = 0;
+            continue;
+        }
+
+        Parser.isAfterCr = false;
+        if (Parser.lineLength < STREAM_MAX_LINE_BYTES)
+        {
+            Parser.line[Parser.lineLength] = c;
+        }
+        Parser.lineLength++;
+    }
+
+    return length;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called by cURL with each header of the response. The stream is connected once the server
+ * accepted it.
+ *
+ * @return
+ *      size of the header handled
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t HeaderCallback
+(
+    char * bufferPtr,           ///< [IN] Header, not NULL terminated
+    size_t size,                ///< [IN] Size of an element
+    size_t nitems,              ///< [IN] Number of elements
+    void * userPtr              ///< [IN] Unused
+)
+{
+    size_t length = size * nitems;
+    long httpCode = 0;
+
+    // Only the empty line ending the headers matters
+    if ( (length > 2) || IsConnected )
+    {
+        return length;
+    }
+
+    curl_easy_getinfo(CurlPtr, CURLINFO_RESPONSE_CODE, &httpCode);
+    if (httpCode != 200)
+    {
+        LE_WARN("Stream refused: HTTP %ld", httpCode);
+        return length;
+    }
+
+    LE_INFO("Stream connected: %s", Url);
+    IsConnected = true;
+
+    if (StateHandlerPtr)
+    {
+        StateHandlerPtr(true);
+    }
+
+    return length;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called once the stream dropped long enough
+ */
+//--------------------------------------------------------------------------------------------------
+static void RetryTimerHandler
+(
+    le_timer_Ref_t timerRef     ///< [IN] RetryTimer
+)
+{
+    stream_Start();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes the request of the stream from the multi handle
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveRequest
+(
+    void
+)
+{
+    if (IsRunning)
+    {
+        curl_multi_remove_handle(MultiPtr, CurlPtr);
+        IsRunning = false;
+    }
+    IsConnected = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the handles the stream runs with, and the handlers of its changes and events
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Init
+(
+    CURLM * multiPtr,                           ///< [IN] Multi handle running the transfers
+    CURLSH * sharePtr,                          ///< [IN] Share handle of the transfers
+    stream_StateHandlerFunc_t stateHandlerPtr,  ///< [IN] Handler of the connection changes
+    stream_EventHandlerFunc_t eventHandlerPtr   ///< [IN] Handler of the events
+)
+{
+    MultiPtr = multiPtr;
+    SharePtr = sharePtr;
+    StateHandlerPtr = stateHandlerPtr;
+    EventHandlerPtr = eventHandlerPtr;
+
+    RetryTimer = le_timer_Create("StreamRetryTimer");
+    le_timer_SetHandler(RetryTimer, RetryTimerHandler);
+    // The polling timer wakes the device up meanwhile
+    le_timer_SetWakeup(RetryTimer, false);
+
+    RequestHeadersPtr = curl_slist_append(RequestHeadersPtr, "Accept: text/event-stream");
+    RequestHeadersPtr = curl_slist_append(RequestHeadersPtr, "Cache-Control: no-cache");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the settings of the stream. The stream is stopped if they change, see stream_Start.
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_SetSettings
+(
+    const char * urlPtr,            ///< [IN] URL of the stream, "" for none
+    const char * eventPtr,          ///< [IN] Type or content of the events asking for a poll, ""
+                                    ///<      for all of them
+    long connectTimeoutSec,         ///< [IN] Time allowed to connect
+    long idleTimeoutSec,            ///< [IN] Time without receiving anything before it drops
+    uint32_t retrySec               ///< [IN] Delay before connecting again once it dropped
+)
+{
+    le_utf8_Copy(EventFilter, eventPtr, sizeof(EventFilter), NULL);
+    RetrySec = retrySec;
+
+    if ( (strcmp(urlPtr, Url) == 0) &&
+         (connectTimeoutSec == ConnectTimeoutSec) &&
+         (idleTimeoutSec == IdleTimeoutSec) )
+    {
+        return;
+    }
+
+    stream_Stop();
+
+    le_utf8_Copy(Url, urlPtr, sizeof(Url), NULL);
+    ConnectTimeoutSec = connectTimeoutSec;
+    IdleTimeoutSec = idleTimeoutSec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connects the stream, if its URL is set and it is not already
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Start
+(
+    void
+)
+{
+    if ( (Url[0] == '\0') || IsRunning )
+    {
+        return;
+    }
+
+    le_timer_Stop(RetryTimer);
+
+    if (!CurlPtr)
+    {
+        CurlPtr = curl_easy_init();
+        if (!CurlPtr)
+        {
+            LE_ERROR("Couldn't initialize cURL.");
+            return;
+        }
+
+        curl_easy_setopt(CurlPtr, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(CurlPtr, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(CurlPtr, CURLOPT_HTTPHEADER, RequestHeadersPtr);
+        curl_easy_setopt(CurlPtr, CURLOPT_SHARE, SharePtr);
+        curl_easy_setopt(CurlPtr, CURLOPT_TCP_KEEPALIVE, 1L);
+    }
+
+    curl_easy_setopt(CurlPtr, CURLOPT_URL, Url);
+    curl_easy_setopt(CurlPtr, CURLOPT_CONNECTTIMEOUT, ConnectTimeoutSec);
+
+    // The stream never ends, but a server that stopped sending anything, even comments, is gone
+    curl_easy_setopt(CurlPtr, CURLOPT_TIMEOUT, 0L);
+    curl_easy_setopt(CurlPtr, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(CurlPtr, CURLOPT_LOW_SPEED_TIME, IdleTimeoutSec);
+
+    memset(&Parser, 0, sizeof(Parser));
+
+    if (curl_multi_add_handle(MultiPtr, CurlPtr) != CURLM_OK)
+    {
+        LE_ERROR("Unable to add the stream");
+        le_timer_SetMsInterval(RetryTimer, RetrySec * 1000);
+        le_timer_Start(RetryTimer);
+        return;
+    }
+
+    LE_INFO("Connecting stream: %s", Url);
+    IsRunning = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disconnects the stream and stops connecting it again. The state handler is not called.
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Stop
+(
+    void
+)
+{
+    if (RetryTimer)
+    {
+        le_timer_Stop(RetryTimer);
+    }
+
+    if (IsRunning)
+    {
+        LE_INFO("Stream stopped");
+    }
+    RemoveRequest();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the stream is connected
+ *
+ * @return
+ *      true if the server answered and events are received
+ */
+//--------------------------------------------------------------------------------------------------
+bool stream_IsConnected
+(
+    void
+)
+{
+    return IsConnected;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the request of the stream runs on the multi handle
+ *
+ * @return
+ *      true if it runs, connected or not yet
+ */
+//--------------------------------------------------------------------------------------------------
+bool stream_IsRunning
+(
+    void
+)
+{
+    return IsRunning;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles the end of a transfer of the multi handle if it is the stream, which then dropped
+ *
+ * @return
+ *      true if the transfer is the stream
+ */
+//--------------------------------------------------------------------------------------------------
+bool stream_HandleDone
+(
+    CURL * easyPtr,                 ///< [IN] Easy handle of the transfer that is done
+    CURLcode result                 ///< [IN] Result of the transfer
+)
+{
+    bool wasConnected = IsConnected;
+    const char * reasonPtr;
+
+    if ( !IsRunning || (easyPtr != CurlPtr) )
+    {
+        return false;
+    }
+
+    // The body of a refused stream is not received, see WriteCallback
+    if (result == CURLE_OK)
+    {
+        reasonPtr = "closed by the server";
+    }
+    else if ( (result == CURLE_WRITE_ERROR) && !wasConnected )
+    {
+        reasonPtr = "refused";
+    }
+    else
+    {
+        reasonPtr = curl_easy_strerror(result);
+    }
+
+    LE_WARN("Stream %s: %s, connecting again in %u s",
+            wasConnected ? "dropped" : "not connected",
+            reasonPtr,
+            RetrySec);
+
+    RemoveRequest();
+    DropCount += wasConnected ? 1 : 0;
+
+    le_timer_SetMsInterval(RetryTimer, RetrySec * 1000);
+    le_timer_Start(RetryTimer);
+
+    if (wasConnected && StateHandlerPtr)
+    {
+        StateHandlerPtr(false);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes whether the stream is connected as stream/connected, the events that asked for a poll as
+ * stream/events and the number of times it dropped as stream/drops, relative to the node the
+ * iterator is on.
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Write
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Write iterator, e.g. on /stats
+)
+{
+    le_cfg_SetInt(iteratorRef, "stream/connected", IsConnected ? 1 : 0);
+    le_cfg_SetInt(iteratorRef, "stream/events", EventCount);
+    le_cfg_SetInt(iteratorRef, "stream/drops", DropCount);
+}
@@ -0,0 +1,137 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file stream.h
+ *
+ * Stream of Server-Sent Events telling when the state of the monitors may have changed, e.g. when
+ * a Jenkins build finished. A single long-lived request runs with the transfers of the polls, on
+ * the same multi handle, and each event of the stream asks for an immediate poll. While it is
+ * connected the polling timer is not needed; once it drops, it is connected again after a delay.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef STREAM_H_INCLUDE_GUARD
+#define STREAM_H_INCLUDE_GUARD
+
+#include <curl/curl.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when the stream is connected or drops
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*stream_StateHandlerFunc_t)
+(
+    bool isConnected                ///< [IN] Whether events are received
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called when an event of the stream asks for a poll
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*stream_EventHandlerFunc_t)
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the handles the stream runs with, and the handlers of its changes and events
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Init
+(
+    CURLM * multiPtr,                           ///< [IN] Multi handle running the transfers
+    CURLSH * sharePtr,                          ///< [IN] Share handle of the transfers
+    stream_StateHandlerFunc_t stateHandlerPtr,  ///< [IN] Handler of the connection changes
+    stream_EventHandlerFunc_t eventHandlerPtr   ///< [IN] Handler of the events
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the settings of the stream. The stream is stopped if they change, see stream_Start.
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_SetSettings
+(
+    const char * urlPtr,            ///< [IN] URL of the stream, "" for none
+    const char * eventPtr,          ///< [IN] Type or content of the events asking for a poll, ""
+                                    ///<      for all of them
+    long connectTimeoutSec,         ///< [IN] Time allowed to connect
+    long idleTimeoutSec,            ///< [IN] Time without receiving anything before it drops
+    uint32_t retrySec               ///< [IN] Delay before connecting again once it dropped
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connects the stream, if its URL is set and it is not already
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Start
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disconnects the stream and stops connecting it again. The state handler is not called.
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Stop
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the stream is connected
+ *
+ * @return
+ *      true if the server answered and events are received
+ */
+//--------------------------------------------------------------------------------------------------
+bool stream_IsConnected
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tells whether the request of the stream runs on the multi handle
+ *
+ * @return
+ *      true if it runs, connected or not yet
+ */
+//--------------------------------------------------------------------------------------------------
+bool stream_IsRunning
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles the end of a transfer of the multi handle if it is the stream, which then dropped
+ *
+ * @return
+ *      true if the transfer is the stream
+ */
+//--------------------------------------------------------------------------------------------------
+bool stream_HandleDone
+(
+    CURL * easyPtr,                 ///< [IN] Easy handle of the transfer that is done
+    CURLcode result                 ///< [IN] Result of the transfer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes whether the stream is connected as stream/connected, the events that asked for a poll as
+ * stream/events and the number of times it dropped as stream/drops, relative to the node the
+ * iterator is on.
+ */
+//--------------------------------------------------------------------------------------------------
+void stream_Write
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Write iterator, e.g. on /stats
+);
+
+#endif // STREAM_H_INCLUDE_GUARD
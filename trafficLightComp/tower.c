@@ -0,0 +1,565 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file tower.c
+ *
+ * Rules of the towers, see tower.h
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "tower.h"
+#include <ctype.h>
+
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
+// Size of the name of a tower in the config tree, with its NULL char
+#define MAX_TOWER_NAME_BYTES 32
+
+// Longest rule in the config tree, e.g. "weighted(api:3, db:2, jobs*)"
+#define MAX_TOWER_RULE_BYTES 256
+
+// Highest weight of a monitor
+#define MAX_TERM_WEIGHT 1000
+
+// Number of monitor states
+#define STATE_COUNT (STATE_UNKNOWN + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Kinds of rules
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    RULE_WORST,                     ///< Worst state of the monitors
+    RULE_MAJORITY,                  ///< State of at least half of the monitors, or worse
+    RULE_WEIGHTED,                  ///< Same as majority, with each monitor counting its weight
+    RULE_ANY_CRITICAL,              ///< Fail if a monitor fails, pass otherwise
+}
+RuleKind_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tower, as read from /towers/<n>, with the state of its monitors
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char name[MAX_TOWER_NAME_BYTES];    ///< Name of the node in the config tree
+    size_t output;                      ///< Tower driven, from 0
+    RuleKind_t kind;                    ///< Kind of its rule
+    uint32_t stateWeights[STATE_COUNT]; ///< Sum of the weights of its monitors in each state
+    uint32_t inProgressCount;           ///< Number of its monitors whose job is running
+    bool isChanged;                     ///< Whether it must be evaluated again
+}
+Tower_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Monitor, with the weight it has in each tower
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    MonitorState_t state;                   ///< Last state set
+    bool isInProgress;                      ///< Whether its job is running
+    uint16_t weights[LIGHT_MAX_OUTPUTS];    ///< Weight in each tower, 0 if not part of it
+}
+TowerMonitor_t;
+
+// Handler showing the state of a tower
+static tower_ShowHandlerFunc_t ShowHandlerPtr = NULL;
+
+// Towers read from the config tree
+static Tower_t Towers[LIGHT_MAX_OUTPUTS];
+static size_t TowerCount = 0;
+
+// Monitors the rules are compiled against, and the jobs of views shown as monitors
+static TowerMonitor_t TowerMonitors[MAX_MONITORS + MAX_JOB_MONITORS];
+static size_t TowerMonitorCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes the spaces around a string, in place
+ *
+ * @return
+ *      Start of the trimmed string
+ */
+//--------------------------------------------------------------------------------------------------
+static char * Trim
+(
+    char * stringPtr                ///< [IN] String, modified
+)
+{
+    char * endPtr;
+
+    while (isspace((unsigned char) *stringPtr))
+    {
+        stringPtr++;
+    }
+
+    endPtr = stringPtr + strlen(stringPtr);
+    while ( (endPtr > stringPtr) && isspace((unsigned char) endPtr[-1]) )
+    {
+        endPtr--;
+    }
+    *endPtr = '\0';
+
+    return stringPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds the monitors a term selects to a tower
+ *
+ * @return
+ *      true if the term is valid
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CompileTerm
+(
+    size_t towerIndex,              ///< [IN] Tower the monitors are added to
+    char * termPtr,                 ///< [IN] Term, e.g. "api", "jobs*:2" or "*", modified
+    bool hasWeight,                 ///< [IN] Whether the weight of the term counts
+    const char * const namePtrs[]   ///< [IN] Names of the monitors
+)
+{
+    char * weightPtr = strchr(termPtr, ':');
+    unsigned long weight = 1;
+    size_t length;
+    bool isPrefix = false;
+    size_t matchCount = 0;
+    size_t i;
+
+    if (weightPtr)
+    {
+        char * endPtr;
+
+        *weightPtr++ = '\0';
+        weight = strtoul(weightPtr, &endPtr, 10);
+        if ( (endPtr == weightPtr) || (*Trim(endPtr) != '\0') ||
+             (weight == 0) || (weight > MAX_TERM_WEIGHT) )
+        {
+            return false;
+        }
+        weight = hasWeight ? weight : 1;
+    }
+
+    termPtr = Trim(termPtr);
+    length = strlen(termPtr);
+    if (length == 0)
+    {
+        return false;
+    }
+
+    if (termPtr[length - 1] == '*')
+    {
+        isPrefix = true;
+        length--;
+    }
+
+    for (i = 0; i < TowerMonitorCount; i++)
+    {
+        // The jobs of a view, "<view>/<job>", are only selected by a term naming the view
+        if ( (strchr(namePtrs[i], '/') != NULL) && (memchr(termPtr, '/', length) == NULL) )
+        {
+            continue;
+        }
+
+        if ( isPrefix ? (strncmp(namePtrs[i], termPtr, length) == 0) :
+                        (strcmp(namePtrs[i], termPtr) == 0) )
+        {
+            TowerMonitors[i].weights[towerIndex] = weight;
+            matchCount++;
+        }
+    }
+
+    // The jobs of a view are only known once it is polled
+    if ( (matchCount == 0) && (strchr(termPtr, '/') == NULL) )
+    {
+        LE_WARN("Tower '%s': no monitor matches '%s'", Towers[towerIndex].name, termPtr);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compiles the rule of a tower: reads its kind, and sets the weight of each of the monitors it
+ * selects
+ *
+ * @return
+ *      true if the rule is valid
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CompileRule
+(
+    size_t towerIndex,              ///< [IN] Tower whose rule is compiled
+    const char * rulePtr,           ///< [IN] Rule, e.g. "majority(api, db)"
+    const char * const namePtrs[]   ///< [IN] Names of the monitors
+)
+{
+    Tower_t * towerPtr = &Towers[towerIndex];
+    char buffer[MAX_TOWER_RULE_BYTES];
+    char * kindPtr;
+    char * termsPtr;
+    char * savePtr = NULL;
+    char * termPtr;
+    size_t i;
+
+    if (le_utf8_Copy(buffer, rulePtr, sizeof(buffer), NULL) != LE_OK)
+    {
+        return false;
+    }
+
+    // Without terms, the rule is over all the monitors
+    termsPtr = strchr(buffer, '(');
+    if (termsPtr)
+    {
+        char * endPtr = strrchr(termsPtr, ')');
+
+        if ( (endPtr == NULL) || (*Trim(endPtr + 1) != '\0') )
+        {
+            return false;
+        }
+        *termsPtr++ = '\0';
+        *endPtr = '\0';
+    }
+
+    kindPtr = Trim(buffer);
+    if (strcmp(kindPtr, "worst") == 0)
+    {
+        towerPtr->kind = RULE_WORST;
+    }
+    else if (strcmp(kindPtr, "majority") == 0)
+    {
+        towerPtr->kind = RULE_MAJORITY;
+    }
+    else if (strcmp(kindPtr, "weighted") == 0)
+    {
+        towerPtr->kind = RULE_WEIGHTED;
+    }
+    else if (strcmp(kindPtr, "anyCritical") == 0)
+    {
+        towerPtr->kind = RULE_ANY_CRITICAL;
+    }
+    else
+    {
+        return false;
+    }
+
+    if ( (termsPtr == NULL) || (*Trim(termsPtr) == '\0') )
+    {
+        char all[] = "*";
+
+        return CompileTerm(towerIndex, all, false, namePtrs);
+    }
+
+    for (termPtr = strtok_r(termsPtr, ",", &savePtr);
+         termPtr != NULL;
+         termPtr = strtok_r(NULL, ",", &savePtr))
+    {
+        if (!CompileTerm(towerIndex, termPtr, towerPtr->kind == RULE_WEIGHTED, namePtrs))
+        {
+            for (i = 0; i < TowerMonitorCount; i++)
+            {
+                TowerMonitors[i].weights[towerIndex] = 0;
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads a tower from the config tree and compiles its rule. An invalid rule is replaced by the
+ * worst state of all the monitors.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadTower
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator on the node of the tower
+    const char * const namePtrs[]       ///< [IN] Names of the monitors
+)
+{
+    Tower_t * towerPtr = &Towers[TowerCount];
+    char rule[MAX_TOWER_RULE_BYTES] = "";
+    int32_t output;
+    size_t i;
+
+    memset(towerPtr, 0, sizeof(*towerPtr));
+    le_cfg_GetNodeName(iteratorRef, "", towerPtr->name, sizeof(towerPtr->name));
+    le_cfg_GetString(iteratorRef, "rule", rule, sizeof(rule), "worst");
+
+    output = le_cfg_GetInt(iteratorRef, "output", TowerCount + 1);
+    if ( (output < 1) || (output > LIGHT_MAX_OUTPUTS) )
+    {
+        LE_WARN("Tower '%s': output %d out of range [1, %d], skipping",
+                towerPtr->name,
+                output,
+                LIGHT_MAX_OUTPUTS);
+        return;
+    }
+    towerPtr->output = output - 1;
+
+    for (i = 0; i < TowerCount; i++)
+    {
+        if (Towers[i].output == towerPtr->output)
+        {
+            LE_WARN("Tower '%s': output %d already used by '%s', skipping",
+                    towerPtr->name,
+                    output,
+                    Towers[i].name);
+            return;
+        }
+    }
+
+    if (!light_IsAvailable(towerPtr->output))
+    {
+        LE_WARN("Tower '%s': output %d is not bound", towerPtr->name, output);
+    }
+
+    if (!CompileRule(TowerCount, rule, namePtrs))
+    {
+        char all[] = "*";
+
+        LE_ERROR("Tower '%s': invalid rule '%s', showing the worst state of all the monitors",
+                 towerPtr->name,
+                 rule);
+        towerPtr->kind = RULE_WORST;
+        CompileTerm(TowerCount, all, false, namePtrs);
+    }
+    else
+    {
+        LE_INFO("Tower '%s' on output %d: %s", towerPtr->name, output, rule);
+    }
+
+    TowerCount++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the state of a tower from the weights of its monitors in each state
+ *
+ * @return
+ *      State to show, STATE_UNKNOWN if none of its monitors is known
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t EvaluateTower
+(
+    const Tower_t * towerPtr        ///< [IN] Tower
+)
+{
+    const uint32_t * weightsPtr = towerPtr->stateWeights;
+    uint32_t knownWeight = weightsPtr[STATE_FAIL] + weightsPtr[STATE_WARNING] +
+                           weightsPtr[STATE_PASS];
+    uint32_t weight = 0;
+    int state;
+
+    switch (towerPtr->kind)
+    {
+        case RULE_ANY_CRITICAL:
+            if (weightsPtr[STATE_FAIL] > 0)
+            {
+                return STATE_FAIL;
+            }
+            return (knownWeight > 0) ? STATE_PASS : STATE_UNKNOWN;
+
+        case RULE_MAJORITY:
+        case RULE_WEIGHTED:
+            // Worst state that at least half of the weight is in, or better than
+            for (state = STATE_FAIL; state <= STATE_PASS; state++)
+            {
+                weight += weightsPtr[state];
+                if ( (knownWeight > 0) && (2 * weight >= knownWeight) )
+                {
+                    return state;
+                }
+            }
+            return STATE_UNKNOWN;
+
+        case RULE_WORST:
+        default:
+            for (state = STATE_FAIL; state < STATE_UNKNOWN; state++)
+            {
+                if (weightsPtr[state] > 0)
+                {
+                    return state;
+                }
+            }
+            return STATE_UNKNOWN;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the handler showing the states of the towers
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Init
+(
+    tower_ShowHandlerFunc_t handlerPtr  ///< [IN] Handler showing a state on a tower
+)
+{
+    ShowHandlerPtr = handlerPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the towers from the config tree and compiles their rules against the monitors, the jobs of
+ * views included. The monitors are unknown until their state is set.
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Load
+(
+    const char * const namePtrs[],  ///< [IN] Names of the monitors, by index
+    size_t monitorCount             ///< [IN] Number of monitors
+)
+{
+    le_cfg_IteratorRef_t iteratorRef;
+    size_t i;
+    size_t j;
+
+    TowerCount = 0;
+    TowerMonitorCount = MIN(monitorCount, NUM_ARRAY_MEMBERS(TowerMonitors));
+    memset(TowerMonitors, 0, sizeof(TowerMonitors));
+
+    iteratorRef = le_cfg_CreateReadTxn("/towers");
+    if (le_cfg_GoToFirstChild(iteratorRef) == LE_OK)
+    {
+        do
+        {
+            if (TowerCount >= LIGHT_MAX_OUTPUTS)
+            {
+                LE_WARN("Too many towers, only the first %d are shown", LIGHT_MAX_OUTPUTS);
+                break;
+            }
+
+            LoadTower(iteratorRef, namePtrs);
+        }
+        while (le_cfg_GoToNextSibling(iteratorRef) == LE_OK);
+    }
+    le_cfg_CancelTxn(iteratorRef);
+
+    // Without towers, the main one shows the worst state of all the monitors
+    if (TowerCount == 0)
+    {
+        char all[] = "*";
+
+        memset(&Towers[0], 0, sizeof(Towers[0]));
+        snprintf(Towers[0].name, sizeof(Towers[0].name), "default");
+        Towers[0].kind = RULE_WORST;
+        CompileTerm(0, all, false, namePtrs);
+        TowerCount = 1;
+    }
+
+    for (i = 0; i < TowerMonitorCount; i++)
+    {
+        TowerMonitors[i].state = STATE_UNKNOWN;
+        for (j = 0; j < TowerCount; j++)
+        {
+            Towers[j].stateWeights[STATE_UNKNOWN] += TowerMonitors[i].weights[j];
+        }
+    }
+
+    tower_Invalidate();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the state of a monitor, and marks the towers it is part of as changed if it changed
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_SetMonitorState
+(
+    size_t monitorIndex,            ///< [IN] Index of the monitor, as loaded
+    MonitorState_t state,           ///< [IN] State of the monitor
+    bool isInProgress               ///< [IN] Whether its job is running
+)
+{
+    TowerMonitor_t * monitorPtr;
+    size_t i;
+
+    if (monitorIndex >= TowerMonitorCount)
+    {
+        return;
+    }
+    monitorPtr = &TowerMonitors[monitorIndex];
+
+    if ( (monitorPtr->state == state) && (monitorPtr->isInProgress == isInProgress) )
+    {
+        return;
+    }
+
+    for (i = 0; i < TowerCount; i++)
+    {
+        uint32_t weight = monitorPtr->weights[i];
+
+        if (weight == 0)
+        {
+            continue;
+        }
+
+        Towers[i].stateWeights[monitorPtr->state] -= weight;
+        Towers[i].stateWeights[state] += weight;
+        Towers[i].inProgressCount = Towers[i].inProgressCount
+                                    - (monitorPtr->isInProgress ? 1 : 0)
+                                    + (isInProgress ? 1 : 0);
+        Towers[i].isChanged = true;
+    }
+
+    monitorPtr->state = state;
+    monitorPtr->isInProgress = isInProgress;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Evaluates the towers that changed, and shows their state
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Update
+(
+    void
+)
+{
+    size_t i;
+
+    for (i = 0; i < TowerCount; i++)
+    {
+        Tower_t * towerPtr = &Towers[i];
+
+        if (!towerPtr->isChanged)
+        {
+            continue;
+        }
+        towerPtr->isChanged = false;
+
+        if (ShowHandlerPtr)
+        {
+            ShowHandlerPtr(towerPtr->output,
+                           EvaluateTower(towerPtr),
+                           towerPtr->inProgressCount > 0);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Marks all the towers as changed, e.g. once something else was shown on them
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Invalidate
+(
+    void
+)
+{
+    size_t i;
+
+    for (i = 0; i < TowerCount; i++)
+    {
+        Towers[i].isChanged = true;
+    }
+}
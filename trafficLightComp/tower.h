@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file tower.h
+ *
+ * Rules computing the state shown by each tower from the states of the monitors, as read from
+ * /towers/<n>:
+ *  - output: tower driven, from 1 to LIGHT_MAX_OUTPUTS (default: its position in the list)
+ *  - rule: "<kind>" or "<kind>(<term>, <term>, ...)", where <kind> is "worst", "majority",
+ *    "weighted" or "anyCritical", and <term> is a monitor name, a prefix followed by '*', or '*',
+ *    optionally followed by ":<weight>" (default: "worst", over all the monitors)
+ *
+ * The jobs of a view shown as monitors of their own, named "<view>/<job>", are only selected by
+ * the terms that contain a '/', e.g. "ci/deploy" or "ci/" followed by '*': "*" and the rules
+ * without terms are over the monitors of the config tree.
+ *
+ * The rules are compiled once when the config is loaded. Each tower keeps the sum of the weights
+ * of its monitors in each state, updated when a monitor changes, so that only the towers of the
+ * monitors that changed are evaluated again, without going through their monitors.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef TOWER_H_INCLUDE_GUARD
+#define TOWER_H_INCLUDE_GUARD
+
+#include "trafficLight.h"
+#include "light.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler called with the state to show on a tower
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*tower_ShowHandlerFunc_t)
+(
+    size_t output,                  ///< [IN] Tower, from 0 to LIGHT_MAX_OUTPUTS - 1
+    MonitorState_t state,           ///< [IN] State computed by its rule
+    bool isInProgress               ///< [IN] Whether a job of its monitors is running
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the handler showing the states of the towers
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Init
+(
+    tower_ShowHandlerFunc_t handlerPtr  ///< [IN] Handler showing a state on a tower
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the towers from the config tree and compiles their rules against the monitors, the jobs of
+ * views included. The monitors are unknown until their state is set.
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Load
+(
+    const char * const namePtrs[],  ///< [IN] Names of the monitors, by index
+    size_t monitorCount             ///< [IN] Number of monitors
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the state of a monitor, and marks the towers it is part of as changed if it changed
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_SetMonitorState
+(
+    size_t monitorIndex,            ///< [IN] Index of the monitor, as loaded
+    MonitorState_t state,           ///< [IN] State of the monitor
+    bool isInProgress               ///< [IN] Whether its job is running
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Evaluates the towers that changed, and shows their state
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Update
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Marks all the towers as changed, e.g. once something else was shown on them
+ */
+//--------------------------------------------------------------------------------------------------
+void tower_Invalidate
+(
+    void
+);
+
+#endif // TOWER_H_INCLUDE_GUARD
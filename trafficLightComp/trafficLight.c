@@ -1,120 +1,350 @@
 #include "legato.h"
 #include "le_cfg_interface.h"
 #include "interfaces.h"
+#include "contentCheck.h"
+#include "pollStats.h"
+#include "light.h"
+#include "tower.h"
+#include "pollArena.h"
+#include "history.h"
+#include "power.h"
+#include "dataLink.h"
+#include "stream.h"
 #include <curl/curl.h>
+#include <ctype.h>
+#include <strings.h>
+#include <math.h>
 
 #define MIN(a,b) (((a)<(b))?(a):(b))
+#define MAX(a,b) (((a)>(b))?(a):(b))
 #define MAX_URL_BYTES 512
+#define MAX_VALIDATOR_BYTES 128
+
+// Size of the Authorization header line of a monitor, e.g. "Authorization: Key <API key>"
+#define MAX_AUTHORIZATION_BYTES 256
+
+// Size of the token of the next page of a paged response, e.g. of the Sensu Go events
+#define MAX_PAGE_TOKEN_BYTES 256
+
+// Most pages of a response followed in a poll, and their default size
+#define MAX_CONTENT_PAGES 1000
+#define DEFAULT_CONTENT_PAGE_SIZE 500
+
+// Default polling timer interval in seconds
+#define DEFAULT_POLLING_INTERVAL_SEC 10
+
+// Delay between a change in the config tree and its application, so that the changes pushed
+// together are applied at once
+#define CONFIG_APPLY_DELAY_MS 200
+
+// Size of the name of the file descriptor monitor of a socket, e.g. "curl-12"
+#define MAX_FD_MONITOR_NAME_BYTES 32
+
+// Default time allowed to connect to a server, and to complete a whole transfer
+#define DEFAULT_CONNECT_TIMEOUT_SEC 10
+#define DEFAULT_TRANSFER_TIMEOUT_SEC 30
+
+// Time resolved host names are kept in the DNS cache
+#define DNS_CACHE_TIMEOUT_SEC 600
+
+// Idle time before TCP keep-alive probes are sent on an open connection, and interval between them
+#define TCP_KEEPALIVE_IDLE_SEC 30
+#define TCP_KEEPALIVE_INTERVAL_SEC 15
+
+// Size of the buffer the content of a response is received in, see /responseBufferBytes.
+// cURL does not accept less than 1KB or more than 512KB.
+#define DEFAULT_RESPONSE_BUFFER_BYTES 4096
+#define MIN_RESPONSE_BUFFER_BYTES 1024
+#define MAX_RESPONSE_BUFFER_BYTES (512 * 1024)
+
+// Memory of the polls, see /pollArenaBytes and pollArena.h. Each transfer needs a content check,
+// whose size depends on the checkMode (see contentCheck_GetSize), and its conditional headers.
+// By default there is room for MAX_MONITORS checks of the largest checkMode, see
+// GetDefaultPollArenaBytes, each with the two validators, their names and their list items.
+#define POLL_ARENA_HEADER_BYTES (2 * (MAX_VALIDATOR_BYTES + 64 + sizeof(struct curl_slist)))
+#define MIN_POLL_ARENA_BYTES 4096
+#define MAX_POLL_ARENA_BYTES (1024 * 1024)
+
+// Most content read before the state of a response is known, see /maxResponseBytes
+#define DEFAULT_MAX_RESPONSE_BYTES (1024 * 1024)
+
+// Number of polls the latency percentiles are computed over
+#define LATENCY_WINDOW_SIZE 64
+
+// Defaults of the adaptive polling settings, see ScheduleNextPoll
+#define DEFAULT_BACKOFF_MAX_SEC 300
+#define DEFAULT_BURST_INTERVAL_SEC 2
+#define DEFAULT_BURST_POLL_COUNT 5
+#define DEFAULT_JITTER_PERCENT 10
+
+// Highest power of 2 the polling interval is multiplied by on repeated failures
+#define MAX_BACKOFF_SHIFT 16
+
+// Pattern shown until the state of the monitors is known
+#define DEFAULT_UNKNOWN_PATTERN "steady all"
+
+// Statistics are written to the config tree, which lives in flash, at most this often by default
+#define DEFAULT_STATS_PUBLISH_INTERVAL_SEC 300
+
+// State transitions are written to flash by batches of this many, or after this long by default
+#define DEFAULT_HISTORY_FLUSH_COUNT 16
+#define DEFAULT_HISTORY_FLUSH_INTERVAL_SEC 900
+
+// Defaults of the stream settings, see stream.h. The server is expected to send something, e.g. a
+// comment, at least once per idle timeout.
+#define DEFAULT_STREAM_IDLE_TIMEOUT_SEC 120
+#define DEFAULT_STREAM_RETRY_SEC 30
+
+// Settings read from the config tree. They are only read again when the config tree changes, see
+// ConfigChangeHandler, so that polling does not need to access the config tree.
 
 // Polling timer interval in seconds
-static int PollingIntervalSec = 10;
+static int PollingIntervalSec = DEFAULT_POLLING_INTERVAL_SEC;
+
+// Size of the buffer the content of a response is received in
+static long ResponseBufferBytes = DEFAULT_RESPONSE_BUFFER_BYTES;
+
+// Size of the memory of the polls, only applied at startup
+static long PollArenaBytes = 0;
+
+// Most content read before the state of a response is known, the response fails beyond
+static long MaxResponseBytes = DEFAULT_MAX_RESPONSE_BYTES;
+
+// Whether the servers are asked for compressed responses
+static bool Compression = true;
 
-// Memory pool and timer reference
-static le_mem_PoolRef_t PoolRef;
+// Adaptive polling: whether it is enabled, the longest interval when backing off, the interval and
+// number of the polls of a burst, and the random variation of the interval in percent
+static bool AdaptivePolling = false;
+static int BackoffMaxSec = DEFAULT_BACKOFF_MAX_SEC;
+static int BurstIntervalSec = DEFAULT_BURST_INTERVAL_SEC;
+static int BurstPollCount = DEFAULT_BURST_POLL_COUNT;
+static int JitterPercent = DEFAULT_JITTER_PERCENT;
+
+// Time allowed to connect to a server, and to complete a whole transfer
+static long ConnectTimeoutSec = DEFAULT_CONNECT_TIMEOUT_SEC;
+static long TransferTimeoutSec = DEFAULT_TRANSFER_TIMEOUT_SEC;
+
+// Patterns shown when the state is unknown, and while a monitored job is running (none by
+// default: the state of the monitors is shown)
+static LightPattern_t UnknownPattern = { .steps = { { LIGHT_ON, 0 } }, .stepCount = 1 };
+static LightPattern_t BuildingPattern;
+
+// Pattern shown while the data link is down (none by default: the last state stays shown)
+static LightPattern_t LinkDownPattern;
+
+// Minimum interval between two writes of the statistics to /stats, 0 to not write them
+static int StatsPublishIntervalSec = DEFAULT_STATS_PUBLISH_INTERVAL_SEC;
+
+// Timer references
 static le_timer_Ref_t PollingTimer = NULL;
+static le_timer_Ref_t ConfigTimer = NULL;
+
+// Timer requested by cURL to check the transfers for timeouts, see TransferTimerCallback
+static le_timer_Ref_t TransferTimer = NULL;
+
+// Nodes of the config tree whose changes are applied
+static const char * ConfigWatchPaths[] =
+{
+    "/pollingIntervalSec",
+    "/adaptivePolling",
+    "/backoffMaxSec",
+    "/burstIntervalSec",
+    "/burstPollCount",
+    "/jitterPercent",
+    "/responseBufferBytes",
+    "/pollArenaBytes",
+    "/maxResponseBytes",
+    "/compression",
+    "/connectTimeoutSec",
+    "/transferTimeoutSec",
+    "/statsPublishIntervalSec",
+    "/historyFlushCount",
+    "/historyFlushIntervalSec",
+    "/lowPower",
+    "/dataChannel",
+    "/fallbackDataChannel",
+    "/streamUrl",
+    "/streamEvent",
+    "/streamIdleTimeoutSec",
+    "/streamRetrySec",
+    "/patterns",
+    "/towers",
+    "/url",
+    "/authorization",
+    "/info",
+    "/monitors",
+};
+
+// Multi handle used to run the transfers of all the monitors at the same time. It also holds the
+// connection cache, so connections are kept open between polls.
+static CURLM *MultiPtr = NULL;
+
+// Share handle so that the DNS cache and TLS sessions are common to all the monitors
+static CURLSH *SharePtr = NULL;
+
+// Number of transfers that reused an open connection, and number of connections created
+static uint32_t ReusedConnectionCount = 0;
+static uint32_t NewConnectionCount = 0;
+
+// Number of requests sent with validators, number of them that were not modified, and the size of
+// the content that did not have to be downloaded again
+static uint32_t ConditionalRequestCount = 0;
+static uint32_t NotModifiedCount = 0;
+static uint64_t NotModifiedBytes = 0;
+
+// Number of responses that exceeded /maxResponseBytes before their state was known
+static uint32_t TooLargeCount = 0;
+
+// Latencies of the last polls, from the start of the poll to the update of the light
+static uint32_t PollLatencyMs[LATENCY_WINDOW_SIZE];
+static size_t PollCount = 0;
+
+// State of the adaptive polling: number of polls in a row where every transfer failed, number of
+// fast polls left, and state displayed by the last poll
+static uint32_t ConsecutiveFailureCount = 0;
+static int BurstPollsLeft = 0;
+static MonitorState_t LastPolledState = STATE_UNKNOWN;
+
+// Relative time the statistics were last written to /stats at, and whether they ever were
+static le_clk_Time_t LastStatsPublishTime;
+static bool HasPublishedStats = false;
+
+// Whether an event of the stream arrived while a poll was running, see StreamPoll
+static bool IsStreamPollPending = false;
 
 // Header declaration
 static void GpioInit(void);
 static void Polling(le_timer_Ref_t timerRef);
 static void TimerHandle();
+static void ScheduleNextPoll(void);
+static void StreamPoll(void * param1Ptr, void * param2Ptr);
+static void StreamEventHandler(void);
+static void StreamStateHandler(bool isConnected);
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Holds information of the htmlstring from url
+ * Validators of a response, sent back with the next request so that the server only answers with
+ * the content if it changed
  */
 //--------------------------------------------------------------------------------------------------
 typedef struct
 {
-    char* actualData;
+    char etag[MAX_VALIDATOR_BYTES];         ///< ETag header, empty if absent or too long
+    char lastModified[MAX_VALIDATOR_BYTES]; ///< Last-Modified header, empty if absent or too long
 }
-MemoryPool_t;
+Validators_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Light statuses
- *
- * @note Enumerated type is used in SetMonitorState function
+ * State of the last full response of a monitor, reused when the server answers 304 Not Modified
  */
 //--------------------------------------------------------------------------------------------------
-typedef enum
+typedef struct
 {
-    LIGHT_RED,
-    LIGHT_YELLOW,
-    LIGHT_GREEN,
-    LIGHT_ON,
-    LIGHT_OFF,
+    bool isValid;                   ///< Whether the response can be reused
+    MonitorState_t state;           ///< State computed from the response
+    bool isInProgress;              ///< Whether the monitored job was running
+    curl_off_t length;              ///< Bytes downloaded for the response, compressed or not
+    Validators_t validators;        ///< Validators of the response
 }
-LightState_t;
+ResponseCache_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Monitor statuses used for comparison to ultimately set the lightstates
+ * Monitored endpoint, as read from /monitors/<n> (or from the root of the config tree when no
+ * monitor list is set)
  */
 //--------------------------------------------------------------------------------------------------
-typedef enum
+typedef struct
 {
-    STATE_FAIL,
-    STATE_WARNING,
-    STATE_PASS,
-    STATE_UNKNOWN,
+    char name[MAX_MONITOR_NAME_BYTES];      ///< Name of the node in the config tree
+    char url[MAX_URL_BYTES];                ///< Url to poll
+    char authorization[MAX_AUTHORIZATION_BYTES];    ///< Authorization header, empty if none
+    struct curl_slist authorizationHeader;  ///< Item of the authorization in the request headers
+    bool exitCodeCheck;                     ///< info/exitCode/checkFlag
+    bool contentCheck;                      ///< info/content/checkFlag
+    const ContentChecker_t * checkerPtr;    ///< info/content/checkMode, NULL if unknown
+    ContentCheckParams_t contentParams;     ///< Other settings of info/content
+    CURL *curlPtr;                          ///< Easy handle, kept from one poll to the other
+    bool isTransferring;                    ///< Whether the easy handle is in the multi handle
+    bool hasFailed;                         ///< Whether the server could not be polled
+    bool isInProgress;                      ///< Whether the monitored job is still running
+    int32_t httpCode;                       ///< HTTP code of the last response, 0 if none
+    bool isNotModified;                     ///< Whether the last response reused the cached one
+    MonitorState_t recordedState;           ///< State last added to the history
+    ContentCheck_t * contentPtr;            ///< Check of the content of the transfer, in the arena
+    bool isTooLarge;                        ///< Whether the content exceeded /maxResponseBytes
+    le_clk_Time_t parseTime;                ///< Time spent checking the content of the transfer
+    Validators_t receivedValidators;        ///< Validators received for the transfer
+    struct curl_slist *requestHeadersPtr;   ///< Conditional headers sent with the transfer
+    char nextPageToken[MAX_PAGE_TOKEN_BYTES];   ///< Token of the next page, empty if none
+    size_t pageCount;                       ///< Number of pages of the response received
+    size_t pageOffset;                      ///< Bytes of content received before the current page
+    size_t drainedBytes;                    ///< Content received after the verdict was known
+    ResponseCache_t cache;                  ///< Last full response
 }
-MonitorState_t;
+Monitor_t;
+
+// Monitors polled on each tick
+static Monitor_t Monitors[MAX_MONITORS];
+static size_t MonitorCount = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Sets the GPIO pins to active_high with respect to the light states.
- *
- * @return
- *      GPIO pins
+ * Job of a view shown as a monitor of its own, from the items of the content of the view, see
+ * ContentItem_t. The jobs follow the monitors in the towers.
  */
 //--------------------------------------------------------------------------------------------------
-static void SetLightState
-(
-    LightState_t state    ///< [IN] States of the lights.
-)
+typedef struct
 {
-    bool gpioRed = false;
-    bool gpioYellow = false;
-    bool gpioGreen = false;
-
-    switch(state)
-    {
-        case LIGHT_GREEN:
-            gpioGreen = true;
-            break;
-
-        case LIGHT_YELLOW:
-            gpioYellow = true;
-            break;
-
-        case LIGHT_RED:
-            gpioRed = true;
-            break;
-
-        case LIGHT_ON:
-            gpioGreen = true;
-            gpioYellow = true;
-            gpioRed = true;
-            break;
-
-        case LIGHT_OFF:
-            break;
+    char name[MAX_MONITOR_NAME_BYTES];      ///< "<view>/<job>", truncated if needed
+    size_t viewIndex;                       ///< Monitor of the view
+    MonitorState_t state;                   ///< Last state of the job
+    bool isInProgress;                      ///< Whether a build of the job is running
+}
+JobMonitor_t;
 
-        default:
-            break;
-    }
+// Jobs of the views, kept in the order of their views
+static JobMonitor_t Jobs[MAX_JOB_MONITORS];
+static size_t JobCount = 0;
 
-    le_gpioGreen_SetPushPullOutput(LE_GPIOGREEN_ACTIVE_HIGH, gpioGreen);
-    le_gpioYellow_SetPushPullOutput(LE_GPIOYELLOW_ACTIVE_HIGH, gpioYellow);
-    le_gpioRed_SetPushPullOutput(LE_GPIORED_ACTIVE_HIGH, gpioRed);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Poll whose transfers are running. The transfers are driven by the event loop, the poll is
+ * finished by the handler that sees its last transfer complete.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isRunning;                 ///< Whether transfers are still running
+    le_clk_Time_t startTime;        ///< Relative time the poll started at
+    size_t transferCount;           ///< Number of transfers started
+    size_t pendingCount;            ///< Number of transfers not completed yet
+    size_t failedCount;             ///< Number of transfers where the server could not be polled
+    MonitorState_t state;           ///< Worst state of the monitors so far
+    bool isInProgress;              ///< Whether a monitored job is still running
+    uint64_t receivedBytes;         ///< Bytes downloaded, compressed if the server compressed them
+    uint64_t contentBytes;          ///< Bytes of content checked, once decompressed
 }
+Poll_t;
 
+static Poll_t CurrentPoll;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shows the state of the monitors on a tower
+ */
+//--------------------------------------------------------------------------------------------------
 static void SetMonitorState
 (
-    MonitorState_t monitorState
+    size_t output,                  ///< [IN] Tower
+    MonitorState_t monitorState,    ///< [IN] State of its monitors, as computed by its rule
+    bool isInProgress               ///< [IN] Whether a job of its monitors is running
 )
 {
     LightState_t lightState;
+    LightPattern_t pattern;
     const char * monitorStateStr = "";
 
     switch(monitorState)
@@ -141,19 +371,41 @@ static void SetMonitorState
             break;
     }
 
-    LE_INFO("Monitor state: %s (%d)", monitorStateStr, monitorState);
+    LE_INFO("Monitor state on tower %zu: %s (%d)%s",
+            output + 1,
+            monitorStateStr,
+            monitorState,
+            isInProgress ? ", in progress" : "");
 
-    SetLightState(lightState);
+    if (monitorState == STATE_UNKNOWN)
+    {
+        light_Show(output, &UnknownPattern);
+    }
+    else if (isInProgress && (BuildingPattern.stepCount > 0))
+    {
+        light_Show(output, &BuildingPattern);
+    }
+    else
+    {
+        light_SetSteady(&pattern, lightState);
+        light_Show(output, &pattern);
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * 1. Takes the data from bufferPtr and allocates memory to store in userDataPtr.
+ * 1. Called by cURL each time a chunk of content is received, at most /responseBufferBytes long.
+ *    A compressed response is decompressed by cURL chunk by chunk before it gets here.
  *
- * 2. The bufferPtr data holds the HTML text.
+ * 2. Feeds the chunk to the content check of the monitor, the chunk is not kept. The transfer
+ *    fails if the state is still not known after /maxResponseBytes of a response, or of a page
+ *    of a paged response.
+ *
+ * 3. Stops the transfer once the verdict is known. If the rest of the content is small, it is
+ *    read and dropped instead so that the connection can be reused.
  *
  * @return
- *      size and information of the data that was received
+ *      size of the data handled, anything else aborts the transfer
  */
 //--------------------------------------------------------------------------------------------------
 static size_t WriteCallback
@@ -161,146 +413,155 @@ static size_t WriteCallback
     void *bufferPtr,      ///< [IN] Ptr to the string of information.
     size_t size,          ///< [IN] size of individual elements
     size_t nbMember,      ///< [IN] number of elements in bufferPtr
-    void *userDataPtr     ///< [OUT] memory containing information and size
+    void *userDataPtr     ///< [IN] monitor whose content is received
 )
 {
     size_t realsize = size * nbMember;
-    MemoryPool_t * memoryPoolPtr = (MemoryPool_t *) userDataPtr;
+    Monitor_t * monitorPtr = (Monitor_t *) userDataPtr;
+    ContentCheck_t * checkPtr = monitorPtr->contentPtr;
+    curl_off_t contentLength = -1;
+    curl_off_t receivedLength = 0;
 
-    LE_DEBUG("bufferPtr = %s. This should match myPool.actualData in the CheckUrl function", (char *) bufferPtr);
+    if (!checkPtr->isDone)
+    {
+        le_clk_Time_t startTime = le_clk_GetRelativeTime();
 
-    memoryPoolPtr->actualData = (char*) bufferPtr;
+        if (checkPtr->length - monitorPtr->pageOffset + realsize > (size_t) MaxResponseBytes)
+        {
+            monitorPtr->isTooLarge = true;
+            return 0;
+        }
 
-    return realsize;
+        contentCheck_Feed(checkPtr, (const char *) bufferPtr, realsize);
+        monitorPtr->parseTime = le_clk_Add(monitorPtr->parseTime,
+                                           le_clk_Sub(le_clk_GetRelativeTime(), startTime));
+        if (!checkPtr->isDone)
+        {
+            return realsize;
+        }
+
+        LE_DEBUG("[%s] verdict known after %zu bytes", monitorPtr->name, checkPtr->length);
+    }
+    else
+    {
+        checkPtr->length += realsize;
+        monitorPtr->drainedBytes += realsize;
+    }
+
+    // The rest of the response is drained so that the connection is kept for the next poll, unless
+    // it is more than the buffer. Both lengths are counted before decompression, as received from
+    // the server.
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+    if (contentLength >= 0)
+    {
+        curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_SIZE_DOWNLOAD_T, &receivedLength);
+        return (contentLength - receivedLength <= ResponseBufferBytes) ? realsize : 0;
+    }
+
+    // Length unknown, e.g. chunked: drained until more than the buffer was
+    return (monitorPtr->drainedBytes <= (size_t) ResponseBufferBytes) ? realsize : 0;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Check the state of a Jenkins job based on the content by the REST API <job>/<build>/api/xml
+ * Copies the value of a header line if it has the given name
  *
  * @return
- *      light states
- *      contentResult in config tree
+ *      true if the header has the given name
  */
 //--------------------------------------------------------------------------------------------------
-static MonitorState_t CheckJenkinsResult
+static bool CopyHeaderValue
 (
-    char * actualData     ///< [IN] Data that was handled in CheckUrl with WriteCallback
+    const char * linePtr,       ///< [IN] Header line, not NULL terminated
+    size_t length,              ///< [IN] Length of the line, with its CRLF
+    const char * namePtr,       ///< [IN] Name of the header with its colon, e.g. "ETag:"
+    char * valuePtr,            ///< [OUT] Value, empty if too long to fit
+    size_t valueSize            ///< [IN] Size of the value buffer
 )
 {
-    char * contentResult;
-    MonitorState_t status;
+    size_t nameLength = strlen(namePtr);
 
-    if( strstr(actualData, "SUCCESS") )
-    {
-        contentResult = "SUCCESS";
-        status = STATE_PASS;
-    }
-    else if( strstr(actualData, "FAILURE") )
+    if ( (length < nameLength) || strncasecmp(linePtr, namePtr, nameLength) )
     {
-        contentResult = "FAILURE";
-        status = STATE_FAIL;
+        return false;
     }
-    else if( strstr(actualData, "ABORTED") )
+
+    linePtr += nameLength;
+    length -= nameLength;
+
+    while ( (length > 0) && isspace((unsigned char) linePtr[0]) )
     {
-        contentResult = "ABORTED";
-        status = STATE_PASS;
+        linePtr++;
+        length--;
     }
-    else if( strstr(actualData, "UNSTABLE") )
+    while ( (length > 0) && isspace((unsigned char) linePtr[length - 1]) )
     {
-        contentResult = "UNSTABLE";
-        status = STATE_WARNING;
+        length--;
     }
-    else
+
+    if (length >= valueSize)
     {
-        contentResult = "NULL";
-        LE_ERROR("Cannot find keyword for statuses");
-        status = STATE_FAIL;
+        valuePtr[0] = '\0';
+        return true;
     }
 
-    LE_INFO("contentResult = %s", contentResult);
-
-    return status;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Takes a char array and given a character value, return the index of the array with the
- * first occurence of the value.
- */
-//--------------------------------------------------------------------------------------------------
-static int GetIndexOfArrayValue
-(
-    char * string,
-    size_t size,
-    char value
-)
-{
-    int index = 0;
-
-    while ( index < size && string[index] != value ) ++index;
+    memcpy(valuePtr, linePtr, length);
+    valuePtr[length] = '\0';
 
-    return ( index == size ? -1 : index );
+    return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Check the Sensu state based on content as returned by the '/metrics' REST API.
+ * Called by cURL for each header line received, keeps the validators of the response and the
+ * token of its next page
  *
  * @return
- *      light states
- *      contentResult in config tree
+ *      size of the data handled
  */
 //--------------------------------------------------------------------------------------------------
-static MonitorState_t CheckSensuResult
+static size_t HeaderCallback
 (
-    char * actualData     ///< [IN] Data that was handled in CheckUrl with WriteCallback
+    char *bufferPtr,      ///< [IN] Header line, not NULL terminated
+    size_t size,          ///< [IN] size of individual elements
+    size_t nbMember,      ///< [IN] number of elements in bufferPtr
+    void *userDataPtr     ///< [IN] monitor whose headers are received
 )
 {
-    int index = 0;
-    size_t length;
-    MonitorState_t state = STATE_PASS;
-
-    length = strlen(actualData);
+    size_t realsize = size * nbMember;
+    Monitor_t * monitorPtr = (Monitor_t *) userDataPtr;
+    Validators_t * validatorsPtr = &monitorPtr->receivedValidators;
+    const ContentChecker_t * checkerPtr = monitorPtr->contentPtr->checkerPtr;
 
-    while( index != -1 )
+    // Only keep the headers of the last response, in case of redirection
+    if ( (realsize >= 5) && !strncmp(bufferPtr, "HTTP/", 5) )
     {
-        index = MIN(GetIndexOfArrayValue(actualData, length, 'c'),
-                    GetIndexOfArrayValue(actualData, length, 'w'));
-
-        // Truncate string until the string starts where 'c' is
-        memmove(actualData, actualData + index, length - index + 1);
-        length = strlen(actualData);
+        validatorsPtr->etag[0] = '\0';
+        validatorsPtr->lastModified[0] = '\0';
+        monitorPtr->nextPageToken[0] = '\0';
+        return realsize;
+    }
 
-        // Check if the keyword is actually critical and find if there is a failure on the key
-        if( !strncmp(actualData, "critical", 8) )
-        {
-            // Looks to see if the key to the mapping of "critical" is 0. If not, then there is an error
-            if( actualData[10] != '0')
-            {
-                LE_INFO("There are %c machines in critical state", actualData[10]);
-                state = STATE_FAIL;
-                break;
-            }
-        }
-        // Check if the keyword is actually warning and find if there is a failure on the key
-        if( !strncmp(actualData, "warning", 7) )
-        {
-            // Looks to see if the key to the mapping of "warning" is 0. If not, then there is an error
-            if( actualData[9] != '0')
-            {
-                LE_INFO("There are %c machines in warning state", actualData[9]);
-                state = STATE_WARNING;
-                break;
-            }
-        }
+    if ( CopyHeaderValue(bufferPtr, realsize, "ETag:",
+                         validatorsPtr->etag, sizeof(validatorsPtr->etag)) ||
+         CopyHeaderValue(bufferPtr, realsize, "Last-Modified:",
+                         validatorsPtr->lastModified, sizeof(validatorsPtr->lastModified)) ||
+         (checkerPtr == NULL) || (checkerPtr->pagingPtr == NULL) )
+    {
+        return realsize;
+    }
 
-        memmove(actualData, actualData + 1, length);
-        length = strlen(actualData);
+    // Reading the first pages only would miss what the next ones have
+    if ( CopyHeaderValue(bufferPtr, realsize, checkerPtr->pagingPtr->headerPtr,
+                         monitorPtr->nextPageToken, sizeof(monitorPtr->nextPageToken)) &&
+         (monitorPtr->nextPageToken[0] == '\0') &&
+         (realsize > strlen(checkerPtr->pagingPtr->headerPtr) + sizeof("\r\n")) )
+    {
+        LE_ERROR("[%s] Token of the next page too long, the next pages are not read",
+                 monitorPtr->name);
     }
 
-    LE_INFO("Sensu state: %d", state);
-    return state;
+    return realsize;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -316,12 +577,12 @@ static MonitorState_t GetHTTPCode
     CURL *curlPtr                     ///< [IN] curlPtr handle to perform curl functions
 )
 {
-    int httpCode;
+    long httpCode = 0;
     MonitorState_t status;
 
     curl_easy_getinfo(curlPtr, CURLINFO_RESPONSE_CODE, &httpCode);
 
-    LE_INFO("exitCodeExpected (httpCode): %i", httpCode);
+    LE_INFO("exitCodeExpected (httpCode): %li", httpCode);
 
     if(httpCode == 200)
     {
@@ -337,284 +598,2114 @@ static MonitorState_t GetHTTPCode
 
 //--------------------------------------------------------------------------------------------------
 /**
- * 1. Called by Polling function
- *
- * 2. Tries to check the Url that is set in the config tree and store content into buffer
- *
- * 3. Calls functions to display light depending on the boolean values of exitCodeCheck and contentCheck
+ * Reads the keywords of a content check from info/content/keywords, by priority order. Each one
+ * has a keyword and the state it leads to: "pass", "warning" or "fail".
  */
 //--------------------------------------------------------------------------------------------------
-static void CheckUrl
+static void ReadContentKeywords
 (
-    void
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator on the node of the monitor
+    const char * name,                  ///< [IN] Name used in logs
+    ContentCheckParams_t * paramsPtr    ///< [OUT] Settings to fill
 )
 {
-    char url[MAX_URL_BYTES] = "";
-
-    CURL *curlPtr;                          ///<- Easy handle necessary for curl functions
-    CURLcode res;                           ///<- Stores results of curl functions
-
-    MemoryPool_t myPool;
-
-    MonitorState_t exitCodeState = STATE_PASS;
-    MonitorState_t contentState = STATE_PASS;
-
-    // Get Url from config Tree
-    le_cfg_QuickGetString("/url", url, sizeof(url), "");
-
-    LE_INFO("Url: %s", url);
-    if (url[0] == '\0')
-    {
-        LE_WARN("URL not set, skipping");
-        return;
-    }
-
-    // Curl Operations
-    curlPtr = curl_easy_init();
-    if (curlPtr)
+    le_cfg_GoToNode(iteratorRef, "info/content/keywords");
+    if (le_cfg_GoToFirstChild(iteratorRef) == LE_OK)
     {
-        curl_easy_setopt(curlPtr, CURLOPT_URL, url);
-
-        //Write data into actualData. The conditionals check for errors
-        res = curl_easy_setopt(curlPtr, CURLOPT_WRITEFUNCTION, WriteCallback);
-        if( res == CURLE_WRITE_ERROR)
-        {
-            LE_ERROR("curlopt_writefunction failed: %s", curl_easy_strerror(res));
-        }
-
-        // Create a memory pool to store the htmlString. If exists, do not create anymore duplicates
-        if( !le_mem_FindPool("htmlString") )
+        do
         {
-            LE_DEBUG("Created local memory pool 'htmlString'");
-            PoolRef = le_mem_CreatePool("htmlString", sizeof(MemoryPool_t));
-        }
-        myPool.actualData = le_mem_ForceAlloc(PoolRef);
+            ContentKeyword_t * keywordPtr = &paramsPtr->keywords[paramsPtr->keywordCount];
+            char state[MAX_CHECK_MODE_BYTES] = "";
 
-        res = curl_easy_setopt(curlPtr, CURLOPT_WRITEDATA, (void *) &myPool);
-        if( res != CURLE_OK)
-        {
-            LE_ERROR("curlopt_writedata failed: %s", curl_easy_strerror(res));
+            if (paramsPtr->keywordCount >= MAX_CONTENT_KEYWORDS)
+            {
+                LE_WARN("[%s] Too many keywords, only the first %d are looked for",
+                        name,
+                        MAX_CONTENT_KEYWORDS);
+                break;
+            }
 
-            SetMonitorState(STATE_WARNING);
-        }
+            le_cfg_GetString(iteratorRef,
+                             "keyword",
+                             keywordPtr->keyword,
+                             sizeof(keywordPtr->keyword),
+                             "");
+            le_cfg_GetString(iteratorRef, "state", state, sizeof(state), "");
 
-        res = curl_easy_perform(curlPtr);
-        if (res != CURLE_OK)
-        {
-            LE_ERROR("curl_easy_perform() failed: %s", curl_easy_strerror(res));
-            if (res == CURLE_SSL_CACERT)
+            if (strcmp(state, "pass") == 0)
             {
-                LE_ERROR("Make sure your system date is set correctly (e.g. `date -s '2016-7-7'`)");
-                LE_ERROR("Check the minimum date for this SSL cert to work");
+                keywordPtr->state = STATE_PASS;
             }
-
-            SetMonitorState(STATE_WARNING);
-        }
-        else
-        {
-            // States are described in README.md
-            if(le_cfg_QuickGetBool("/info/exitCode/checkFlag", false))
+            else if (strcmp(state, "warning") == 0)
             {
-                exitCodeState = GetHTTPCode(curlPtr);
+                keywordPtr->state = STATE_WARNING;
             }
-
-            if(le_cfg_QuickGetBool("/info/content/checkFlag", false))
+            else if (strcmp(state, "fail") == 0)
+            {
+                keywordPtr->state = STATE_FAIL;
+            }
+            else
             {
-                if( myPool.actualData[strlen(myPool.actualData)] != '\0')
-                {
-                    contentState = STATE_FAIL;
-                    LE_ERROR("There is no NULL char at the end of the buffer");
-                }
-                else
-                {
-                    char checkMode[256] = {0};
-
-                    le_cfg_QuickGetString("/info/content/checkMode",
-                                          checkMode,
-                                          sizeof(checkMode),
-                                          "");
-
-                    if(strncmp(checkMode, "sensu", sizeof(checkMode)) == 0)
-                    {
-                        contentState = CheckSensuResult(myPool.actualData);
-                    }
-                    else if(strncmp(checkMode, "jenkins", sizeof(checkMode)) == 0)
-                    {
-                        contentState = CheckJenkinsResult(myPool.actualData);
-                    }
-                    else
-                    {
-                        LE_ERROR("Not checking Sensu-client or jenkins job");
-                    }
-                }
+                LE_WARN("[%s] Invalid state '%s' of keyword '%s', ignoring it",
+                        name,
+                        state,
+                        keywordPtr->keyword);
+                memset(keywordPtr, 0, sizeof(ContentKeyword_t));
+                continue;
             }
 
-            SetMonitorState( MIN(exitCodeState, contentState) );
+            paramsPtr->keywordCount++;
         }
+        while (le_cfg_GoToNextSibling(iteratorRef) == LE_OK);
 
-        curl_easy_cleanup(curlPtr);
+        le_cfg_GoToParent(iteratorRef);
     }
-    else
+    le_cfg_GoToNode(iteratorRef, "../../..");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the authorization of a monitor, and makes the header line sent with its requests
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadAuthorization
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator on the node of the monitor
+    const char * name,                  ///< [IN] Name used in logs
+    char * headerPtr,                   ///< [OUT] Header line, empty if not set
+    size_t headerSize                   ///< [IN] Size of the header buffer
+)
+{
+    char value[MAX_AUTHORIZATION_BYTES] = "";
+    int written;
+
+    headerPtr[0] = '\0';
+
+    le_cfg_GetString(iteratorRef, "authorization", value, sizeof(value), "");
+    if (value[0] == '\0')
     {
-        LE_ERROR("Couldn't initialize cURL.");
+        return;
     }
 
-    curl_global_cleanup();
+    written = snprintf(headerPtr, headerSize, "Authorization: %s", value);
+    if ( (written < 0) || ((size_t) written >= headerSize) )
+    {
+        LE_ERROR("[%s] authorization too long, not sent", name);
+        headerPtr[0] = '\0';
+    }
 }
 
-
 //--------------------------------------------------------------------------------------------------
 /**
- * Initializes IoT pins 13, 15, 17 (green, yellow, red respectively) for output
+ * Reads the settings of a monitor, relative to the node the iterator is on.
  *
- * @return
- *      Activated pins and initialize light to be off
+ * The layout is the same for /monitors/<n> and for the root of the config tree:
+ *  - url
+ *  - authorization, sent as the Authorization header, e.g. "Key <API key>" for Sensu Go
+ *  - info/exitCode/checkFlag
+ *  - info/content/checkFlag
+ *  - info/content/checkMode
+ *  - info/content/path, info/content/value, info/content/warningThreshold and
+ *    info/content/criticalThreshold, depending on the checkMode
+ *  - info/content/keywords, info/content/anchor and info/content/anchorEnd for the keywords
+ *  - info/content/labelSelector, info/content/fieldSelector and info/content/pageSize for the
+ *    APIs filtering and paging their items on the server
  */
 //--------------------------------------------------------------------------------------------------
-static void GpioInit
+static void ReadMonitorConfig
 (
-    void
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator on the node of the monitor
+    const char * name,                  ///< [IN] Name used in logs
+    Monitor_t * monitorPtr              ///< [OUT] Monitor to fill
 )
 {
-    le_gpioRed_Activate();
-    le_gpioRed_EnablePullUp();
+    char url[MAX_URL_BYTES] = "";
+    char authorization[MAX_AUTHORIZATION_BYTES] = "";
+    char checkMode[MAX_CHECK_MODE_BYTES] = "";
+    const ContentChecker_t * checkerPtr;
+    ContentCheckParams_t contentParams;
+    bool exitCodeCheck;
+    bool contentCheck;
+
+    le_cfg_GetString(iteratorRef, "url", url, sizeof(url), "");
+    ReadAuthorization(iteratorRef, name, authorization, sizeof(authorization));
+    exitCodeCheck = le_cfg_GetBool(iteratorRef, "info/exitCode/checkFlag", false);
+    contentCheck = le_cfg_GetBool(iteratorRef, "info/content/checkFlag", false);
+    le_cfg_GetString(iteratorRef, "info/content/checkMode", checkMode, sizeof(checkMode), "");
+
+    memset(&contentParams, 0, sizeof(contentParams));
+    le_cfg_GetString(iteratorRef,
+                     "info/content/path",
+                     contentParams.path,
+                     sizeof(contentParams.path),
+                     "");
+    le_cfg_GetString(iteratorRef,
+                     "info/content/value",
+                     contentParams.value,
+                     sizeof(contentParams.value),
+                     "");
+    contentParams.warningThreshold = le_cfg_GetFloat(iteratorRef,
+                                                     "info/content/warningThreshold",
+                                                     NAN);
+    contentParams.criticalThreshold = le_cfg_GetFloat(iteratorRef,
+                                                      "info/content/criticalThreshold",
+                                                      NAN);
+    le_cfg_GetString(iteratorRef,
+                     "info/content/anchor",
+                     contentParams.anchor,
+                     sizeof(contentParams.anchor),
+                     "");
+    le_cfg_GetString(iteratorRef,
+                     "info/content/anchorEnd",
+                     contentParams.anchorEnd,
+                     sizeof(contentParams.anchorEnd),
+                     "");
+    le_cfg_GetString(iteratorRef,
+                     "info/content/labelSelector",
+                     contentParams.labelSelector,
+                     sizeof(contentParams.labelSelector),
+                     "");
+    le_cfg_GetString(iteratorRef,
+                     "info/content/fieldSelector",
+                     contentParams.fieldSelector,
+                     sizeof(contentParams.fieldSelector),
+                     "");
+    contentParams.pageSize = le_cfg_GetInt(iteratorRef,
+                                           "info/content/pageSize",
+                                           DEFAULT_CONTENT_PAGE_SIZE);
+    if (contentParams.pageSize <= 0)
+    {
+        LE_WARN("[%s] Invalid info/content/pageSize %" PRId32 ", using %d",
+                name,
+                contentParams.pageSize,
+                DEFAULT_CONTENT_PAGE_SIZE);
+        contentParams.pageSize = DEFAULT_CONTENT_PAGE_SIZE;
+    }
+    ReadContentKeywords(iteratorRef, name, &contentParams);
 
-    le_gpioYellow_Activate();
-    le_gpioYellow_EnablePullUp();
+    checkerPtr = contentCheck_GetChecker(checkMode);
+    if (contentCheck && (checkerPtr == NULL))
+    {
+        LE_ERROR("[%s] Unknown checkMode '%s', not checking the content", name, checkMode);
+    }
 
-    le_gpioGreen_Activate();
-    le_gpioGreen_EnablePullUp();
+    if ( contentCheck && checkerPtr &&
+         (contentCheck_Prepare(checkerPtr, &contentParams) != LE_OK) )
+    {
+        LE_ERROR("[%s] Cannot prepare the content check", name);
+    }
+
+    // e.g. a Jenkins view is queried for the fields its check reads only
+    if ( contentCheck &&
+         (contentCheck_CompleteUrl(checkerPtr, &contentParams, url, sizeof(url)) != LE_OK) )
+    {
+        LE_ERROR("[%s] URL too long to add the API of checkMode '%s'", name, checkMode);
+    }
 
-    SetMonitorState(LIGHT_OFF);
+    // A new monitor in this slot: its transitions go on from its last one in the history
+    if (strcmp(monitorPtr->name, name))
+    {
+        monitorPtr->recordedState = history_GetLastState(name);
+    }
 
-    LE_DEBUG("RED read PP - High: %d", le_gpioRed_Read());
-    LE_DEBUG("YELLOW read PP - High: %d", le_gpioYellow_Read());
-    LE_DEBUG("GREEN read PP - High: %d", le_gpioGreen_Read());
+    // The last response can only be reused for the same request and the same checks. Both settings
+    // are prepared the same way, their configured values are what is compared.
+    if ( strcmp(monitorPtr->name, name) ||
+         strcmp(monitorPtr->url, url) ||
+         strcmp(monitorPtr->authorization, authorization) ||
+         (monitorPtr->checkerPtr != checkerPtr) ||
+         !contentCheck_IsSameSettings(&monitorPtr->contentParams, &contentParams) ||
+         (monitorPtr->exitCodeCheck != exitCodeCheck) ||
+         (monitorPtr->contentCheck != contentCheck) )
+    {
+        monitorPtr->cache.isValid = false;
+    }
+
+    snprintf(monitorPtr->name, sizeof(monitorPtr->name), "%s", name);
+    snprintf(monitorPtr->url, sizeof(monitorPtr->url), "%s", url);
+    snprintf(monitorPtr->authorization, sizeof(monitorPtr->authorization), "%s", authorization);
+    monitorPtr->checkerPtr = checkerPtr;
+    contentCheck_Release(&monitorPtr->contentParams);
+    monitorPtr->contentParams = contentParams;
+    monitorPtr->exitCodeCheck = exitCodeCheck;
+    monitorPtr->contentCheck = contentCheck;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Deactivate any active pins that are set currently so that the GPIO pins are usable
+ * Compiles the rules of the towers against the monitors and the jobs of the views, and sets their
+ * last states
  */
 //--------------------------------------------------------------------------------------------------
-static void GpioDeinit
+static void LoadTowers
 (
     void
 )
 {
-    le_gpioGreen_Deactivate();
-    le_gpioYellow_Deactivate();
-    le_gpioRed_Deactivate();
+    const char * namePtrs[MAX_MONITORS + MAX_JOB_MONITORS];
+    size_t i;
+
+    for (i = 0; i < MonitorCount; i++)
+    {
+        namePtrs[i] = Monitors[i].name;
+    }
+    for (i = 0; i < JobCount; i++)
+    {
+        namePtrs[MonitorCount + i] = Jobs[i].name;
+    }
+    tower_Load(namePtrs, MonitorCount + JobCount);
+
+    // The towers go on from the last state of the monitors they show
+    for (i = 0; i < MonitorCount; i++)
+    {
+        tower_SetMonitorState(i, Monitors[i].recordedState, Monitors[i].isInProgress);
+    }
+    for (i = 0; i < JobCount; i++)
+    {
+        tower_SetMonitorState(MonitorCount + i, Jobs[i].state, Jobs[i].isInProgress);
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * 1. Initialize the indefinitely repeating PollingTimer to x seconds
- *
- * 2. Reset polling interval from Polling function
- *
- * @return
- *      A timer reference PollingTimer
+ * Removes the jobs of a view, or of the views that are no longer monitored
  */
 //--------------------------------------------------------------------------------------------------
-static void TimerHandle
+static void RemoveJobs
 (
-    void
+    size_t viewIndex                ///< [IN] Monitor of the view, MAX_MONITORS for the views gone
 )
 {
-    if(le_timer_IsRunning(PollingTimer))
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < JobCount; i++)
     {
-        le_timer_Stop(PollingTimer);
+        if ( (viewIndex < MAX_MONITORS) ? (Jobs[i].viewIndex != viewIndex) :
+                                          (Jobs[i].viewIndex < MonitorCount) )
+        {
+            Jobs[count++] = Jobs[i];
+        }
     }
-    LE_DEBUG("pollingIntervalSec is %i", PollingIntervalSec);
-    le_clk_Time_t interval = {PollingIntervalSec, 0}; // first parameter is the seconds
-    le_timer_SetInterval(PollingTimer, interval);
-    le_timer_SetRepeat(PollingTimer, 0); // repeat indefinitely
-    le_timer_SetHandler(PollingTimer, Polling);
-    le_timer_Start(PollingTimer);
+    JobCount = count;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function is called every x seconds where x can be set in the configTree.
- *
- * eg. config set trafficLight:/pollingIntervalSec 10 int
+ * Sets the state of all the jobs of a view, e.g. when the view could not be polled
  */
 //--------------------------------------------------------------------------------------------------
-static void Polling
+static void SetJobStates
 (
-    le_timer_Ref_t timerRef      ///< [IN] timer reference for changing intervals, starting and stopping
+    size_t viewIndex,               ///< [IN] Monitor of the view
+    MonitorState_t state            ///< [IN] State of its jobs
 )
 {
-    int timerSet;
+    size_t i;
 
-    timerSet = le_cfg_QuickGetInt("/pollingIntervalSec", PollingIntervalSec);
+    for (i = 0; i < JobCount; i++)
+    {
+        if (Jobs[i].viewIndex == viewIndex)
+        {
+            Jobs[i].state = state;
+            Jobs[i].isInProgress = false;
+            tower_SetMonitorState(MonitorCount + i, state, false);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name a job of a view is shown as a monitor with, "<view>/<job>"
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetJobName
+(
+    const Monitor_t * monitorPtr,   ///< [IN] Monitor of the view
+    const ContentItem_t * itemPtr,  ///< [IN] Job, as read from the content of the view
+    char * namePtr                  ///< [OUT] Name, of MAX_MONITOR_NAME_BYTES
+)
+{
+    int length = snprintf(namePtr,
+                          MAX_MONITOR_NAME_BYTES,
+                          "%s/%s",
+                          monitorPtr->name,
+                          itemPtr->name);
+
+    if (length >= MAX_MONITOR_NAME_BYTES)
+    {
+        LE_DEBUG("[%s] Name of job '%s' truncated", monitorPtr->name, itemPtr->name);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Updates the jobs of a view once its transfer is done. Their states are those of the items of its
+ * content, or the state of the view if no content was checked, e.g. when the server did not
+ * answer. When the jobs of the view changed, the rules of the towers are compiled again.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateJobs
+(
+    Monitor_t * monitorPtr,         ///< [IN] Monitor whose transfer is done
+    MonitorState_t state            ///< [IN] Its state
+)
+{
+    size_t viewIndex = monitorPtr - Monitors;
+    const ContentItem_t * itemsPtr = NULL;
+    size_t itemCount = 0;
+    size_t firstIndex = JobCount;
+    size_t jobCount = 0;
+    size_t i;
+
+    // The jobs of a view that did not change are as they were
+    if (monitorPtr->isNotModified)
+    {
+        return;
+    }
+
+    if (monitorPtr->contentCheck && (monitorPtr->httpCode == 200))
+    {
+        itemsPtr = contentCheck_GetItems(monitorPtr->contentPtr, &itemCount);
+    }
+
+    if (itemCount == 0)
+    {
+        SetJobStates(viewIndex, state);
+        return;
+    }
+
+    // The jobs of a view follow each other
+    for (i = 0; i < JobCount; i++)
+    {
+        if (Jobs[i].viewIndex == viewIndex)
+        {
+            firstIndex = MIN(firstIndex, i);
+            jobCount++;
+        }
+    }
+
+    for (i = 0; (i < itemCount) && (jobCount == itemCount); i++)
+    {
+        char name[MAX_MONITOR_NAME_BYTES];
+
+        GetJobName(monitorPtr, &itemsPtr[i], name);
+        if (strcmp(Jobs[firstIndex + i].name, name) != 0)
+        {
+            jobCount = 0;
+        }
+    }
+
+    // Same jobs: only their states changed
+    if (jobCount == itemCount)
+    {
+        for (i = 0; i < itemCount; i++)
+        {
+            JobMonitor_t * jobPtr = &Jobs[firstIndex + i];
+
+            jobPtr->state = itemsPtr[i].state;
+            jobPtr->isInProgress = itemsPtr[i].isInProgress;
+            tower_SetMonitorState(MonitorCount + firstIndex + i,
+                                  jobPtr->state,
+                                  jobPtr->isInProgress);
+        }
+        return;
+    }
+
+    RemoveJobs(viewIndex);
+    for (i = 0; i < itemCount; i++)
+    {
+        JobMonitor_t * jobPtr = &Jobs[JobCount];
+
+        if (JobCount >= MAX_JOB_MONITORS)
+        {
+            LE_WARN("[%s] Too many jobs, only %d are shown as monitors",
+                    monitorPtr->name,
+                    MAX_JOB_MONITORS);
+            break;
+        }
+
+        GetJobName(monitorPtr, &itemsPtr[i], jobPtr->name);
+        jobPtr->viewIndex = viewIndex;
+        jobPtr->state = itemsPtr[i].state;
+        jobPtr->isInProgress = itemsPtr[i].isInProgress;
+        JobCount++;
+    }
+
+    LE_INFO("[%s] %zu job(s) shown as monitors", monitorPtr->name, itemCount);
+    LoadTowers();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Loads the list of monitors from /monitors. If the list is empty, the settings at the root of the
+ * config tree (/url, /info/...) are used as a single monitor.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadMonitors
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iteratorRef;
+    size_t i;
+    size_t j;
+
+    MonitorCount = 0;
+
+    iteratorRef = le_cfg_CreateReadTxn("/monitors");
+    if (le_cfg_GoToFirstChild(iteratorRef) == LE_OK)
+    {
+        do
+        {
+            char name[MAX_MONITOR_NAME_BYTES] = "";
+
+            if (MonitorCount >= MAX_MONITORS)
+            {
+                LE_WARN("Too many monitors, only the first %d are polled", MAX_MONITORS);
+                break;
+            }
+
+            le_cfg_GetNodeName(iteratorRef, "", name, sizeof(name));
+            ReadMonitorConfig(iteratorRef, name, &Monitors[MonitorCount]);
+            MonitorCount++;
+        }
+        while (le_cfg_GoToNextSibling(iteratorRef) == LE_OK);
+    }
+    le_cfg_CancelTxn(iteratorRef);
+
+    if (MonitorCount == 0)
+    {
+        iteratorRef = le_cfg_CreateReadTxn("/");
+        ReadMonitorConfig(iteratorRef, "default", &Monitors[0]);
+        le_cfg_CancelTxn(iteratorRef);
+        MonitorCount = 1;
+    }
+
+    // Release the easy handles and the automata of the monitors that were removed
+    for (i = MonitorCount; i < MAX_MONITORS; i++)
+    {
+        if (Monitors[i].curlPtr)
+        {
+            curl_easy_cleanup(Monitors[i].curlPtr);
+            Monitors[i].curlPtr = NULL;
+        }
+        contentCheck_Release(&Monitors[i].contentParams);
+    }
+
+    // The jobs of the views still monitored are kept until the views are polled again, which
+    // may only tell that they did not change
+    for (i = 0; i < JobCount; i++)
+    {
+        size_t length = strcspn(Jobs[i].name, "/");
+
+        Jobs[i].viewIndex = MAX_MONITORS;
+        for (j = 0; j < MonitorCount; j++)
+        {
+            if ( (strlen(Monitors[j].name) == length) &&
+                 (strncmp(Monitors[j].name, Jobs[i].name, length) == 0) &&
+                 Monitors[j].contentCheck )
+            {
+                Jobs[i].viewIndex = j;
+                break;
+            }
+        }
+    }
+    RemoveJobs(MAX_MONITORS);
+
+    LoadTowers();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads a light pattern, see light_ParsePattern for its syntax
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadPattern
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator on the root of the config tree
+    const char * pathPtr,               ///< [IN] Path of the pattern
+    const char * defaultPtr,            ///< [IN] Pattern used when not set or invalid
+    LightPattern_t * patternPtr         ///< [OUT] Pattern
+)
+{
+    char description[MAX_LIGHT_PATTERN_BYTES] = {0};
+
+    le_cfg_GetString(iteratorRef, pathPtr, description, sizeof(description), defaultPtr);
+
+    if (light_ParsePattern(description, patternPtr) != LE_OK)
+    {
+        LE_WARN("%s '%s' is not a valid pattern, using '%s'", pathPtr, description, defaultPtr);
+        light_ParsePattern(defaultPtr, patternPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the default size of the memory of the polls: every monitor polled with the largest check
+ * registered, and its headers
+ *
+ * @return
+ *      Size of the poll arena, in bytes
+ */
+//--------------------------------------------------------------------------------------------------
+static long GetDefaultPollArenaBytes
+(
+    void
+)
+{
+    return MAX_MONITORS * (long) (contentCheck_GetMaxSize() + POLL_ARENA_HEADER_BYTES);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the settings from the config tree. This is the only place the config tree is read from.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadConfig
+(
+    void
+)
+{
+    le_cfg_IteratorRef_t iteratorRef = le_cfg_CreateReadTxn("/");
+    char dataChannel[LE_DCS_CHANNEL_NAME_MAX_LEN + 1];
+    char fallbackDataChannel[LE_DCS_CHANNEL_NAME_MAX_LEN + 1];
+    char streamUrl[MAX_URL_BYTES];
+    char streamEvent[MAX_VALIDATOR_BYTES];
+    int streamIdleTimeoutSec;
+    int streamRetrySec;
+
+    PollingIntervalSec = le_cfg_GetInt(iteratorRef,
+                                       "pollingIntervalSec",
+                                       DEFAULT_POLLING_INTERVAL_SEC);
+    if (PollingIntervalSec <= 0)
+    {
+        LE_WARN("pollingIntervalSec %i is not positive, using %d",
+                PollingIntervalSec,
+                DEFAULT_POLLING_INTERVAL_SEC);
+        PollingIntervalSec = DEFAULT_POLLING_INTERVAL_SEC;
+    }
+
+    ResponseBufferBytes = le_cfg_GetInt(iteratorRef,
+                                        "responseBufferBytes",
+                                        DEFAULT_RESPONSE_BUFFER_BYTES);
+    if ( (ResponseBufferBytes < MIN_RESPONSE_BUFFER_BYTES) ||
+         (ResponseBufferBytes > MAX_RESPONSE_BUFFER_BYTES) )
+    {
+        LE_WARN("responseBufferBytes %li out of range [%d, %d], using %d",
+                ResponseBufferBytes,
+                MIN_RESPONSE_BUFFER_BYTES,
+                MAX_RESPONSE_BUFFER_BYTES,
+                DEFAULT_RESPONSE_BUFFER_BYTES);
+        ResponseBufferBytes = DEFAULT_RESPONSE_BUFFER_BYTES;
+    }
+
+    PollArenaBytes = le_cfg_GetInt(iteratorRef, "pollArenaBytes", GetDefaultPollArenaBytes());
+    if ( (PollArenaBytes < MIN_POLL_ARENA_BYTES) || (PollArenaBytes > MAX_POLL_ARENA_BYTES) )
+    {
+        LE_WARN("pollArenaBytes %li out of range [%d, %d], using %li",
+                PollArenaBytes,
+                MIN_POLL_ARENA_BYTES,
+                MAX_POLL_ARENA_BYTES,
+                GetDefaultPollArenaBytes());
+        PollArenaBytes = GetDefaultPollArenaBytes();
+    }
+    if ( (pollArena_GetSize() != 0) && (pollArena_GetSize() != (size_t) PollArenaBytes) )
+    {
+        LE_WARN("pollArenaBytes %li applies after a restart, keeping %zu",
+                PollArenaBytes,
+                pollArena_GetSize());
+    }
+    pollArena_Init(PollArenaBytes);
+
+    MaxResponseBytes = le_cfg_GetInt(iteratorRef, "maxResponseBytes", DEFAULT_MAX_RESPONSE_BYTES);
+    if (MaxResponseBytes <= 0)
+    {
+        LE_WARN("maxResponseBytes %li is not positive, using %d",
+                MaxResponseBytes,
+                DEFAULT_MAX_RESPONSE_BYTES);
+        MaxResponseBytes = DEFAULT_MAX_RESPONSE_BYTES;
+    }
+
+    Compression = le_cfg_GetBool(iteratorRef, "compression", true);
+
+    AdaptivePolling = le_cfg_GetBool(iteratorRef, "adaptivePolling", false);
+    BackoffMaxSec = le_cfg_GetInt(iteratorRef, "backoffMaxSec", DEFAULT_BACKOFF_MAX_SEC);
+    BurstIntervalSec = le_cfg_GetInt(iteratorRef, "burstIntervalSec", DEFAULT_BURST_INTERVAL_SEC);
+    BurstPollCount = le_cfg_GetInt(iteratorRef, "burstPollCount", DEFAULT_BURST_POLL_COUNT);
+    JitterPercent = le_cfg_GetInt(iteratorRef, "jitterPercent", DEFAULT_JITTER_PERCENT);
+
+    BackoffMaxSec = MAX(BackoffMaxSec, PollingIntervalSec);
+    BurstIntervalSec = MAX(BurstIntervalSec, 1);
+    BurstPollCount = MAX(BurstPollCount, 0);
+    JitterPercent = MIN(MAX(JitterPercent, 0), 100);
+
+    ConnectTimeoutSec = le_cfg_GetInt(iteratorRef,
+                                      "connectTimeoutSec",
+                                      DEFAULT_CONNECT_TIMEOUT_SEC);
+    TransferTimeoutSec = le_cfg_GetInt(iteratorRef,
+                                       "transferTimeoutSec",
+                                       DEFAULT_TRANSFER_TIMEOUT_SEC);
+    if (ConnectTimeoutSec <= 0)
+    {
+        LE_WARN("connectTimeoutSec %li is not positive, using %d",
+                ConnectTimeoutSec,
+                DEFAULT_CONNECT_TIMEOUT_SEC);
+        ConnectTimeoutSec = DEFAULT_CONNECT_TIMEOUT_SEC;
+    }
+    if (TransferTimeoutSec <= 0)
+    {
+        LE_WARN("transferTimeoutSec %li is not positive, using %d",
+                TransferTimeoutSec,
+                DEFAULT_TRANSFER_TIMEOUT_SEC);
+        TransferTimeoutSec = DEFAULT_TRANSFER_TIMEOUT_SEC;
+    }
+
+    LoadPattern(iteratorRef, "patterns/unknown", DEFAULT_UNKNOWN_PATTERN, &UnknownPattern);
+    LoadPattern(iteratorRef, "patterns/building", "", &BuildingPattern);
+    LoadPattern(iteratorRef, "patterns/linkDown", "", &LinkDownPattern);
+
+    StatsPublishIntervalSec = le_cfg_GetInt(iteratorRef,
+                                            "statsPublishIntervalSec",
+                                            DEFAULT_STATS_PUBLISH_INTERVAL_SEC);
+
+    history_SetFlushPolicy(le_cfg_GetInt(iteratorRef,
+                                         "historyFlushCount",
+                                         DEFAULT_HISTORY_FLUSH_COUNT),
+                           le_cfg_GetInt(iteratorRef,
+                                         "historyFlushIntervalSec",
+                                         DEFAULT_HISTORY_FLUSH_INTERVAL_SEC));
+
+    power_SetLowPower(le_cfg_GetBool(iteratorRef, "lowPower", false));
+
+    le_cfg_GetString(iteratorRef, "dataChannel", dataChannel, sizeof(dataChannel), "");
+    le_cfg_GetString(iteratorRef,
+                     "fallbackDataChannel",
+                     fallbackDataChannel,
+                     sizeof(fallbackDataChannel),
+                     "");
+
+    le_cfg_GetString(iteratorRef, "streamUrl", streamUrl, sizeof(streamUrl), "");
+    le_cfg_GetString(iteratorRef, "streamEvent", streamEvent, sizeof(streamEvent), "");
+    streamIdleTimeoutSec = le_cfg_GetInt(iteratorRef,
+                                         "streamIdleTimeoutSec",
+                                         DEFAULT_STREAM_IDLE_TIMEOUT_SEC);
+    if (streamIdleTimeoutSec <= 0)
+    {
+        LE_WARN("streamIdleTimeoutSec %i is not positive, using %d",
+                streamIdleTimeoutSec,
+                DEFAULT_STREAM_IDLE_TIMEOUT_SEC);
+        streamIdleTimeoutSec = DEFAULT_STREAM_IDLE_TIMEOUT_SEC;
+    }
+    streamRetrySec = le_cfg_GetInt(iteratorRef, "streamRetrySec", DEFAULT_STREAM_RETRY_SEC);
+    if (streamRetrySec <= 0)
+    {
+        LE_WARN("streamRetrySec %i is not positive, using %d",
+                streamRetrySec,
+                DEFAULT_STREAM_RETRY_SEC);
+        streamRetrySec = DEFAULT_STREAM_RETRY_SEC;
+    }
+
+    le_cfg_CancelTxn(iteratorRef);
+
+    LoadMonitors();
+
+    // A stream whose settings changed is connected again, see ApplyConfig
+    stream_SetSettings(streamUrl,
+                       streamEvent,
+                       ConnectTimeoutSec,
+                       streamIdleTimeoutSec,
+                       streamRetrySec);
+
+    // Polling restarts with the new settings, see ApplyConfig
+    dataLink_SetChannels(dataChannel, fallbackDataChannel);
+
+    LE_INFO("Config loaded: %zu monitor(s), polling every %i s", MonitorCount, PollingIntervalSec);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the easy handle of a monitor. The handle is kept across polls so that the connection,
+ * the TLS session and the resolved address can be reused.
+ *
+ * @return
+ *      Easy handle, NULL on error
+ */
+//--------------------------------------------------------------------------------------------------
+static CURL * CreateEasyHandle
+(
+    Monitor_t * monitorPtr      ///< [IN] Monitor the handle belongs to
+)
+{
+    CURL *curlPtr;                          ///<- Easy handle necessary for curl functions
+    CURLcode res;                           ///<- Stores results of curl functions
+
+    curlPtr = curl_easy_init();
+    if (!curlPtr)
+    {
+        LE_ERROR("Couldn't initialize cURL.");
+        return NULL;
+    }
+
+    curl_easy_setopt(curlPtr, CURLOPT_PRIVATE, monitorPtr);
+
+    // Feed the content to the check of the monitor. The conditionals check for errors
+    res = curl_easy_setopt(curlPtr, CURLOPT_WRITEFUNCTION, WriteCallback);
+    if( res == CURLE_WRITE_ERROR)
+    {
+        LE_ERROR("curlopt_writefunction failed: %s", curl_easy_strerror(res));
+    }
+
+    res = curl_easy_setopt(curlPtr, CURLOPT_WRITEDATA, (void *) monitorPtr);
+    if( res != CURLE_OK)
+    {
+        LE_ERROR("curlopt_writedata failed: %s", curl_easy_strerror(res));
+        curl_easy_cleanup(curlPtr);
+        return NULL;
+    }
+
+    // Keep the validators of the response for the next conditional request
+    curl_easy_setopt(curlPtr, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curlPtr, CURLOPT_HEADERDATA, (void *) monitorPtr);
+
+    // Keep the connection and what it took to open it for the next polls
+    curl_easy_setopt(curlPtr, CURLOPT_SHARE, SharePtr);
+    curl_easy_setopt(curlPtr, CURLOPT_DNS_CACHE_TIMEOUT, (long) DNS_CACHE_TIMEOUT_SEC);
+    curl_easy_setopt(curlPtr, CURLOPT_SSL_SESSIONID_CACHE, 1L);
+    curl_easy_setopt(curlPtr, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curlPtr, CURLOPT_TCP_KEEPIDLE, (long) TCP_KEEPALIVE_IDLE_SEC);
+    curl_easy_setopt(curlPtr, CURLOPT_TCP_KEEPINTVL, (long) TCP_KEEPALIVE_INTERVAL_SEC);
+
+    return curlPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a header to the request of a monitor. It is allocated in the poll arena.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddRequestHeader
+(
+    Monitor_t * monitorPtr,     ///< [IN] Monitor to poll
+    const char * namePtr,       ///< [IN] Name of the header
+    const char * valuePtr       ///< [IN] Value of the header
+)
+{
+    size_t headerSize = strlen(namePtr) + strlen(valuePtr) + sizeof(": ");
+    struct curl_slist *itemPtr = pollArena_Alloc(sizeof(struct curl_slist));
+    char *headerPtr = pollArena_Alloc(headerSize);
+
+    if ( (itemPtr == NULL) || (headerPtr == NULL) )
+    {
+        LE_WARN("[%s] Poll arena full, %s not sent", monitorPtr->name, namePtr);
+        return;
+    }
+
+    // cURL only reads the list, it can be built in the arena instead of with curl_slist_append
+    snprintf(headerPtr, headerSize, "%s: %s", namePtr, valuePtr);
+    itemPtr->data = headerPtr;
+    itemPtr->next = monitorPtr->requestHeadersPtr;
+    monitorPtr->requestHeadersPtr = itemPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the headers of the request of a monitor: its authorization, kept in the monitor, then the
+ * validators of its last response if it can be reused, so that the server does not send the same
+ * content again
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetRequestHeaders
+(
+    Monitor_t * monitorPtr      ///< [IN] Monitor to poll
+)
+{
+    const Validators_t * validatorsPtr = &monitorPtr->cache.validators;
+
+    monitorPtr->requestHeadersPtr = NULL;
+
+    if (monitorPtr->authorization[0] != '\0')
+    {
+        monitorPtr->authorizationHeader.data = monitorPtr->authorization;
+        monitorPtr->authorizationHeader.next = NULL;
+        monitorPtr->requestHeadersPtr = &monitorPtr->authorizationHeader;
+    }
+
+    if (monitorPtr->cache.isValid)
+    {
+        if (validatorsPtr->etag[0] != '\0')
+        {
+            AddRequestHeader(monitorPtr, "If-None-Match", validatorsPtr->etag);
+        }
+        if (validatorsPtr->lastModified[0] != '\0')
+        {
+            AddRequestHeader(monitorPtr, "If-Modified-Since", validatorsPtr->lastModified);
+        }
+    }
+
+    if ( (monitorPtr->requestHeadersPtr != NULL) &&
+         (monitorPtr->requestHeadersPtr != &monitorPtr->authorizationHeader) )
+    {
+        ConditionalRequestCount++;
+    }
+
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_HTTPHEADER, monitorPtr->requestHeadersPtr);
+
+    monitorPtr->receivedValidators.etag[0] = '\0';
+    monitorPtr->receivedValidators.lastModified[0] = '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds the transfer of a monitor to the multi handle.
+ *
+ * @return
+ *      - LE_OK if the transfer is started
+ *      - LE_FAULT otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartTransfer
+(
+    Monitor_t * monitorPtr      ///< [IN] Monitor to poll
+)
+{
+    const ContentChecker_t * checkerPtr;
+
+    LE_INFO("[%s] Url: %s", monitorPtr->name, monitorPtr->url);
+
+    if (!monitorPtr->curlPtr)
+    {
+        monitorPtr->curlPtr = CreateEasyHandle(monitorPtr);
+        if (!monitorPtr->curlPtr)
+        {
+            return LE_FAULT;
+        }
+    }
+
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_URL, monitorPtr->url);
+
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_BUFFERSIZE, ResponseBufferBytes);
+
+    // An empty string offers every encoding cURL was built with: gzip and deflate, brotli and zstd
+    // when available
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_ACCEPT_ENCODING, Compression ? "" : NULL);
+
+    // A stalled server must not hold the light, or the next polls, for ever
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_CONNECTTIMEOUT, ConnectTimeoutSec);
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_TIMEOUT, TransferTimeoutSec);
+
+    // Without content check, only the headers are needed
+    checkerPtr = monitorPtr->contentCheck ? monitorPtr->checkerPtr : NULL;
+    monitorPtr->contentPtr = pollArena_Alloc(contentCheck_GetSize(checkerPtr));
+    if (!monitorPtr->contentPtr)
+    {
+        LE_ERROR("[%s] Poll arena full (%zu bytes), see pollArenaBytes",
+                 monitorPtr->name,
+                 pollArena_GetSize());
+        return LE_FAULT;
+    }
+    contentCheck_Init(monitorPtr->contentPtr, checkerPtr, &monitorPtr->contentParams);
+    monitorPtr->isTooLarge = false;
+
+    SetRequestHeaders(monitorPtr);
+    monitorPtr->nextPageToken[0] = '\0';
+    monitorPtr->pageCount = 1;
+    monitorPtr->pageOffset = 0;
+    monitorPtr->drainedBytes = 0;
+    monitorPtr->parseTime.sec = 0;
+    monitorPtr->parseTime.usec = 0;
+
+    if (curl_multi_add_handle(MultiPtr, monitorPtr->curlPtr) != CURLM_OK)
+    {
+        LE_ERROR("[%s] Unable to add transfer", monitorPtr->name);
+        return LE_FAULT;
+    }
+
+    monitorPtr->isTransferring = true;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counts whether the transfer reused an open connection or had to create new ones.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CountConnections
+(
+    CURL *curlPtr               ///< [IN] Easy handle of the transfer that is done
+)
+{
+    long newConnections = 0;
+
+    curl_easy_getinfo(curlPtr, CURLINFO_NUM_CONNECTS, &newConnections);
+
+    if (newConnections == 0)
+    {
+        ReusedConnectionCount++;
+    }
+    else
+    {
+        NewConnectionCount += newConnections;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keeps the state computed from a full response, along with its validators, so that it can be
+ * reused if the server answers 304 Not Modified to the next request
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateResponseCache
+(
+    Monitor_t * monitorPtr,     ///< [IN] Monitor whose transfer is done
+    long httpCode,              ///< [IN] HTTP code of the response
+    MonitorState_t state        ///< [IN] State computed from the response
+)
+{
+    ResponseCache_t * cachePtr = &monitorPtr->cache;
+    const Validators_t * validatorsPtr = &monitorPtr->receivedValidators;
+    curl_off_t contentLength = -1;
+
+    // The validators of a page do not tell whether the next pages changed
+    if ( (httpCode != 200) || (monitorPtr->pageCount > 1) ||
+         ( (validatorsPtr->etag[0] == '\0') && (validatorsPtr->lastModified[0] == '\0') ) )
+    {
+        cachePtr->isValid = false;
+        return;
+    }
+
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+    if (contentLength < 0)
+    {
+        curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_SIZE_DOWNLOAD_T, &contentLength);
+    }
+
+    cachePtr->isValid = true;
+    cachePtr->state = state;
+    cachePtr->isInProgress = monitorPtr->isInProgress;
+    cachePtr->length = contentLength;
+    cachePtr->validators = *validatorsPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the state of a monitor once its transfer is done, depending on the boolean values of
+ * exitCodeCheck and contentCheck.
+ *
+ * @return
+ *      State of the monitor
+ */
+//--------------------------------------------------------------------------------------------------
+static MonitorState_t CheckTransferResult
+(
+    Monitor_t * monitorPtr,     ///< [IN] Monitor whose transfer is done
+    CURLcode res                ///< [IN] Result of the transfer
+)
+{
+    MonitorState_t exitCodeState = STATE_PASS;
+    MonitorState_t contentState = STATE_PASS;
+    long httpCode = 0;
+
+    monitorPtr->hasFailed = false;
+    monitorPtr->isInProgress = false;
+    monitorPtr->httpCode = 0;
+    monitorPtr->isNotModified = false;
+
+    // The transfer is stopped on purpose once the verdict of the content is known
+    if ( (res == CURLE_WRITE_ERROR) && monitorPtr->contentPtr->isDone )
+    {
+        LE_DEBUG("[%s] transfer stopped after %zu bytes",
+                 monitorPtr->name,
+                 monitorPtr->contentPtr->length);
+        res = CURLE_OK;
+    }
+
+    // The server answered, but with more content than the state can be computed from
+    if ( (res == CURLE_WRITE_ERROR) && monitorPtr->isTooLarge )
+    {
+        LE_ERROR("[%s] response too large, state unknown after %zu bytes",
+                 monitorPtr->name,
+                 monitorPtr->contentPtr->length);
+        TooLargeCount++;
+        monitorPtr->cache.isValid = false;
+        return STATE_FAIL;
+    }
+
+    if (res != CURLE_OK)
+    {
+        LE_ERROR("[%s] transfer failed: %s", monitorPtr->name, curl_easy_strerror(res));
+        if (res == CURLE_SSL_CACERT)
+        {
+            LE_ERROR("Make sure your system date is set correctly (e.g. `date -s '2016-7-7'`)");
+            LE_ERROR("Check the minimum date for this SSL cert to work");
+        }
+
+        monitorPtr->hasFailed = true;
+        return STATE_WARNING;
+    }
+
+    // Unchanged since the last full response: its state still applies, the content is not parsed
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_RESPONSE_CODE, &httpCode);
+    monitorPtr->httpCode = httpCode;
+    if ( (httpCode == 304) && monitorPtr->cache.isValid )
+    {
+        NotModifiedCount++;
+        NotModifiedBytes += monitorPtr->cache.length;
+
+        LE_INFO("[%s] not modified", monitorPtr->name);
+        monitorPtr->isNotModified = true;
+        monitorPtr->isInProgress = monitorPtr->cache.isInProgress;
+        return monitorPtr->cache.state;
+    }
+
+    // A failing server is not polled more often than needed, see ScheduleNextPoll
+    monitorPtr->hasFailed = (httpCode >= 500);
+
+    // States are described in README.md
+    if(monitorPtr->exitCodeCheck)
+    {
+        exitCodeState = GetHTTPCode(monitorPtr->curlPtr);
+    }
+
+    if(monitorPtr->contentCheck)
+    {
+        contentState = contentCheck_GetResult(monitorPtr->contentPtr);
+        monitorPtr->isInProgress = contentCheck_IsInProgress(monitorPtr->contentPtr);
+    }
+
+    UpdateResponseCache(monitorPtr, httpCode, MIN(exitCodeState, contentState));
+
+    return MIN(exitCodeState, contentState);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records how long each phase of a transfer took, so that a slow poll can be blamed on the name
+ * resolution, the connection, the TLS handshake, the server or the download. Also records how many
+ * bytes were downloaded, and how many bytes of content they were decompressed into.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RecordTransferTimes
+(
+    Monitor_t * monitorPtr      ///< [IN] Monitor whose transfer is done
+)
+{
+    // Times are in seconds from the start of the transfer, each one includes the previous ones
+    double nameLookup = 0;
+    double connect = 0;
+    double appConnect = 0;
+    double startTransfer = 0;
+    double total = 0;
+    curl_off_t bytes = 0;
+    size_t contentBytes = monitorPtr->contentPtr->length - monitorPtr->pageOffset;
+
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_NAMELOOKUP_TIME, &nameLookup);
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_CONNECT_TIME, &connect);
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_APPCONNECT_TIME, &appConnect);
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_STARTTRANSFER_TIME, &startTransfer);
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_TOTAL_TIME, &total);
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+
+    // A phase that did not happen is reported as 0, e.g. the TLS handshake of a plain HTTP
+    // transfer, or the connection when it is reused
+    connect = MAX(connect, nameLookup);
+    appConnect = MAX(appConnect, connect);
+    startTransfer = MAX(startTransfer, appConnect);
+    total = MAX(total, startTransfer);
+
+    pollStats_Record(POLL_STATS_DNS, nameLookup * 1000000);
+    pollStats_Record(POLL_STATS_CONNECT, (connect - nameLookup) * 1000000);
+    pollStats_Record(POLL_STATS_TLS, (appConnect - connect) * 1000000);
+    pollStats_Record(POLL_STATS_FIRST_BYTE, (startTransfer - appConnect) * 1000000);
+    pollStats_Record(POLL_STATS_TRANSFER, (total - startTransfer) * 1000000);
+    pollStats_Record(POLL_STATS_TOTAL, total * 1000000);
+    pollStats_Record(POLL_STATS_PARSE,
+                     monitorPtr->parseTime.sec * 1000000 + monitorPtr->parseTime.usec);
+    pollStats_Record(POLL_STATS_BYTES, bytes);
+    pollStats_Record(POLL_STATS_CONTENT_BYTES, contentBytes);
+
+    CurrentPoll.receivedBytes += bytes;
+    CurrentPoll.contentBytes += contentBytes;
+
+    LE_DEBUG("[%s] dns %.3f, connect %.3f, tls %.3f, first byte %.3f, total %.3f s, %"
+             CURL_FORMAT_CURL_OFF_T " bytes",
+             monitorPtr->name,
+             nameLookup,
+             connect,
+             appConnect,
+             startTransfer,
+             total,
+             bytes);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the statistics and the counters under /stats, at most every StatsPublishIntervalSec
+ * since each write of the config tree goes to flash.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PublishStats
+(
+    void
+)
+{
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    le_cfg_IteratorRef_t iteratorRef;
+
+    if (StatsPublishIntervalSec <= 0)
+    {
+        return;
+    }
+
+    if ( HasPublishedStats &&
+         (le_clk_Sub(now, LastStatsPublishTime).sec < StatsPublishIntervalSec) )
+    {
+        return;
+    }
+
+    iteratorRef = le_cfg_CreateWriteTxn("/stats");
+
+    pollStats_Write(iteratorRef);
+
+    le_cfg_SetInt(iteratorRef, "polls", PollCount);
+    le_cfg_SetInt(iteratorRef, "connections/reused", ReusedConnectionCount);
+    le_cfg_SetInt(iteratorRef, "connections/new", NewConnectionCount);
+    le_cfg_SetInt(iteratorRef, "conditional/requests", ConditionalRequestCount);
+    le_cfg_SetInt(iteratorRef, "conditional/notModified", NotModifiedCount);
+    le_cfg_SetInt(iteratorRef, "responses/tooLarge", TooLargeCount);
+    le_cfg_SetInt(iteratorRef, "lastPoll/bytes", CurrentPoll.receivedBytes);
+    le_cfg_SetInt(iteratorRef, "lastPoll/contentBytes", CurrentPoll.contentBytes);
+    le_cfg_SetInt(iteratorRef, "arena/size", pollArena_GetSize());
+    le_cfg_SetInt(iteratorRef, "arena/highWater", pollArena_GetHighWater());
+    le_cfg_SetInt(iteratorRef, "arena/failures", pollArena_GetFailureCount());
+    power_Write(iteratorRef);
+    stream_Write(iteratorRef);
+
+    le_cfg_CommitTxn(iteratorRef);
+
+    LastStatsPublishTime = now;
+    HasPublishedStats = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records the latency of a poll, from its start to the update of the light, and logs the
+ * percentiles over the last LATENCY_WINDOW_SIZE polls.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RecordPollLatency
+(
+    le_clk_Time_t startTime,    ///< [IN] Relative time the poll started at
+    size_t transferCount        ///< [IN] Number of transfers done by the poll
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+    uint32_t latencyMs = elapsed.sec * 1000 + elapsed.usec / 1000;
+    uint32_t sorted[LATENCY_WINDOW_SIZE];
+    size_t count;
+    size_t i;
+
+    PollLatencyMs[PollCount % LATENCY_WINDOW_SIZE] = latencyMs;
+    PollCount++;
+
+    count = MIN(PollCount, LATENCY_WINDOW_SIZE);
+
+    // Insertion sort, the window is small
+    for (i = 0; i < count; i++)
+    {
+        uint32_t value = PollLatencyMs[i];
+        size_t j = i;
+
+        while ( (j > 0) && (sorted[j - 1] > value) )
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    LE_INFO("Poll latency: %u ms for %zu transfer(s); p50 %u, p90 %u, max %u ms over %zu polls",
+            latencyMs,
+            transferCount,
+            sorted[count / 2],
+            sorted[(count * 9) / 10],
+            sorted[count - 1],
+            count);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Displays the light depending on the worst state of the monitors once all the transfers of the
+ * poll are done, and updates what the next polls depend on.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FinishPoll
+(
+    void
+)
+{
+    CurrentPoll.isRunning = false;
+
+    LE_INFO("Connections: %u reused, %u new", ReusedConnectionCount, NewConnectionCount);
+    LE_INFO("Not modified: %u of %u conditional requests, %" PRIu64 " bytes saved",
+            NotModifiedCount,
+            ConditionalRequestCount,
+            NotModifiedBytes);
+    LE_INFO("Poll bytes: %" PRIu64 " received, %" PRIu64 " of content",
+            CurrentPoll.receivedBytes,
+            CurrentPoll.contentBytes);
+
+    // Only the towers whose monitors changed are evaluated again
+    history_SetState(CurrentPoll.state);
+    tower_Update();
+
+    RecordPollLatency(CurrentPoll.startTime, CurrentPoll.transferCount);
+
+    PublishStats();
+
+    // Back off only when no server could be polled at all
+    ConsecutiveFailureCount = (CurrentPoll.failedCount == CurrentPoll.transferCount) ?
+                              ConsecutiveFailureCount + 1 : 0;
+
+    // Poll faster for a while after the state changed, and as long as a job is running
+    if ( ( (CurrentPoll.state != LastPolledState) && (LastPolledState != STATE_UNKNOWN) ) ||
+         CurrentPoll.isInProgress )
+    {
+        BurstPollsLeft = BurstPollCount;
+    }
+    LastPolledState = CurrentPoll.state;
+
+    if (AdaptivePolling)
+    {
+        ScheduleNextPoll();
+    }
+
+    // The light is up to date, the device may suspend until the next poll
+    power_Relax();
+
+    // The poll may have started before the change the event tells about
+    if (IsStreamPollPending)
+    {
+        IsStreamPollPending = false;
+        le_event_QueueFunction(StreamPoll, NULL, NULL);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Requests the next page of the response of a monitor, if it has one and the verdict of its
+ * content is not known yet. The pages are fed to the same content check, on the same connection.
+ *
+ * @return
+ *      true if the next page is requested
+ */
+//--------------------------------------------------------------------------------------------------
+static bool StartNextPage
+(
+    Monitor_t * monitorPtr,     ///< [IN] Monitor whose transfer of a page is done
+    CURLcode res                ///< [IN] Result of the transfer
+)
+{
+    const ContentChecker_t * checkerPtr = monitorPtr->contentPtr->checkerPtr;
+    char url[MAX_URL_BYTES];
+    long httpCode = 0;
+
+    curl_easy_getinfo(monitorPtr->curlPtr, CURLINFO_RESPONSE_CODE, &httpCode);
+
+    if ( (res != CURLE_OK) || (httpCode != 200) ||
+         (checkerPtr == NULL) || (checkerPtr->pagingPtr == NULL) ||
+         monitorPtr->contentPtr->isDone || (monitorPtr->nextPageToken[0] == '\0') )
+    {
+        return false;
+    }
+
+    if (monitorPtr->pageCount >= MAX_CONTENT_PAGES)
+    {
+        LE_ERROR("[%s] More than %d pages, the next ones are not read",
+                 monitorPtr->name,
+                 MAX_CONTENT_PAGES);
+        return false;
+    }
+
+    snprintf(url, sizeof(url), "%s", monitorPtr->url);
+    if (contentCheck_AddQueryParam(url,
+                                   sizeof(url),
+                                   checkerPtr->pagingPtr->paramPtr,
+                                   monitorPtr->nextPageToken) != LE_OK)
+    {
+        LE_ERROR("[%s] URL of page %zu too long, the next pages are not read",
+                 monitorPtr->name,
+                 monitorPtr->pageCount + 1);
+        return false;
+    }
+
+    // Adding the handle again starts another transfer. The validators only apply to the first page.
+    curl_multi_remove_handle(MultiPtr, monitorPtr->curlPtr);
+    curl_easy_setopt(monitorPtr->curlPtr, CURLOPT_URL, url);
+    curl_easy_setopt(monitorPtr->curlPtr,
+                     CURLOPT_HTTPHEADER,
+                     (monitorPtr->authorization[0] != '\0') ?
+                     &monitorPtr->authorizationHeader : NULL);
+    monitorPtr->pageCount++;
+    monitorPtr->pageOffset = monitorPtr->contentPtr->length;
+    monitorPtr->parseTime.sec = 0;
+    monitorPtr->parseTime.usec = 0;
+
+    if (curl_multi_add_handle(MultiPtr, monitorPtr->curlPtr) != CURLM_OK)
+    {
+        LE_ERROR("[%s] Unable to add the transfer of page %zu, state of the previous pages",
+                 monitorPtr->name,
+                 monitorPtr->pageCount);
+        return false;
+    }
+
+    LE_DEBUG("[%s] page %zu", monitorPtr->name, monitorPtr->pageCount);
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the state of the monitors whose transfers completed, and finishes the poll once they
+ * all did. Called after cURL handled activity on a socket or a timeout.
+ */
+//--------------------------------------------------------------------------------------------------
+static void HandleDoneTransfers
+(
+    void
+)
+{
+    int pendingMessages = 0;
+    CURLMsg *msgPtr;
+
+    while ( (msgPtr = curl_multi_info_read(MultiPtr, &pendingMessages)) != NULL )
+    {
+        Monitor_t * monitorPtr = NULL;
+        MonitorState_t monitorState;
+        le_clk_Time_t elapsed;
+        uint32_t latencyMs;
+
+        if (msgPtr->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        // The stream runs on the same multi handle, but is not part of the poll
+        if (stream_HandleDone(msgPtr->easy_handle, msgPtr->data.result))
+        {
+            continue;
+        }
+
+        curl_easy_getinfo(msgPtr->easy_handle, CURLINFO_PRIVATE, (char **) &monitorPtr);
+        CountConnections(msgPtr->easy_handle);
+        RecordTransferTimes(monitorPtr);
+
+        // The state is only known from the content of all the pages
+        if (StartNextPage(monitorPtr, msgPtr->data.result))
+        {
+            continue;
+        }
+
+        monitorState = CheckTransferResult(monitorPtr, msgPtr->data.result);
+        LE_INFO("[%s] state: %d", monitorPtr->name, monitorState);
+        tower_SetMonitorState(monitorPtr - Monitors, monitorState, monitorPtr->isInProgress);
+
+        elapsed = le_clk_Sub(le_clk_GetRelativeTime(), CurrentPoll.startTime);
+        latencyMs = elapsed.sec * 1000 + elapsed.usec / 1000;
+
+        if (monitorState != monitorPtr->recordedState)
+        {
+            history_Record(monitorPtr->name, monitorPtr->httpCode, monitorState, latencyMs);
+            monitorPtr->recordedState = monitorState;
+        }
+        history_ReportPoll(monitorPtr->name, monitorPtr->httpCode, monitorState, latencyMs);
+
+        // e.g. the jobs of a Jenkins view, once the state of the view is recorded
+        UpdateJobs(monitorPtr, monitorState);
+
+        // Detach the handle, its connection stays in the cache of the multi handle
+        curl_multi_remove_handle(MultiPtr, monitorPtr->curlPtr);
+        monitorPtr->isTransferring = false;
+
+        CurrentPoll.state = MIN(CurrentPoll.state, monitorState);
+        CurrentPoll.failedCount += monitorPtr->hasFailed ? 1 : 0;
+        CurrentPoll.isInProgress = CurrentPoll.isInProgress || monitorPtr->isInProgress;
+        CurrentPoll.pendingCount--;
+    }
+
+    if (CurrentPoll.isRunning && (CurrentPoll.pendingCount == 0))
+    {
+        FinishPoll();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stops the transfers of the running poll without updating the light, e.g. before the monitors
+ * are reloaded or when the app stops.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AbortPoll
+(
+    void
+)
+{
+    size_t i;
+
+    if (!CurrentPoll.isRunning)
+    {
+        return;
+    }
+
+    LE_INFO("Aborting the poll, %zu transfer(s) still running", CurrentPoll.pendingCount);
+
+    for (i = 0; i < MAX_MONITORS; i++)
+    {
+        if (Monitors[i].isTransferring)
+        {
+            curl_multi_remove_handle(MultiPtr, Monitors[i].curlPtr);
+            Monitors[i].isTransferring = false;
+        }
+    }
+
+    // The stream still needs the timeouts of cURL
+    if (!stream_IsRunning())
+    {
+        le_timer_Stop(TransferTimer);
+    }
+
+    CurrentPoll.isRunning = false;
+
+    power_Relax();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called by the event loop when a socket of a transfer is ready
+ */
+//--------------------------------------------------------------------------------------------------
+static void SocketEventHandler
+(
+    int fd,                     ///< [IN] Socket
+    short events                ///< [IN] Bit map of the events that occurred (POLLIN, ...)
+)
+{
+    int runningTransfers = 0;
+    int flags = 0;
+    CURLMcode mres;
+
+    flags |= (events & POLLIN) ? CURL_CSELECT_IN : 0;
+    flags |= (events & POLLOUT) ? CURL_CSELECT_OUT : 0;
+    flags |= (events & (POLLERR | POLLHUP)) ? CURL_CSELECT_ERR : 0;
+
+    mres = curl_multi_socket_action(MultiPtr, fd, flags, &runningTransfers);
+    if (mres != CURLM_OK)
+    {
+        LE_ERROR("curl multi failed: %s", curl_multi_strerror(mres));
+    }
+
+    HandleDoneTransfers();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called by cURL when it needs a socket of a transfer to be watched for other events, or not
+ * anymore. The sockets are watched by the event loop so that polling never blocks.
+ *
+ * @return
+ *      0
+ */
+//--------------------------------------------------------------------------------------------------
+static int SocketCallback
+(
+    CURL *easyPtr,              ///< [IN] Easy handle of the transfer
+    curl_socket_t fd,           ///< [IN] Socket
+    int what,                   ///< [IN] Events to watch (CURL_POLL_IN, ...) or CURL_POLL_REMOVE
+    void *userDataPtr,          ///< [IN] Unused
+    void *socketDataPtr         ///< [IN] File descriptor monitor of the socket, NULL if none yet
+)
+{
+    le_fdMonitor_Ref_t fdMonitorRef = (le_fdMonitor_Ref_t) socketDataPtr;
+    short events = 0;
+
+    if (what == CURL_POLL_REMOVE)
+    {
+        if (fdMonitorRef)
+        {
+            le_fdMonitor_Delete(fdMonitorRef);
+        }
+        return 0;
+    }
+
+    events |= (what & CURL_POLL_IN) ? POLLIN : 0;
+    events |= (what & CURL_POLL_OUT) ? POLLOUT : 0;
+
+    if (!fdMonitorRef)
+    {
+        char name[MAX_FD_MONITOR_NAME_BYTES];
+
+        snprintf(name, sizeof(name), "curl-%d", fd);
+        fdMonitorRef = le_fdMonitor_Create(name, fd, SocketEventHandler, events);
+        curl_multi_assign(MultiPtr, fd, fdMonitorRef);
+    }
+    else
+    {
+        le_fdMonitor_Disable(fdMonitorRef, POLLIN | POLLOUT);
+        le_fdMonitor_Enable(fdMonitorRef, events);
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called by the event loop when the timeout requested by cURL expired
+ */
+//--------------------------------------------------------------------------------------------------
+static void TransferTimerHandler
+(
+    le_timer_Ref_t timerRef     ///< [IN] TransferTimer
+)
+{
+    int runningTransfers = 0;
+    CURLMcode mres;
+
+    mres = curl_multi_socket_action(MultiPtr, CURL_SOCKET_TIMEOUT, 0, &runningTransfers);
+    if (mres != CURLM_OK)
+    {
+        LE_ERROR("curl multi failed: %s", curl_multi_strerror(mres));
+    }
+
+    HandleDoneTransfers();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called by cURL to set when it needs to check the transfers for timeouts
+ *
+ * @return
+ *      0
+ */
+//--------------------------------------------------------------------------------------------------
+static int TransferTimerCallback
+(
+    CURLM *multiPtr,            ///< [IN] Multi handle
+    long timeoutMs,             ///< [IN] Delay before the check, -1 to cancel it
+    void *userDataPtr           ///< [IN] Unused
+)
+{
+    le_timer_Stop(TransferTimer);
+
+    if (timeoutMs >= 0)
+    {
+        // cURL must not be called from its own callback, a delay of 0 is handled by the event loop
+        le_timer_SetMsInterval(TransferTimer, MAX(timeoutMs, 1));
+        le_timer_Start(TransferTimer);
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * 1. Called by Polling function
+ *
+ * 2. Starts polling the Urls of all the monitors at the same time. The transfers then run from
+ *    the event loop, see HandleDoneTransfers.
+ *
+ * 3. Displays the light depending on the worst state of the monitors, see FinishPoll
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckUrl
+(
+    void
+)
+{
+    size_t i;
+
+    if (CurrentPoll.isRunning)
+    {
+        LE_WARN("Previous poll still running, %zu transfer(s) left", CurrentPoll.pendingCount);
+        return;
+    }
+
+    // Nothing of the previous poll is in use anymore
+    pollArena_Reset();
+
+    memset(&CurrentPoll, 0, sizeof(CurrentPoll));
+    CurrentPoll.startTime = le_clk_GetRelativeTime();
+    CurrentPoll.state = STATE_UNKNOWN;
+
+    for (i = 0; i < MonitorCount; i++)
+    {
+        if (Monitors[i].url[0] == '\0')
+        {
+            LE_WARN("[%s] URL not set, skipping", Monitors[i].name);
+            continue;
+        }
+
+        if (StartTransfer(&Monitors[i]) == LE_OK)
+        {
+            CurrentPoll.transferCount++;
+        }
+        else
+        {
+            CurrentPoll.state = MIN(CurrentPoll.state, STATE_WARNING);
+            tower_SetMonitorState(i, STATE_WARNING, false);
+            SetJobStates(i, STATE_WARNING);
+        }
+    }
+
+    if (CurrentPoll.transferCount == 0)
+    {
+        if (CurrentPoll.state != STATE_UNKNOWN)
+        {
+            history_SetState(CurrentPoll.state);
+            tower_Update();
+        }
+        return;
+    }
+
+    // Adding the transfers made cURL request a timeout, the transfers start when it expires
+    CurrentPoll.pendingCount = CurrentPoll.transferCount;
+    CurrentPoll.isRunning = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes cURL and the handles shared by all the transfers
+ */
+//--------------------------------------------------------------------------------------------------
+static void CurlInit
+(
+    void
+)
+{
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    MultiPtr = curl_multi_init();
+    LE_FATAL_IF(MultiPtr == NULL, "Couldn't initialize cURL multi handle.");
+
+    SharePtr = curl_share_init();
+    LE_FATAL_IF(SharePtr == NULL, "Couldn't initialize cURL share handle.");
+
+    curl_share_setopt(SharePtr, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(SharePtr, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    // The transfers are driven by the event loop instead of blocking it
+    TransferTimer = le_timer_Create("TransferTimer");
+    le_timer_SetHandler(TransferTimer, TransferTimerHandler);
+
+    curl_multi_setopt(MultiPtr, CURLMOPT_SOCKETFUNCTION, SocketCallback);
+    curl_multi_setopt(MultiPtr, CURLMOPT_TIMERFUNCTION, TransferTimerCallback);
+
+    stream_Init(MultiPtr, SharePtr, StreamStateHandler, StreamEventHandler);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Closes the open connections and releases cURL
+ */
+//--------------------------------------------------------------------------------------------------
+static void CurlDeinit
+(
+    void
+)
+{
+    size_t i;
+
+    AbortPoll();
+    stream_Stop();
 
-    if(timerSet != PollingIntervalSec)
+    for (i = 0; i < MAX_MONITORS; i++)
     {
-        PollingIntervalSec = timerSet;
-        TimerHandle();
+        if (Monitors[i].curlPtr)
+        {
+            curl_easy_cleanup(Monitors[i].curlPtr);
+            Monitors[i].curlPtr = NULL;
+        }
     }
 
-    LE_INFO("-------------------------- In polling function--------------------");
+    curl_multi_cleanup(MultiPtr);
+    MultiPtr = NULL;
 
-    CheckUrl();
+    curl_share_cleanup(SharePtr);
+    SharePtr = NULL;
+
+    curl_global_cleanup();
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Handles internal states of GPIO pins when the app is terminated by the user.
+ * Initializes IoT pins 13, 15, 17 (green, yellow, red respectively) for output
  *
  * @return
- *      Deactivated GPIO pins
+ *      Activated pins, showing the state restored from the history (or the unknown pattern) until
+ *      the first poll
  */
 //--------------------------------------------------------------------------------------------------
-static void SigTermEventHandler
+static void GpioInit
 (
-    int sigNum
+    void
+)
+{
+    size_t i;
+
+    le_gpioRed_Activate();
+    le_gpioRed_EnablePullUp();
+
+    le_gpioYellow_Activate();
+    le_gpioYellow_EnablePullUp();
+
+    le_gpioGreen_Activate();
+    le_gpioGreen_EnablePullUp();
+
+    light_Init();
+
+    // Until the towers are loaded, they all show the state restored from the history
+    for (i = 0; i < LIGHT_MAX_OUTPUTS; i++)
+    {
+        SetMonitorState(i, history_GetState(), false);
+    }
+
+    LE_DEBUG("RED read PP - High: %d", le_gpioRed_Read());
+    LE_DEBUG("YELLOW read PP - High: %d", le_gpioYellow_Read());
+    LE_DEBUG("GREEN read PP - High: %d", le_gpioGreen_Read());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deactivate any active pins that are set currently so that the GPIO pins are usable
+ */
+//--------------------------------------------------------------------------------------------------
+static void GpioDeinit
+(
+    void
+)
+{
+    light_Deinit();
+
+    le_gpioGreen_Deactivate();
+    le_gpioYellow_Deactivate();
+    le_gpioRed_Deactivate();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * 1. Initialize the indefinitely repeating PollingTimer to x seconds
+ *
+ * 2. Reset polling interval from Polling function
+ *
+ * @return
+ *      A timer reference PollingTimer
+ */
+//--------------------------------------------------------------------------------------------------
+static void TimerHandle
+(
+    void
+)
+{
+    if(le_timer_IsRunning(PollingTimer))
+    {
+        le_timer_Stop(PollingTimer);
+    }
+    // The events of the stream trigger the polls, see StreamStateHandler
+    if (stream_IsConnected())
+    {
+        return;
+    }
+    LE_DEBUG("pollingIntervalSec is %i", PollingIntervalSec);
+    le_clk_Time_t interval = {PollingIntervalSec, 0}; // first parameter is the seconds
+    le_timer_SetInterval(PollingTimer, interval);
+    // repeat indefinitely, unless each poll schedules the next one
+    le_timer_SetRepeat(PollingTimer, AdaptivePolling ? 1 : 0);
+    le_timer_SetHandler(PollingTimer, Polling);
+    // Wakes the device up for the next poll in low-power mode
+    le_timer_SetWakeup(PollingTimer, true);
+    le_timer_Start(PollingTimer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Schedules the next poll when adaptive polling is enabled:
+ *  - the interval doubles on each poll where no server could be polled, up to /backoffMaxSec
+ *  - otherwise /burstPollCount polls are done every /burstIntervalSec after the state changed,
+ *    and as long as a Jenkins build is in progress
+ *  - otherwise the interval is /pollingIntervalSec
+ *
+ * The interval then varies randomly by up to /jitterPercent so that devices do not poll in
+ * lockstep.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ScheduleNextPoll
+(
+    void
 )
 {
+    uint64_t intervalMs;
+    uint32_t jitterMs;
+
+    if (stream_IsConnected())
+    {
+        return;
+    }
+
+    if (ConsecutiveFailureCount > 0)
+    {
+        uint32_t shift = MIN(ConsecutiveFailureCount, MAX_BACKOFF_SHIFT);
+
+        intervalMs = MIN((uint64_t) PollingIntervalSec << shift, (uint64_t) BackoffMaxSec) * 1000;
+    }
+    else if (BurstPollsLeft > 0)
+    {
+        BurstPollsLeft--;
+        intervalMs = (uint64_t) MIN(BurstIntervalSec, PollingIntervalSec) * 1000;
+    }
+    else
+    {
+        intervalMs = (uint64_t) PollingIntervalSec * 1000;
+    }
+
+    jitterMs = (intervalMs * JitterPercent) / 100;
+    if (jitterMs > 0)
+    {
+        intervalMs = intervalMs - jitterMs + le_rand_GetNumBetween(0, 2 * jitterMs);
+    }
+
+    LE_DEBUG("Next poll in %" PRIu64 " ms", intervalMs);
+
     le_timer_Stop(PollingTimer);
-    LE_INFO("Deactivating GPIO Pins");
-    GpioDeinit();
+    le_timer_SetMsInterval(PollingTimer, intervalMs);
+    le_timer_SetRepeat(PollingTimer, 1);
+    le_timer_Start(PollingTimer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function is called every x seconds where x can be set in the configTree.
+ *
+ * eg. config set trafficLight:/pollingIntervalSec 10 int
+ */
+//--------------------------------------------------------------------------------------------------
+static void Polling
+(
+    le_timer_Ref_t timerRef      ///< [IN] timer reference for changing intervals, starting and stopping
+)
+{
+    LE_INFO("-------------------------- In polling function--------------------");
+
+    // Polling resumes once the link is up, see LinkChangeHandler
+    if (!dataLink_IsUp())
+    {
+        LE_INFO("Data link down, not polling");
+        return;
+    }
+
+    // Awake until the transfers are done and the light is updated, see FinishPoll
+    power_StayAwake();
+
+    CheckUrl();
+
+    // Otherwise the next poll is scheduled once the transfers are done, see FinishPoll
+    if (!CurrentPoll.isRunning)
+    {
+        if (AdaptivePolling)
+        {
+            ScheduleNextPoll();
+        }
+        power_Relax();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Applies the settings once the config tree stopped changing: reloads them, restarts the polling
+ * timer and polls right away with the new settings. A poll still running with the old settings is
+ * aborted first, since the monitors it uses are reloaded.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ApplyConfig
+(
+    le_timer_Ref_t timerRef      ///< [IN] ConfigTimer
+)
+{
+    AbortPoll();
+    LoadConfig();
+
+    if (dataLink_IsUp())
+    {
+        stream_Start();
+        TimerHandle();
+        Polling(PollingTimer);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when the data link goes down or up. Polling pauses while it is down, so that transfers
+ * do not wait for DNS or connections to fail, and resumes with an immediate poll once it is up.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LinkChangeHandler
+(
+    bool isUp                   ///< [IN] Whether the servers can be polled
+)
+{
+    if (!isUp)
+    {
+        AbortPoll();
+        stream_Stop();
+        le_timer_Stop(PollingTimer);
+
+        if (LinkDownPattern.stepCount > 0)
+        {
+            size_t i;
+
+            for (i = 0; i < LIGHT_MAX_OUTPUTS; i++)
+            {
+                light_Show(i, &LinkDownPattern);
+            }
+
+            // The state of the monitors is shown again after the next poll
+            tower_Invalidate();
+        }
+        return;
+    }
+
+    stream_Start();
+    TimerHandle();
+    Polling(PollingTimer);
 }
 
-// This is the callback function for handling the results of a channel list query
-static void ClientChannelQueryHandler
+//--------------------------------------------------------------------------------------------------
+/**
+ * Polls right away for an event of the stream, or once the running poll is done
+ */
+//--------------------------------------------------------------------------------------------------
+static void StreamPoll
 (
-    le_result_t result,                       ///< [IN] Result of the query
-    const le_dcs_ChannelInfo_t *channelList,  ///< [IN] Channel list returned
-    size_t channelListSize,                   ///< [IN] Channel list's size
-    void *contextPtr                          ///< [IN] Associated user context pointer
+    void * param1Ptr,           ///< [IN] Unused
+    void * param2Ptr            ///< [IN] Unused
 )
 {
-    uint16_t i;
+    if (CurrentPoll.isRunning)
+    {
+        IsStreamPollPending = true;
+        return;
+    }
+
+    Polling(PollingTimer);
+}
 
-    LE_INFO("Received channel query result %d, channel list size %d", result, channelListSize);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when an event of the stream tells that the state of the monitors may have changed. The
+ * poll is queued since cURL is running the stream when the event is received.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StreamEventHandler
+(
+    void
+)
+{
+    le_event_QueueFunction(StreamPoll, NULL, NULL);
+}
 
-    if (channelListSize == 0)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when the stream is connected or drops. While it is connected the polls are only done on
+ * its events; once it drops the polling timer takes over until it is connected again.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StreamStateHandler
+(
+    bool isConnected            ///< [IN] Whether events are received
+)
+{
+    if (isConnected)
     {
+        // Catch up with the changes missed while connecting
+        le_timer_Stop(PollingTimer);
+        le_event_QueueFunction(StreamPoll, NULL, NULL);
         return;
     }
 
-    for (i = 0; i < channelListSize; i++)
+    if (dataLink_IsUp())
     {
-        LE_INFO("Available channel #%d: name %s from technology %d, state %s, reference %p",
-                i + 1,
-                channelList[i].name,
-                channelList[i].technology,
-                ( channelList[i].state == LE_DCS_STATE_UP ) ? "up" : "down" ,
-                channelList[i].ref);
+        TimerHandle();
+        le_event_QueueFunction(StreamPoll, NULL, NULL);
     }
 }
 
-// This is the function initiating a channel list query
-static void PrintDcsChannels
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when one of the watched nodes of the config tree changes, e.g. when writeConfigTree
+ * writes a setting pushed by AirVantage. The changes are applied after a short delay so that
+ * settings written together only lead to one reload.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ConfigChangeHandler
+(
+    void * contextPtr           ///< [IN] Path of the node that changed
+)
+{
+    LE_DEBUG("Config tree changed: %s", (const char *) contextPtr);
+
+    le_timer_Restart(ConfigTimer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the settings and watches the config tree for changes
+ */
+//--------------------------------------------------------------------------------------------------
+static void ConfigInit
 (
     void
 )
 {
-    le_dcs_GetChannels(ClientChannelQueryHandler, NULL);
+    size_t i;
+
+    LoadConfig();
+
+    ConfigTimer = le_timer_Create("ConfigTimer");
+    le_timer_SetMsInterval(ConfigTimer, CONFIG_APPLY_DELAY_MS);
+    le_timer_SetRepeat(ConfigTimer, 1);
+    le_timer_SetHandler(ConfigTimer, ApplyConfig);
+    // Settings changed while the device suspends can wait until it wakes up
+    le_timer_SetWakeup(ConfigTimer, false);
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(ConfigWatchPaths); i++)
+    {
+        le_cfg_AddChangeHandler(ConfigWatchPaths[i],
+                                ConfigChangeHandler,
+                                (void *) ConfigWatchPaths[i]);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles internal states of GPIO pins when the app is terminated by the user, and exits: the
+ * timers and config change handlers would otherwise keep polling with the cURL handles released.
+ *
+ * @return
+ *      Deactivated GPIO pins
+ */
+//--------------------------------------------------------------------------------------------------
+static void SigTermEventHandler
+(
+    int sigNum
+)
+{
+    le_timer_Stop(PollingTimer);
+    history_Flush();
+    dataLink_Release();
+    LE_INFO("Deactivating GPIO Pins");
+    GpioDeinit();
+    CurlDeinit();
+
+    exit(EXIT_SUCCESS);
 }
 
 //---------------------------------------------------
@@ -624,19 +2715,28 @@ static void PrintDcsChannels
 //---------------------------------------------------
 COMPONENT_INIT
 {
-    // Create a wake-up source to make sure that we don't fall asleep
-    const char * wakeUpTag = "trafficLightWakeUpTag";
-    le_pm_WakeupSourceRef_t wakeUpRef = le_pm_NewWakeupSource(1, wakeUpTag);
-    le_pm_StayAwake(wakeUpRef);
+    // Awake until the config tells whether the device may suspend between polls
+    power_Init();
 
-    PrintDcsChannels();
+    // Polling pauses while the data channel requested in the config is down
+    dataLink_Init(LinkChangeHandler);
 
-    curl_global_init(CURL_GLOBAL_ALL);
+    // Each tower shows the state of its monitors, see LoadMonitors
+    tower_Init(SetMonitorState);
+
+    CurlInit();
+    history_Init();
     GpioInit();
+    ConfigInit();
 
     PollingTimer = le_timer_Create("PollingTimer");
     TimerHandle();
 
+    if (dataLink_IsUp())
+    {
+        stream_Start();
+    }
+
     le_sig_Block(SIGTERM);
     le_sig_SetEventHandler(SIGTERM, SigTermEventHandler);
 }
@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file trafficLight.h
+ *
+ * Types shared by the modules of the trafficLight component
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef TRAFFIC_LIGHT_H_INCLUDE_GUARD
+#define TRAFFIC_LIGHT_H_INCLUDE_GUARD
+
+#include "keywordMatch.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Monitor statuses used for comparison to ultimately set the lightstates
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    STATE_FAIL,
+    STATE_WARNING,
+    STATE_PASS,
+    STATE_UNKNOWN,
+}
+MonitorState_t;
+
+// Maximum number of monitors that can be listed under /monitors
+#define MAX_MONITORS 64
+
+// Maximum number of jobs of views shown as monitors of their own, see ContentItem_t
+#define MAX_JOB_MONITORS 64
+
+// Size of the name of a monitor, with its NULL char
+#define MAX_MONITOR_NAME_BYTES 64
+
+// Sizes of the settings of a content check
+#define MAX_CONTENT_PATH_BYTES 128
+#define MAX_CONTENT_VALUE_BYTES 128
+#define MAX_CONTENT_KEYWORD_BYTES KEYWORD_MAX_PATTERN_BYTES
+#define MAX_CONTENT_SELECTOR_BYTES 128
+
+// Most keywords of a content check: the automaton also looks for the anchor, its end and the
+// marker of a Jenkins build in progress
+#define MAX_CONTENT_KEYWORDS (KEYWORD_MAX_PATTERNS - 3)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Keyword looked for in the content, as read from info/content/keywords/<n>
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char keyword[MAX_CONTENT_KEYWORD_BYTES];    ///< keyword: text to look for
+    MonitorState_t state;                       ///< state: state of the monitor when found
+}
+ContentKeyword_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Settings of the content check of a monitor, as read from info/content. Their meaning depends on
+ * the checker, see README.md.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char path[MAX_CONTENT_PATH_BYTES];      ///< info/content/path: what to look at in the content
+    char value[MAX_CONTENT_VALUE_BYTES];    ///< info/content/value: value expected there
+    double warningThreshold;                ///< info/content/warningThreshold, NAN if not set
+    double criticalThreshold;               ///< info/content/criticalThreshold, NAN if not set
+    ContentKeyword_t keywords[MAX_CONTENT_KEYWORDS];    ///< info/content/keywords, by priority
+    size_t keywordCount;                                ///< Number of keywords
+    char anchor[MAX_CONTENT_KEYWORD_BYTES];     ///< info/content/anchor: where keywords count
+    char anchorEnd[MAX_CONTENT_KEYWORD_BYTES];  ///< info/content/anchorEnd: where they stop to
+    char labelSelector[MAX_CONTENT_SELECTOR_BYTES]; ///< info/content/labelSelector: server filter
+    char fieldSelector[MAX_CONTENT_SELECTOR_BYTES]; ///< info/content/fieldSelector: server filter
+    int32_t pageSize;                           ///< info/content/pageSize: items per page
+    KeywordAutomaton_t * automatonPtr;          ///< Built from the settings by the checkers of
+                                                ///< keywords, NULL for the others, see
+                                                ///< contentCheck_Release
+}
+ContentCheckParams_t;
+
+#endif // TRAFFIC_LIGHT_H_INCLUDE_GUARD
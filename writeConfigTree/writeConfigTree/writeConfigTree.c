@@ -24,6 +24,41 @@
 #define CONFIG_TREE_INFO_CONTENT_CHECKFLAG "/info/content/checkFlag"
 #define CONFIG_TREE_POLLINGINTERVALSEC "/pollingIntervalSec"
 
+// Node of the config tree where trafficLight publishes its statistics
+#define CONFIG_TREE_STATS "/stats"
+
+// Longest path of a statistic, e.g. /stats/firstByte/max
+#define MAX_STATS_PATH_BYTES 64
+
+// Quiet time after the last write from AirVantage before the writes received are committed to the
+// config tree together, unless the AVC session stops before
+#define CONFIG_COMMIT_DELAY_MS 1000
+
+// Resources reporting how many writes were received and how many commits the batching saved
+#define RESOURCE_WRITES_RECEIVED "/configWrites/received"
+#define RESOURCE_WRITES_UNCHANGED "/configWrites/unchanged"
+#define RESOURCE_COMMITS_SAVED "/configWrites/commitsSaved"
+
+// Settings of the upload of the poll results, in the config tree of trafficLight
+#define CONFIG_TREE_TELEMETRY_PUSH_INTERVAL_SEC "/telemetryPushIntervalSec"
+#define CONFIG_TREE_TELEMETRY_BATCH_SIZE "/telemetryBatchSize"
+
+// Default time between uploads of the poll results, and number of results uploading them sooner
+#define DEFAULT_TELEMETRY_PUSH_INTERVAL_SEC 3600
+#define DEFAULT_TELEMETRY_BATCH_SIZE 100
+
+// Records of poll results kept until they are uploaded, the oldest is dropped beyond
+#define TELEMETRY_MAX_RECORDS 8
+
+// Poll results in a record, so that the three values of a result always fit in the record
+#define TELEMETRY_MAX_RESULTS_PER_RECORD 16
+
+// Time before an upload that failed, or that waits for the AVC session, is tried again
+#define TELEMETRY_PUSH_RETRY_SEC 60
+
+// Longest path of a poll result in a record, e.g. polls/<monitor>/latencyMs
+#define MAX_TELEMETRY_PATH_BYTES (TRAFFICLIGHT_MAX_MONITOR_NAME_LEN + 32)
+
 //-------------------------------------------------------------------------------------------------
 /**
  * AVC related variable
@@ -69,68 +104,279 @@ const ConfigEntry_t ConfigEntries[] = {
     /* ... insert other entries here ... */
 };
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Value received from AirVantage for a config entry and not committed yet
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isPending;                             ///< Whether a value is waiting to be committed
+    union
+    {
+        bool boolValue;
+        int32_t intValue;
+        double floatValue;
+        char stringValue[LE_CFG_STR_LEN_BYTES];
+    }
+    value;                                      ///< Value, of the type of the config entry
+}
+PendingWrite_t;
+
+// Values waiting to be committed, in the order of ConfigEntries. A later write of the same entry
+// replaces the value.
+static PendingWrite_t PendingWrites[NUM_ARRAY_MEMBERS(ConfigEntries)];
+
+// Timer committing the pending values once AirVantage stops writing
+static le_timer_Ref_t CommitTimer = NULL;
+
+// Writes received from AirVantage, writes of a value that was already set, and commits done
+static uint32_t ReceivedWriteCount = 0;
+static uint32_t UnchangedWriteCount = 0;
+static uint32_t CommitCount = 0;
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Time-series record of poll results, uploaded in a single push
+ */
+//-------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_avdata_RecordRef_t recordRef;            ///< Record, compressed by avcService when pushed
+    uint32_t resultCount;                       ///< Number of poll results in the record
+}
+TelemetryRecord_t;
+
+// Records not uploaded yet, oldest first. Results are added to the last one while it is open.
+static TelemetryRecord_t TelemetryRecords[TELEMETRY_MAX_RECORDS];
+static size_t TelemetryRecordCount = 0;
+static bool IsLastRecordOpen = false;
+
+// Poll results in the records, and whether the first record is being pushed
+static uint32_t UnpushedResultCount = 0;
+static bool IsPushing = false;
+
+// Whether the AVC session is started, and whether an upload waits for it
+static bool IsSessionStarted = false;
+static bool IsPushDue = false;
+
+// When the poll results are uploaded. The timer is set to the push interval, or to the retry
+// time while an upload is due.
+static uint32_t TelemetryBatchSize = DEFAULT_TELEMETRY_BATCH_SIZE;
+static uint32_t PushIntervalSec = DEFAULT_TELEMETRY_PUSH_INTERVAL_SEC;
+static le_timer_Ref_t PushTimer = NULL;
+
+// Poll results uploaded, and dropped because too many waited for the link
+static uint32_t PushedResultCount = 0;
+static uint32_t DroppedResultCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Statistics published by trafficLight, mirrored as read-only resources with the same paths.
+ * Each measure has a min, avg and max, in microseconds (bytes for the sizes of the responses).
+ */
+//--------------------------------------------------------------------------------------------------
+static const char * StatsMeasures[] =
+{
+    "dns",
+    "connect",
+    "tls",
+    "firstByte",
+    "transfer",
+    "total",
+    "parse",
+    "bytes",
+    "contentBytes",
+};
+
+static const char * StatsValues[] =
+{
+    "min",
+    "avg",
+    "max",
+};
+
+static const char * StatsCounters[] =
+{
+    "polls",
+    "connections/reused",
+    "connections/new",
+    "conditional/requests",
+    "conditional/notModified",
+    "responses/tooLarge",
+    "lastPoll/bytes",
+    "lastPoll/contentBytes",
+    "arena/size",
+    "arena/highWater",
+    "arena/failures",
+    "power/awakeSec",
+    "power/wakeups",
+    "power/awakePermille",
+    "stream/connected",
+    "stream/events",
+    "stream/drops",
+};
+
 //-------------------------------------------------------------------------------------------------
 /**
- * Functions to write different data types (bool, string, int, float) to the config tree given the
- * path and the data
+ * Writes a pending value to the config tree, unless it is already set
+ *
+ * @return
+ *      true if the config tree is changed
  */
 //-------------------------------------------------------------------------------------------------
-static void WriteBoolToConfig
+static bool WritePendingValue
 (
-    const char * pathToDataPtr,
-    bool dataToWrite
+    le_cfg_IteratorRef_t iteratorRef,
+    const ConfigEntry_t * entryPtr,
+    const PendingWrite_t * writePtr
 )
 {
-    le_cfg_IteratorRef_t iteratorRef;
+    const char * pathPtr = entryPtr->configTreePathPtr;
+    bool exists = le_cfg_NodeExists(iteratorRef, pathPtr);
 
-    iteratorRef = le_cfg_CreateWriteTxn(CONFIG_TREE_NAME_STR ":");
-    le_cfg_SetBool(iteratorRef, pathToDataPtr, dataToWrite);
-    le_cfg_CommitTxn(iteratorRef);
+    switch (entryPtr->dataType)
+    {
+        case LE_AVDATA_DATA_TYPE_STRING:
+            {
+                char current[LE_CFG_STR_LEN_BYTES] = {0};
+
+                le_cfg_GetString(iteratorRef, pathPtr, current, sizeof(current), "");
+                if (exists && !strcmp(current, writePtr->value.stringValue))
+                {
+                    return false;
+                }
+                le_cfg_SetString(iteratorRef, pathPtr, writePtr->value.stringValue);
+            }
+            return true;
+
+        case LE_AVDATA_DATA_TYPE_INT:
+            if (exists && (le_cfg_GetInt(iteratorRef, pathPtr, 0) == writePtr->value.intValue))
+            {
+                return false;
+            }
+            le_cfg_SetInt(iteratorRef, pathPtr, writePtr->value.intValue);
+            return true;
+
+        case LE_AVDATA_DATA_TYPE_FLOAT:
+            if (exists && (le_cfg_GetFloat(iteratorRef, pathPtr, 0) == writePtr->value.floatValue))
+            {
+                return false;
+            }
+            le_cfg_SetFloat(iteratorRef, pathPtr, writePtr->value.floatValue);
+            return true;
+
+        case LE_AVDATA_DATA_TYPE_BOOL:
+            if (exists &&
+                (le_cfg_GetBool(iteratorRef, pathPtr, false) == writePtr->value.boolValue))
+            {
+                return false;
+            }
+            le_cfg_SetBool(iteratorRef, pathPtr, writePtr->value.boolValue);
+            return true;
+
+        default:
+            LE_ERROR("Asset Data type not handled: %d", entryPtr->dataType);
+            return false;
+    }
 }
 
-static void WriteStringToConfig
+//-------------------------------------------------------------------------------------------------
+/**
+ * Updates the resources reporting the writes received and the commits saved
+ */
+//-------------------------------------------------------------------------------------------------
+static void UpdateWriteCounters
 (
-    const char * pathToDataPtr,
-    char * dataToWrite
+    void
 )
 {
-    le_cfg_IteratorRef_t iteratorRef;
-
-    iteratorRef = le_cfg_CreateWriteTxn(CONFIG_TREE_NAME_STR ":");
-    le_cfg_SetString(iteratorRef, pathToDataPtr, dataToWrite);
-    le_cfg_CommitTxn(iteratorRef);
+    le_avdata_SetInt(RESOURCE_WRITES_RECEIVED, ReceivedWriteCount);
+    le_avdata_SetInt(RESOURCE_WRITES_UNCHANGED, UnchangedWriteCount);
+    le_avdata_SetInt(RESOURCE_COMMITS_SAVED, ReceivedWriteCount - CommitCount);
 }
 
-static void WriteIntToConfig
+//-------------------------------------------------------------------------------------------------
+/**
+ * Commits the values received from AirVantage in a single transaction, so that the flash is
+ * written once and trafficLight is notified once. Values that did not change are not written, and
+ * nothing is committed if none did.
+ */
+//-------------------------------------------------------------------------------------------------
+static void CommitPendingWrites
 (
-    const char * pathToDataPtr,
-    int dataToWrite
+    void
 )
 {
     le_cfg_IteratorRef_t iteratorRef;
+    int changedCount = 0;
+    int pendingCount = 0;
+    int i;
+
+    le_timer_Stop(CommitTimer);
 
     iteratorRef = le_cfg_CreateWriteTxn(CONFIG_TREE_NAME_STR ":");
-    le_cfg_SetInt(iteratorRef, pathToDataPtr, dataToWrite);
-    le_cfg_CommitTxn(iteratorRef);
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(ConfigEntries); i++)
+    {
+        if (!PendingWrites[i].isPending)
+        {
+            continue;
+        }
+
+        pendingCount++;
+        if (WritePendingValue(iteratorRef, &ConfigEntries[i], &PendingWrites[i]))
+        {
+            changedCount++;
+        }
+        else
+        {
+            LE_INFO("%s unchanged, not written", ConfigEntries[i].configTreePathPtr);
+            UnchangedWriteCount++;
+        }
+
+        PendingWrites[i].isPending = false;
+    }
+
+    if (changedCount > 0)
+    {
+        le_cfg_CommitTxn(iteratorRef);
+        CommitCount++;
+    }
+    else
+    {
+        le_cfg_CancelTxn(iteratorRef);
+    }
+
+    LE_INFO("%d value(s) written in %d commit(s), %u commit(s) saved so far",
+            changedCount,
+            (changedCount > 0) ? 1 : 0,
+            ReceivedWriteCount - CommitCount);
+
+    if (pendingCount > 0)
+    {
+        UpdateWriteCounters();
+    }
 }
 
-static void WriteFloatToConfig
+//-------------------------------------------------------------------------------------------------
+/**
+ * Called once AirVantage stopped writing for CONFIG_COMMIT_DELAY_MS
+ */
+//-------------------------------------------------------------------------------------------------
+static void CommitTimerHandler
 (
-    const char * pathToDataPtr,
-    double dataToWrite
+    le_timer_Ref_t timerRef
 )
 {
-    le_cfg_IteratorRef_t iteratorRef;
-
-    iteratorRef = le_cfg_CreateWriteTxn(CONFIG_TREE_NAME_STR ":");
-    le_cfg_SetFloat(iteratorRef, pathToDataPtr, dataToWrite);
-    le_cfg_CommitTxn(iteratorRef);
+    CommitPendingWrites();
 }
 
 //-------------------------------------------------------------------------------------------------
 /**
  * This function is returned whenever a write operation occurs from AirVantage.
- * It will write the data sent from the resource to the path specified.
+ * It keeps the data sent from the resource until it is committed with the other writes of the
+ * session, see CommitPendingWrites.
  */
 //-------------------------------------------------------------------------------------------------
 static void ConfigSettingHandler
@@ -143,6 +389,7 @@ static void ConfigSettingHandler
 {
     const char * pathToDataPtr = NULL;
     le_avdata_DataType_t dataType = LE_AVDATA_DATA_TYPE_NONE;
+    PendingWrite_t * writePtr = NULL;
 
     // Find the pathToDataPtr and the dataType through the contextPtr sent by the handler.
     int i;
@@ -152,6 +399,7 @@ static void ConfigSettingHandler
         {
             pathToDataPtr = ConfigEntries[i].configTreePathPtr;
             dataType = ConfigEntries[i].dataType;
+            writePtr = &PendingWrites[i];
             break;
         }
     }
@@ -175,7 +423,10 @@ static void ConfigSettingHandler
                 if (resultGet == LE_OK)
                 {
                     LE_INFO("String being written is: '%s'", bufferString);
-                    WriteStringToConfig(pathToDataPtr, bufferString);
+                    le_utf8_Copy(writePtr->value.stringValue,
+                                 bufferString,
+                                 sizeof(writePtr->value.stringValue),
+                                 NULL);
                 }
             }
             break;
@@ -187,7 +438,7 @@ static void ConfigSettingHandler
                 if (resultGet == LE_OK)
                 {
                     LE_INFO("Int being written is: %i", bufferInt);
-                    WriteIntToConfig(pathToDataPtr, bufferInt);
+                    writePtr->value.intValue = bufferInt;
                 }
             }
             break;
@@ -199,7 +450,7 @@ static void ConfigSettingHandler
                 if (resultGet == LE_OK)
                 {
                     LE_INFO("Float being written is: %f", bufferFloat);
-                    WriteFloatToConfig(pathToDataPtr, bufferFloat);
+                    writePtr->value.floatValue = bufferFloat;
                 }
             }
             break;
@@ -211,7 +462,7 @@ static void ConfigSettingHandler
                 if (resultGet == LE_OK)
                 {
                     LE_INFO("Bool being written is: %s", bufferBool ? "true" : "false");
-                    WriteBoolToConfig(pathToDataPtr, bufferBool);
+                    writePtr->value.boolValue = bufferBool;
                 }
             }
             break;
@@ -228,9 +479,499 @@ static void ConfigSettingHandler
     if(resultGet != LE_OK)
     {
         LE_ERROR("Unable to retreive asset data at '%s': %d", pathToDataPtr, resultGet);
+        return;
+    }
+
+    // The other writes of the session are likely to follow, commit them all at once
+    writePtr->isPending = true;
+    ReceivedWriteCount++;
+    le_timer_Restart(CommitTimer);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Copies a statistic from the config tree to its resource
+ */
+//-------------------------------------------------------------------------------------------------
+static void MirrorStat
+(
+    le_cfg_IteratorRef_t iteratorRef,
+    const char * pathPtr
+)
+{
+    le_result_t result;
+
+    result = le_avdata_SetInt(pathPtr, le_cfg_GetInt(iteratorRef, pathPtr, 0));
+    if (result != LE_OK)
+    {
+        LE_ERROR("Unable to update resource '%s': %d", pathPtr, result);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Called when trafficLight publishes its statistics, updates the resources mirroring them.
+ * Also called once at start-up.
+ */
+//-------------------------------------------------------------------------------------------------
+static void StatsChangeHandler
+(
+    void* contextPtr
+)
+{
+    char path[MAX_STATS_PATH_BYTES];
+    le_cfg_IteratorRef_t iteratorRef;
+    int i;
+    int j;
+
+    iteratorRef = le_cfg_CreateReadTxn(CONFIG_TREE_NAME_STR ":/");
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(StatsMeasures); i++)
+    {
+        for (j = 0; j < NUM_ARRAY_MEMBERS(StatsValues); j++)
+        {
+            snprintf(path, sizeof(path), CONFIG_TREE_STATS "/%s/%s",
+                     StatsMeasures[i], StatsValues[j]);
+            MirrorStat(iteratorRef, path);
+        }
+    }
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(StatsCounters); i++)
+    {
+        snprintf(path, sizeof(path), CONFIG_TREE_STATS "/%s", StatsCounters[i]);
+        MirrorStat(iteratorRef, path);
+    }
+
+    le_cfg_CancelTxn(iteratorRef);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Creates the read-only resources mirroring the statistics of trafficLight
+ */
+//-------------------------------------------------------------------------------------------------
+static void CreateStatsResource
+(
+    const char * pathPtr
+)
+{
+    if (LE_FAULT == le_avdata_CreateResource(pathPtr, LE_AVDATA_ACCESS_VARIABLE))
+    {
+        LE_ERROR("Error in creating %s", pathPtr);
+    }
+}
+
+static void StatsInit
+(
+    void
+)
+{
+    char path[MAX_STATS_PATH_BYTES];
+    int i;
+    int j;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(StatsMeasures); i++)
+    {
+        for (j = 0; j < NUM_ARRAY_MEMBERS(StatsValues); j++)
+        {
+            snprintf(path, sizeof(path), CONFIG_TREE_STATS "/%s/%s",
+                     StatsMeasures[i], StatsValues[j]);
+            CreateStatsResource(path);
+        }
+    }
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(StatsCounters); i++)
+    {
+        snprintf(path, sizeof(path), CONFIG_TREE_STATS "/%s", StatsCounters[i]);
+        CreateStatsResource(path);
+    }
+
+    le_cfg_AddChangeHandler(CONFIG_TREE_NAME_STR ":" CONFIG_TREE_STATS, StatsChangeHandler, NULL);
+
+    StatsChangeHandler(NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Removes the first record from the records not uploaded yet
+ */
+//-------------------------------------------------------------------------------------------------
+static void RemoveFirstRecord
+(
+    void
+)
+{
+    le_avdata_DeleteRecord(TelemetryRecords[0].recordRef);
+    UnpushedResultCount -= TelemetryRecords[0].resultCount;
+
+    TelemetryRecordCount--;
+    memmove(&TelemetryRecords[0],
+            &TelemetryRecords[1],
+            TelemetryRecordCount * sizeof(TelemetryRecord_t));
+
+    if (TelemetryRecordCount == 0)
+    {
+        IsLastRecordOpen = false;
+    }
+}
+
+static void PushRecords(void);
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Requests the AVC session, unless it is already requested. Once it is started, the uploads that
+ * are due are done.
+ */
+//-------------------------------------------------------------------------------------------------
+static void RequestSession
+(
+    void
+)
+{
+    if (AvcSessionRef != NULL)
+    {
+        return;
+    }
+
+    AvcSessionRef = le_avdata_RequestSession();
+    if (AvcSessionRef == NULL)
+    {
+        LE_ERROR("AirVantage Connection Controller does not start.");
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Sets when the poll results are uploaded next: after the retry time if an upload is due, after
+ * the push interval otherwise.
+ */
+//-------------------------------------------------------------------------------------------------
+static void SchedulePush
+(
+    void
+)
+{
+    uint32_t delaySec = IsPushDue ? TELEMETRY_PUSH_RETRY_SEC : PushIntervalSec;
+
+    le_timer_Stop(PushTimer);
+    if (delaySec > 0)
+    {
+        le_timer_SetMsInterval(PushTimer, delaySec * 1000);
+        le_timer_Start(PushTimer);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Called once the first record is pushed. The next one is pushed, if any.
+ */
+//-------------------------------------------------------------------------------------------------
+static void PushRecordResultHandler
+(
+    le_avdata_PushStatus_t status,
+    void* contextPtr
+)
+{
+    IsPushing = false;
+
+    if (status != LE_AVDATA_PUSH_SUCCESS)
+    {
+        LE_WARN("Unable to push %u poll result(s), retrying in %d s",
+                TelemetryRecords[0].resultCount,
+                TELEMETRY_PUSH_RETRY_SEC);
+        IsPushDue = true;
+        SchedulePush();
+        return;
+    }
+
+    LE_INFO("%u poll result(s) pushed", TelemetryRecords[0].resultCount);
+    PushedResultCount += TelemetryRecords[0].resultCount;
+    RemoveFirstRecord();
+
+    if (TelemetryRecordCount > 0)
+    {
+        PushRecords();
     }
 }
 
+//-------------------------------------------------------------------------------------------------
+/**
+ * Uploads the poll results, one record after the other. If the AVC session is not started, it is
+ * requested and the results are uploaded once it is, or tried again from PushTimer.
+ */
+//-------------------------------------------------------------------------------------------------
+static void PushRecords
+(
+    void
+)
+{
+    le_result_t result;
+
+    if ( (TelemetryRecordCount == 0) || IsPushing )
+    {
+        return;
+    }
+
+    if (!IsSessionStarted)
+    {
+        IsPushDue = true;
+        RequestSession();
+        SchedulePush();
+        return;
+    }
+
+    // The results that follow go to a new record
+    IsLastRecordOpen = false;
+    IsPushDue = false;
+
+    result = le_avdata_PushRecord(TelemetryRecords[0].recordRef, PushRecordResultHandler, NULL);
+    if (result != LE_OK)
+    {
+        LE_WARN("Unable to push %u poll result(s): %d", TelemetryRecords[0].resultCount, result);
+        IsPushDue = true;
+        SchedulePush();
+        return;
+    }
+
+    IsPushing = true;
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Called every /telemetryPushIntervalSec to upload the poll results, and every
+ * TELEMETRY_PUSH_RETRY_SEC while an upload is due
+ */
+//-------------------------------------------------------------------------------------------------
+static void PushTimerHandler
+(
+    le_timer_Ref_t timerRef
+)
+{
+    PushRecords();
+
+    if (!IsPushDue)
+    {
+        SchedulePush();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Opens a new record for the poll results. The oldest record not being pushed is dropped if too
+ * many are kept.
+ *
+ * @return
+ *      The record, NULL if it cannot be created
+ */
+//-------------------------------------------------------------------------------------------------
+static TelemetryRecord_t * OpenRecord
+(
+    void
+)
+{
+    TelemetryRecord_t * recordPtr;
+    le_avdata_RecordRef_t recordRef;
+
+    if (TelemetryRecordCount == TELEMETRY_MAX_RECORDS)
+    {
+        size_t index = IsPushing ? 1 : 0;
+
+        LE_WARN("Too many poll results waiting, %u dropped",
+                TelemetryRecords[index].resultCount);
+
+        le_avdata_DeleteRecord(TelemetryRecords[index].recordRef);
+        UnpushedResultCount -= TelemetryRecords[index].resultCount;
+        DroppedResultCount += TelemetryRecords[index].resultCount;
+
+        TelemetryRecordCount--;
+        memmove(&TelemetryRecords[index],
+                &TelemetryRecords[index + 1],
+                (TelemetryRecordCount - index) * sizeof(TelemetryRecord_t));
+    }
+
+    recordRef = le_avdata_CreateRecord();
+    if (recordRef == NULL)
+    {
+        LE_ERROR("Unable to create a record");
+        return NULL;
+    }
+
+    recordPtr = &TelemetryRecords[TelemetryRecordCount++];
+    recordPtr->recordRef = recordRef;
+    recordPtr->resultCount = 0;
+    IsLastRecordOpen = true;
+
+    return recordPtr;
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Adds the values of a poll result to a record
+ *
+ * @return
+ *      - LE_OK if all the values are added
+ *      - LE_NO_MEMORY if the record is full, some values may be added
+ *      - LE_FAULT on any other error
+ */
+//-------------------------------------------------------------------------------------------------
+static le_result_t RecordResult
+(
+    TelemetryRecord_t * recordPtr,
+    const char * monitorPtr,
+    int32_t httpCode,
+    trafficLight_State_t state,
+    uint32_t latencyMs,
+    uint64_t timestamp
+)
+{
+    const char * namePtrs[] = { "state", "httpCode", "latencyMs" };
+    int32_t values[] = { state, httpCode, latencyMs };
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(namePtrs); i++)
+    {
+        char path[MAX_TELEMETRY_PATH_BYTES];
+        le_result_t result;
+
+        snprintf(path, sizeof(path), "polls/%s/%s", monitorPtr, namePtrs[i]);
+
+        result = le_avdata_RecordInt(recordPtr->recordRef, path, values[i], timestamp);
+        if (result == LE_NO_MEMORY)
+        {
+            return LE_NO_MEMORY;
+        }
+        if (result != LE_OK)
+        {
+            LE_ERROR("Unable to record '%s': %d", path, result);
+            return LE_FAULT;
+        }
+    }
+
+    return LE_OK;
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Called by trafficLight with the result of each monitor once it is polled. The result is added
+ * to a time-series record, uploaded once TelemetryBatchSize results are waiting. A record holds
+ * TELEMETRY_MAX_RESULTS_PER_RECORD results, so that the three values of a result are recorded
+ * together; the result is only counted once all of them are.
+ */
+//-------------------------------------------------------------------------------------------------
+static void PollResultHandler
+(
+    const char * monitorPtr,
+    int32_t httpCode,
+    trafficLight_State_t state,
+    uint32_t latencyMs,
+    void * contextPtr
+)
+{
+    le_clk_Time_t now = le_clk_GetAbsoluteTime();
+    uint64_t timestamp = (uint64_t) now.sec * 1000 + now.usec / 1000;
+    TelemetryRecord_t * recordPtr = IsLastRecordOpen ?
+                                    &TelemetryRecords[TelemetryRecordCount - 1] : NULL;
+    le_result_t result = LE_NO_MEMORY;
+
+    if ( (recordPtr != NULL) && (recordPtr->resultCount < TELEMETRY_MAX_RESULTS_PER_RECORD) )
+    {
+        result = RecordResult(recordPtr, monitorPtr, httpCode, state, latencyMs, timestamp);
+    }
+
+    // Full before its limit, e.g. with long monitor names: the result goes to a new record
+    if (result == LE_NO_MEMORY)
+    {
+        recordPtr = OpenRecord();
+        if (recordPtr == NULL)
+        {
+            return;
+        }
+        result = RecordResult(recordPtr, monitorPtr, httpCode, state, latencyMs, timestamp);
+    }
+
+    if (result != LE_OK)
+    {
+        LE_ERROR("Unable to record the poll result of %s: %d", monitorPtr, result);
+        return;
+    }
+
+    recordPtr->resultCount++;
+    UnpushedResultCount++;
+
+    if (UnpushedResultCount >= TelemetryBatchSize)
+    {
+        PushRecords();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Reads when the poll results are uploaded. Also called once at start-up.
+ */
+//-------------------------------------------------------------------------------------------------
+static void TelemetryConfigChangeHandler
+(
+    void* contextPtr
+)
+{
+    int32_t pushIntervalSec = le_cfg_QuickGetInt(CONFIG_TREE_NAME_STR ":"
+                                                 CONFIG_TREE_TELEMETRY_PUSH_INTERVAL_SEC,
+                                                 DEFAULT_TELEMETRY_PUSH_INTERVAL_SEC);
+    int32_t batchSize = le_cfg_QuickGetInt(CONFIG_TREE_NAME_STR ":"
+                                           CONFIG_TREE_TELEMETRY_BATCH_SIZE,
+                                           DEFAULT_TELEMETRY_BATCH_SIZE);
+
+    if (pushIntervalSec < 0)
+    {
+        LE_WARN("Invalid telemetry push interval %d, using %d",
+                pushIntervalSec, DEFAULT_TELEMETRY_PUSH_INTERVAL_SEC);
+        pushIntervalSec = DEFAULT_TELEMETRY_PUSH_INTERVAL_SEC;
+    }
+
+    if (batchSize < 1)
+    {
+        LE_WARN("Invalid telemetry batch size %d, using %d",
+                batchSize, DEFAULT_TELEMETRY_BATCH_SIZE);
+        batchSize = DEFAULT_TELEMETRY_BATCH_SIZE;
+    }
+
+    TelemetryBatchSize = batchSize;
+    PushIntervalSec = pushIntervalSec;
+    SchedulePush();
+
+    LE_INFO("Poll results pushed every %d s or by %d", pushIntervalSec, batchSize);
+
+    if (UnpushedResultCount >= TelemetryBatchSize)
+    {
+        PushRecords();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Starts recording the poll results of trafficLight
+ */
+//-------------------------------------------------------------------------------------------------
+static void TelemetryInit
+(
+    void
+)
+{
+    PushTimer = le_timer_Create("TelemetryPushTimer");
+    le_timer_SetRepeat(PushTimer, 1);
+    le_timer_SetHandler(PushTimer, PushTimerHandler);
+
+    le_cfg_AddChangeHandler(CONFIG_TREE_NAME_STR ":" CONFIG_TREE_TELEMETRY_PUSH_INTERVAL_SEC,
+                            TelemetryConfigChangeHandler,
+                            NULL);
+    le_cfg_AddChangeHandler(CONFIG_TREE_NAME_STR ":" CONFIG_TREE_TELEMETRY_BATCH_SIZE,
+                            TelemetryConfigChangeHandler,
+                            NULL);
+    TelemetryConfigChangeHandler(NULL);
+
+    trafficLight_AddPollResultHandler(PollResultHandler, NULL);
+}
+
 //-------------------------------------------------------------------------------------------------
 /**
  * Function relevant to AirVantage server connection
@@ -243,6 +984,13 @@ static void AppTerminationHandler
 {
     LE_INFO("Close AVC session");
 
+    CommitPendingWrites();
+
+    LE_INFO("%u poll result(s) pushed, %u dropped, %u not pushed",
+            PushedResultCount,
+            DroppedResultCount,
+            UnpushedResultCount);
+
     if (AvcSessionRef != NULL)
     {
         le_avdata_ReleaseSession(AvcSessionRef);
@@ -271,9 +1019,22 @@ static void AvcStatusHandler
     {
         case LE_AVDATA_SESSION_STARTED:
             LE_INFO("Legato session started successfully");
+            IsSessionStarted = true;
+            if (IsPushDue)
+            {
+                PushRecords();
+            }
             break;
         case LE_AVDATA_SESSION_STOPPED:
             LE_INFO("Legato session stopped");
+            IsSessionStarted = false;
+            CommitPendingWrites();
+            // Requested again when an upload is due
+            if (AvcSessionRef != NULL)
+            {
+                le_avdata_ReleaseSession(AvcSessionRef);
+                AvcSessionRef = NULL;
+            }
             break;
         default:
             LE_ERROR("Error: AvcStatusHandler called with no updateStatus passed to the function");
@@ -309,12 +1070,8 @@ COMPONENT_INIT
     AvcEventHandlerRef = le_avdata_AddSessionStateHandler(AvcStatusHandler, NULL);
 
     // Request AVC session. Note: AVC handler must be registered prior starting a session
-    AvcSessionRef = le_avdata_RequestSession();
-    if (NULL == AvcSessionRef)
-    {
-        LE_ERROR("AirVantage Connection Controller does not start.");
-    }
-    else
+    RequestSession();
+    if (AvcSessionRef != NULL)
     {
         LE_INFO("AirVantage Connection Controller started.");
     }
@@ -339,4 +1096,19 @@ COMPONENT_INIT
                                           ConfigSettingHandler,
                                           ConfigEntries[i].resourcePathPtr);
     }
+
+    CommitTimer = le_timer_Create("CommitTimer");
+    le_timer_SetMsInterval(CommitTimer, CONFIG_COMMIT_DELAY_MS);
+    le_timer_SetHandler(CommitTimer, CommitTimerHandler);
+
+    le_avdata_CreateResource(RESOURCE_WRITES_RECEIVED, LE_AVDATA_ACCESS_VARIABLE);
+    le_avdata_CreateResource(RESOURCE_WRITES_UNCHANGED, LE_AVDATA_ACCESS_VARIABLE);
+    le_avdata_CreateResource(RESOURCE_COMMITS_SAVED, LE_AVDATA_ACCESS_VARIABLE);
+    UpdateWriteCounters();
+
+    LE_INFO("Create statistics AssetData");
+    StatsInit();
+
+    LE_INFO("Record poll results");
+    TelemetryInit();
 }